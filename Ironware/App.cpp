@@ -10,6 +10,7 @@
 #define IR_INCLUDE_TEXTURE
 #include "BindableCommon.h"
 #include "BindableCollection.h"
+#include "GeometryHeap.h"
 #include "DynamicConstantBuffer.h"
 #include "ModelProbe.h"
 #include "Node.h"
@@ -18,9 +19,11 @@
 #include "IronChannels.h"
 
 #include <DirectXTex/DirectXTex.h>
+#include <imgui/imgui.h>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 
+#include <cmath>
 #include <string>
 
 App::App()
@@ -37,7 +40,6 @@ App::App()
 	cameras.AddCamera( pointLight.ShareCamera() );
 
 	pointLight.LinkTechniques( rg );
-	sponza.LinkTechniques( rg );
 	goblin.LinkTechniques( rg );
 	nano.LinkTechniques( rg );
 	cube.LinkTechniques( rg );
@@ -45,6 +47,11 @@ App::App()
 	cameras.LinkTechniques( rg );
 
 	rg.BindShadowCamera( *pointLight.ShareCamera() );
+	// shadow map is filtered and has less resolution, so it takes coarser levels of detail
+	shadowFrustum.SetLodThreshold( Frustum::DEFAULT_LOD_THRESHOLD * 4.f );
+
+	sceneBvh.AddModel( goblin );
+	sceneBvh.AddModel( nano );
 
 	wnd.EnableMouseCursor();
 }
@@ -68,24 +75,67 @@ int App::BeginFrame()
 
 void App::ProcessFrame()
 {
+	PollLoaders();
 	wnd.Gfx().BeginFrame( 0.07f, 0.f, 0.12f );
 	pointLight.Bind( wnd.Gfx(), cameras->GetMatrix() );
 	rg.BindMainCamera( cameras.GetActiveCamera() );
 
-	nano.Submit( IR_CH::main );
-	goblin.Submit( IR_CH::main );
+	// world matrices are read by the submission tasks, so hierarchies are updated up front
+	nano.UpdateTransforms();
+	goblin.UpdateTransforms();
+	if( pSponza )
+	{
+		pSponza->UpdateTransforms();
+	}
+	sceneBvh.Update();
+
+	// models are traversed by the scheduler, while simple drawables are submitted from this thread
+	TaskScheduler::Group submitGroup;
+	mainFrustum.Update( cameras.GetActiveCamera() );
+	shadowFrustum.Update( *pointLight.ShareCamera() );
+	if( useSceneBvh )
+	{
+		sceneBvh.Submit( IR_CH::main, mainFrustum, scheduler, submitGroup );
+		sceneBvh.Submit( IR_CH::shadow, shadowFrustum, scheduler, submitGroup );
+	}
+	else
+	{
+		nano.Submit( IR_CH::main, mainFrustum, scheduler, submitGroup );
+		goblin.Submit( IR_CH::main, mainFrustum, scheduler, submitGroup );
+		if( pSponza )
+		{
+			pSponza->Submit( IR_CH::main, mainFrustum, scheduler, submitGroup );
+			pSponza->Submit( IR_CH::shadow, shadowFrustum, scheduler, submitGroup );
+		}
+		goblin.Submit( IR_CH::shadow, shadowFrustum, scheduler, submitGroup );
+		nano.Submit( IR_CH::shadow, shadowFrustum, scheduler, submitGroup );
+	}
+
 	pointLight.Submit( IR_CH::main );
-	sponza.Submit( IR_CH::main );
 	cube.Submit( IR_CH::main );
 	cube2.Submit( IR_CH::main );
 	cameras.Submit( IR_CH::main );
 
-	sponza.Submit( IR_CH::shadow );
 	cube.Submit( IR_CH::shadow );
-	sponza.Submit( IR_CH::shadow );
 	cube2.Submit( IR_CH::shadow );
-	goblin.Submit( IR_CH::shadow );
-	nano.Submit( IR_CH::shadow );
+
+	if( drawStressBoxes )
+	{
+		constexpr size_t chunkSize = 4096u;
+		for( size_t first = 0; first < stressBoxes.size(); first += chunkSize )
+		{
+			const size_t last = std::min( first + chunkSize, stressBoxes.size() );
+			scheduler.Run( submitGroup, [this, first, last]()
+			{
+				for( size_t i = first; i < last; i++ )
+				{
+					stressBoxes[i]->Submit( IR_CH::main | IR_CH::shadow );
+				}
+			} );
+		}
+	}
+
+	scheduler.Wait( submitGroup );
 
 	rg.Execute( wnd.Gfx() );
 
@@ -99,11 +149,25 @@ void App::ProcessFrame()
 	static MP sponzaProbe{ "Sponza" };
 	static MP goblinProbe{ "Goblin" };
 	static MP nanoProbe{ "Nanosuit" };
-	sponzaProbe.SpawnWindow( sponza );
+	if( pickedNode )
+	{
+		auto& probe = pickedNode->pModel == pSponza.get() ? sponzaProbe : ( pickedNode->pModel == &nano ? nanoProbe : goblinProbe );
+		probe.SelectNode( pickedNode->pModel->GetNode( pickedNode->nodeId ) );
+		pickedNode.reset();
+	}
+	if( pSponza )
+	{
+		sponzaProbe.SpawnWindow( *pSponza );
+	}
 	nanoProbe.SpawnWindow( nano );
 	goblinProbe.SpawnWindow( goblin );
 	cameras.SpawnWindow( wnd.Gfx() );
 	pointLight.SpawnControlWindow();
+	SpawnCullingWindow();
+	SpawnBindablesWindow();
+	SpawnLoadingWindow();
+	SpawnInstancingWindow();
+	SpawnTransformsWindow();
 
 	rg.RenderWindows( wnd.Gfx() );
 
@@ -112,6 +176,247 @@ void App::ProcessFrame()
 	rg.Reset();
 }
 
+void App::SpawnCullingWindow() noexcept
+{
+	if( ImGui::Begin( "Culling" ) )
+	{
+		const auto frustumStats = []( const char* label, Frustum& frustum )
+		{
+			ImGui::PushID( label );
+			ImGui::Text( "%s: %zu visible, %zu culled", label, frustum.GetVisibleCount(), frustum.GetCulledCount() );
+			bool enabled = frustum.IsEnabled();
+			if( ImGui::Checkbox( "Enable", &enabled ) )
+			{
+				frustum.SetEnabled( enabled );
+			}
+			float lodThreshold = frustum.GetLodThreshold();
+			if( ImGui::SliderFloat( "LOD Threshold", &lodThreshold, 0.f, 0.02f, "%.4f" ) )
+			{
+				frustum.SetLodThreshold( lodThreshold );
+			}
+			bool meshletCulling = frustum.IsMeshletCullingEnabled();
+			if( ImGui::Checkbox( "Meshlet Culling", &meshletCulling ) )
+			{
+				frustum.SetMeshletCulling( meshletCulling );
+			}
+			const size_t triangles = frustum.GetMeshletTriangleCount();
+			const float percent = triangles > 0u ? 100.f / float( triangles ) : 0.f;
+			ImGui::Text( "meshlet triangles %zu: %.1f%% outside, %.1f%% backfacing, %zu ranges drawn", triangles,
+				frustum.GetFrustumCulledTriangleCount() * percent, frustum.GetConeCulledTriangleCount() * percent, frustum.GetMeshletRangeCount() );
+			ImGui::PopID();
+		};
+		frustumStats( "Main", mainFrustum );
+		frustumStats( "Shadow", shadowFrustum );
+
+		ImGui::Separator();
+		ImGui::Checkbox( "Use Scene BVH", &useSceneBvh );
+		const auto& bvhStats = sceneBvh.GetStats();
+		ImGui::Text( "BVH: %zu items, %zu nodes, build %.3f ms, refit %.3f ms",
+			bvhStats.itemCount, bvhStats.nodeCount, bvhStats.buildTime, bvhStats.refitTime );
+		ImGui::SliderInt( "Scene Copies", &bvhBenchCopies, 1, 64 );
+		if( ImGui::Button( "Benchmark BVH" ) )
+		{
+			sceneBvh.Benchmark( (size_t)bvhBenchCopies, mainFrustum, cameras.GetActiveCamera().GetPickingRay( 0.f, 0.f ) );
+		}
+		const auto& bench = sceneBvh.GetBenchmarkStats();
+		ImGui::Text( "x%zu: %zu items, %zu nodes", bench.copies, bench.itemCount, bench.nodeCount );
+		ImGui::Text( "build %.3f ms, refit %.3f ms", bench.buildTime, bench.refitTime );
+		ImGui::Text( "frustum query %.4f ms, ray query %.2f us", bench.frustumQueryTime, bench.rayQueryTime * 1000.f );
+	}
+	ImGui::End();
+}
+
+void App::SpawnBindablesWindow() noexcept
+{
+	if( ImGui::Begin( "Bindables" ) )
+	{
+		const auto stats = BindableCollection::GetStats();
+		ImGui::Text( "%zu bindables, %zu slots", stats.count, stats.capacity );
+		ImGui::Text( "Resolve: %zu hits, %zu misses", stats.hits, stats.misses );
+		ImGui::Separator();
+		if( ImGui::Button( "Benchmark Resolve Keys" ) )
+		{
+			bindableBench = BindableCollection::Benchmark( 1000u );
+		}
+		ImGui::Text( "%zu keys", bindableBench.keyCount );
+		ImGui::Text( "string UID %.1f ns, hashed key %.1f ns", bindableBench.stringKeyTime, bindableBench.hashedKeyTime );
+		if( ImGui::Button( "Benchmark Buffer Access" ) )
+		{
+			bufferAccessBench = Buffer::Benchmark( 100000u );
+		}
+		ImGui::Text( "%zu accesses", bufferAccessBench.accessCount );
+		ImGui::Text( "keyed %.1f ns, handle %.1f ns", bufferAccessBench.keyedTime, bufferAccessBench.handleTime );
+		if( ImGui::Button( "Benchmark Layouts" ) )
+		{
+			layoutBench = DynamicLayout::Benchmark( 10000u );
+		}
+		ImGui::Text( "%zu layouts, %zu mismatches of table and tree", layoutBench.layouts, layoutBench.mismatches );
+		ImGui::Text( "key: signature %.1f ns, structural hash %.1f ns", layoutBench.signatureKeyTime, layoutBench.hashKeyTime );
+		ImGui::Text( "path: tree %.1f ns, table %.1f ns", layoutBench.treePathTime, layoutBench.tablePathTime );
+		ImGui::Text( "buffer: tree %.1f ns, table %.1f ns", layoutBench.treeBufferTime, layoutBench.tableBufferTime );
+		ImGui::Separator();
+		// jobs of this frame are drawn already, so the offsets can change until the next submission
+		for( const auto& pool : GeometryHeap::GetStats() )
+		{
+			const auto& r = pool.ranges;
+			ImGui::Text( "%s: %zu of %zu elements (%u bytes), %zu ranges", to_narrow( pool.name ).c_str(), r.used, r.capacity, pool.elementSize, r.allocationCount );
+			ImGui::Text( "  %zu free ranges, largest %zu", r.freeRangeCount, r.largestFreeRange );
+		}
+		if( ImGui::Button( "Defragment Geometry" ) )
+		{
+			geometryMoved = GeometryHeap::Defragment( wnd.Gfx() );
+		}
+		ImGui::Text( "%zu elements moved", geometryMoved );
+	}
+	ImGui::End();
+}
+
+void App::SpawnLoadingWindow() noexcept
+{
+	if( ImGui::Begin( "Loading" ) )
+	{
+		const auto stats = sponzaLoader.GetStats();
+		ImGui::Text( "%s: %s", to_narrow( sponzaLoader.GetPath() ).c_str(), sponzaLoader.IsReady() ? "ready" : "loading" );
+		ImGui::Text( "%zu materials, %zu textures, %zu meshes", stats.materialCount, stats.textureCount, stats.meshCount );
+		ImGui::Text( "vertices %.2f MB, %.2f MB as floats", stats.vertexBytes / ( 1024.f * 1024.f ), stats.unpackedVertexBytes / ( 1024.f * 1024.f ) );
+		ImGui::Text( "%s %.1f ms", stats.cooked ? "cooked load" : "import", stats.importTime );
+		ImGui::Text( "materials %.1f ms, decode %.1f ms, extract %.1f ms (summed over tasks)", stats.materialTime, stats.decodeTime, stats.extractTime );
+		ImGui::Text( "mesh optimization %.1f ms, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+			stats.optimizeTime, stats.acmrBefore, stats.acmrAfter, stats.atvrBefore, stats.atvrAfter );
+		ImGui::Text( "%zu levels of detail, %zu triangles -> %zu at the coarsest levels, simplification %.1f ms",
+			stats.lodCount, stats.triangleCount, stats.coarsestTriangleCount, stats.simplifyTime );
+		ImGui::Text( "%zu meshlets in %zu meshes", stats.meshletCount, stats.meshletMeshCount );
+		ImGui::Text( "static batching: %zu of %zu mesh references in %zu batches, %zu draws left, %.1f ms",
+			stats.batches.batchedInstanceCount, stats.batches.instanceCount, stats.batches.batchCount,
+			stats.batches.instanceCount - stats.batches.batchedInstanceCount + stats.batches.batchCount, stats.batches.buildTime );
+		ImGui::Text( "cooked file written in %.1f ms", stats.cookTime );
+		ImGui::Text( "CPU stages done after %.1f ms", stats.cpuTime );
+		ImGui::Text( "GPU publish %.1f ms, ready after %.1f ms", stats.publishTime, stats.totalTime );
+		ImGui::Separator();
+		if( ImGui::Button( "Benchmark Nanosuit" ) )
+		{
+			cookedBench = CookedModel::Benchmark( L"Models\\nanosuit_textured\\nanosuit.obj", 1.5f );
+		}
+		ImGui::SameLine();
+		if( ImGui::Button( "Benchmark Sponza" ) )
+		{
+			cookedBench = CookedModel::Benchmark( L"Models\\sponza\\sponza.obj", 1.f / 20.f );
+		}
+		ImGui::Text( "%zu meshes, %.1f MB of vertices", cookedBench.meshCount, cookedBench.vertexBytes / ( 1024.f * 1024.f ) );
+		ImGui::Text( "assimp import %.1f ms, cooked load %.2f ms", cookedBench.importTime, cookedBench.cookedTime );
+		ImGui::Separator();
+		if( ImGui::Button( "Benchmark Vertex Fill" ) )
+		{
+			vertexFillBench = Material::BenchmarkVertexFill( L"Models\\sponza\\sponza.obj", 1.f / 20.f, scheduler );
+		}
+		ImGui::Text( "%zu meshes, %zu vertices", vertexFillBench.meshCount, vertexFillBench.vertexCount );
+		ImGui::Text( "per vertex %.2f ms, streamed %.2f ms, parallel %.2f ms",
+			vertexFillBench.perVertexTime, vertexFillBench.streamTime, vertexFillBench.parallelTime );
+		ImGui::Text( "packing error: normal %.3f deg, tangent %.3f deg, bitangent %.3f deg, uv %.5f",
+			vertexFillBench.maxNormalError, vertexFillBench.maxTangentError, vertexFillBench.maxBitangentError, vertexFillBench.maxTexCoordError );
+	}
+	ImGui::End();
+}
+
+void App::SpawnInstancingWindow()
+{
+	if( ImGui::Begin( "Instancing" ) )
+	{
+		const auto& drawStats = wnd.Gfx().GetDrawStats();
+		ImGui::Text( "%zu draw calls, %zu instances", drawStats.drawCalls, drawStats.instances );
+		ImGui::SliderInt( "Box Count", &stressBoxCount, 1000, 100000 );
+		if( ImGui::Checkbox( "Draw Boxes", &drawStressBoxes ) && drawStressBoxes && stressBoxes.size() != (size_t)stressBoxCount )
+		{
+			BuildStressBoxes( (size_t)stressBoxCount );
+		}
+		if( drawStressBoxes && stressBoxes.size() != (size_t)stressBoxCount && ImGui::Button( "Rebuild" ) )
+		{
+			BuildStressBoxes( (size_t)stressBoxCount );
+		}
+		ImGui::Text( "%zu boxes", stressBoxes.size() );
+	}
+	ImGui::End();
+}
+
+void App::SpawnTransformsWindow()
+{
+	if( ImGui::Begin( "Transforms" ) )
+	{
+		auto& stage = wnd.Gfx().GetTransformStage();
+		bool batched = stage.IsEnabled();
+		if( ImGui::Checkbox( "Batch transforms per camera", &batched ) )
+		{
+			stage.SetEnabled( batched );
+		}
+		const auto& stats = stage.GetStats();
+		ImGui::Text( "%zu drawables, %zu cameras", stats.drawables, stats.cameras );
+		ImGui::Text( "%zu binds read %zu computed transforms in %.3f ms", stats.requests, stats.computed, stats.computeTime );
+		ImGui::Separator();
+		// requests of the frame that was just drawn, sponza and the nanosuit among them
+		if( ImGui::Button( "Benchmark Scene Transforms" ) )
+		{
+			transformBench = stage.Benchmark( 100u );
+		}
+		ImGui::Text( "%zu drawables, %zu cameras, %zu requests", transformBench.drawables, transformBench.cameras, transformBench.requests );
+		ImGui::Text( "per request %.3f ms, batched %.3f ms", transformBench.perRequestTime, transformBench.batchedTime );
+	}
+	ImGui::End();
+}
+
+void App::BuildStressBoxes( size_t count )
+{
+	// outlines would cover the whole grid, so the prototype keeps only shading and shadows
+	class : public TechniqueProbe
+	{
+		void OnSetTechnique() override
+		{
+			if( pTech->GetName() == L"Outline" )
+			{
+				pTech->SetActive( false );
+			}
+		}
+	} probe;
+
+	stressBoxes.clear();
+	stressBoxes.reserve( count );
+	stressBoxes.push_back( std::make_unique<Box>( wnd.Gfx(), 1.f ) );
+	stressBoxes.front()->Accept( probe );
+	const auto& prototype = *stressBoxes.front();
+	const size_t side = (size_t)std::ceil( std::cbrt( (float)count ) );
+	constexpr float spacing = 2.5f;
+	for( size_t i = 0; i < count; i++ )
+	{
+		if( i > 0u )
+		{
+			stressBoxes.push_back( Box::MakeInstance( prototype ) );
+		}
+		const size_t x = i % side;
+		const size_t y = i / side % side;
+		const size_t z = i / ( side * side );
+		auto& box = *stressBoxes.back();
+		box.SetPos( {
+			( (float)x - (float)side * 0.5f ) * spacing,
+			20.f + (float)y * spacing,
+			( (float)z - (float)side * 0.5f ) * spacing
+		} );
+		box.SetRotation( { (float)x * 0.3f, (float)y * 0.2f, (float)z * 0.1f } );
+	}
+	for( auto& pBox : stressBoxes )
+	{
+		pBox->LinkTechniques( rg );
+	}
+}
+
+void App::PollLoaders()
+{
+	if( !pSponza && sponzaLoader.Poll( wnd.Gfx() ) )
+	{
+		pSponza = sponzaLoader.Take();
+		pSponza->LinkTechniques( rg );
+		sceneBvh.AddModel( *pSponza );
+	}
+}
+
 void App::HandleInput()
 {
 	const float dt = timer.Mark();
@@ -168,6 +473,22 @@ void App::HandleInput()
 			}
 		}
 	}
+	else
+	{
+		// clicks on the viewport pick nodes, clicks on imgui windows don't reach the mouse
+		while( const auto e = wnd.mouse.Read() )
+		{
+			if( e->GetType() == Mouse::Event::Type::LPRESS )
+			{
+				const float ndcX = 2.f * e->GetPosX() / wnd.Gfx().GetWidth() - 1.f;
+				const float ndcY = 1.f - 2.f * e->GetPosY() / wnd.Gfx().GetHeight();
+				if( const auto pick = sceneBvh.Pick( cameras.GetActiveCamera().GetPickingRay( ndcX, ndcY ) ) )
+				{
+					pickedNode = pick;
+				}
+			}
+		}
+	}
 
 	while( const auto e = wnd.kbd.ReadKey() )
 	{
@@ -20,6 +20,17 @@
 #include "Material.h"
 #include "BlurOutlineRenderGraph.h"
 #include "IronMath.h"
+#include "TaskScheduler.h"
+#include "Frustum.h"
+#include "SceneBvh.h"
+#include "ModelLoader.h"
+#include "BindableCollection.h"
+#include "DynamicLayout.h"
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <vector>
 
  /**
   * @brief Base class that controls scene
@@ -41,6 +52,19 @@ private:
 	*/
 	void ProcessFrame();
 	void HandleInput();
+	void SpawnCullingWindow() noexcept;
+	void SpawnBindablesWindow() noexcept;
+	void SpawnLoadingWindow() noexcept;
+	void SpawnInstancingWindow();
+	void SpawnTransformsWindow();
+	/**
+	 * @brief Fills a grid with copies of one box, they share all bindables and are drawn instanced
+	*/
+	void BuildStressBoxes( size_t count );
+	/**
+	 * @brief Publishes streamed models once they are loaded
+	*/
+	void PollLoaders();
 
 private:
 	ImguiManager imguim;
@@ -54,9 +78,32 @@ private:
 	/*Model wallObj{ wnd.Gfx(), L"Models\\brickwall\\brickwall.obj", 3.f, { -10.f, 10.f, 0.f } };*/
 	/*Sheet sheet1{ wnd.Gfx(), 3.f, { 0.f, 0.f, 1.f, 0.5f } };
 	Sheet sheet2{ wnd.Gfx(), 3.f, { 1.f, 0.f, 0.f, 0.5f } };*/
-	Model sponza{ wnd.Gfx(), L"Models\\sponza\\sponza.obj", 1.f / 20.f };
+	// sponza is streamed in on its own workers, so the frame scheduler is never stalled by decoding
+	TaskScheduler loaderScheduler{ std::max<size_t>( 1u, TaskScheduler::DefaultWorkerCount() / 2u ), TaskScheduler::Role::Background };
+	// sponza never moves, its meshes are merged into static batches per material
+	ModelLoader sponzaLoader{ loaderScheduler, L"Models\\sponza\\sponza.obj", 1.f / 20.f, { 0.f, 0.f, 0.f }, true };
+	std::unique_ptr<Model> pSponza;
 	Box cube{ wnd.Gfx(), 5.f };
 	Box cube2{ wnd.Gfx(), 5.f };
+	std::vector<std::unique_ptr<Box>> stressBoxes;
+	int stressBoxCount = 100000;
+	bool drawStressBoxes = false;
 	IronTimer timer;
+	TaskScheduler scheduler;
+	// frustums of the cameras bound to the main and shadow passes
+	Frustum mainFrustum;
+	Frustum shadowFrustum;
+	SceneBvh sceneBvh;
+	bool useSceneBvh = true;
+	int bvhBenchCopies = 8;
+	// node hit by the last viewport click, selected in its model window
+	std::optional<SceneBvh::PickResult> pickedNode;
+	BindableCollection::BenchmarkStats bindableBench;
+	Buffer::BenchmarkStats bufferAccessBench;
+	DynamicLayout::BenchmarkStats layoutBench;
+	size_t geometryMoved = 0u;
+	CookedModel::BenchmarkStats cookedBench;
+	VertexByteBuffer::FillBenchmarkStats vertexFillBench;
+	TransformStage::BenchmarkStats transformBench;
 	bool isSavingDepthExeRunning = false;
 };
\ No newline at end of file
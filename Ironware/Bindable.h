@@ -42,6 +42,10 @@ public:
 	 * @param gfx Graphics object where the context and device are stored
 	*/
 	virtual void Bind( Graphics& gfx ) IFNOEXCEPT = 0;
+	/**
+	 * @brief Writes the constants of the next Bind to the frame ring before the draws of the pass, see ConstantUploadRing
+	*/
+	virtual void StageConstants( Graphics& ) IFNOEXCEPT {}
 	virtual ~Bindable() = default;
 	virtual std::wstring GetUID() const noexcept { return L"?"; }
 	virtual void InitializeParentReference( const class Drawable& ) noexcept {}
@@ -0,0 +1,173 @@
+/*!
+ * \file BindableCollection.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ *
+ */
+#include "BindableCollection.h"
+#include "Texture.h"
+#include "PixelShader.h"
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+	// stand-in value for the benchmark containers
+	class BenchmarkBindable : public Bindable
+	{
+	public:
+		void Bind( Graphics& ) noexcept override {}
+	};
+}
+
+BindableCollection::Table::Table() :
+	slots( INITIAL_CAPACITY )
+{}
+
+std::shared_ptr<Bindable> BindableCollection::Table::Find( const Key& key ) const noexcept
+{
+	return slots[Probe( key )].pBindable;
+}
+
+std::shared_ptr<Bindable> BindableCollection::Table::Insert( const Key& key, std::shared_ptr<Bindable> pBindable, std::wstring debugName )
+{
+	// load factor is kept at most 1/2
+	if( ( count + 1u ) * 2u > slots.size() )
+	{
+		Grow();
+	}
+	auto& slot = slots[Probe( key )];
+	if( !slot.pBindable )
+	{
+		slot.key = key;
+		slot.pBindable = std::move( pBindable );
+#ifndef NDEBUG
+		slot.debugName = std::move( debugName );
+#endif
+		count++;
+	}
+	return slot.pBindable;
+}
+
+#ifndef NDEBUG
+const std::wstring* BindableCollection::Table::FindDebugName( const Key& key ) const noexcept
+{
+	const auto& slot = slots[Probe( key )];
+	return slot.pBindable ? &slot.debugName : nullptr;
+}
+#endif
+
+size_t BindableCollection::Table::Probe( const Key& key ) const noexcept
+{
+	const size_t mask = slots.size() - 1u;
+	size_t i = (size_t)( ( key.params ^ key.type ) * 0x9e3779b97f4a7c15ull ) & mask;
+	while( slots[i].pBindable && !( slots[i].key == key ) )
+	{
+		i = ( i + 1u ) & mask;
+	}
+	return i;
+}
+
+void BindableCollection::Table::Grow()
+{
+	std::vector<Slot> old( slots.size() * 2u );
+	old.swap( slots );
+	for( auto& s : old )
+	{
+		if( s.pBindable )
+		{
+			slots[Probe( s.key )] = std::move( s );
+		}
+	}
+}
+
+BindableCollection::Stats BindableCollection::GetStats() noexcept
+{
+	auto& c = Get();
+	std::shared_lock lock( c.mutex );
+	return { c.bindables.GetCount(), c.bindables.GetCapacity(), c.hits, c.misses };
+}
+
+BindableCollection::BenchmarkStats BindableCollection::Benchmark( size_t iterations )
+{
+	using namespace std::chrono;
+	constexpr size_t textureCount = 256u;
+
+	// resolve parameters of a typical model load: textures in 3 slots and a few shaders
+	struct Sample
+	{
+		std::wstring path;
+		UINT slot;
+		bool isShader;
+	};
+	std::vector<Sample> samples;
+	for( size_t i = 0; i < textureCount; i++ )
+	{
+		samples.push_back( { L"Models\\sponza\\textures\\texture_" + std::to_wstring( i ) + L".png", UINT( i % 3u ), false } );
+	}
+	for( const auto& code : { L"Phong", L"PhongDif", L"PhongDifMsk", L"PhongDifNrm", L"PhongDifSpc", L"PhongDifMskNrm", L"PhongDifSpcNrm", L"PhongDifMskSpcNrm" } )
+	{
+		samples.push_back( { std::wstring( code ) + L"_PS.cso", 0u, true } );
+	}
+
+	// both containers hold the same keys, values are irrelevant for lookups
+	std::unordered_map<std::wstring, std::shared_ptr<Bindable>> stringKeyed;
+	Table hashKeyed;
+	const auto pDummy = std::make_shared<BenchmarkBindable>();
+	std::shared_mutex benchMutex;
+	for( const auto& s : samples )
+	{
+		if( s.isShader )
+		{
+			stringKeyed[PixelShader::GenerateUID( s.path )] = pDummy;
+			hashKeyed.Insert( { type_id<PixelShader>(), PixelShader::GenerateKey( s.path ) }, pDummy, {} );
+		}
+		else
+		{
+			stringKeyed[Texture::GenerateUID( s.path, s.slot )] = pDummy;
+			hashKeyed.Insert( { type_id<Texture>(), Texture::GenerateKey( s.path, s.slot ) }, pDummy, {} );
+		}
+	}
+
+	size_t found = 0u;
+	auto start = steady_clock::now();
+	for( size_t it = 0; it < iterations; it++ )
+	{
+		for( const auto& s : samples )
+		{
+			const auto key = s.isShader ? PixelShader::GenerateUID( s.path ) : Texture::GenerateUID( s.path, s.slot );
+			found += stringKeyed.find( key ) != stringKeyed.cend();
+		}
+	}
+	const float stringTime = duration<float, std::nano>( steady_clock::now() - start ).count();
+
+	start = steady_clock::now();
+	for( size_t it = 0; it < iterations; it++ )
+	{
+		for( const auto& s : samples )
+		{
+			const Key key = s.isShader ?
+				Key{ type_id<PixelShader>(), PixelShader::GenerateKey( s.path ) } :
+				Key{ type_id<Texture>(), Texture::GenerateKey( s.path, s.slot ) };
+			// lookups in Resolve take the shared lock as well
+			std::shared_lock lock( benchMutex );
+			found += hashKeyed.Find( key ) != nullptr;
+		}
+	}
+	const float hashTime = duration<float, std::nano>( steady_clock::now() - start ).count();
+
+	BenchmarkStats stats;
+	stats.keyCount = samples.size();
+	stats.lookups = found;
+	const float lookupCount = float( samples.size() * iterations );
+	if( lookupCount > 0.f )
+	{
+		stats.stringKeyTime = stringTime / lookupCount;
+		stats.hashedKeyTime = hashTime / lookupCount;
+	}
+	return stats;
+}
@@ -6,20 +6,51 @@
  * Contact: yernar.aa@gmail.com
  *
  * \brief Header that contains BindableCollection class
+ *
+ * \note Bindables are keyed by compile-time type id and hash of the resolve parameters
+ * * (T::GenerateKey), string UIDs (T::GenerateUID) are only kept as debug names
 */
 #pragma once
 
 #include "Bindable.h"
 #include "CommonMacros.h"
+#include "IronUtils.h"
 
-#include <unordered_map>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
 
 /**
  * @brief Singleton container class which stores all of the bindables
  * * and enables sharing bindables between different type of drawables
+ * @note Lookups and insertions of Resolve are locked, but constructing a bindable isn't made thread-safe
+ * * by that. Bindables whose constructors use the immediate context (textures upload their mips and
+ * * generate the rest) have to be resolved on the render thread, loaders hand them over in Poll
 */
 class BindableCollection
 {
+public:
+	struct Stats
+	{
+		size_t count = 0u;
+		size_t capacity = 0u;
+		size_t hits = 0u;
+		size_t misses = 0u;
+	};
+
+	struct BenchmarkStats
+	{
+		size_t keyCount = 0u;
+		// successful lookups of both runs, keeps the loops from being optimized away
+		size_t lookups = 0u;
+		// average time of a single lookup with key generation in nanoseconds
+		float stringKeyTime = 0.f;
+		float hashedKeyTime = 0.f;
+	};
+
 public:
 	/**
 	 * @brief Function that resolves bindable type and either stores some value
@@ -31,6 +62,63 @@ public:
 	*/
 	template<class T, TPACK Params>
 	static std::shared_ptr<T> Resolve( Graphics& gfx, Params&&... p ) IFNOEXCEPT;
+	static Stats GetStats() noexcept;
+	/**
+	 * @brief Times lookups of texture and shader keys as wide string UIDs and as hashed keys
+	 * @param iterations number of passes over all of the sample keys
+	*/
+	static BenchmarkStats Benchmark( size_t iterations );
+
+private:
+	struct Key
+	{
+		uint64_t type;
+		uint64_t params;
+
+		bool operator==( const Key& rhs ) const noexcept { return type == rhs.type && params == rhs.params; }
+	};
+
+	/**
+	 * @brief Open-addressed (linear probing) table of bindables, never shrinks
+	*/
+	class Table
+	{
+	public:
+		Table();
+		std::shared_ptr<Bindable> Find( const Key& key ) const noexcept;
+		/**
+		 * @brief Inserts the bindable unless the key is taken
+		 * @return bindable that is stored with the key after insertion
+		*/
+		std::shared_ptr<Bindable> Insert( const Key& key, std::shared_ptr<Bindable> pBindable, std::wstring debugName );
+		size_t GetCount() const noexcept { return count; }
+		size_t GetCapacity() const noexcept { return slots.size(); }
+#ifndef NDEBUG
+		const std::wstring* FindDebugName( const Key& key ) const noexcept;
+#endif
+
+	private:
+		struct Slot
+		{
+			Key key;
+			std::shared_ptr<Bindable> pBindable;
+#ifndef NDEBUG
+			std::wstring debugName;
+#endif
+		};
+
+	private:
+		size_t Probe( const Key& key ) const noexcept;
+		void Grow();
+
+	private:
+		static constexpr size_t INITIAL_CAPACITY = 256u;
+
+	private:
+		// power of two sized, empty slots have null bindable
+		std::vector<Slot> slots;
+		size_t count = 0u;
+	};
 
 private:
 	template<class T, TPACK Params>
@@ -38,7 +126,10 @@ private:
 	static BindableCollection& Get() noexcept;
 
 private:
-	std::unordered_map<std::wstring, std::shared_ptr<Bindable>> bindables;
+	Table bindables;
+	mutable std::shared_mutex mutex;
+	std::atomic<size_t> hits = 0u;
+	std::atomic<size_t> misses = 0u;
 };
 
 #pragma region implementation
@@ -53,16 +144,29 @@ std::shared_ptr<T> BindableCollection::Resolve( Graphics& gfx, Params&&... p ) I
 template<class T, TPACK Params>
 std::shared_ptr<T> BindableCollection::Resolve_( Graphics& gfx, Params&&... p ) IFNOEXCEPT
 {
-	const auto key = T::GenerateUID( std::forward<Params>( p )... );
-	const auto i = bindables.find( key );
-	if( i != bindables.cend() )
+	static constexpr uint64_t typeId = type_id<T>();
+	const Key key = { typeId, T::GenerateKey( p... ) };
 	{
-		return std::static_pointer_cast<T>( i->second );
+		std::shared_lock lock( mutex );
+		if( auto pExisting = bindables.Find( key ) )
+		{
+			// fires when two different parameter sets hash to the same key
+			assert( *bindables.FindDebugName( key ) == T::GenerateUID( p... ) );
+			hits++;
+			return std::static_pointer_cast<T>( std::move( pExisting ) );
+		}
 	}
-	auto bind = std::make_shared<T>( gfx, std::forward<Params>( p )... );
-	bindables[key] = bind;
 
-	return bind;
+	// created outside of the lock, so that threads resolving bindables without context work don't wait on each other
+	std::wstring debugName;
+#ifndef NDEBUG
+	debugName = T::GenerateUID( p... );
+#endif
+	auto bind = std::make_shared<T>( gfx, std::forward<Params>( p )... );
+	misses++;
+	std::unique_lock lock( mutex );
+	// another thread might have resolved the same bindable meanwhile, its instance is kept then
+	return std::static_pointer_cast<T>( bindables.Insert( key, std::move( bind ), std::move( debugName ) ) );
 }
 
 inline BindableCollection& BindableCollection::Get() noexcept
@@ -71,4 +175,4 @@ inline BindableCollection& BindableCollection::Get() noexcept
 	return collection;
 }
 
-#pragma endregion implementation
\ No newline at end of file
+#pragma endregion implementation
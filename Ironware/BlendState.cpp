@@ -9,6 +9,8 @@
 #include "BlendState.h"
 #include "GraphicsExceptionMacros.h"
 
+#include <cstring>
+
 BlendState::BlendState( Graphics & gfx, bool isBlending, std::optional<float> factor ) :
 	isBlending( isBlending )
 {
@@ -41,6 +43,18 @@ void BlendState::Bind( Graphics & gfx ) IFNOEXCEPT
 {
 	INFOMAN_NOHR( gfx );
 	const FLOAT* pBlendFactors = blendFactors ? blendFactors->data() : nullptr;
+	// factors are part of the bound state, key them alongside the state object
+	uint64_t factorKey = 0u;
+	if( blendFactors )
+	{
+		uint32_t factorBits;
+		std::memcpy( &factorBits, pBlendFactors, sizeof( factorBits ) );
+		factorKey = ( 1ull << 32u ) | factorBits;
+	}
+	if( !GetStateCache( gfx ).Set( PipelineStateCache::Stage::OMBlendState, pBlendState.Get(), factorKey ) )
+	{
+		return;
+	}
 	GFX_CALL_THROW_INFO_ONLY( GetContext( gfx )->OMSetBlendState( pBlendState.Get(), pBlendFactors, 0xffffffffu ) );
 }
 
@@ -25,6 +25,7 @@ public:
 	void SetFactor( float factor ) IFNOEXCEPT;
 	float GetFactor() const IFNOEXCEPT;
 	static std::shared_ptr<BlendState> Resolve( Graphics& gfx, bool isBlending, std::optional<float> factor = {} ) { return BindableCollection::Resolve<BlendState>( gfx, isBlending, factor ); }
+	static size_t GenerateKey( bool isBlending, std::optional<float> factor ) noexcept { return hash_values( isBlending, factor ); }
 	static std::wstring GenerateUID( bool isBlending, std::optional<float> factor );
 	std::wstring GetUID() const noexcept override { return GenerateUID( isBlending, blendFactors->front() ); }
 
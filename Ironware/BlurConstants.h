@@ -0,0 +1,31 @@
+/*!
+ * \file BlurConstants.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Header file that contains the constant buffers of BlurPack
+ *
+ * \note Kept apart from BlurPack so the packing can be checked without a d3d device.
+*/
+#pragma once
+
+#include "IronWin.h"
+#include "ReflectedLayout.h"
+
+#include <DirectXMath.h>
+
+struct BlurKernel
+{
+	static constexpr int MAX_RADIUS = 15;
+	alignas( 16 ) int nTaps;
+	// elements of hlsl arrays start on a new register
+	alignas( 16 ) DirectX::XMFLOAT4 coefficients[MAX_RADIUS * 2 + 1];
+	CBUFFER_FIELDS( BlurKernel, CBUFFER_FIELD( nTaps ), CBUFFER_FIELD( coefficients ) )
+};
+
+struct BlurControl
+{
+	alignas( 16 ) BOOL horizontal;
+	CBUFFER_FIELDS( BlurControl, CBUFFER_FIELD( horizontal ) )
+};
@@ -23,6 +23,8 @@
 #include "IronMath.h"
 #include "imgui/imgui.h"
 
+#include <algorithm>
+
 BlurOutlineRenderGraph::BlurOutlineRenderGraph( Graphics& gfx ) :
 	RenderGraph( gfx )
 {
@@ -126,18 +128,19 @@ void BlurOutlineRenderGraph::SetKernelGauss( int radius, float sigma ) IFNOEXCEP
 	assert( radius <= maxRadius );
 	auto k = blurKernel->GetBuffer();
 	const int nTaps = radius * 2 + 1;
-	k["nTaps"] = nTaps;
+	k.Set( k.MakeHandle<int>( "nTaps" ), nTaps );
+	const auto coefficients = k.GetSpan( k.MakeArrayHandle<float>( "coefficients" ) ).Slice( 0u, size_t( nTaps ) );
 	float sum = 0.f;
 	for( int i = 0; i < nTaps; i++ )
 	{
 		const auto x = float( i - radius );
 		const auto g = gauss( x, sigma );
 		sum += g;
-		k["coefficients"][i] = g;
+		coefficients[i] = g;
 	}
-	for( int i = 0; i < nTaps; i++ )
+	for( auto& c : coefficients )
 	{
-		k["coefficients"][i] = (float)k["coefficients"][i] / sum;
+		c /= sum;
 	}
 	blurKernel->SetBuffer( k );
 }
@@ -147,12 +150,9 @@ void BlurOutlineRenderGraph::SetKernelBox( int radius ) IFNOEXCEPT
 	assert( radius <= maxRadius );
 	auto k = blurKernel->GetBuffer();
 	const int nTaps = radius * 2 + 1;
-	k["nTaps"] = nTaps;
-	const float c = 1.f / nTaps;
-	for( int i = 0; i < nTaps; i++ )
-	{
-		k["coefficients"][i] = c;
-	}
+	k.Set( k.MakeHandle<int>( "nTaps" ), nTaps );
+	const auto coefficients = k.GetSpan( k.MakeArrayHandle<float>( "coefficients" ) ).Slice( 0u, size_t( nTaps ) );
+	std::fill( coefficients.begin(), coefficients.end(), 1.f / nTaps );
 	blurKernel->SetBuffer( k );
 }
 
@@ -160,6 +160,7 @@ void BlurOutlineRenderGraph::RenderWindows( Graphics& gfx )
 {
 	RenderShadowWindow( gfx );
 	RenderKernelWindow( gfx );
+	RenderQueueWindow( gfx );
 }
 
 void BlurOutlineRenderGraph::DumpShadowMap( Graphics & gfx, const std::wstring & path )
@@ -226,6 +227,9 @@ void BlurOutlineRenderGraph::RenderKernelWindow( Graphics & gfx )
 				SetKernelBox( radius );
 			}
 		}
+		const auto& uploads = blurKernel->GetUploadStats();
+		ImGui::Text( "Uploads: %zu, %zu skipped, %zu partial with %zu ranges, %zu bytes",
+			uploads.uploads, uploads.skipped, uploads.partialUploads, uploads.ranges, uploads.bytes );
 	}
 	ImGui::End();
 }
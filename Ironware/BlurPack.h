@@ -9,6 +9,7 @@
 #pragma once
 
 #include "BindableCommon.h"
+#include "BlurConstants.h"
 #include "IronMath.h"
 
 #include <imgui/imgui.h>
@@ -126,20 +127,12 @@ private:
 		Gauss,
 		Box
 	};
-	static constexpr int MAX_RADIUS = 15;
+	static constexpr int MAX_RADIUS = BlurKernel::MAX_RADIUS;
 	int radius;
 	float sigma;
 	KernelType kernelType = KernelType::Gauss;
-	struct Kernel
-	{
-		alignas( 16 ) int nTaps;
-		DirectX::XMFLOAT4 coefficients[MAX_RADIUS * 2 + 1];
-	};
-
-	struct Control
-	{
-		alignas( 16 ) BOOL horizontal;
-	};
+	using Kernel = BlurKernel;
+	using Control = BlurControl;
 
 	PixelShader shader;
 	PixelConstantBuffer<Kernel> pcb;
@@ -0,0 +1,61 @@
+/*!
+ * \file BoundingBoxSet.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ *
+ */
+#include "BoundingBoxSet.h"
+
+#include <cassert>
+
+namespace dx = DirectX;
+
+void BoundingBoxSet::Resize( size_t count )
+{
+	size = count;
+	blocks.resize( ( count + BLOCK_SIZE - 1u ) / BLOCK_SIZE, Block{} );
+}
+
+void BoundingBoxSet::Set( size_t i, const dx::XMFLOAT3& center, const dx::XMFLOAT3& extents ) noexcept
+{
+	assert( i < size );
+	auto& b = blocks[i / BLOCK_SIZE];
+	const auto lane = i % BLOCK_SIZE;
+	b.centerX[lane] = center.x;
+	b.centerY[lane] = center.y;
+	b.centerZ[lane] = center.z;
+	b.extentX[lane] = extents.x;
+	b.extentY[lane] = extents.y;
+	b.extentZ[lane] = extents.z;
+}
+
+void BoundingBoxSet::Get( size_t i, dx::XMFLOAT3& center, dx::XMFLOAT3& extents ) const noexcept
+{
+	assert( i < size );
+	const auto& b = blocks[i / BLOCK_SIZE];
+	const auto lane = i % BLOCK_SIZE;
+	center = { b.centerX[lane], b.centerY[lane], b.centerZ[lane] };
+	extents = { b.extentX[lane], b.extentY[lane], b.extentZ[lane] };
+}
+
+void BoundingBoxSet::SetTransformed( size_t i, const dx::XMFLOAT3& localCenter, const dx::XMFLOAT3& localExtents, dx::FXMMATRIX transform ) noexcept
+{
+	// extents of the transformed box are the local extents projected onto the absolute basis vectors
+	const auto extents =
+		dx::XMVectorAdd(
+			dx::XMVectorAdd(
+				dx::XMVectorScale( dx::XMVectorAbs( transform.r[0] ), localExtents.x ),
+				dx::XMVectorScale( dx::XMVectorAbs( transform.r[1] ), localExtents.y )
+			),
+			dx::XMVectorScale( dx::XMVectorAbs( transform.r[2] ), localExtents.z )
+		);
+	const auto center = dx::XMVector3Transform( dx::XMLoadFloat3( &localCenter ), transform );
+
+	dx::XMFLOAT3 c;
+	dx::XMFLOAT3 e;
+	dx::XMStoreFloat3( &c, center );
+	dx::XMStoreFloat3( &e, extents );
+	Set( i, c, e );
+}
@@ -0,0 +1,49 @@
+/*!
+ * \file BoundingBoxSet.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Axis aligned bounding boxes stored in blocks of 4 for SIMD tests
+ *
+ * \note Boxes are kept as center/extents, every block holds the components
+ * of 4 boxes in separate lanes. Lanes past the size of the set are empty.
+ */
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <cstddef>
+#include <vector>
+
+class BoundingBoxSet
+{
+public:
+	static constexpr size_t BLOCK_SIZE = 4u;
+
+	struct alignas( 16 ) Block
+	{
+		float centerX[BLOCK_SIZE];
+		float centerY[BLOCK_SIZE];
+		float centerZ[BLOCK_SIZE];
+		float extentX[BLOCK_SIZE];
+		float extentY[BLOCK_SIZE];
+		float extentZ[BLOCK_SIZE];
+	};
+
+public:
+	void Resize( size_t count );
+	void Set( size_t i, const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents ) noexcept;
+	/**
+	 * @brief Stores box that encloses the given local box after transformation
+	*/
+	void SetTransformed( size_t i, const DirectX::XMFLOAT3& localCenter, const DirectX::XMFLOAT3& localExtents, DirectX::FXMMATRIX transform ) noexcept;
+	void Get( size_t i, DirectX::XMFLOAT3& center, DirectX::XMFLOAT3& extents ) const noexcept;
+	const Block& GetBlock( size_t b ) const noexcept { return blocks[b]; }
+	size_t GetBlockCount() const noexcept { return blocks.size(); }
+	size_t GetSize() const noexcept { return size; }
+
+private:
+	std::vector<Block> blocks;
+	size_t size = 0u;
+};
@@ -0,0 +1,383 @@
+/*!
+ * \file BoundingVolumeHierarchy.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ *
+ */
+#include "BoundingVolumeHierarchy.h"
+#include "Frustum.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <numeric>
+
+namespace dx = DirectX;
+
+namespace
+{
+	using Box = BoundingVolumeHierarchy::Box;
+
+	Box empty_box() noexcept
+	{
+		return { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+	}
+
+	Box merge( const Box& a, const Box& b ) noexcept
+	{
+		return {
+			{ std::min( a.min.x, b.min.x ), std::min( a.min.y, b.min.y ), std::min( a.min.z, b.min.z ) },
+			{ std::max( a.max.x, b.max.x ), std::max( a.max.y, b.max.y ), std::max( a.max.z, b.max.z ) }
+		};
+	}
+
+	Box merge( const Box& a, const dx::XMFLOAT3& p ) noexcept
+	{
+		return merge( a, Box{ p, p } );
+	}
+
+	float surface_area( const Box& b ) noexcept
+	{
+		const float w = b.max.x - b.min.x;
+		const float h = b.max.y - b.min.y;
+		const float d = b.max.z - b.min.z;
+		return 2.f * ( w * h + h * d + d * w );
+	}
+
+	float component( const dx::XMFLOAT3& v, uint32_t axis ) noexcept
+	{
+		return ( &v.x )[axis];
+	}
+
+	void to_center_extents( const Box& b, dx::XMFLOAT3& center, dx::XMFLOAT3& extents ) noexcept
+	{
+		center = { ( b.min.x + b.max.x ) * 0.5f, ( b.min.y + b.max.y ) * 0.5f, ( b.min.z + b.max.z ) * 0.5f };
+		extents = { ( b.max.x - b.min.x ) * 0.5f, ( b.max.y - b.min.y ) * 0.5f, ( b.max.z - b.min.z ) * 0.5f };
+	}
+}
+
+void BoundingVolumeHierarchy::Build( const std::vector<Box>& boxes )
+{
+	using namespace std::chrono;
+	const auto start = steady_clock::now();
+
+	nodes.clear();
+	leafItems.clear();
+	stats.itemCount = boxes.size();
+	if( boxes.empty() )
+	{
+		leafBounds.Resize( 0u );
+		stats.nodeCount = 0u;
+		stats.leafCount = 0u;
+		return;
+	}
+
+	std::vector<dx::XMFLOAT3> centroids( boxes.size() );
+	for( size_t i = 0; i < boxes.size(); i++ )
+	{
+		centroids[i] = {
+			( boxes[i].min.x + boxes[i].max.x ) * 0.5f,
+			( boxes[i].min.y + boxes[i].max.y ) * 0.5f,
+			( boxes[i].min.z + boxes[i].max.z ) * 0.5f
+		};
+	}
+	order.resize( boxes.size() );
+	std::iota( order.begin(), order.end(), 0u );
+
+	nodes.reserve( boxes.size() * 2u );
+	nodes.push_back( {} );
+	Subdivide( 0u, 0u, (uint32_t)boxes.size(), boxes, centroids );
+
+	leafBounds.Resize( leafItems.size() );
+	RefitNodes( boxes );
+	order.clear();
+
+	stats.nodeCount = nodes.size();
+	stats.leafCount = leafItems.size() / LEAF_SIZE;
+	stats.buildTime = duration<float, std::milli>( steady_clock::now() - start ).count();
+}
+
+void BoundingVolumeHierarchy::Refit( const std::vector<Box>& boxes ) noexcept
+{
+	using namespace std::chrono;
+	assert( boxes.size() == stats.itemCount );
+	const auto start = steady_clock::now();
+	RefitNodes( boxes );
+	stats.refitTime = duration<float, std::milli>( steady_clock::now() - start ).count();
+}
+
+void BoundingVolumeHierarchy::Query( const Frustum& frustum, std::vector<uint32_t>& visible ) const
+{
+	if( nodes.empty() )
+	{
+		return;
+	}
+
+	std::vector<uint32_t> stack;
+	stack.reserve( 64u );
+	stack.push_back( 0u );
+	while( !stack.empty() )
+	{
+		const auto nodeIdx = stack.back();
+		stack.pop_back();
+		const auto& node = nodes[nodeIdx];
+
+		dx::XMFLOAT3 center;
+		dx::XMFLOAT3 extents;
+		to_center_extents( node.bounds, center, extents );
+		const auto containment = frustum.Classify( center, extents );
+		if( containment == Frustum::Containment::Outside )
+		{
+			continue;
+		}
+		// nothing below a fully contained node has to be tested
+		if( containment == Frustum::Containment::Inside )
+		{
+			AppendSubtree( nodeIdx, visible );
+			continue;
+		}
+
+		if( node.count != 0u )
+		{
+			const auto mask = frustum.Test( leafBounds.GetBlock( node.first ) );
+			for( uint32_t lane = 0; lane < node.count; lane++ )
+			{
+				if( mask & ( 1u << lane ) )
+				{
+					visible.push_back( leafItems[node.first * LEAF_SIZE + lane] );
+				}
+			}
+		}
+		else
+		{
+			stack.push_back( node.first );
+			stack.push_back( node.first + 1u );
+		}
+	}
+}
+
+std::optional<BoundingVolumeHierarchy::RayHit> BoundingVolumeHierarchy::Raycast( const Ray& ray, float maxDistance ) const noexcept
+{
+	if( nodes.empty() )
+	{
+		return std::nullopt;
+	}
+
+	const auto& o = ray.origin;
+	const dx::XMFLOAT3 invDir = { 1.f / ray.direction.x, 1.f / ray.direction.y, 1.f / ray.direction.z };
+
+	std::optional<RayHit> hit;
+	float closest = maxDistance;
+	std::vector<uint32_t> stack;
+	stack.reserve( 64u );
+	stack.push_back( 0u );
+	while( !stack.empty() )
+	{
+		const auto& node = nodes[stack.back()];
+		stack.pop_back();
+		if( IntersectRay( node.bounds, o, invDir, closest ) == FLT_MAX )
+		{
+			continue;
+		}
+
+		if( node.count != 0u )
+		{
+			for( uint32_t lane = 0; lane < node.count; lane++ )
+			{
+				const auto i = node.first * LEAF_SIZE + lane;
+				dx::XMFLOAT3 c;
+				dx::XMFLOAT3 e;
+				leafBounds.Get( i, c, e );
+				const Box itemBox = { { c.x - e.x, c.y - e.y, c.z - e.z }, { c.x + e.x, c.y + e.y, c.z + e.z } };
+				const float t = IntersectRay( itemBox, o, invDir, closest );
+				if( t < closest )
+				{
+					closest = t;
+					hit = RayHit{ leafItems[i], t };
+				}
+			}
+		}
+		else
+		{
+			// nearer child is pushed last, so it is visited first and shrinks the search distance
+			const float tLeft = IntersectRay( nodes[node.first].bounds, o, invDir, closest );
+			const float tRight = IntersectRay( nodes[node.first + 1u].bounds, o, invDir, closest );
+			const auto nearChild = tLeft <= tRight ? node.first : node.first + 1u;
+			const auto farChild = tLeft <= tRight ? node.first + 1u : node.first;
+			if( std::max( tLeft, tRight ) != FLT_MAX )
+			{
+				stack.push_back( farChild );
+			}
+			if( std::min( tLeft, tRight ) != FLT_MAX )
+			{
+				stack.push_back( nearChild );
+			}
+		}
+	}
+	return hit;
+}
+
+void BoundingVolumeHierarchy::Subdivide( uint32_t nodeIdx, uint32_t begin, uint32_t end, const std::vector<Box>& boxes, const std::vector<dx::XMFLOAT3>& centroids )
+{
+	auto bounds = empty_box();
+	auto centroidBounds = empty_box();
+	for( uint32_t i = begin; i < end; i++ )
+	{
+		bounds = merge( bounds, boxes[order[i]] );
+		centroidBounds = merge( centroidBounds, centroids[order[i]] );
+	}
+	nodes[nodeIdx].bounds = bounds;
+
+	const uint32_t count = end - begin;
+	if( count <= LEAF_SIZE )
+	{
+		MakeLeaf( nodeIdx, begin, end );
+		return;
+	}
+
+	struct Bin
+	{
+		Box bounds = empty_box();
+		uint32_t count = 0u;
+	};
+
+	// binned SAH, split is placed before the bin with index bestSplit
+	uint32_t bestAxis = 3u;
+	uint32_t bestSplit = 0u;
+	float bestCost = FLT_MAX;
+	for( uint32_t axis = 0; axis < 3u; axis++ )
+	{
+		const float lo = component( centroidBounds.min, axis );
+		const float hi = component( centroidBounds.max, axis );
+		if( hi - lo <= FLT_EPSILON )
+		{
+			continue;
+		}
+		const float binScale = BIN_COUNT / ( hi - lo );
+
+		Bin bins[BIN_COUNT];
+		for( uint32_t i = begin; i < end; i++ )
+		{
+			const auto b = std::min( BIN_COUNT - 1u, uint32_t( ( component( centroids[order[i]], axis ) - lo ) * binScale ) );
+			bins[b].count++;
+			bins[b].bounds = merge( bins[b].bounds, boxes[order[i]] );
+		}
+
+		float leftArea[BIN_COUNT - 1u];
+		uint32_t leftCount[BIN_COUNT - 1u];
+		auto acc = empty_box();
+		uint32_t n = 0u;
+		for( uint32_t b = 0; b < BIN_COUNT - 1u; b++ )
+		{
+			acc = merge( acc, bins[b].bounds );
+			n += bins[b].count;
+			leftArea[b] = surface_area( acc );
+			leftCount[b] = n;
+		}
+		acc = empty_box();
+		n = 0u;
+		for( uint32_t b = BIN_COUNT - 1u; b > 0u; b-- )
+		{
+			acc = merge( acc, bins[b].bounds );
+			n += bins[b].count;
+			if( leftCount[b - 1u] == 0u || n == 0u )
+			{
+				continue;
+			}
+			const float cost = leftCount[b - 1u] * leftArea[b - 1u] + n * surface_area( acc );
+			if( cost < bestCost )
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = b;
+			}
+		}
+	}
+
+	uint32_t mid = begin + count / 2u;
+	// centroids that can't be separated are split in halves
+	if( bestAxis < 3u )
+	{
+		const float lo = component( centroidBounds.min, bestAxis );
+		const float binScale = BIN_COUNT / ( component( centroidBounds.max, bestAxis ) - lo );
+		const auto it = std::partition( order.begin() + begin, order.begin() + end, [&]( uint32_t item )
+		{
+			return std::min( BIN_COUNT - 1u, uint32_t( ( component( centroids[item], bestAxis ) - lo ) * binScale ) ) < bestSplit;
+		} );
+		mid = uint32_t( it - order.begin() );
+	}
+
+	const auto children = (uint32_t)nodes.size();
+	nodes.push_back( {} );
+	nodes.push_back( {} );
+	nodes[nodeIdx].first = children;
+	nodes[nodeIdx].count = 0u;
+	Subdivide( children, begin, mid, boxes, centroids );
+	Subdivide( children + 1u, mid, end, boxes, centroids );
+}
+
+void BoundingVolumeHierarchy::MakeLeaf( uint32_t nodeIdx, uint32_t begin, uint32_t end )
+{
+	auto& node = nodes[nodeIdx];
+	node.first = uint32_t( leafItems.size() / LEAF_SIZE );
+	node.count = end - begin;
+	for( uint32_t lane = 0; lane < LEAF_SIZE; lane++ )
+	{
+		leafItems.push_back( lane < node.count ? order[begin + lane] : INVALID_ITEM );
+	}
+}
+
+void BoundingVolumeHierarchy::RefitNodes( const std::vector<Box>& boxes ) noexcept
+{
+	// children follow their parents, walking backwards visits them first
+	for( size_t i = nodes.size(); i-- > 0u; )
+	{
+		auto& node = nodes[i];
+		if( node.count == 0u )
+		{
+			node.bounds = merge( nodes[node.first].bounds, nodes[node.first + 1u].bounds );
+			continue;
+		}
+
+		node.bounds = empty_box();
+		for( uint32_t lane = 0; lane < node.count; lane++ )
+		{
+			const auto slot = node.first * LEAF_SIZE + lane;
+			const auto& box = boxes[leafItems[slot]];
+			node.bounds = merge( node.bounds, box );
+			dx::XMFLOAT3 center;
+			dx::XMFLOAT3 extents;
+			to_center_extents( box, center, extents );
+			leafBounds.Set( slot, center, extents );
+		}
+	}
+}
+
+void BoundingVolumeHierarchy::AppendSubtree( uint32_t nodeIdx, std::vector<uint32_t>& visible ) const
+{
+	const auto& node = nodes[nodeIdx];
+	if( node.count != 0u )
+	{
+		const auto first = leafItems.begin() + node.first * LEAF_SIZE;
+		visible.insert( visible.end(), first, first + node.count );
+		return;
+	}
+	AppendSubtree( node.first, visible );
+	AppendSubtree( node.first + 1u, visible );
+}
+
+float BoundingVolumeHierarchy::IntersectRay( const Box& box, const dx::XMFLOAT3& origin, const dx::XMFLOAT3& invDir, float maxDistance ) noexcept
+{
+	// slab test
+	const float tx1 = ( box.min.x - origin.x ) * invDir.x;
+	const float tx2 = ( box.max.x - origin.x ) * invDir.x;
+	const float ty1 = ( box.min.y - origin.y ) * invDir.y;
+	const float ty2 = ( box.max.y - origin.y ) * invDir.y;
+	const float tz1 = ( box.min.z - origin.z ) * invDir.z;
+	const float tz2 = ( box.max.z - origin.z ) * invDir.z;
+	const float tMin = std::max( { std::min( tx1, tx2 ), std::min( ty1, ty2 ), std::min( tz1, tz2 ), 0.f } );
+	const float tMax = std::min( { std::max( tx1, tx2 ), std::max( ty1, ty2 ), std::max( tz1, tz2 ) } );
+	return ( tMin <= tMax && tMin < maxDistance ) ? tMin : FLT_MAX;
+}
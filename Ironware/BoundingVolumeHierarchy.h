@@ -0,0 +1,103 @@
+/*!
+ * \file BoundingVolumeHierarchy.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Binary AABB hierarchy over indexed items, built with binned SAH
+ *
+ * \note Children are always stored after their parent, so the tree can be refitted
+ * in a single backward pass. Every leaf holds up to 4 items whose boxes are kept
+ * in one BoundingBoxSet block, so leaves are frustum tested with one SIMD test.
+ */
+#pragma once
+
+#include "BoundingBoxSet.h"
+#include "IronMath.h"
+
+#include <DirectXMath.h>
+
+#include <cfloat>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+class Frustum;
+
+class BoundingVolumeHierarchy
+{
+public:
+	struct Box
+	{
+		DirectX::XMFLOAT3 min;
+		DirectX::XMFLOAT3 max;
+	};
+
+	struct RayHit
+	{
+		uint32_t item;
+		float distance;
+	};
+
+	struct Stats
+	{
+		size_t itemCount = 0u;
+		size_t nodeCount = 0u;
+		size_t leafCount = 0u;
+		float buildTime = 0.f;
+		float refitTime = 0.f;
+	};
+
+	static constexpr size_t LEAF_SIZE = BoundingBoxSet::BLOCK_SIZE;
+
+public:
+	/**
+	 * @brief Rebuilds the hierarchy, index of a box in the vector is the item id
+	*/
+	void Build( const std::vector<Box>& boxes );
+	/**
+	 * @brief Updates bounds of the nodes without changing the topology
+	 * @param boxes new boxes of the same items that were used for building
+	*/
+	void Refit( const std::vector<Box>& boxes ) noexcept;
+	/**
+	 * @brief Appends ids of the items whose boxes intersect the frustum
+	*/
+	void Query( const Frustum& frustum, std::vector<uint32_t>& visible ) const;
+	/**
+	 * @brief Finds closest item box hit by the ray
+	*/
+	std::optional<RayHit> Raycast( const Ray& ray, float maxDistance = FLT_MAX ) const noexcept;
+	size_t GetItemCount() const noexcept { return stats.itemCount; }
+	const Stats& GetStats() const noexcept { return stats; }
+
+private:
+	struct Node
+	{
+		Box bounds;
+		// interior: index of the left child, right one follows it; leaf: index of the leaf block
+		uint32_t first;
+		// number of items, 0 for interior nodes
+		uint32_t count;
+	};
+
+private:
+	void Subdivide( uint32_t nodeIdx, uint32_t begin, uint32_t end, const std::vector<Box>& boxes, const std::vector<DirectX::XMFLOAT3>& centroids );
+	void MakeLeaf( uint32_t nodeIdx, uint32_t begin, uint32_t end );
+	void RefitNodes( const std::vector<Box>& boxes ) noexcept;
+	void AppendSubtree( uint32_t nodeIdx, std::vector<uint32_t>& visible ) const;
+	static float IntersectRay( const Box& box, const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& invDir, float maxDistance ) noexcept;
+
+private:
+	static constexpr uint32_t BIN_COUNT = 8u;
+	static constexpr uint32_t INVALID_ITEM = UINT32_MAX;
+
+private:
+	std::vector<Node> nodes;
+	// item ids in build order, temporary while building
+	std::vector<uint32_t> order;
+	// LEAF_SIZE entries per leaf, unused lanes hold INVALID_ITEM
+	std::vector<uint32_t> leafItems;
+	BoundingBoxSet leafBounds;
+	Stats stats;
+};
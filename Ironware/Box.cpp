@@ -63,6 +63,7 @@ Box::Box( Graphics & gfx, float size )
 			auto pvs = VertexShader::Resolve( gfx, L"Shadow_VS.cso" );
 
 			only.AddBindable( InputLayout::Resolve( gfx, layout, *pvs ) );
+			only.SetInstancedShader( gfx, layout, L"ShadowInst_VS.cso" );
 
 			only.AddBindable( std::move( pvs ) );
 
@@ -94,6 +95,7 @@ Box::Box( Graphics & gfx, float size )
 
 			// TODO: better sub-layout generation tech for future consideration maybe
 			mask.AddBindable( InputLayout::Resolve( gfx, layout, *VertexShader::Resolve( gfx, L"Solid_VS.cso" ) ) );
+			mask.SetInstancedShader( gfx, layout, L"SolidInst_VS.cso" );
 
 			mask.AddBindable( std::move( tcb ) );
 
@@ -112,6 +114,7 @@ Box::Box( Graphics & gfx, float size )
 
 			// TODO: better sub-layout generation tech for future consideration maybe
 			draw.AddBindable( InputLayout::Resolve( gfx, layout, *VertexShader::Resolve( gfx, L"Solid_VS.cso" ) ) );
+			draw.SetInstancedShader( gfx, layout, L"SolidInst_VS.cso" );
 
 			draw.AddBindable( std::make_shared<TransformCBuffer>( gfx ) );
 
@@ -128,6 +131,7 @@ Box::Box( Graphics & gfx, float size )
 			RenderStep draw( "shadowMap" );
 
 			draw.AddBindable( InputLayout::Resolve( gfx, layout, *VertexShader::Resolve( gfx, L"Solid_VS.cso" ) ) );
+			draw.SetInstancedShader( gfx, layout, L"SolidInst_VS.cso" );
 
 			draw.AddBindable( std::make_shared<TransformCBuffer>( gfx ) );
 
@@ -137,6 +141,16 @@ Box::Box( Graphics & gfx, float size )
 	}
 }
 
+std::unique_ptr<Box> Box::MakeInstance( const Box& prototype )
+{
+	// the constructor for instances is private, so make_unique can't reach it
+	std::unique_ptr<Box> pBox( new Box );
+	pBox->pos = prototype.pos;
+	pBox->orientation = prototype.orientation;
+	pBox->ShareResources( prototype );
+	return pBox;
+}
+
 DirectX::XMMATRIX Box::GetTransformXM() const noexcept
 {
 	return DirectX::XMMatrixRotationRollPitchYaw( orientation.x, orientation.y, orientation.z ) *
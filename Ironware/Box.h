@@ -17,11 +17,20 @@ class Box : public Drawable
 {
 public:
 	Box( Graphics& gfx, float size );
+	Box( const Box& ) = delete;
+	Box& operator=( const Box& ) = delete;
+	/**
+	 * @brief Box that shares the geometry and the material of the prototype, so both are drawn as instances
+	*/
+	static std::unique_ptr<Box> MakeInstance( const Box& prototype );
 	DirectX::XMMATRIX GetTransformXM() const noexcept override;
 	void SpawnControlWindow( Graphics& gfx, const char* name ) noexcept;
 	void SetPos( const DirectX::XMFLOAT3& pos_in ) noexcept { pos = pos_in; }
 	void SetRotation( const DirectX::XMFLOAT3& orientation_in ) noexcept { orientation = orientation_in; }
 
+private:
+	Box() = default;
+
 private:
 	DirectX::XMFLOAT3 pos = { 0.f, 0.f, 0.f };
 	DirectX::XMFLOAT3 orientation = { 0.f, 0.f, 0.f };
@@ -48,6 +48,17 @@ DirectX::XMMATRIX Camera::GetProjection() const noexcept
 	return projection.GetMatrix();
 }
 
+Ray Camera::GetPickingRay( float ndcX, float ndcY ) const noexcept
+{
+	const auto invViewProj = dx::XMMatrixInverse( nullptr, GetMatrix() * GetProjection() );
+	const auto nearPoint = dx::XMVector3TransformCoord( dx::XMVectorSet( ndcX, ndcY, 0.f, 1.f ), invViewProj );
+	const auto farPoint = dx::XMVector3TransformCoord( dx::XMVectorSet( ndcX, ndcY, 1.f, 1.f ), invViewProj );
+	Ray ray;
+	dx::XMStoreFloat3( &ray.origin, nearPoint );
+	dx::XMStoreFloat3( &ray.direction, dx::XMVector3Normalize( dx::XMVectorSubtract( farPoint, nearPoint ) ) );
+	return ray;
+}
+
 void Camera::SpawnControlWidgets( Graphics& gfx ) noexcept
 {
 	bool rotDirty = false;
@@ -16,6 +16,7 @@
 #include "Projection.h"
 #include "CameraIndicator.h"
 #include "RenderStep.h"
+#include "IronMath.h"
 
 #include <string>
 
@@ -37,6 +38,11 @@ public:
 	void BindToGraphics( Graphics& gfx ) const;
 	DirectX::XMMATRIX GetMatrix() const noexcept;
 	DirectX::XMMATRIX GetProjection() const noexcept;
+	/**
+	 * @brief Ray from the camera through the point of the screen
+	 * @param ndcX, ndcY normalized device coordinates, -1..1 from left to right and bottom to top
+	*/
+	Ray GetPickingRay( float ndcX, float ndcY ) const noexcept;
 	void SpawnControlWidgets( Graphics& gfx ) noexcept;
 	void Rotate( float dx, float dy ) noexcept;
 	void Translate( DirectX::XMFLOAT3 translation ) noexcept;
@@ -70,6 +70,7 @@ CameraIndicator::CameraIndicator( Graphics& gfx )
 
 		auto pvs = VertexShader::Resolve( gfx, L"Solid_VS.cso" );
 		only.AddBindable( InputLayout::Resolve( gfx, vertices.GetLayout(), *pvs ) );
+		only.SetInstancedShader( gfx, vertices.GetLayout(), L"SolidInst_VS.cso" );
 		only.AddBindable( std::move( pvs ) );
 
 		only.AddBindable( PixelShader::Resolve( gfx, L"Solid_PS.cso" ) );
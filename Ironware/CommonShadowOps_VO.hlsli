@@ -3,7 +3,7 @@ cbuffer ShadowTransformCBuf : register( b1 )
     matrix shadowViewProj;
 };
 
-float4 to_shadow_homo_space( const in float3 pos, uniform matrix modelTransform )
+float4 to_shadow_homo_space( const in float3 pos, const in matrix modelTransform )
 {
     const float4 world = mul( float4( pos, 1.f ), modelTransform );
     const float4 shadowHomo = mul( world, shadowViewProj );
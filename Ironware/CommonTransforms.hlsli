@@ -1,6 +1,33 @@
+#ifdef IR_INSTANCED
+// model matrix of every instance is read from the instance buffer, the camera is shared by the draw
+cbuffer InstanceCameraCBuf : register( b2 )
+{
+    matrix view;
+    matrix viewProjection;
+};
+
+static matrix model;
+static matrix modelView;
+static matrix modelViewProjection;
+
+#define IR_INSTANCE_INPUT , float4 instance0 : InstanceTransform0, float4 instance1 : InstanceTransform1, \
+    float4 instance2 : InstanceTransform2, float4 instance3 : InstanceTransform3
+#define IR_LOAD_TRANSFORMS() load_transforms( float4x4( instance0, instance1, instance2, instance3 ) )
+
+void load_transforms( const in matrix instanceModel )
+{
+    model = instanceModel;
+    modelView = mul( model, view );
+    modelViewProjection = mul( model, viewProjection );
+}
+#else
 cbuffer CBuffer : register( b0 )
 {
     matrix model;
     matrix modelView;
     matrix modelViewProjection;
-};
\ No newline at end of file
+};
+
+#define IR_INSTANCE_INPUT
+#define IR_LOAD_TRANSFORMS()
+#endif
\ No newline at end of file
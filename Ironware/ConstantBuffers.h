@@ -17,6 +17,7 @@
 #include "BindableCollection.h"
 #include "GraphicsExceptionMacros.h"
 #include "IronUtils.h"
+#include "ReflectedLayout.h"
 
 /*!
  * \class ConstantBuffer
@@ -62,6 +63,13 @@ public:
 	*/
 	void Update( Graphics& gfx, const C& consts );
 
+private:
+	/**
+	 * @brief Cooks the layout of a reflected struct once in debug builds, so the fields that were checked
+	 * * at compile time also resolve through DynamicLayout to the same offsets
+	*/
+	static void CheckCookedLayout() IFNOEXCEPT;
+
 protected:
 	Microsoft::WRL::ComPtr<ID3D11Buffer> pConstantBuffer;
 	UINT slot;
@@ -87,12 +95,21 @@ class VertexConstantBuffer : public ConstantBuffer<C>
 	using ConstantBuffer<C>::pConstantBuffer;
 	using ConstantBuffer<C>::slot;
 	using Bindable::GetContext;
+	using Bindable::GetStateCache;
 
 public:
 	using ConstantBuffer<C>::ConstantBuffer;
-	void Bind( Graphics& gfx ) IFNOEXCEPT override { GetContext( gfx )->VSSetConstantBuffers( slot, 1u, pConstantBuffer.GetAddressOf() ); }
+	void Bind( Graphics& gfx ) IFNOEXCEPT override
+	{
+		if( GetStateCache( gfx ).Set( PipelineStateCache::Stage::VSConstantBuffer, slot, pConstantBuffer.Get() ) )
+		{
+			GetContext( gfx )->VSSetConstantBuffers( slot, 1u, pConstantBuffer.GetAddressOf() );
+		}
+	}
 	static std::shared_ptr<VertexConstantBuffer> Resolve( Graphics& gfx, const C& consts, UINT slot = 0u ) { return BindableCollection::Resolve<VertexConstantBuffer>( gfx, consts, slot ); }
 	static std::shared_ptr<VertexConstantBuffer> Resolve( Graphics& gfx, UINT slot = 0u ) { return BindableCollection::Resolve<VertexConstantBuffer>( gfx, slot ); }
+	static size_t GenerateKey( const C& consts, UINT slot ) noexcept { return GenerateKey( slot ); }
+	static size_t GenerateKey( UINT slot = 0u ) noexcept { return hash_values( slot ); }
 	static std::wstring GenerateUID( const C& consts, UINT slot ) { return GenerateUID( slot ); }
 	static std::wstring GenerateUID( UINT slot = 0u ) { return GET_CLASS_WNAME( VertexConstantBuffer ) + L"#" + std::to_wstring( slot ); }
 	std::wstring GetUID() const noexcept override { return GenerateUID( slot ); }
@@ -118,12 +135,21 @@ class PixelConstantBuffer : public ConstantBuffer<C>
 	using ConstantBuffer<C>::pConstantBuffer;
 	using ConstantBuffer<C>::slot;
 	using Bindable::GetContext;
+	using Bindable::GetStateCache;
 
 public:
 	using ConstantBuffer<C>::ConstantBuffer;
-	void Bind( Graphics& gfx ) IFNOEXCEPT override { GetContext( gfx )->PSSetConstantBuffers( slot, 1u, pConstantBuffer.GetAddressOf() ); }
+	void Bind( Graphics& gfx ) IFNOEXCEPT override
+	{
+		if( GetStateCache( gfx ).Set( PipelineStateCache::Stage::PSConstantBuffer, slot, pConstantBuffer.Get() ) )
+		{
+			GetContext( gfx )->PSSetConstantBuffers( slot, 1u, pConstantBuffer.GetAddressOf() );
+		}
+	}
 	static std::shared_ptr<PixelConstantBuffer> Resolve( Graphics& gfx, const C& consts, UINT slot = 0u ) { return BindableCollection::Resolve<PixelConstantBuffer<C>>( gfx, consts, slot ); }
 	static std::shared_ptr<PixelConstantBuffer> Resolve( Graphics& gfx, UINT slot = 0u ) { return BindableCollection::Resolve<PixelConstantBuffer<C>>( gfx, slot ); }
+	static size_t GenerateKey( const C& consts, UINT slot ) noexcept { return GenerateKey( slot ); }
+	static size_t GenerateKey( UINT slot = 0u ) noexcept { return hash_values( slot ); }
 	static std::wstring GenerateUID( const C& consts, UINT slot ) { return GenerateUID( slot ); }
 	static std::wstring GenerateUID( UINT slot = 0u ) { return GET_CLASS_WNAME( PixelConstantBuffer ) + L"#" + std::to_wstring( slot ); }
 	std::wstring GetUID() const noexcept override { return GenerateUID( slot ); }
@@ -135,6 +161,8 @@ template<typename C>
 ConstantBuffer<C>::ConstantBuffer( Graphics& gfx, UINT slot ) :
 	slot( slot )
 {
+	static_assert( is_packed_for_hlsl<C>(), "Constant buffer struct isn't packed for hlsl" );
+	CheckCookedLayout();
 	INFOMAN( gfx );
 
 	D3D11_BUFFER_DESC descConstBuffer;
@@ -151,6 +179,8 @@ template<typename C>
 ConstantBuffer<C>::ConstantBuffer( Graphics& gfx, const C& consts, UINT slot ) :
 	slot( slot )
 {
+	static_assert( is_packed_for_hlsl<C>(), "Constant buffer struct isn't packed for hlsl" );
+	CheckCookedLayout();
 	INFOMAN( gfx );
 
 	D3D11_BUFFER_DESC descConstBuffer;
@@ -182,6 +212,19 @@ void ConstantBuffer<C>::Update( Graphics& gfx, const C& consts )
 	// copy the data into subres pData memory
 	memcpy( subresMap.pData, &consts, sizeof( consts ) );
 	GetContext( gfx )->Unmap( pConstantBuffer.Get(), 0u );
+	CountMap( gfx, sizeof( consts ), true );
+}
+
+template<typename C>
+void ConstantBuffer<C>::CheckCookedLayout() IFNOEXCEPT
+{
+#ifndef NDEBUG
+	if constexpr( IsReflected<C>::value )
+	{
+		static const bool matches = ReflectedLayout<C>::MatchesLayout( *ReflectedLayout<C>::Cook().ShareRoot() );
+		assert( "Cooked layout of the constant buffer doesn't match the struct" && matches );
+	}
+#endif
 }
 
 #pragma endregion implementation
\ No newline at end of file
@@ -11,16 +11,41 @@
 void ConstantBufferEx::Update( Graphics & gfx, const Buffer & buf )
 {
 	assert( &buf.GetRootLayoutElement() == &GetRootLayoutElement() );
-	INFOMAN( gfx );
 
-	D3D11_MAPPED_SUBRESOURCE msr;
-	GFX_CALL_THROW_INFO( GetContext( gfx )->Map(
-		pConstantBuffer.Get(), 0u,
-		D3D11_MAP_WRITE_DISCARD, 0u,
-		&msr
-	) );
-	memcpy( msr.pData, buf.GetData(), buf.GetSizeInBytes() );
-	GetContext( gfx )->Unmap( pConstantBuffer.Get(), 0u );
+	GetContext( gfx )->UpdateSubresource( pConstantBuffer.Get(), 0u, nullptr, buf.GetData(), 0u, 0u );
+	CountUpload( gfx, 1u, buf.GetSizeInBytes(), false );
+}
+
+void ConstantBufferEx::UpdateRanges( Graphics& gfx, const Buffer& buf )
+{
+	assert( &buf.GetRootLayoutElement() == &GetRootLayoutElement() );
+
+	const auto& ranges = buf.GetDirtyRanges();
+	if( !pContext1 || ranges.empty() )
+	{
+		Update( gfx, buf );
+		return;
+	}
+	size_t bytes = 0u;
+	const auto write = [&]( size_t begin, size_t end )
+	{
+		// source points at the first byte of the box
+		const D3D11_BOX box = { UINT( begin ), 0u, 0u, UINT( end ), 1u, 1u };
+		pContext1->UpdateSubresource1( pConstantBuffer.Get(), 0u, &box, buf.GetData() + begin, 0u, 0u, 0u );
+		bytes += end - begin;
+	};
+	if( ranges.size() > MAX_RANGES )
+	{
+		// one write that covers all ranges
+		write( ranges.front().begin, ranges.back().end );
+		CountUpload( gfx, 1u, bytes, true );
+		return;
+	}
+	for( const auto& r : ranges )
+	{
+		write( r.begin, r.end );
+	}
+	CountUpload( gfx, ranges.size(), bytes, true );
 }
 
 std::wstring ConstantBufferEx::GetUID() const noexcept
@@ -34,10 +59,11 @@ ConstantBufferEx::ConstantBufferEx( Graphics & gfx, const LayoutElement & layout
 {
 	INFOMAN( gfx );
 
+	// updated with UpdateSubresource, which can write ranges of the buffer unlike a discarding map
 	D3D11_BUFFER_DESC cbd;
 	cbd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	cbd.Usage = D3D11_USAGE_DYNAMIC;
-	cbd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	cbd.Usage = D3D11_USAGE_DEFAULT;
+	cbd.CPUAccessFlags = 0u;
 	cbd.MiscFlags = 0u;
 	cbd.ByteWidth = (UINT)layoutRoot.GetSizeInBytes();
 	cbd.StructureByteStride = 0u;
@@ -52,4 +78,35 @@ ConstantBufferEx::ConstantBufferEx( Graphics & gfx, const LayoutElement & layout
 	{
 		GFX_CALL_THROW_INFO( GetDevice( gfx )->CreateBuffer( &cbd, nullptr, &pConstantBuffer ) );
 	}
+
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	if( SUCCEEDED( GetDevice( gfx )->CheckFeatureSupport( D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof( options ) ) ) &&
+		options.ConstantBufferPartialUpdate )
+	{
+		GetContext( gfx )->QueryInterface( __uuidof( ID3D11DeviceContext1 ), &pContext1 );
+	}
+}
+
+void ConstantBufferEx::CountSkippedUpload() noexcept
+{
+	stats.skipped++;
+	Totals().skipped++;
+}
+
+ConstantBufferEx::UploadStats& ConstantBufferEx::Totals() noexcept
+{
+	static UploadStats totals;
+	return totals;
+}
+
+void ConstantBufferEx::CountUpload( Graphics& gfx, size_t ranges, size_t bytes, bool partial ) noexcept
+{
+	CountMap( gfx, bytes, true );
+	for( auto pStats : { &stats, &Totals() } )
+	{
+		pStats->uploads++;
+		pStats->partialUploads += partial ? 1u : 0u;
+		pStats->ranges += ranges;
+		pStats->bytes += bytes;
+	}
 }
\ No newline at end of file
@@ -17,34 +17,87 @@
 #include "GraphicsExceptionMacros.h"
 #include "DynamicConstantBuffer.h"
 #include "TechniqueProbe.h"
+#include "IronUtils.h"
+
+#include <d3d11_1.h>
+
+#include <string_view>
 
 class ConstantBufferEx : public Bindable
 {
+public:
+	struct UploadStats
+	{
+		size_t uploads = 0u;
+		// uploads that were skipped because the contents had the hash of the last upload
+		size_t skipped = 0u;
+		// uploads of dirty ranges instead of the whole buffer, and the ranges written by them
+		size_t partialUploads = 0u;
+		size_t ranges = 0u;
+		size_t bytes = 0u;
+	};
+
 public:
 	void Update( Graphics& gfx, const Buffer& buf );
+	/**
+	 * @brief Writes the dirty ranges of the buffer only, the whole buffer if the device can't update parts
+	 * * of constant buffers
+	*/
+	void UpdateRanges( Graphics& gfx, const Buffer& buf );
 	virtual const LayoutElement& GetRootLayoutElement() const noexcept = 0;
 	std::wstring GetUID() const noexcept override;
+	const UploadStats& GetUploadStats() const noexcept { return stats; }
+	/**
+	 * @return counters of all extended constant buffers
+	*/
+	static const UploadStats& GetTotalUploadStats() noexcept { return Totals(); }
 
 protected:
 	ConstantBufferEx( Graphics& gfx, const LayoutElement& layoutRoot, UINT slot, const Buffer* pBuf );
+	void CountSkippedUpload() noexcept;
+
+private:
+	static UploadStats& Totals() noexcept;
+	void CountUpload( Graphics& gfx, size_t ranges, size_t bytes, bool partial ) noexcept;
+
+private:
+	// separate writes cost more than the bytes between them past this many ranges
+	static constexpr size_t MAX_RANGES = 4u;
 
 protected:
 	Microsoft::WRL::ComPtr<ID3D11Buffer> pConstantBuffer;
 	UINT slot;
+
+private:
+	// set if the device can update ranges of constant buffers
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext1> pContext1;
+	UploadStats stats;
 };
 
 class PixelConstantBufferEx : public ConstantBufferEx
 {
 public:
 	using ConstantBufferEx::ConstantBufferEx;
-	void Bind( Graphics& gfx ) IFNOEXCEPT override { GetContext( gfx )->PSSetConstantBuffers( slot, 1u, pConstantBuffer.GetAddressOf() ); }
+	void Bind( Graphics& gfx ) IFNOEXCEPT override
+	{
+		if( GetStateCache( gfx ).Set( PipelineStateCache::Stage::PSConstantBuffer, slot, pConstantBuffer.Get() ) )
+		{
+			GetContext( gfx )->PSSetConstantBuffers( slot, 1u, pConstantBuffer.GetAddressOf() );
+		}
+	}
 };
 
 class VertexConstantBufferEx : public ConstantBufferEx
 {
 public:
 	using ConstantBufferEx::ConstantBufferEx;
-	void Bind( Graphics& gfx ) IFNOEXCEPT override { GetContext( gfx )->VSSetConstantBuffers( slot, 1u, pConstantBuffer.GetAddressOf() ); }
+	void Bind( Graphics& gfx ) IFNOEXCEPT override
+	{
+		if( GetStateCache( gfx ).Set( PipelineStateCache::Stage::VSConstantBuffer, slot, pConstantBuffer.Get() ) )
+		{
+			GetContext( gfx )->VSSetConstantBuffers( slot, 1u, pConstantBuffer.GetAddressOf() );
+		}
+	}
 };
 
 template<class T>
@@ -54,17 +107,34 @@ public:
 	CachingConstantBufferEx( Graphics& gfx, const CookedLayout& layout, UINT slot ) :
 		T( gfx, *layout.ShareRoot(), slot, nullptr ),
 		buf( Buffer( layout ) )
-	{}
+	{
+		// contents of the new buffer are undefined until the first bind uploads them
+		buf.MarkDirty( 0u, buf.GetSizeInBytes() );
+	}
 	CachingConstantBufferEx( Graphics& gfx, const Buffer& buf, UINT slot ) :
 		T( gfx, buf.GetRootLayoutElement(), slot, &buf ),
-		buf( buf )
-	{}
+		buf( buf ),
+		uploadedHash( HashContents() )
+	{
+		// the buffer was created with these contents
+		this->buf.ClearDirtyRanges();
+	}
 	void Bind( Graphics& gfx ) IFNOEXCEPT override
 	{
-		if( dirty )
+		if( buf.IsDirty() )
 		{
-			T::Update( gfx, buf );
-			dirty = false;
+			// values that were written back to what was uploaded don't need an upload
+			const auto hash = HashContents();
+			if( hash == uploadedHash )
+			{
+				T::CountSkippedUpload();
+			}
+			else
+			{
+				T::UpdateRanges( gfx, buf );
+				uploadedHash = hash;
+			}
+			buf.ClearDirtyRanges();
 		}
 		T::Bind( gfx );
 	}
@@ -72,14 +142,22 @@ public:
 	void SetBuffer( const Buffer& buf_in )
 	{
 		buf.CopyFrom( buf_in );
-		dirty = true;
+	}
+	/**
+	 * @brief Copies a C++ struct with the packing of the layout, registers that changed are uploaded on the next bind
+	*/
+	void SetData( const void* pData, size_t size ) IFNOEXCEPT
+	{
+		buf.CopyFrom( pData, size );
 	}
 
 	void Accept( TechniqueProbe& probe ) override
 	{
+		// probes write through references, so what they changed is found by comparing with a copy
+		const Buffer previous = buf;
 		if( probe.VisitBuffer( buf ) )
 		{
-			dirty = true;
+			buf.MarkChangedSince( previous );
 		}
 	}
 
@@ -87,8 +165,14 @@ public:
 	const Buffer& GetBuffer() const noexcept { return buf; }
 
 private:
-	bool dirty = false;
+	uint64_t HashContents() const noexcept
+	{
+		return hash_fnv1a( { reinterpret_cast<const char*>( buf.GetData() ), buf.GetSizeInBytes() } );
+	}
+
+private:
 	Buffer buf;
+	uint64_t uploadedHash = 0u;
 };
 
 using CachingPixelConstantBufferEx = CachingConstantBufferEx<PixelConstantBufferEx>;
@@ -0,0 +1,218 @@
+/*!
+ * \file ConstantUploadRing.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ *
+ */
+#include "ConstantUploadRing.h"
+#include "GraphicsExceptionMacros.h"
+
+#include <cassert>
+#include <cstring>
+#include <thread>
+
+ConstantUploadRing::ConstantUploadRing( Graphics& gfx, size_t capacity ) :
+	ring( capacity, ALIGNMENT )
+{
+	INFOMAN( gfx );
+
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	if( FAILED( GetDevice( gfx )->CheckFeatureSupport( D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof( options ) ) ) ||
+		!options.ConstantBufferOffsetting || !options.MapNoOverwriteOnDynamicConstantBuffer ||
+		FAILED( GetContext( gfx )->QueryInterface( __uuidof( ID3D11DeviceContext1 ), &pContext1 ) ) )
+	{
+		return;
+	}
+	supported = true;
+
+	CreateBuffer( gfx );
+	D3D11_QUERY_DESC descQuery = {};
+	descQuery.Query = D3D11_QUERY_EVENT;
+	for( auto& q : queries )
+	{
+		GFX_CALL_THROW_INFO( GetDevice( gfx )->CreateQuery( &descQuery, &q ) );
+	}
+}
+
+ConstantUploadRing::Ticket ConstantUploadRing::Stage( const void* pData, size_t size )
+{
+	Ticket ticket;
+	ticket.flush = stagingId;
+	ticket.offset = UINT( staging.size() );
+	ticket.size = UINT( size );
+	staging.resize( staging.size() + ( size + ALIGNMENT - 1u ) / ALIGNMENT * ALIGNMENT );
+	std::memcpy( staging.data() + ticket.offset, pData, size );
+	stagedWrites++;
+	return ticket;
+}
+
+void ConstantUploadRing::Flush( Graphics& gfx )
+{
+	if( !staging.empty() )
+	{
+		flushBase = Allocate( gfx, staging.size() );
+		Upload( gfx, flushBase, staging.data(), staging.size() );
+		staging.clear();
+		flushes++;
+	}
+	flushedId = stagingId++;
+}
+
+ConstantUploadRing::Range ConstantUploadRing::GetRange( const Ticket& ticket ) const noexcept
+{
+	assert( IsFlushed( ticket ) );
+	return MakeRange( flushBase + ticket.offset, ticket.size );
+}
+
+ConstantUploadRing::Range ConstantUploadRing::Write( Graphics& gfx, const void* pData, size_t size )
+{
+	const auto offset = Allocate( gfx, size );
+	Upload( gfx, offset, pData, size );
+	immediateWrites++;
+	return MakeRange( offset, size );
+}
+
+void ConstantUploadRing::BindVS( Graphics& gfx, UINT slot, Range range ) IFNOEXCEPT
+{
+	if( GetStateCache( gfx ).Set( PipelineStateCache::Stage::VSConstantBuffer, slot, pBuffer.Get(),
+		( uint64_t( range.firstConstant ) << 32u ) | range.numConstants ) )
+	{
+		pContext1->VSSetConstantBuffers1( slot, 1u, pBuffer.GetAddressOf(), &range.firstConstant, &range.numConstants );
+	}
+}
+
+void ConstantUploadRing::BindPS( Graphics& gfx, UINT slot, Range range ) IFNOEXCEPT
+{
+	if( GetStateCache( gfx ).Set( PipelineStateCache::Stage::PSConstantBuffer, slot, pBuffer.Get(),
+		( uint64_t( range.firstConstant ) << 32u ) | range.numConstants ) )
+	{
+		pContext1->PSSetConstantBuffers1( slot, 1u, pBuffer.GetAddressOf(), &range.firstConstant, &range.numConstants );
+	}
+}
+
+void ConstantUploadRing::EndFrame( Graphics& gfx )
+{
+	lastFrameBytes = frameBytes;
+	frameBytes = 0u;
+	if( !supported )
+	{
+		return;
+	}
+	RetireFinished( gfx );
+	// the query of the frame is still taken by a frame in flight
+	if( frame - retiredFrame > MAX_FRAMES )
+	{
+		WaitFrame( gfx, frame - MAX_FRAMES );
+		ring.Retire( retiredFrame );
+	}
+	GetContext( gfx )->End( queries[frame % MAX_FRAMES].Get() );
+	ring.EndFrame( frame );
+	frame++;
+}
+
+ConstantUploadRing::Stats ConstantUploadRing::GetStats() const noexcept
+{
+	Stats stats;
+	stats.ring = ring.GetStats();
+	stats.frameBytes = lastFrameBytes;
+	stats.flushes = flushes;
+	stats.stagedWrites = stagedWrites;
+	stats.immediateWrites = immediateWrites;
+	stats.growths = growths;
+	return stats;
+}
+
+void ConstantUploadRing::CreateBuffer( Graphics& gfx )
+{
+	INFOMAN( gfx );
+
+	D3D11_BUFFER_DESC descBuffer = {};
+	descBuffer.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	descBuffer.Usage = D3D11_USAGE_DYNAMIC;
+	descBuffer.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	descBuffer.MiscFlags = 0u;
+	descBuffer.ByteWidth = UINT( ring.GetCapacity() );
+	descBuffer.StructureByteStride = 0u;
+	GFX_CALL_THROW_INFO( GetDevice( gfx )->CreateBuffer( &descBuffer, nullptr, &pBuffer ) );
+	discardNext = true;
+	// the new buffer may have the address of a released one
+	GetStateCache( gfx ).Invalidate( PipelineStateCache::Stage::VSConstantBuffer );
+	GetStateCache( gfx ).Invalidate( PipelineStateCache::Stage::PSConstantBuffer );
+}
+
+size_t ConstantUploadRing::Allocate( Graphics& gfx, size_t size )
+{
+	RetireFinished( gfx );
+	const size_t aligned = ( size + ALIGNMENT - 1u ) / ALIGNMENT * ALIGNMENT;
+	auto offset = aligned <= ring.GetCapacity() ?
+		ring.AllocateWaiting( aligned, [&]( uint64_t f ) { WaitFrame( gfx, f ); } ) :
+		UploadRing::NO_SPACE;
+	if( offset == UploadRing::NO_SPACE )
+	{
+		// the frame alone needs more than the ring, frames in flight keep reading the old buffer,
+		// which d3d keeps alive until they're done
+		size_t capacity = ring.GetCapacity() * 2u;
+		while( capacity < aligned )
+		{
+			capacity *= 2u;
+		}
+		ring.Reset( capacity );
+		CreateBuffer( gfx );
+		// ranges of the last flush are in the old buffer
+		flushedId = 0u;
+		growths++;
+		offset = ring.Allocate( aligned );
+	}
+	return offset;
+}
+
+void ConstantUploadRing::Upload( Graphics& gfx, size_t offset, const void* pData, size_t size )
+{
+	INFOMAN( gfx );
+
+	// space that the gpu may still read is never handed out, so nothing has to be waited for
+	D3D11_MAPPED_SUBRESOURCE subresMap;
+	GFX_CALL_THROW_INFO( GetContext( gfx )->Map(
+		pBuffer.Get(), 0u,
+		discardNext ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, 0u,
+		&subresMap
+	) );
+	std::memcpy( static_cast<std::byte*>( subresMap.pData ) + offset, pData, size );
+	GetContext( gfx )->Unmap( pBuffer.Get(), 0u );
+	discardNext = false;
+	CountMap( gfx, size, true );
+	frameBytes += size;
+}
+
+ConstantUploadRing::Range ConstantUploadRing::MakeRange( size_t offset, size_t size ) const noexcept
+{
+	Range range;
+	range.firstConstant = UINT( offset / 16u );
+	range.numConstants = UINT( ( size + ALIGNMENT - 1u ) / ALIGNMENT * ALIGNMENT / 16u );
+	return range;
+}
+
+void ConstantUploadRing::RetireFinished( Graphics& gfx )
+{
+	while( retiredFrame + 1u < frame &&
+		GetContext( gfx )->GetData( queries[( retiredFrame + 1u ) % MAX_FRAMES].Get(), nullptr, 0u, D3D11_ASYNC_GETDATA_DONOTFLUSH ) == S_OK )
+	{
+		retiredFrame++;
+	}
+	ring.Retire( retiredFrame );
+}
+
+void ConstantUploadRing::WaitFrame( Graphics& gfx, uint64_t frame_in )
+{
+	while( retiredFrame < frame_in )
+	{
+		// without the flag the context submits its commands, so the query is bound to be reached
+		while( GetContext( gfx )->GetData( queries[( retiredFrame + 1u ) % MAX_FRAMES].Get(), nullptr, 0u, 0u ) == S_FALSE )
+		{
+			std::this_thread::yield();
+		}
+		retiredFrame++;
+	}
+}
@@ -0,0 +1,136 @@
+/*!
+ * \file ConstantUploadRing.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Header file that contains ConstantUploadRing, one large dynamic constant buffer that per draw constants
+ * * of the frame are written into linearly
+ *
+ * \note Passes stage the constants of their draws first and upload them with a single map, draws then bind
+ * * their range with VSSetConstantBuffers1. Constants that weren't staged are written with a map of their own.
+ * * Space of a frame is given back when its event query has passed, a full ring waits for the oldest one.
+ * * Needs constant buffer offsetting of d3d 11.1, without it bindables keep their own buffers.
+*/
+#pragma once
+
+#include "GraphicsResource.h"
+#include "UploadRing.h"
+
+#include <d3d11_1.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+class ConstantUploadRing : public GraphicsResource
+{
+public:
+	// first constant and constant count of a bind are multiples of 16 constants
+	static constexpr size_t ALIGNMENT = 256u;
+	static constexpr size_t DEFAULT_CAPACITY = 4u * 1024u * 1024u;
+
+	/**
+	 * @brief Range of the ring in 16 byte constants
+	*/
+	struct Range
+	{
+		UINT firstConstant = 0u;
+		UINT numConstants = 0u;
+	};
+
+	/**
+	 * @brief Staged constants, valid for binding until the next flush
+	*/
+	struct Ticket
+	{
+		// id of the flush that uploads the constants, 0 for none
+		uint64_t flush = 0u;
+		UINT offset = 0u;
+		UINT size = 0u;
+	};
+
+	struct Stats
+	{
+		UploadRing::Stats ring;
+		// of the previous frame
+		size_t frameBytes = 0u;
+		size_t flushes = 0u;
+		size_t stagedWrites = 0u;
+		size_t immediateWrites = 0u;
+		size_t growths = 0u;
+	};
+
+public:
+	ConstantUploadRing( Graphics& gfx, size_t capacity = DEFAULT_CAPACITY );
+	/**
+	 * @return false if the device can't bind ranges of constant buffers or the ring was disabled
+	*/
+	bool IsActive() const noexcept { return supported && enabled; }
+	bool IsSupported() const noexcept { return supported; }
+	void SetEnabled( bool enabled_in ) noexcept { enabled = enabled_in; }
+	/**
+	 * @brief Copies the constants to the staging memory of the pass, nothing is mapped
+	*/
+	Ticket Stage( const void* pData, size_t size );
+	/**
+	 * @brief Uploads all constants staged since the last flush with a single map
+	*/
+	void Flush( Graphics& gfx );
+	/**
+	 * @return true if the ticket was uploaded by the last flush
+	*/
+	bool IsFlushed( const Ticket& ticket ) const noexcept { return ticket.flush != 0u && ticket.flush == flushedId; }
+	Range GetRange( const Ticket& ticket ) const noexcept;
+	/**
+	 * @brief Uploads the constants of a single bind with a map of their own
+	*/
+	Range Write( Graphics& gfx, const void* pData, size_t size );
+	void BindVS( Graphics& gfx, UINT slot, Range range ) IFNOEXCEPT;
+	void BindPS( Graphics& gfx, UINT slot, Range range ) IFNOEXCEPT;
+	/**
+	 * @brief Closes the space of the frame under a new query, has to be called after the last draw of the frame
+	*/
+	void EndFrame( Graphics& gfx );
+	Stats GetStats() const noexcept;
+
+private:
+	void CreateBuffer( Graphics& gfx );
+	/**
+	 * @brief Takes space for the size, the ring grows if it can't hold that much even when it's empty
+	*/
+	size_t Allocate( Graphics& gfx, size_t size );
+	void Upload( Graphics& gfx, size_t offset, const void* pData, size_t size );
+	Range MakeRange( size_t offset, size_t size ) const noexcept;
+	/**
+	 * @brief Gives back the space of the frames whose queries have passed
+	*/
+	void RetireFinished( Graphics& gfx );
+	void WaitFrame( Graphics& gfx, uint64_t frame );
+
+private:
+	// frames that can be in flight before the oldest one is waited for
+	static constexpr size_t MAX_FRAMES = 4u;
+
+private:
+	bool supported = false;
+	bool enabled = true;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext1> pContext1;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> pBuffer;
+	// the first map of a new buffer discards, the space of the ring is guarded by queries after that
+	bool discardNext = true;
+	UploadRing ring;
+	std::array<Microsoft::WRL::ComPtr<ID3D11Query>, MAX_FRAMES> queries;
+	uint64_t frame = 1u;
+	uint64_t retiredFrame = 0u;
+	std::vector<std::byte> staging;
+	uint64_t stagingId = 1u;
+	uint64_t flushedId = 0u;
+	size_t flushBase = 0u;
+	size_t frameBytes = 0u;
+	size_t lastFrameBytes = 0u;
+	size_t flushes = 0u;
+	size_t stagedWrites = 0u;
+	size_t immediateWrites = 0u;
+	size_t growths = 0u;
+};
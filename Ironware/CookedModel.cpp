@@ -0,0 +1,656 @@
+/*!
+ * \file CookedModel.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ *
+ */
+#include "IronWin.h"
+#include "CookedModel.h"
+#include "ModelException.h"
+#include "IronUtils.h"
+#include "GeometryHeap.h"
+#include "TransformHierarchy.h"
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+struct CookedModel::StringRef
+{
+	// byte range in the string section
+	uint32_t offset;
+	uint32_t length;
+};
+
+struct CookedModel::Header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t sourceHash;
+	uint64_t fileSize;
+	uint32_t materialCount;
+	uint32_t meshCount;
+	uint32_t nodeCount;
+	uint32_t nodeMeshCount;
+	uint32_t dependencyCount;
+	// keeps the offsets 8 byte aligned
+	uint32_t padding;
+	uint64_t materialOffset;
+	uint64_t meshOffset;
+	uint64_t nodeOffset;
+	uint64_t nodeMeshOffset;
+	// string refs of the paths of the files that the import opened
+	uint64_t dependencyOffset;
+	uint64_t stringOffset;
+	uint64_t stringSize;
+};
+
+struct CookedModel::MaterialRecord
+{
+	StringRef name;
+	StringRef diffusePath;
+	StringRef specularPath;
+	StringRef normalPath;
+	DirectX::XMFLOAT3 materialColor;
+	DirectX::XMFLOAT3 specularColor;
+	float specularGloss;
+	uint32_t hasPaths;
+};
+
+struct CookedModel::MeshRecord
+{
+	StringRef tag;
+	uint32_t materialIndex;
+	uint32_t indexCount;
+	uint64_t layoutHash;
+	uint64_t vertexOffset;
+	uint64_t vertexBytes;
+	uint64_t indexOffset;
+	DirectX::XMFLOAT3 boundsCenter;
+	DirectX::XMFLOAT3 boundsExtents;
+	uint32_t indexFormat;
+	uint32_t lodCount;
+	Drawable::Lod lods[Mesh::MAX_LOD_COUNT];
+	uint32_t meshletCount;
+	uint64_t meshletOffset;
+};
+
+struct CookedModel::NodeRecord
+{
+	StringRef name;
+	uint32_t parent;
+	// range in the node mesh section
+	uint32_t firstMesh;
+	uint32_t meshCount;
+	DirectX::XMFLOAT4X4 transform;
+};
+
+namespace
+{
+	enum PathBits : uint32_t
+	{
+		DIFFUSE_PATH = 1u << 0,
+		SPECULAR_PATH = 1u << 1,
+		NORMAL_PATH = 1u << 2
+	};
+
+	uint64_t align_up( uint64_t value, uint64_t alignment ) noexcept
+	{
+		return ( value + alignment - 1u ) / alignment * alignment;
+	}
+
+	/**
+	 * @brief Combines the size and write time of the file into the hash
+	 * @return false if the file doesn't exist anymore
+	*/
+	bool hash_file_stamp( size_t& seed, const std::filesystem::path& path )
+	{
+		// size and write time stand in for the contents, hashing the whole source on
+		// every load would cost as much as a good part of the import
+		std::error_code ec;
+		const auto fileSize = std::filesystem::file_size( path, ec );
+		if( ec )
+		{
+			return false;
+		}
+		const auto writeTime = std::filesystem::last_write_time( path, ec );
+		if( ec )
+		{
+			return false;
+		}
+		hash_combine( seed, fileSize );
+		hash_combine( seed, writeTime.time_since_epoch().count() );
+		return true;
+	}
+}
+
+Assimp::IOStream* CookedModel::RecordingIOSystem::Open( const char* pFile, const char* pMode )
+{
+	auto pStream = DefaultIOSystem::Open( pFile, pMode );
+	if( pStream && std::find( openedFiles.begin(), openedFiles.end(), pFile ) == openedFiles.end() )
+	{
+		openedFiles.emplace_back( pFile );
+	}
+	return pStream;
+}
+
+const CookedModel::RecordingIOSystem& CookedModel::RecordDependencies( Assimp::Importer& importer )
+{
+	auto pIOSystem = new RecordingIOSystem;
+	importer.SetIOHandler( pIOSystem );
+	return *pIOSystem;
+}
+
+std::unique_ptr<CookedModel> CookedModel::Open( const std::wstring& sourcePath, float scale )
+{
+	std::unique_ptr<CookedModel> pCooked( new CookedModel );
+	pCooked->hFile = CreateFileW( MakeCachePath( sourcePath ).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+	if( pCooked->hFile == INVALID_HANDLE_VALUE )
+	{
+		pCooked->hFile = nullptr;
+		return nullptr;
+	}
+	LARGE_INTEGER fileSize = {};
+	if( !GetFileSizeEx( pCooked->hFile, &fileSize ) || (uint64_t)fileSize.QuadPart < sizeof( Header ) )
+	{
+		return nullptr;
+	}
+	pCooked->hMapping = CreateFileMappingW( pCooked->hFile, nullptr, PAGE_READONLY, 0u, 0u, nullptr );
+	if( !pCooked->hMapping )
+	{
+		return nullptr;
+	}
+	pCooked->pBase = static_cast<const std::byte*>( MapViewOfFile( pCooked->hMapping, FILE_MAP_READ, 0u, 0u, 0u ) );
+	if( !pCooked->pBase )
+	{
+		return nullptr;
+	}
+	pCooked->size = (size_t)fileSize.QuadPart;
+
+	const auto& header = pCooked->GetHeader();
+	// the dependencies are read from the file, so it's validated before the hash is compared
+	if( header.magic != MAGIC || header.version != VERSION || header.fileSize != pCooked->size ||
+		!pCooked->Validate( sourcePath ) || header.sourceHash != HashSource( sourcePath, scale, pCooked->GetDependencies() ) )
+	{
+		return nullptr;
+	}
+	return pCooked;
+}
+
+bool CookedModel::Write( const std::wstring& sourcePath, float scale, const std::vector<std::string>& dependencies,
+	const std::vector<Material::Desc>& materials, const std::vector<MeshSource>& meshes, const std::vector<Model::NodeDesc>& nodes )
+{
+	std::vector<std::byte> strings;
+	const auto addString = [&strings]( const void* pData, size_t bytes )
+	{
+		const StringRef ref = { (uint32_t)strings.size(), (uint32_t)bytes };
+		const auto pBytes = static_cast<const std::byte*>( pData );
+		strings.insert( strings.end(), pBytes, pBytes + bytes );
+		return ref;
+	};
+	const auto addWide = [&addString]( const std::wstring& s )
+	{
+		return addString( s.data(), s.size() * sizeof( wchar_t ) );
+	};
+
+	std::vector<MaterialRecord> materialRecords;
+	for( const auto& desc : materials )
+	{
+		MaterialRecord r = {};
+		r.name = addWide( desc.name );
+		r.hasPaths = ( desc.diffusePath ? DIFFUSE_PATH : 0u ) | ( desc.specularPath ? SPECULAR_PATH : 0u ) | ( desc.normalPath ? NORMAL_PATH : 0u );
+		r.diffusePath = addWide( desc.diffusePath.value_or( L"" ) );
+		r.specularPath = addWide( desc.specularPath.value_or( L"" ) );
+		r.normalPath = addWide( desc.normalPath.value_or( L"" ) );
+		r.materialColor = desc.materialColor;
+		r.specularColor = desc.specularColor;
+		r.specularGloss = desc.specularGloss;
+		materialRecords.push_back( r );
+	}
+
+	std::vector<NodeRecord> nodeRecords;
+	std::vector<uint32_t> nodeMeshes;
+	for( const auto& node : nodes )
+	{
+		NodeRecord r = {};
+		r.name = addString( node.name.data(), node.name.size() );
+		r.parent = node.parent;
+		r.firstMesh = (uint32_t)nodeMeshes.size();
+		r.meshCount = (uint32_t)node.meshes.size();
+		r.transform = node.transform;
+		nodeMeshes.insert( nodeMeshes.end(), node.meshes.begin(), node.meshes.end() );
+		nodeRecords.push_back( r );
+	}
+
+	std::vector<StringRef> dependencyRecords;
+	for( const auto& d : dependencies )
+	{
+		dependencyRecords.push_back( addString( d.data(), d.size() ) );
+	}
+
+	std::vector<MeshRecord> meshRecords;
+	for( const auto& m : meshes )
+	{
+		MeshRecord r = {};
+		r.tag = addWide( m.pData->tag );
+		r.materialIndex = m.materialIndex;
+		r.indexCount = (uint32_t)m.pData->indices.Count();
+		r.indexFormat = (uint32_t)m.pData->indices.GetFormat();
+		r.lodCount = (uint32_t)m.pData->lods.size();
+		std::copy( m.pData->lods.begin(), m.pData->lods.end(), r.lods );
+		r.meshletCount = (uint32_t)m.pData->meshlets.size();
+		r.layoutHash = m.pData->vertices.GetLayout().GetHash();
+		r.vertexBytes = m.pData->vertices.SizeBytes();
+		r.boundsCenter = m.pData->boundsCenter;
+		r.boundsExtents = m.pData->boundsExtents;
+		meshRecords.push_back( r );
+	}
+
+	// sections follow each other in the order of the header, each of them aligned
+	Header header = {};
+	header.magic = MAGIC;
+	header.version = VERSION;
+	header.sourceHash = HashSource( sourcePath, scale, dependencies );
+	header.materialCount = (uint32_t)materialRecords.size();
+	header.meshCount = (uint32_t)meshRecords.size();
+	header.nodeCount = (uint32_t)nodeRecords.size();
+	header.nodeMeshCount = (uint32_t)nodeMeshes.size();
+	header.dependencyCount = (uint32_t)dependencyRecords.size();
+	header.materialOffset = align_up( sizeof( Header ), DATA_ALIGNMENT );
+	header.meshOffset = align_up( header.materialOffset + sizeof( MaterialRecord ) * materialRecords.size(), DATA_ALIGNMENT );
+	header.nodeOffset = align_up( header.meshOffset + sizeof( MeshRecord ) * meshRecords.size(), DATA_ALIGNMENT );
+	header.nodeMeshOffset = align_up( header.nodeOffset + sizeof( NodeRecord ) * nodeRecords.size(), DATA_ALIGNMENT );
+	header.dependencyOffset = align_up( header.nodeMeshOffset + sizeof( uint32_t ) * nodeMeshes.size(), DATA_ALIGNMENT );
+	header.stringOffset = align_up( header.dependencyOffset + sizeof( StringRef ) * dependencyRecords.size(), DATA_ALIGNMENT );
+	header.stringSize = strings.size();
+	uint64_t offset = header.stringOffset + strings.size();
+	for( auto& r : meshRecords )
+	{
+		r.vertexOffset = align_up( offset, DATA_ALIGNMENT );
+		r.indexOffset = align_up( r.vertexOffset + r.vertexBytes, DATA_ALIGNMENT );
+		r.meshletOffset = align_up( r.indexOffset + IndexByteBuffer::SizeOf( (IndexByteBuffer::Format)r.indexFormat ) * r.indexCount, DATA_ALIGNMENT );
+		offset = r.meshletOffset + sizeof( MeshletSet::Meshlet ) * r.meshletCount;
+	}
+	header.fileSize = offset;
+
+	// written next to the cooked file and moved over it, so a reader never sees a partial file
+	const auto cachePath = MakeCachePath( sourcePath );
+	const auto tempPath = cachePath + L".tmp";
+	{
+		std::ofstream file( tempPath, std::ios::binary | std::ios::trunc );
+		if( !file )
+		{
+			return false;
+		}
+		const auto writeAt = [&file]( uint64_t at, const void* pData, size_t bytes )
+		{
+			for( auto pos = (uint64_t)file.tellp(); pos < at; pos++ )
+			{
+				file.put( '\0' );
+			}
+			file.write( static_cast<const char*>( pData ), (std::streamsize)bytes );
+		};
+		writeAt( 0u, &header, sizeof( header ) );
+		writeAt( header.materialOffset, materialRecords.data(), sizeof( MaterialRecord ) * materialRecords.size() );
+		writeAt( header.meshOffset, meshRecords.data(), sizeof( MeshRecord ) * meshRecords.size() );
+		writeAt( header.nodeOffset, nodeRecords.data(), sizeof( NodeRecord ) * nodeRecords.size() );
+		writeAt( header.nodeMeshOffset, nodeMeshes.data(), sizeof( uint32_t ) * nodeMeshes.size() );
+		writeAt( header.dependencyOffset, dependencyRecords.data(), sizeof( StringRef ) * dependencyRecords.size() );
+		writeAt( header.stringOffset, strings.data(), strings.size() );
+		for( size_t i = 0; i < meshes.size(); i++ )
+		{
+			const auto& data = *meshes[i].pData;
+			writeAt( meshRecords[i].vertexOffset, data.vertices.GetData(), data.vertices.SizeBytes() );
+			writeAt( meshRecords[i].indexOffset, data.indices.GetData(), data.indices.SizeBytes() );
+			writeAt( meshRecords[i].meshletOffset, data.meshlets.data(), sizeof( MeshletSet::Meshlet ) * data.meshlets.size() );
+		}
+		if( !file )
+		{
+			return false;
+		}
+	}
+	std::error_code ec;
+	std::filesystem::rename( tempPath, cachePath, ec );
+	if( ec )
+	{
+		std::filesystem::remove( tempPath, ec );
+		return false;
+	}
+	return true;
+}
+
+CookedModel::BenchmarkStats CookedModel::Benchmark( const std::wstring& sourcePath, float scale )
+{
+	using namespace std::chrono;
+	BenchmarkStats stats;
+
+	auto start = steady_clock::now();
+	Assimp::Importer importer;
+	const auto& io = RecordDependencies( importer );
+	const auto pScene = importer.ReadFile(
+		to_narrow( sourcePath ),
+		aiProcess_Triangulate |
+		aiProcess_JoinIdenticalVertices |
+		aiProcess_ConvertToLeftHanded |
+		aiProcess_GenNormals |
+		aiProcess_CalcTangentSpace
+	);
+	if( !pScene )
+	{
+		throw ModelException( __LINE__, WFILE, importer.GetErrorString() );
+	}
+	std::vector<Material> materials;
+	materials.reserve( pScene->mNumMaterials );
+	for( size_t i = 0; i < pScene->mNumMaterials; i++ )
+	{
+		materials.emplace_back( *pScene->mMaterials[i], sourcePath );
+	}
+	std::vector<Mesh::Data> meshData;
+	meshData.reserve( pScene->mNumMeshes );
+	for( size_t i = 0; i < pScene->mNumMeshes; i++ )
+	{
+		const auto& mesh = *pScene->mMeshes[i];
+		meshData.push_back( Mesh::Extract( materials[mesh.mMaterialIndex], mesh, scale ) );
+	}
+	const auto nodes = Model::FlattenNodes( *pScene->mRootNode );
+	stats.importTime = duration<float, std::milli>( steady_clock::now() - start ).count();
+
+	if( !Open( sourcePath, scale ) )
+	{
+		std::vector<Material::Desc> descs;
+		for( const auto& m : materials )
+		{
+			descs.push_back( m.GetDesc() );
+		}
+		std::vector<MeshSource> sources;
+		for( size_t i = 0; i < meshData.size(); i++ )
+		{
+			sources.push_back( { &meshData[i], pScene->mMeshes[i]->mMaterialIndex } );
+		}
+		Write( sourcePath, scale, io.GetOpenedFiles(), descs, sources, nodes );
+	}
+
+	// everything the loader reads before creating the buffers
+	start = steady_clock::now();
+	if( const auto pCooked = Open( sourcePath, scale ) )
+	{
+		for( size_t i = 0; i < pCooked->GetMaterialCount(); i++ )
+		{
+			const Material mat( pCooked->GetMaterialDesc( i ), sourcePath );
+		}
+		for( size_t i = 0; i < pCooked->GetMeshCount(); i++ )
+		{
+			stats.vertexBytes += pCooked->GetMesh( i ).vertexBytes;
+		}
+		stats.meshCount = pCooked->GetMeshCount();
+		pCooked->GetNodes();
+	}
+	stats.cookedTime = duration<float, std::milli>( steady_clock::now() - start ).count();
+	return stats;
+}
+
+CookedModel::~CookedModel() noexcept
+{
+	if( pBase )
+	{
+		UnmapViewOfFile( pBase );
+	}
+	if( hMapping )
+	{
+		CloseHandle( hMapping );
+	}
+	if( hFile )
+	{
+		CloseHandle( hFile );
+	}
+}
+
+size_t CookedModel::GetMaterialCount() const noexcept
+{
+	return GetHeader().materialCount;
+}
+
+Material::Desc CookedModel::GetMaterialDesc( size_t i ) const
+{
+	const auto& r = GetArray<MaterialRecord>( GetHeader().materialOffset )[i];
+	Material::Desc desc;
+	desc.name = ReadWide( r.name );
+	if( r.hasPaths & DIFFUSE_PATH )
+	{
+		desc.diffusePath = ReadWide( r.diffusePath );
+	}
+	if( r.hasPaths & SPECULAR_PATH )
+	{
+		desc.specularPath = ReadWide( r.specularPath );
+	}
+	if( r.hasPaths & NORMAL_PATH )
+	{
+		desc.normalPath = ReadWide( r.normalPath );
+	}
+	desc.materialColor = r.materialColor;
+	desc.specularColor = r.specularColor;
+	desc.specularGloss = r.specularGloss;
+	return desc;
+}
+
+size_t CookedModel::GetMeshCount() const noexcept
+{
+	return GetHeader().meshCount;
+}
+
+CookedModel::MeshView CookedModel::GetMesh( size_t i ) const
+{
+	const auto& r = GetArray<MeshRecord>( GetHeader().meshOffset )[i];
+	return {
+		ReadWide( r.tag ),
+		r.materialIndex,
+		pBase + r.vertexOffset,
+		(size_t)r.vertexBytes,
+		pBase + r.indexOffset,
+		(IndexByteBuffer::Format)r.indexFormat,
+		r.indexCount,
+		r.boundsCenter,
+		r.boundsExtents,
+		{ r.lods, r.lods + r.lodCount },
+		GetArray<MeshletSet::Meshlet>( r.meshletOffset ),
+		r.meshletCount
+	};
+}
+
+std::vector<Model::NodeDesc> CookedModel::GetNodes() const
+{
+	const auto& header = GetHeader();
+	const auto pRecords = GetArray<NodeRecord>( header.nodeOffset );
+	const auto pMeshes = GetArray<uint32_t>( header.nodeMeshOffset );
+	std::vector<Model::NodeDesc> nodes( header.nodeCount );
+	for( size_t i = 0; i < nodes.size(); i++ )
+	{
+		const auto& r = pRecords[i];
+		nodes[i].name = ReadNarrow( r.name );
+		nodes[i].parent = r.parent;
+		nodes[i].transform = r.transform;
+		nodes[i].meshes.assign( pMeshes + r.firstMesh, pMeshes + r.firstMesh + r.meshCount );
+	}
+	return nodes;
+}
+
+std::unique_ptr<Mesh> CookedModel::MakeMesh( Graphics& gfx, size_t i, const Material& mat ) const noexcept( !IS_DEBUG )
+{
+	const auto view = GetMesh( i );
+	return std::make_unique<Mesh>( gfx, mat,
+		GeometryHeap::Resolve( gfx, view.tag, mat.GetVertexLayout(), view.pVertices, view.vertexBytes, view.indexFormat, view.pIndices, view.indexCount ),
+		view.boundsCenter, view.boundsExtents, view.lods,
+		std::vector<MeshletSet::Meshlet>( view.pMeshlets, view.pMeshlets + view.meshletCount )
+	);
+}
+
+bool CookedModel::Validate( const std::wstring& sourcePath ) const
+{
+	const auto& header = GetHeader();
+	const auto inFile = [this]( uint64_t offset, uint64_t bytes )
+	{
+		return offset <= size && bytes <= size - offset;
+	};
+	if( !inFile( header.materialOffset, sizeof( MaterialRecord ) * (uint64_t)header.materialCount ) ||
+		!inFile( header.meshOffset, sizeof( MeshRecord ) * (uint64_t)header.meshCount ) ||
+		!inFile( header.nodeOffset, sizeof( NodeRecord ) * (uint64_t)header.nodeCount ) ||
+		!inFile( header.nodeMeshOffset, sizeof( uint32_t ) * (uint64_t)header.nodeMeshCount ) ||
+		!inFile( header.dependencyOffset, sizeof( StringRef ) * (uint64_t)header.dependencyCount ) ||
+		!inFile( header.stringOffset, header.stringSize ) )
+	{
+		return false;
+	}
+	const auto inStrings = [&header]( const StringRef& ref )
+	{
+		return (uint64_t)ref.offset + ref.length <= header.stringSize;
+	};
+
+	const auto pDependencies = GetArray<StringRef>( header.dependencyOffset );
+	for( size_t i = 0; i < header.dependencyCount; i++ )
+	{
+		if( !inStrings( pDependencies[i] ) )
+		{
+			return false;
+		}
+	}
+
+	// vertices are used as they are, so the layout of every material has to match the cooked one
+	std::vector<Material> materials;
+	materials.reserve( header.materialCount );
+	const auto pMaterials = GetArray<MaterialRecord>( header.materialOffset );
+	for( size_t i = 0; i < header.materialCount; i++ )
+	{
+		const auto& r = pMaterials[i];
+		if( !inStrings( r.name ) || !inStrings( r.diffusePath ) || !inStrings( r.specularPath ) || !inStrings( r.normalPath ) )
+		{
+			return false;
+		}
+		materials.emplace_back( GetMaterialDesc( i ), sourcePath );
+	}
+
+	const auto pMeshes = GetArray<MeshRecord>( header.meshOffset );
+	for( size_t i = 0; i < header.meshCount; i++ )
+	{
+		const auto& r = pMeshes[i];
+		if( r.indexFormat > (uint32_t)IndexByteBuffer::Format::UInt32 )
+		{
+			return false;
+		}
+		const auto indexSize = IndexByteBuffer::SizeOf( (IndexByteBuffer::Format)r.indexFormat );
+		if( !inStrings( r.tag ) || r.materialIndex >= header.materialCount ||
+			!inFile( r.vertexOffset, r.vertexBytes ) || !inFile( r.indexOffset, indexSize * (uint64_t)r.indexCount ) ||
+			r.vertexOffset % DATA_ALIGNMENT != 0u || r.indexOffset % DATA_ALIGNMENT != 0u )
+		{
+			return false;
+		}
+		if( r.lodCount > Mesh::MAX_LOD_COUNT )
+		{
+			return false;
+		}
+		for( uint32_t l = 0; l < r.lodCount; l++ )
+		{
+			if( (uint64_t)r.lods[l].startIndex + r.lods[l].indexCount > r.indexCount )
+			{
+				return false;
+			}
+		}
+		// meshlets partition the full level
+		if( !inFile( r.meshletOffset, sizeof( MeshletSet::Meshlet ) * (uint64_t)r.meshletCount ) || r.meshletOffset % DATA_ALIGNMENT != 0u )
+		{
+			return false;
+		}
+		const uint64_t fullCount = r.lodCount > 0u ? r.lods[0].indexCount : r.indexCount;
+		const auto pMeshlets = GetArray<MeshletSet::Meshlet>( r.meshletOffset );
+		for( uint32_t m = 0; m < r.meshletCount; m++ )
+		{
+			if( (uint64_t)pMeshlets[m].startIndex + pMeshlets[m].indexCount > fullCount )
+			{
+				return false;
+			}
+		}
+		const auto& layout = materials[r.materialIndex].GetVertexLayout();
+		if( r.layoutHash != layout.GetHash() || layout.Size() == 0u || r.vertexBytes % layout.Size() != 0u )
+		{
+			return false;
+		}
+	}
+
+	const auto pNodes = GetArray<NodeRecord>( header.nodeOffset );
+	const auto pNodeMeshes = GetArray<uint32_t>( header.nodeMeshOffset );
+	for( size_t i = 0; i < header.nodeCount; i++ )
+	{
+		const auto& r = pNodes[i];
+		// the root has to come first and every parent before its children
+		const bool parentValid = i == 0u ? r.parent == TransformHierarchy::NO_PARENT : r.parent < i;
+		if( !inStrings( r.name ) || !parentValid || (uint64_t)r.firstMesh + r.meshCount > header.nodeMeshCount )
+		{
+			return false;
+		}
+		for( uint32_t j = 0; j < r.meshCount; j++ )
+		{
+			if( pNodeMeshes[r.firstMesh + j] >= header.meshCount )
+			{
+				return false;
+			}
+		}
+	}
+	return header.nodeCount != 0u;
+}
+
+const CookedModel::Header& CookedModel::GetHeader() const noexcept
+{
+	return *reinterpret_cast<const Header*>( pBase );
+}
+
+std::wstring CookedModel::ReadWide( const StringRef& ref ) const
+{
+	// string section has no alignment guarantees for wchar_t
+	std::wstring s( ref.length / sizeof( wchar_t ), L'\0' );
+	std::memcpy( s.data(), pBase + GetHeader().stringOffset + ref.offset, s.size() * sizeof( wchar_t ) );
+	return s;
+}
+
+std::string CookedModel::ReadNarrow( const StringRef& ref ) const
+{
+	return { reinterpret_cast<const char*>( pBase + GetHeader().stringOffset + ref.offset ), ref.length };
+}
+
+std::vector<std::string> CookedModel::GetDependencies() const
+{
+	const auto& header = GetHeader();
+	const auto pRecords = GetArray<StringRef>( header.dependencyOffset );
+	std::vector<std::string> dependencies;
+	dependencies.reserve( header.dependencyCount );
+	for( size_t i = 0; i < header.dependencyCount; i++ )
+	{
+		dependencies.push_back( ReadNarrow( pRecords[i] ) );
+	}
+	return dependencies;
+}
+
+uint64_t CookedModel::HashSource( const std::wstring& sourcePath, float scale, const std::vector<std::string>& dependencies )
+{
+	size_t seed = hash_values( scale, VERSION );
+	if( !hash_file_stamp( seed, sourcePath ) )
+	{
+		return 0u;
+	}
+	// a material library that was edited or removed makes the cooked materials stale
+	for( const auto& d : dependencies )
+	{
+		if( !hash_file_stamp( seed, d ) )
+		{
+			return 0u;
+		}
+	}
+	return seed;
+}
@@ -0,0 +1,159 @@
+/*!
+ * \file CookedModel.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Binary cache of an imported model that is loaded by memory mapping
+ *
+ * \note The file holds the node hierarchy, material descriptions, bounds, levels of detail, meshlets, index data and
+ * vertex data already laid out for the vertex layout of the material. Vertex and index
+ * buffers are created straight from the mapped view, nothing is parsed or copied per vertex.
+ * The file is rebuilt when the size or write time of the source or of a file that the import opened besides it
+ * (material libraries), the scale or the format version changes.
+ */
+#pragma once
+
+#include "Model.h"
+#include "Material.h"
+#include "Mesh.h"
+#include "IndexByteBuffer.h"
+
+#include <DirectXMath.h>
+#include <assimp/DefaultIOSystem.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class CookedModel
+{
+public:
+	/**
+	 * @brief Mesh of the mapped file, pointers stay valid while the CookedModel is alive
+	*/
+	struct MeshView
+	{
+		std::wstring tag;
+		uint32_t materialIndex;
+		const std::byte* pVertices;
+		size_t vertexBytes;
+		const std::byte* pIndices;
+		IndexByteBuffer::Format indexFormat;
+		size_t indexCount;
+		DirectX::XMFLOAT3 boundsCenter;
+		DirectX::XMFLOAT3 boundsExtents;
+		std::vector<Drawable::Lod> lods;
+		const MeshletSet::Meshlet* pMeshlets;
+		size_t meshletCount;
+	};
+
+	/**
+	 * @brief Extracted mesh that is written to the file
+	*/
+	struct MeshSource
+	{
+		const Mesh::Data* pData;
+		uint32_t materialIndex;
+	};
+
+	/**
+	 * @brief IO system of an import that records the paths of the files the importer opened
+	*/
+	class RecordingIOSystem : public Assimp::DefaultIOSystem
+	{
+	public:
+		Assimp::IOStream* Open( const char* pFile, const char* pMode = "rb" ) override;
+		const std::vector<std::string>& GetOpenedFiles() const noexcept { return openedFiles; }
+
+	private:
+		std::vector<std::string> openedFiles;
+	};
+
+	struct BenchmarkStats
+	{
+		size_t meshCount = 0u;
+		size_t vertexBytes = 0u;
+		// assimp import, material parsing and vertex extraction
+		float importTime = 0.f;
+		// mapping of the cooked file and reading of all of its records
+		float cookedTime = 0.f;
+	};
+
+public:
+	/**
+	 * @brief Maps the cooked file of the source
+	 * @return nullptr if there is no cooked file or it is stale
+	*/
+	static std::unique_ptr<CookedModel> Open( const std::wstring& sourcePath, float scale );
+	/**
+	 * @brief Gives the importer an IO system that records the files it opens, the importer owns it
+	 * @return the IO system, valid while the importer is alive
+	*/
+	static const RecordingIOSystem& RecordDependencies( Assimp::Importer& importer );
+	/**
+	 * @brief Writes the cooked file of the source
+	 * @param dependencies files that the import opened, their changes make the cooked file stale as well
+	 * @return false if the file couldn't be written
+	*/
+	static bool Write( const std::wstring& sourcePath, float scale, const std::vector<std::string>& dependencies,
+		const std::vector<Material::Desc>& materials, const std::vector<MeshSource>& meshes, const std::vector<Model::NodeDesc>& nodes );
+	static std::wstring MakeCachePath( const std::wstring& sourcePath ) { return sourcePath + L".cooked"; }
+	/**
+	 * @brief Times the CPU side of an assimp import against the load of the cooked file,
+	 * * the cooked file is written first if it is missing
+	 * @note Both runs read the source files through the OS file cache, the first run of the
+	 * * application will show higher import times
+	*/
+	static BenchmarkStats Benchmark( const std::wstring& sourcePath, float scale );
+
+	CookedModel( const CookedModel& ) = delete;
+	CookedModel& operator=( const CookedModel& ) = delete;
+	~CookedModel() noexcept;
+
+	size_t GetMaterialCount() const noexcept;
+	Material::Desc GetMaterialDesc( size_t i ) const;
+	size_t GetMeshCount() const noexcept;
+	MeshView GetMesh( size_t i ) const;
+	std::vector<Model::NodeDesc> GetNodes() const;
+	/**
+	 * @brief Creates the mesh with buffers initialized from the mapped view
+	 * @param mat material of the mesh, its vertex layout matches the cooked vertices
+	*/
+	std::unique_ptr<Mesh> MakeMesh( Graphics& gfx, size_t i, const Material& mat ) const IFNOEXCEPT;
+
+private:
+	struct Header;
+	struct StringRef;
+	struct MaterialRecord;
+	struct MeshRecord;
+	struct NodeRecord;
+
+private:
+	CookedModel() = default;
+	/**
+	 * @brief Checks that all of the records and data ranges lie inside of the mapping
+	*/
+	bool Validate( const std::wstring& sourcePath ) const;
+	const Header& GetHeader() const noexcept;
+	template<typename T>
+	const T* GetArray( uint64_t offset ) const noexcept { return reinterpret_cast<const T*>( pBase + offset ); }
+	std::wstring ReadWide( const StringRef& ref ) const;
+	std::string ReadNarrow( const StringRef& ref ) const;
+	std::vector<std::string> GetDependencies() const;
+	static uint64_t HashSource( const std::wstring& sourcePath, float scale, const std::vector<std::string>& dependencies );
+
+private:
+	static constexpr uint32_t MAGIC = 0x4b4f4f43u; // "COOK"
+	static constexpr uint32_t VERSION = 7u;
+	static constexpr uint64_t DATA_ALIGNMENT = 16u;
+
+private:
+	// win32 file and mapping handles
+	void* hFile = nullptr;
+	void* hMapping = nullptr;
+	const std::byte* pBase = nullptr;
+	size_t size = 0u;
+};
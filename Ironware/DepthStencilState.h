@@ -25,8 +25,15 @@ public:
 
 public:
 	DepthStencilState( Graphics& gfx, StencilMode mode );
-	void Bind( Graphics& gfx ) IFNOEXCEPT override { GetContext( gfx )->OMSetDepthStencilState( pDSState.Get(), 0xFFu ); }
+	void Bind( Graphics& gfx ) IFNOEXCEPT override
+	{
+		if( GetStateCache( gfx ).Set( PipelineStateCache::Stage::OMDepthStencilState, pDSState.Get() ) )
+		{
+			GetContext( gfx )->OMSetDepthStencilState( pDSState.Get(), 0xFFu );
+		}
+	}
 	static std::shared_ptr<DepthStencilState> Resolve( Graphics& gfx, StencilMode mode ) { return BindableCollection::Resolve<DepthStencilState>( gfx, mode ); }
+	static size_t GenerateKey( StencilMode mode ) noexcept { return hash_values( mode ); }
 	static std::wstring GenerateUID( StencilMode mode );
 	std::wstring GetUID() const noexcept override { return GenerateUID( mode ); }
 
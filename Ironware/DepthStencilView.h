@@ -30,7 +30,11 @@ public:
 
 	uint32_t GetWidth() const noexcept { return width; }
 	uint32_t GetHeight() const noexcept { return height; }
-	void BindAsBuffer( Graphics& gfx ) IFNOEXCEPT override { GetContext( gfx )->OMSetRenderTargets( 0u, nullptr, pDepthStencilView.Get() ); }
+	void BindAsBuffer( Graphics& gfx ) IFNOEXCEPT override
+	{
+		GetContext( gfx )->OMSetRenderTargets( 0u, nullptr, pDepthStencilView.Get() );
+		GetStateCache( gfx ).OutputTargetsChanged();
+	}
 	void BindAsBuffer( Graphics& gfx, RenderTarget* rt ) IFNOEXCEPT { rt->BindAsBuffer( gfx, this ); }
 	void Clear( Graphics& gfx ) IFNOEXCEPT override { GetContext( gfx )->ClearDepthStencilView( pDepthStencilView.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.f, 0u ); }
 	std::wstring GetUID() const noexcept override { return L"?"; }
@@ -49,7 +53,13 @@ class ShaderInputDepthStencil : public DepthStencilView
 public:
 	ShaderInputDepthStencil( Graphics& gfx, UINT slot, Usage usage = Usage::DepthStencilView );
 	ShaderInputDepthStencil( Graphics& gfx, UINT width, UINT height, UINT slot, Usage usage = Usage::DepthStencilView );
-	void Bind( Graphics& gfx ) IFNOEXCEPT override { GetContext( gfx )->PSSetShaderResources( slot,1u,pShaderResourceView.GetAddressOf() ); }
+	void Bind( Graphics& gfx ) IFNOEXCEPT override
+	{
+		if( GetStateCache( gfx ).Set( PipelineStateCache::Stage::PSShaderResource, slot, pShaderResourceView.Get() ) )
+		{
+			GetContext( gfx )->PSSetShaderResources( slot, 1u, pShaderResourceView.GetAddressOf() );
+		}
+	}
 
 private:
 	UINT slot;
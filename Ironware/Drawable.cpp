@@ -13,13 +13,17 @@
 #include "PrimitiveTopology.h"
 #include <assimp/scene.h>
 #include "Material.h"
+#include "IronUtils.h"
 
 #include <cassert>
 
-Drawable::Drawable( Graphics& gfx, const Material& mat, const aiMesh& mesh, float scale ) noexcept
+Drawable::Drawable( Graphics& gfx, const Material& mat, const std::wstring& tag, const VertexByteBuffer& vertices, const IndexByteBuffer& indices ) noexcept :
+	Drawable( gfx, mat, GeometryHeap::Resolve( gfx, tag, vertices, indices ) )
+{}
+
+Drawable::Drawable( Graphics& gfx, const Material& mat, std::shared_ptr<GeometryHeap::Allocation> pGeometry_in ) noexcept :
+	pGeometry( std::move( pGeometry_in ) )
 {
-	pVertices = mat.MakeVertexBindable( gfx, mesh, scale );
-	pIndices = mat.MakeIndexBindable( gfx, mesh );
 	pTopology = PrimitiveTopology::Resolve( gfx, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
 
 	for( auto& t : mat.GetTechniques() )
@@ -34,17 +38,43 @@ void Drawable::AddTechnique( RenderTechnique tech_in ) noexcept
 	techniques.push_back( std::move( tech_in ) );
 }
 
-void Drawable::Submit( size_t channelFilter ) const noexcept
+void Drawable::Submit( size_t channelFilter, size_t lod, MeshletSet::Visible visible ) const noexcept
 {
 	for( const auto& tech : techniques )
 	{
-		tech.Submit( *this, channelFilter );
+		tech.Submit( *this, channelFilter, lod, visible );
+	}
+}
+
+size_t Drawable::SelectLod( float screenSize, float threshold ) const noexcept
+{
+	size_t lod = 0u;
+	while( lod + 1u < lods.size() && lods[lod + 1u].error * screenSize <= threshold )
+	{
+		lod++;
 	}
+	return lod;
+}
+
+Drawable::Lod Drawable::GetLod( size_t lod ) const IFNOEXCEPT
+{
+	if( lods.empty() )
+	{
+		assert( lod == 0u );
+		return { 0u, GetIndexCount(), 0.f };
+	}
+	assert( lod < lods.size() );
+	return lods[lod];
 }
 
 void Drawable::Bind( Graphics & gfx ) const IFNOEXCEPT
 {
 	pTopology->Bind( gfx );
+	if( pGeometry )
+	{
+		pGeometry->Bind( gfx );
+		return;
+	}
 	pIndices->Bind( gfx );
 	pVertices->Bind( gfx );
 }
@@ -59,7 +89,7 @@ void Drawable::Accept( TechniqueProbe & probe )
 
 UINT Drawable::GetIndexCount() const IFNOEXCEPT
 {
-	return pIndices->GetCount();
+	return pGeometry ? pGeometry->GetIndexCount() : pIndices->GetCount();
 }
 
 void Drawable::LinkTechniques( RenderGraph & rg )
@@ -69,3 +99,39 @@ void Drawable::LinkTechniques( RenderGraph & rg )
 		tech.Link( rg );
 	}
 }
+
+bool Drawable::SharesBuffers( const Drawable& other ) const noexcept
+{
+	if( pTopology != other.pTopology || bool( pGeometry ) != bool( other.pGeometry ) )
+	{
+		return false;
+	}
+	if( pGeometry )
+	{
+		return pGeometry->SharesPools( *other.pGeometry );
+	}
+	return pVertices == other.pVertices && pIndices == other.pIndices;
+}
+
+size_t Drawable::GetBuffersKey() const noexcept
+{
+	if( pGeometry )
+	{
+		return hash_values( &pGeometry->GetVertexPool(), &pGeometry->GetIndexPool(), pTopology.get() );
+	}
+	return hash_values( pVertices.get(), pIndices.get(), pTopology.get() );
+}
+
+void Drawable::ShareResources( const Drawable& prototype )
+{
+	pIndices = prototype.pIndices;
+	pVertices = prototype.pVertices;
+	pTopology = prototype.pTopology;
+	pGeometry = prototype.pGeometry;
+	lods = prototype.lods;
+	techniques.clear();
+	for( const auto& t : prototype.techniques )
+	{
+		AddTechnique( t );
+	}
+}
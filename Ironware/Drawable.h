@@ -16,14 +16,18 @@
 #include "Bindable.h"
 #include "CommonMacros.h"
 #include "RenderTechnique.h"
+#include "GeometryHeap.h"
 
 #include <DirectXMath.h>
 
 #include <memory>
+#include <vector>
 
 class RenderGraph;
 class TechniqueProbe;
 class Material;
+class VertexByteBuffer;
+class IndexByteBuffer;
 struct aiMesh;
 
 /*!
@@ -43,25 +47,82 @@ struct aiMesh;
  */
 class Drawable
 {
+	friend class TransformStage;
+public:
+	/**
+	 * @brief Level of detail, a range of the index buffer that addresses the shared vertices
+	 * @note error is the simplification error relative to the radius of the bounds
+	*/
+	struct Lod
+	{
+		UINT startIndex;
+		UINT indexCount;
+		float error;
+	};
+
 public:
 	Drawable() = default;
-	Drawable( Graphics& gfx, const Material& mat, const aiMesh& mesh, float scale = 1.f ) noexcept;
+	/**
+	 * @brief Resolves ranges of the geometry heap for the geometry that was extracted with the material and copies its techniques
+	*/
+	Drawable( Graphics& gfx, const Material& mat, const std::wstring& tag, const VertexByteBuffer& vertices, const IndexByteBuffer& indices ) noexcept;
+	Drawable( Graphics& gfx, const Material& mat, std::shared_ptr<GeometryHeap::Allocation> pGeometry ) noexcept;
 	Drawable( const Drawable& ) = delete;
 	virtual ~Drawable() = default;
 
 	virtual DirectX::XMMATRIX GetTransformXM() const noexcept = 0;
 	void AddTechnique( RenderTechnique tech_in ) noexcept;
-	void Submit( size_t channelFilter ) const noexcept;
+	/**
+	 * @param visible ranges of the level that are drawn, the whole level if it has no storage
+	*/
+	void Submit( size_t channelFilter, size_t lod = 0u, MeshletSet::Visible visible = {} ) const noexcept;
+	/**
+	 * @brief Coarsest level whose error stays below the threshold at the projected size
+	 * @param screenSize projected radius of the bounds, see Frustum::GetScreenSize
+	*/
+	size_t SelectLod( float screenSize, float threshold ) const noexcept;
+	/**
+	 * @return index range of the level relative to the start index, all indices for drawables without levels
+	*/
+	Lod GetLod( size_t lod ) const IFNOEXCEPT;
+	size_t GetLodCount() const noexcept { return lods.empty() ? 1u : lods.size(); }
 	void Bind( Graphics& gfx ) const IFNOEXCEPT;
 	void Accept( class TechniqueProbe& probe );
 	UINT GetIndexCount() const IFNOEXCEPT;
+	/**
+	 * @brief Offsets of the geometry in the buffers, zero unless it's a range of the geometry heap
+	*/
+	UINT GetStartIndex() const noexcept { return pGeometry ? pGeometry->GetStartIndex() : 0u; }
+	INT GetBaseVertex() const noexcept { return pGeometry ? (INT)pGeometry->GetBaseVertex() : 0; }
 	void LinkTechniques( RenderGraph& rg );
+	/**
+	 * @return true if both drawables draw from the same vertex and index buffers, so binding one binds the other
+	*/
+	bool SharesBuffers( const Drawable& other ) const noexcept;
+	size_t GetBuffersKey() const noexcept;
+
+protected:
+	/**
+	 * @brief Shares the geometry and the technique bindables of the prototype, only the cloning
+	 * * bindables (transforms) are copied, so jobs of both drawables can be drawn instanced
+	*/
+	void ShareResources( const Drawable& prototype );
+	/**
+	 * @param lods_in levels in the order of increasing error, the first one is the full mesh
+	*/
+	void SetLods( std::vector<Lod> lods_in ) noexcept { lods = std::move( lods_in ); }
 
 protected:
 	std::shared_ptr<class IndexBuffer> pIndices;
 	std::shared_ptr<class VertexBuffer> pVertices;
 	std::shared_ptr<class PrimitiveTopology> pTopology;
+	// meshes take ranges of the geometry heap instead of buffers of their own
+	std::shared_ptr<GeometryHeap::Allocation> pGeometry;
 
 private:
 	std::vector<RenderTechnique> techniques;
+	std::vector<Lod> lods;
+	// slot of the transform stage, valid in the frame that it was acquired in
+	mutable uint32_t transformSlot = 0u;
+	mutable uint64_t transformFrame = 0u;
 };
\ No newline at end of file
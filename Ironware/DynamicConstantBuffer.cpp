@@ -9,10 +9,16 @@
 #define DCB_IMPL_SOURCE
 #include "DynamicConstantBuffer.h"
 #include "DynamicLayout.h"
+#include "IronUtils.h"
 
 #include <string>
 #include <algorithm>
 #include <cctype>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <tuple>
+#include <unordered_map>
 
 struct ExtraData
 {
@@ -46,6 +52,57 @@ std::string LayoutElement::GetSignature() const IFNOEXCEPT
 		return "???";
 	}
 }
+size_t LayoutElement::GetStructureHash() const IFNOEXCEPT
+{
+	size_t seed = hash_values( int( type ) );
+	switch( type )
+	{
+	case Struct:
+		for( const auto& mem : static_cast<ExtraData::Struct&>( *pExtraData ).layoutElements )
+		{
+			hash_combine( seed, hash_fnv1a( mem.first ) );
+			hash_combine( seed, mem.second.GetStructureHash() );
+		}
+		break;
+	case Array:
+	{
+		const auto& data = static_cast<ExtraData::Array&>( *pExtraData );
+		hash_combine( seed, data.size );
+		hash_combine( seed, data.layoutElement->GetStructureHash() );
+		break;
+	}
+	default:
+		break;
+	}
+	return seed;
+}
+
+bool LayoutElement::HasSameStructure( const LayoutElement& other ) const IFNOEXCEPT
+{
+	if( type != other.type )
+	{
+		return false;
+	}
+	switch( type )
+	{
+	case Struct:
+	{
+		const auto& members = static_cast<ExtraData::Struct&>( *pExtraData ).layoutElements;
+		const auto& otherMembers = static_cast<ExtraData::Struct&>( *other.pExtraData ).layoutElements;
+		return std::equal( members.begin(), members.end(), otherMembers.begin(), otherMembers.end(),
+			[]( const auto& a, const auto& b ) { return a.first == b.first && a.second.HasSameStructure( b.second ); } );
+	}
+	case Array:
+	{
+		const auto& data = static_cast<ExtraData::Array&>( *pExtraData );
+		const auto& otherData = static_cast<ExtraData::Array&>( *other.pExtraData );
+		return data.size == otherData.size && data.layoutElement->HasSameStructure( *otherData.layoutElement );
+	}
+	default:
+		return true;
+	}
+}
+
 bool LayoutElement::Exists() const noexcept
 {
 	return type != Empty;
@@ -59,6 +116,47 @@ std::pair<size_t, const LayoutElement*> LayoutElement::CalculateIndexingOffset(
 	return { offset + data.element_size * index,&*data.layoutElement };
 }
 
+std::pair<size_t, const LayoutElement*> LayoutElement::ResolvePath( const std::string& path ) const IFNOEXCEPT
+{
+	size_t offset = 0u;
+	const LayoutElement* pElement = this;
+	size_t i = 0u;
+	while( i < path.size() && pElement->Exists() )
+	{
+		if( path[i] == '[' )
+		{
+			const auto close = path.find( ']', i );
+			if( pElement->type != Array || close == std::string::npos || close == i + 1u ||
+				!std::all_of( path.begin() + i + 1u, path.begin() + close, []( char c ) { return std::isdigit( (unsigned char)c ); } ) )
+			{
+				return { 0u, &GetEmptyElement() };
+			}
+			const auto index = std::stoull( path.substr( i + 1u, close - i - 1u ) );
+			if( index >= pElement->GetArraySize() )
+			{
+				return { 0u, &GetEmptyElement() };
+			}
+			std::tie( offset, pElement ) = pElement->CalculateIndexingOffset( offset, size_t( index ) );
+			i = close + 1u;
+		}
+		else
+		{
+			if( path[i] == '.' )
+			{
+				i++;
+			}
+			if( pElement->type != Struct )
+			{
+				return { 0u, &GetEmptyElement() };
+			}
+			const auto end = std::min( path.find_first_of( ".[", i ), path.size() );
+			pElement = &( *pElement )[path.substr( i, end - i )];
+			i = end;
+		}
+	}
+	return { offset, pElement };
+}
+
 LayoutElement& LayoutElement::operator[]( const std::string& key ) IFNOEXCEPT
 {
 	assert( "Keying into non-struct" && type == Struct );
@@ -88,6 +186,18 @@ const LayoutElement& LayoutElement::T() const IFNOEXCEPT
 	return const_cast<LayoutElement&>( *this ).T();
 }
 
+size_t LayoutElement::GetArrayStride() const IFNOEXCEPT
+{
+	assert( "Accessing stride of non-array" && type == Array );
+	return static_cast<ExtraData::Array&>( *pExtraData ).element_size;
+}
+
+size_t LayoutElement::GetArraySize() const IFNOEXCEPT
+{
+	assert( "Accessing size of non-array" && type == Array );
+	return static_cast<ExtraData::Array&>( *pExtraData ).size;
+}
+
 size_t LayoutElement::GetOffsetBegin() const IFNOEXCEPT
 {
 	return *offset;
@@ -220,35 +330,194 @@ size_t LayoutElement::FinalizeForArray( size_t offsetIn )
 	return GetOffsetEnd();
 }
 
-bool LayoutElement::CrossesBoundary( size_t offset, size_t size ) noexcept
+bool LayoutElement::ValidateSymbolName( const std::string& name ) noexcept
+{
+	// symbols can contain alphanumeric and underscore, must not start with digit
+	return !name.empty() && !std::isdigit( name.front() ) &&
+		std::all_of( name.begin(), name.end(), []( char c ) {
+		return std::isalnum( c ) || c == '_';
+	}
+	);
+}
+
+#pragma endregion layElImpl
+
+#pragma region layTableImpl
+
+namespace
 {
-	const auto end = offset + size;
-	const auto pageStart = offset / 16u;
-	const auto pageEnd = end / 16u;
-	return ( pageStart != pageEnd && end % 16 != 0u ) || size > 16u;
+	struct NameTable
+	{
+		// deque keeps the names in place while other layouts intern theirs
+		std::deque<std::string> names;
+		std::unordered_map<std::string, uint32_t> ids;
+	};
+
+	NameTable& get_name_table() noexcept
+	{
+		static NameTable table;
+		return table;
+	}
 }
 
-size_t LayoutElement::AdvanceIfCrossesBoundary( size_t offset, size_t size ) noexcept
+LayoutTable::LayoutTable( const LayoutElement& root ) IFNOEXCEPT
 {
-	return CrossesBoundary( offset, size ) ? AdvanceToBoundary( offset ) : offset;
+	// breadth first, so the members of every Struct are written next to each other
+	std::vector<const LayoutElement*> elements;
+	const auto addRecord = [&]( const LayoutElement& el, uint32_t name )
+	{
+		Record r;
+		r.type = el.type;
+		r.name = name;
+		r.offset = uint32_t( *el.offset );
+		r.size = uint32_t( el.GetSizeInBytes() );
+		records.push_back( r );
+		elements.push_back( &el );
+	};
+	addRecord( root, NO_RECORD );
+	for( size_t i = 0; i < elements.size(); i++ )
+	{
+		const auto& el = *elements[i];
+		if( el.type == Struct )
+		{
+			const auto& members = static_cast<ExtraData::Struct&>( *el.pExtraData ).layoutElements;
+			records[i].first = uint32_t( records.size() );
+			records[i].count = uint32_t( members.size() );
+			for( const auto& mem : members )
+			{
+				addRecord( mem.second, InternName( mem.first ) );
+			}
+		}
+		else if( el.type == Array )
+		{
+			records[i].first = uint32_t( records.size() );
+			records[i].count = uint32_t( el.GetArraySize() );
+			records[i].stride = uint32_t( el.GetArrayStride() );
+			addRecord( el.T(), NO_RECORD );
+		}
+	}
 }
 
-size_t LayoutElement::AdvanceToBoundary( size_t offset ) noexcept
+const std::string& LayoutTable::GetName( uint32_t name ) noexcept
 {
-	return offset + ( 16u - offset % 16u ) % 16u;
+	return get_name_table().names[name];
 }
 
-bool LayoutElement::ValidateSymbolName( const std::string& name ) noexcept
+uint32_t LayoutTable::FindMember( uint32_t parent, std::string_view name ) const noexcept
 {
-	// symbols can contain alphanumeric and underscore, must not start with digit
-	return !name.empty() && !std::isdigit( name.front() ) &&
-		std::all_of( name.begin(), name.end(), []( char c ) {
-		return std::isalnum( c ) || c == '_';
+	const auto& p = records[parent];
+	if( p.type != Struct )
+	{
+		return NO_RECORD;
 	}
-	);
+	for( uint32_t i = p.first; i < p.first + p.count; i++ )
+	{
+		if( GetName( records[i].name ) == name )
+		{
+			return i;
+		}
+	}
+	return NO_RECORD;
 }
 
-#pragma endregion layElImpl
+std::pair<size_t, const LayoutTable::Record*> LayoutTable::ResolvePath( const std::string& path ) const IFNOEXCEPT
+{
+	// offset of the element is the offset of its record plus what the indices on the way add
+	const std::string_view p = path;
+	size_t indexOffset = 0u;
+	uint32_t current = 0u;
+	size_t i = 0u;
+	while( i < path.size() )
+	{
+		const auto& r = records[current];
+		if( path[i] == '[' )
+		{
+			const auto close = p.find( ']', i );
+			if( r.type != Array || close == std::string_view::npos || close == i + 1u )
+			{
+				return { 0u, nullptr };
+			}
+			size_t index = 0u;
+			for( size_t d = i + 1u; d < close; d++ )
+			{
+				if( !std::isdigit( (unsigned char)p[d] ) || index >= r.count )
+				{
+					return { 0u, nullptr };
+				}
+				index = index * 10u + size_t( p[d] - '0' );
+			}
+			if( index >= r.count )
+			{
+				return { 0u, nullptr };
+			}
+			indexOffset += size_t( r.stride ) * size_t( index );
+			current = r.first;
+			i = close + 1u;
+		}
+		else
+		{
+			if( path[i] == '.' )
+			{
+				i++;
+			}
+			const auto end = std::min( p.find_first_of( ".[", i ), p.size() );
+			current = FindMember( current, p.substr( i, end - i ) );
+			if( current == NO_RECORD )
+			{
+				return { 0u, nullptr };
+			}
+			i = end;
+		}
+	}
+	return { indexOffset + records[current].offset, &records[current] };
+}
+
+bool LayoutTable::Matches( const LayoutElement& root ) const IFNOEXCEPT
+{
+	return Matches( 0u, root );
+}
+
+uint32_t LayoutTable::InternName( const std::string& name )
+{
+	auto& table = get_name_table();
+	const auto [it, inserted] = table.ids.emplace( name, uint32_t( table.names.size() ) );
+	if( inserted )
+	{
+		table.names.push_back( name );
+	}
+	return it->second;
+}
+
+bool LayoutTable::Matches( uint32_t index, const LayoutElement& element ) const IFNOEXCEPT
+{
+	const auto& r = records[index];
+	if( r.type != element.type || r.offset != element.GetOffsetBegin() || r.size != element.GetSizeInBytes() )
+	{
+		return false;
+	}
+	if( r.type == Struct )
+	{
+		const auto& members = static_cast<ExtraData::Struct&>( *element.pExtraData ).layoutElements;
+		if( r.count != members.size() )
+		{
+			return false;
+		}
+		for( uint32_t i = 0; i < r.count; i++ )
+		{
+			if( GetName( records[r.first + i].name ) != members[i].first || !Matches( r.first + i, members[i].second ) )
+			{
+				return false;
+			}
+		}
+	}
+	else if( r.type == Array )
+	{
+		return r.count == element.GetArraySize() && r.stride == element.GetArrayStride() && Matches( r.first, element.T() );
+	}
+	return true;
+}
+
+#pragma endregion layTableImpl
 
 #pragma region layImpl
 
@@ -296,8 +565,9 @@ void RawLayout::ClearRoot() noexcept
 
 #pragma region cookLayImpl
 
-CookedLayout::CookedLayout( std::shared_ptr<LayoutElement> pRoot ) noexcept :
-	Layout( std::move( pRoot ) )
+CookedLayout::CookedLayout( std::shared_ptr<LayoutElement> pRoot, const LayoutTable* pTable ) noexcept :
+	Layout( std::move( pRoot ) ),
+	pTable( pTable )
 {}
 std::shared_ptr<LayoutElement> CookedLayout::RelinquishRoot() noexcept
 {
@@ -363,13 +633,13 @@ bool ElementRef::Exists() const noexcept
 
 ElementRef ElementRef::operator[]( const std::string& key ) const IFNOEXCEPT
 {
-	return { &( *pLayout )[key],pBytes,offset };
+	return { &( *pLayout )[key],pBytes,offset,pBuffer };
 }
 
 ElementRef ElementRef::operator[]( size_t index ) const IFNOEXCEPT
 {
 	const auto indexingData = pLayout->CalculateIndexingOffset( offset, index );
-	return { indexingData.second,pBytes,indexingData.first };
+	return { indexingData.second,pBytes,indexingData.first,pBuffer };
 }
 
 ElementRef::Ptr ElementRef::operator&() const IFNOEXCEPT
@@ -377,12 +647,18 @@ ElementRef::Ptr ElementRef::operator&() const IFNOEXCEPT
 	return Ptr{ const_cast<ElementRef*>( this ) };
 }
 
-ElementRef::ElementRef( const LayoutElement* pLayout, std::byte* pBytes, size_t offset ) noexcept :
+ElementRef::ElementRef( const LayoutElement* pLayout, std::byte* pBytes, size_t offset, Buffer* pBuffer ) noexcept :
 	offset( offset ),
 	pLayout( pLayout ),
-	pBytes( pBytes )
+	pBytes( pBytes ),
+	pBuffer( pBuffer )
 {}
 
+void ElementRef::MarkDirty( size_t byteOffset, size_t size ) const noexcept
+{
+	pBuffer->MarkDirty( byteOffset, size );
+}
+
 ElementRef::Ptr::Ptr( ElementRef* ref ) noexcept :
 	ref( ref )
 {}
@@ -397,23 +673,27 @@ Buffer( DynamicLayout::Resolve( std::move( lay ) ) )
 
 Buffer::Buffer( const CookedLayout& lay ) IFNOEXCEPT :
 	pLayoutRoot( lay.ShareRoot() ),
-	bytes( pLayoutRoot->GetOffsetEnd() )
+	pTable( lay.pTable ),
+	bytes( pTable->GetSizeInBytes() )
 {}
 
 Buffer::Buffer( CookedLayout&& lay ) IFNOEXCEPT
 	:
 	pLayoutRoot( lay.RelinquishRoot() ),
-	bytes( pLayoutRoot->GetOffsetEnd() )
+	pTable( lay.pTable ),
+	bytes( pTable->GetSizeInBytes() )
 {}
 
 Buffer::Buffer( Buffer&& buf ) noexcept :
 	pLayoutRoot( std::move( buf.pLayoutRoot ) ),
-	bytes( std::move( buf.bytes ) )
+	pTable( buf.pTable ),
+	bytes( std::move( buf.bytes ) ),
+	dirtyRanges( std::move( buf.dirtyRanges ) )
 {}
 
 ElementRef Buffer::operator[]( const std::string& key ) IFNOEXCEPT
 {
-	return { &( *pLayoutRoot )[key],bytes.data(),0u };
+	return { &( *pLayoutRoot )[key],bytes.data(),0u,this };
 }
 
 ConstElementRef Buffer::operator[]( const std::string& key ) const IFNOEXCEPT
@@ -439,7 +719,69 @@ const LayoutElement& Buffer::GetRootLayoutElement() const noexcept
 void Buffer::CopyFrom( const Buffer& other ) IFNOEXCEPT
 {
 	assert( &GetRootLayoutElement() == &other.GetRootLayoutElement() );
-	std::copy( other.bytes.begin(), other.bytes.end(), bytes.begin() );
+	CopyFrom( other.bytes.data(), other.bytes.size() );
+}
+
+void Buffer::CopyFrom( const void* pData, size_t size ) IFNOEXCEPT
+{
+	assert( size == bytes.size() );
+	// the old bytes are compared with the new ones before they're overwritten
+	const auto pNew = static_cast<const std::byte*>( pData );
+	for( size_t begin = 0u; begin < bytes.size(); begin += 16u )
+	{
+		const auto length = std::min<size_t>( 16u, bytes.size() - begin );
+		if( std::memcmp( bytes.data() + begin, pNew + begin, length ) != 0 )
+		{
+			std::memcpy( bytes.data() + begin, pNew + begin, length );
+			MarkDirty( begin, length );
+		}
+	}
+}
+
+void Buffer::MarkDirty( size_t offset, size_t size ) noexcept
+{
+	if( size == 0u )
+	{
+		return;
+	}
+	DirtyRange range{ offset / 16u * 16u, LayoutElement::AdvanceToBoundary( offset + size ) };
+	// ranges that overlap or touch the new one are merged into it
+	auto it = std::lower_bound( dirtyRanges.begin(), dirtyRanges.end(), range.begin,
+		[]( const DirtyRange& r, size_t begin ) { return r.end < begin; } );
+	auto last = it;
+	while( last != dirtyRanges.end() && last->begin <= range.end )
+	{
+		range.begin = std::min( range.begin, last->begin );
+		range.end = std::max( range.end, last->end );
+		++last;
+	}
+	if( it == last )
+	{
+		dirtyRanges.insert( it, range );
+	}
+	else
+	{
+		*it = range;
+		dirtyRanges.erase( it + 1, last );
+	}
+}
+
+void Buffer::MarkChangedSince( const Buffer& previous ) IFNOEXCEPT
+{
+	assert( &GetRootLayoutElement() == &previous.GetRootLayoutElement() );
+	MarkDifferences( previous.bytes.data() );
+}
+
+void Buffer::MarkDifferences( const std::byte* pOld ) noexcept
+{
+	for( size_t begin = 0u; begin < bytes.size(); begin += 16u )
+	{
+		const auto length = std::min<size_t>( 16u, bytes.size() - begin );
+		if( std::memcmp( bytes.data() + begin, pOld + begin, length ) != 0 )
+		{
+			MarkDirty( begin, length );
+		}
+	}
 }
 
 std::shared_ptr<LayoutElement> Buffer::ShareLayoutRoot() const noexcept
@@ -447,4 +789,96 @@ std::shared_ptr<LayoutElement> Buffer::ShareLayoutRoot() const noexcept
 	return pLayoutRoot;
 }
 
+Buffer::BenchmarkStats Buffer::Benchmark( size_t iterations )
+{
+	using namespace std::chrono;
+	namespace dx = DirectX;
+	constexpr size_t nCoefficients = 15u;
+	BenchmarkStats stats;
+
+	RawLayout materialLayout;
+	materialLayout.Add<Float3>( "materialColor" );
+	materialLayout.Add<Float3>( "specularColor" );
+	materialLayout.Add<Float>( "specularWeight" );
+	materialLayout.Add<Float>( "specularGloss" );
+	materialLayout.Add<Bool>( "useNormalMap" );
+	materialLayout.Add<Float>( "normalMapWeight" );
+	Buffer material( std::move( materialLayout ) );
+	RawLayout kernelLayout;
+	kernelLayout.Add<Integer>( "nTaps" );
+	kernelLayout.Add<Array>( "coefficients" );
+	kernelLayout["coefficients"].Set<Float>( nCoefficients );
+	Buffer kernel( std::move( kernelLayout ) );
+
+	// every iteration writes and reads all elements of both buffers
+	stats.accessCount = ( 6u + 1u + nCoefficients ) * 2u;
+	if( iterations == 0u )
+	{
+		return stats;
+	}
+	float sink = 0.f;
+
+	auto start = steady_clock::now();
+	for( size_t it = 0; it < iterations; it++ )
+	{
+		const float v = float( it & 0xFF );
+		material["materialColor"] = dx::XMFLOAT3{ v,v,v };
+		material["specularColor"] = dx::XMFLOAT3{ v,v,v };
+		material["specularWeight"] = v;
+		material["specularGloss"] = v;
+		material["useNormalMap"] = ( it & 1u ) != 0u;
+		material["normalMapWeight"] = v;
+		kernel["nTaps"] = int( it );
+		for( size_t i = 0; i < nCoefficients; i++ )
+		{
+			kernel["coefficients"][i] = v;
+		}
+		sink += static_cast<const dx::XMFLOAT3&>( material["materialColor"] ).x +
+			static_cast<const dx::XMFLOAT3&>( material["specularColor"] ).y +
+			(float)material["specularWeight"] + (float)material["specularGloss"] +
+			float( (bool)material["useNormalMap"] ) + (float)material["normalMapWeight"] + float( (int)kernel["nTaps"] );
+		for( size_t i = 0; i < nCoefficients; i++ )
+		{
+			sink += (float)kernel["coefficients"][i];
+		}
+	}
+	stats.keyedTime = duration<float, std::nano>( steady_clock::now() - start ).count() / float( iterations * stats.accessCount );
+
+	const auto materialColor = material.MakeHandle<dx::XMFLOAT3>( "materialColor" );
+	const auto specularColor = material.MakeHandle<dx::XMFLOAT3>( "specularColor" );
+	const auto specularWeight = material.MakeHandle<float>( "specularWeight" );
+	const auto specularGloss = material.MakeHandle<float>( "specularGloss" );
+	const auto useNormalMap = material.MakeHandle<bool>( "useNormalMap" );
+	const auto normalMapWeight = material.MakeHandle<float>( "normalMapWeight" );
+	const auto nTaps = kernel.MakeHandle<int>( "nTaps" );
+	const auto coefficients = kernel.MakeArrayHandle<float>( "coefficients" );
+	start = steady_clock::now();
+	for( size_t it = 0; it < iterations; it++ )
+	{
+		const float v = float( it & 0xFF );
+		material.Set( materialColor, { v,v,v } );
+		material.Set( specularColor, { v,v,v } );
+		material.Set( specularWeight, v );
+		material.Set( specularGloss, v );
+		material.Set( useNormalMap, ( it & 1u ) != 0u );
+		material.Set( normalMapWeight, v );
+		kernel.Set( nTaps, int( it ) );
+		const auto span = kernel.GetSpan( coefficients );
+		std::fill( span.begin(), span.end(), v );
+		sink += material.Get( materialColor ).x + material.Get( specularColor ).y +
+			material.Get( specularWeight ) + material.Get( specularGloss ) +
+			float( material.Get( useNormalMap ) ) + material.Get( normalMapWeight ) + float( kernel.Get( nTaps ) );
+		for( const auto c : span )
+		{
+			sink += c;
+		}
+	}
+	stats.handleTime = duration<float, std::nano>( steady_clock::now() - start ).count() / float( iterations * stats.accessCount );
+
+	// keeps the reads from being optimized away
+	static volatile float benchmarkSink;
+	benchmarkSink = sink;
+	return stats;
+}
+
 #pragma endregion bufferImpl
\ No newline at end of file
@@ -9,13 +9,17 @@
 #pragma once
 
 #include "CommonMacros.h"
+#include "StridedView.h"
 
 #include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <DirectXMath.h>
 #include <vector>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 
  // master list of leaf types that generates enum elements and various switches etc.
 #define LEAF_ELEMENT_TYPES \
@@ -116,6 +120,71 @@ struct ReverseMap
 LEAF_ELEMENT_TYPES
 #undef X
 
+class LayoutElement;
+class Buffer;
+
+/**
+ * @brief Offset of a leaf element in the bytes of the buffers of a layout, resolved once from a path
+ * * like "specularColor" or "coefficients[3]", reading and writing through it doesn't walk the layout
+*/
+template<typename T>
+class ElementHandle
+{
+	friend class LayoutElement;
+	friend class LayoutTable;
+	friend class Buffer;
+	template<typename> friend class ArrayHandle;
+public:
+	// handle of an element that doesn't exist
+	ElementHandle() noexcept = default;
+	bool Exists() const noexcept { return pRoot != nullptr; }
+	size_t GetOffset() const noexcept { return offset; }
+private:
+	ElementHandle( const LayoutElement* pRoot, size_t offset ) noexcept :
+		pRoot( pRoot ),
+		offset( offset )
+	{}
+private:
+	// root of the layout that the path was resolved in, buffers of other layouts can't be accessed with it
+	const LayoutElement* pRoot = nullptr;
+	size_t offset = 0u;
+};
+
+/**
+ * @brief First element, stride and size of an array of leaf elements, resolved once from a path
+*/
+template<typename T>
+class ArrayHandle
+{
+	friend class LayoutElement;
+	friend class LayoutTable;
+	friend class Buffer;
+public:
+	ArrayHandle() noexcept = default;
+	bool Exists() const noexcept { return pRoot != nullptr; }
+	size_t GetSize() const noexcept { return size; }
+	/**
+	 * @return handle of the element at the index
+	*/
+	ElementHandle<T> operator[]( size_t index ) const noexcept
+	{
+		assert( index < size );
+		return { pRoot, offset + stride * index };
+	}
+private:
+	ArrayHandle( const LayoutElement* pRoot, size_t offset, size_t stride, size_t size ) noexcept :
+		pRoot( pRoot ),
+		offset( offset ),
+		stride( stride ),
+		size( size )
+	{}
+private:
+	const LayoutElement* pRoot = nullptr;
+	size_t offset = 0u;
+	size_t stride = 0u;
+	size_t size = 0u;
+};
+
 
 /**
  * @brief LayoutElements instances form a tree that describes the layout of the data buffer
@@ -138,6 +207,7 @@ private:
 	// classes that the client should not create can have their constructors made
 	// private, so that Finalize() cannot be called on arbitrary LayoutElements, etc.
 	friend class RawLayout;
+	friend class LayoutTable;
 	friend struct ExtraData;
 
 public:
@@ -147,6 +217,14 @@ public:
 	 * @return	gets signature of the element
 	*/
 	std::string GetSignature() const IFNOEXCEPT;
+	/**
+	 * @brief 64-bit hash of the types, member names and array sizes of the tree, built without any strings
+	*/
+	size_t GetStructureHash() const IFNOEXCEPT;
+	/**
+	 * @return true if both trees have the same types, member names and array sizes, offsets aren't compared
+	*/
+	bool HasSameStructure( const LayoutElement& other ) const IFNOEXCEPT;
 	/**
 	 * @brief Check if element is "real"
 	 */
@@ -178,6 +256,10 @@ public:
 	 * @brief get size in bytes derived from offsets
 	*/
 	size_t GetSizeInBytes() const IFNOEXCEPT;
+	Type GetType() const noexcept { return type; }
+	// only work for Arrays; distance between the elements and their number
+	size_t GetArrayStride() const IFNOEXCEPT;
+	size_t GetArraySize() const IFNOEXCEPT;
 	/**
 	 * @brief only works for Structs; add LayoutElement to struct
 	*/
@@ -194,6 +276,74 @@ public:
 	{
 		return Set( typeAdded, size );
 	}
+	/**
+	 * @brief Walks a path of struct keys and array indices from this element, e.g. "lights[2].color"
+	 * @return offset that the indices add to the offsets of the element at the end of the path
+	 * * and the element itself, which is empty if the path doesn't exist
+	*/
+	std::pair<size_t, const LayoutElement*> ResolvePath( const std::string& path ) const IFNOEXCEPT;
+	/**
+	 * @brief Resolves the path to a leaf element of type T, the handle doesn't exist if the path doesn't
+	*/
+	template<typename T>
+	ElementHandle<T> MakeHandle( const std::string& path ) const IFNOEXCEPT
+	{
+		static_assert( ReverseMap<std::remove_const_t<T>>::valid, "Unsupported SysType used in handle" );
+		const auto [indexOffset, pElement] = ResolvePath( path );
+		if( pElement->type != ReverseMap<T>::type )
+		{
+			assert( "Handle type doesn't match the element" && !pElement->Exists() );
+			return {};
+		}
+		return { this, indexOffset + *pElement->offset };
+	}
+	/**
+	 * @brief Resolves the path to an array of leaf elements of type T
+	*/
+	template<typename T>
+	ArrayHandle<T> MakeArrayHandle( const std::string& path ) const IFNOEXCEPT
+	{
+		static_assert( ReverseMap<std::remove_const_t<T>>::valid, "Unsupported SysType used in handle" );
+		const auto [indexOffset, pElement] = ResolvePath( path );
+		if( pElement->type != Array || pElement->T().type != ReverseMap<T>::type )
+		{
+			assert( "Handle type doesn't match the element" && !pElement->Exists() );
+			return {};
+		}
+		const auto first = pElement->CalculateIndexingOffset( indexOffset, 0u );
+		return { this, first.first + *first.second->offset, pElement->GetArrayStride(), pElement->GetArraySize() };
+	}
+	// packing rules of hlsl, constexpr so that C++ structs can be checked against them at compile time
+	// returns the value of offset bumped up to the next 16-byte boundary (if not already on one)
+	static constexpr size_t AdvanceToBoundary( size_t offset ) noexcept
+	{
+		return offset + ( 16u - offset % 16u ) % 16u;
+	}
+	// return true if a memory block crosses a boundary
+	static constexpr bool CrossesBoundary( size_t offset, size_t size ) noexcept
+	{
+		const auto end = offset + size;
+		const auto pageStart = offset / 16u;
+		const auto pageEnd = end / 16u;
+		return ( pageStart != pageEnd && end % 16 != 0u ) || size > 16u;
+	}
+	// advance an offset to next boundary if block crosses a boundary
+	static constexpr size_t AdvanceIfCrossesBoundary( size_t offset, size_t size ) noexcept
+	{
+		return CrossesBoundary( offset, size ) ? AdvanceToBoundary( offset ) : offset;
+	}
+	// size of a leaf type on the GPU side, 0 for aggregates
+	static constexpr size_t GetLeafSize( Type leafType ) noexcept
+	{
+		switch( leafType )
+		{
+#define X(el) case el: return Map<el>::hlslSize;
+			LEAF_ELEMENT_TYPES
+#undef X
+		default:
+			return 0u;
+		}
+	}
 	// returns offset of leaf types for read/write purposes w/ typecheck in Debug
 	template<typename T>
 	size_t Resolve() const IFNOEXCEPT
@@ -227,12 +377,6 @@ private:
 		static LayoutElement empty{};
 		return empty;
 	}
-	// returns the value of offset bumped up to the next 16-byte boundary (if not already on one)
-	static size_t AdvanceToBoundary( size_t offset ) noexcept;
-	// return true if a memory block crosses a boundary
-	static bool CrossesBoundary( size_t offset, size_t size ) noexcept;
-	// advance an offset to next boundary if block crosses a boundary
-	static size_t AdvanceIfCrossesBoundary( size_t offset, size_t size ) noexcept;
 	// check string for validity as a struct key
 	static bool ValidateSymbolName( const std::string& name ) noexcept;
 private:
@@ -244,6 +388,87 @@ private:
 };
 
 
+/**
+ * @brief Finalized layout tree compiled into a single array of element records
+ * * Members of a Struct are neighboring records with interned names and precomputed offsets and strides,
+ * * so walking the table doesn't chase the nodes of the tree around the heap.
+ * * DynamicLayout compiles a table once for every layout it registers, the tree stays the reference.
+*/
+class LayoutTable
+{
+public:
+	static constexpr uint32_t NO_RECORD = ~0u;
+
+	struct Record
+	{
+		Type type = Empty;
+		// interned name of a Struct member, NO_RECORD for the root and the elements of arrays
+		uint32_t name = NO_RECORD;
+		uint32_t offset = 0u;
+		uint32_t size = 0u;
+		// Struct: members are the records [first, first + count), Array: record first describes all count elements
+		uint32_t first = 0u;
+		uint32_t count = 0u;
+		// distance between the elements of an Array
+		uint32_t stride = 0u;
+	};
+
+public:
+	LayoutTable( const LayoutElement& root ) IFNOEXCEPT;
+	size_t GetSizeInBytes() const noexcept { return records.front().size; }
+	const std::vector<Record>& GetRecords() const noexcept { return records; }
+	static const std::string& GetName( uint32_t name ) noexcept;
+	/**
+	 * @return index of the member of the Struct record, NO_RECORD if it has no member of that name
+	*/
+	uint32_t FindMember( uint32_t parent, std::string_view name ) const noexcept;
+	/**
+	 * @brief Walks the path like LayoutElement::ResolvePath does
+	 * @return offset of the element at the end of the path and its record, nullptr if the path doesn't exist
+	*/
+	std::pair<size_t, const Record*> ResolvePath( const std::string& path ) const IFNOEXCEPT;
+	/**
+	 * @brief Handles of the tree root, resolved through the table
+	*/
+	template<typename T>
+	ElementHandle<T> MakeHandle( const LayoutElement* pRoot, const std::string& path ) const IFNOEXCEPT
+	{
+		static_assert( ReverseMap<std::remove_const_t<T>>::valid, "Unsupported SysType used in handle" );
+		const auto [offset, pRecord] = ResolvePath( path );
+		if( pRecord == nullptr || pRecord->type != ReverseMap<T>::type )
+		{
+			assert( "Handle type doesn't match the element" && pRecord == nullptr );
+			return {};
+		}
+		return { pRoot, offset };
+	}
+	template<typename T>
+	ArrayHandle<T> MakeArrayHandle( const LayoutElement* pRoot, const std::string& path ) const IFNOEXCEPT
+	{
+		static_assert( ReverseMap<std::remove_const_t<T>>::valid, "Unsupported SysType used in handle" );
+		const auto [offset, pRecord] = ResolvePath( path );
+		if( pRecord == nullptr || pRecord->type != Array || records[pRecord->first].type != ReverseMap<T>::type )
+		{
+			assert( "Handle type doesn't match the element" && pRecord == nullptr );
+			return {};
+		}
+		// the first element may start past the offset of the Array
+		return { pRoot, offset - pRecord->offset + records[pRecord->first].offset, pRecord->stride, pRecord->count };
+	}
+	/**
+	 * @return true if the records have the types, offsets, sizes, strides and names of the tree
+	*/
+	bool Matches( const LayoutElement& root ) const IFNOEXCEPT;
+
+private:
+	static uint32_t InternName( const std::string& name );
+	bool Matches( uint32_t index, const LayoutElement& element ) const IFNOEXCEPT;
+
+private:
+	std::vector<Record> records;
+};
+
+
 // the layout class serves as a shell to hold the root of the LayoutElement tree
 // client does not create LayoutElements directly, create a raw layout and then
 // use it to access the elements and add on from there. When building is done,
@@ -279,6 +504,10 @@ public:
 	{
 		return pRoot->Add<type>( key );
 	}
+	LayoutElement& Add( Type type, const std::string& key ) IFNOEXCEPT
+	{
+		return pRoot->Add( type, key );
+	}
 private:
 	// reset this object with an empty struct at its root
 	void ClearRoot() noexcept;
@@ -297,11 +526,20 @@ public:
 	const LayoutElement& operator[]( const std::string& key ) const IFNOEXCEPT;
 	// get a share on layout tree root
 	std::shared_ptr<LayoutElement> ShareRoot() const noexcept;
+	// compiled table of the layout, owned by DynamicLayout
+	const LayoutTable& GetTable() const noexcept { return *pTable; }
+	// resolve a path from the root Struct once, for access to the buffers of this layout without keys
+	template<typename T>
+	ElementHandle<T> MakeHandle( const std::string& path ) const IFNOEXCEPT { return pTable->MakeHandle<T>( pRoot.get(), path ); }
+	template<typename T>
+	ArrayHandle<T> MakeArrayHandle( const std::string& path ) const IFNOEXCEPT { return pTable->MakeArrayHandle<T>( pRoot.get(), path ); }
 private:
 	// this ctor used by Codex to return cooked layouts
-	CookedLayout( std::shared_ptr<LayoutElement> pRoot ) noexcept;
+	CookedLayout( std::shared_ptr<LayoutElement> pRoot, const LayoutTable* pTable ) noexcept;
 	// use to pilfer the layout tree
 	std::shared_ptr<LayoutElement> RelinquishRoot() noexcept;
+private:
+	const LayoutTable* pTable;
 };
 
 
@@ -410,20 +648,29 @@ public:
 		static_assert( ReverseMap<std::remove_const_t<T>>::valid, "Unsupported SysType used in conversion" );
 		return *reinterpret_cast<T*>( pBytes + offset + pLayout->Resolve<T>() );
 	}
-	// assignment for writing to as a supported SysType
+	// assignment for writing to as a supported SysType, only a changed value marks its bytes dirty in the buffer
 	template<typename T>
 	T& operator=( const T& rhs ) const IFNOEXCEPT
 	{
 		static_assert( ReverseMap<std::remove_const_t<T>>::valid, "Unsupported SysType used in assignment" );
-		return static_cast<T&>( *this ) = rhs;
+		auto& dest = static_cast<T&>( *this );
+		if( std::memcmp( &dest, &rhs, sizeof( T ) ) != 0 )
+		{
+			dest = rhs;
+			MarkDirty( size_t( reinterpret_cast<std::byte*>( &dest ) - pBytes ), sizeof( T ) );
+		}
+		return dest;
 	}
 
 private:
 	// refs should only be constructable by other refs or by the buffer
-	ElementRef( const LayoutElement* pLayout, std::byte* pBytes, size_t offset ) noexcept;
+	ElementRef( const LayoutElement* pLayout, std::byte* pBytes, size_t offset, Buffer* pBuffer ) noexcept;
+	void MarkDirty( size_t byteOffset, size_t size ) const noexcept;
 	size_t offset;
 	const LayoutElement* pLayout;
 	std::byte* pBytes;
+	// buffer of the bytes, which tracks the ranges written through the ref
+	Buffer* pBuffer;
 };
 
 /**
@@ -444,6 +691,14 @@ public:
 	// have to be careful with this one...
 	// the buffer that has once been pilfered must not be used :x
 	Buffer( Buffer&& ) noexcept;
+	/**
+	 * @brief Written bytes, widened to whole 16 byte registers
+	*/
+	struct DirtyRange
+	{
+		size_t begin = 0u;
+		size_t end = 0u;
+	};
 	// how you begin indexing into buffer (root is always Struct)
 	ElementRef operator[]( const std::string& key ) IFNOEXCEPT;
 	// if Buffer is const, you only get to index into the buffer with a read-only proxy
@@ -456,16 +711,92 @@ public:
 	size_t GetSizeInBytes() const noexcept;
 	const LayoutElement& GetRootLayoutElement() const noexcept;
 	/**
-	 * @brief copy bytes from another buffer (layouts must match)
+	 * @brief copy bytes from another buffer (layouts must match), registers that change are marked dirty
 	*/
 	void CopyFrom( const Buffer& ) IFNOEXCEPT;
+	/**
+	 * @brief copy the bytes of a C++ struct with the same packing, the size must match
+	*/
+	void CopyFrom( const void* pData, size_t size ) IFNOEXCEPT;
+	/**
+	 * @brief Ranges written since they were cleared, sorted and merged when they overlap or touch
+	*/
+	const std::vector<DirtyRange>& GetDirtyRanges() const noexcept { return dirtyRanges; }
+	bool IsDirty() const noexcept { return !dirtyRanges.empty(); }
+	void ClearDirtyRanges() noexcept { dirtyRanges.clear(); }
+	void MarkDirty( size_t offset, size_t size ) noexcept;
+	/**
+	 * @brief Marks registers that differ from an earlier copy of the buffer, for bytes written through
+	 * * references and pointers that the buffer can't see
+	*/
+	void MarkChangedSince( const Buffer& previous ) IFNOEXCEPT;
 	/**
 	 * @brief return another sptr to the layout root
 	*/
 	std::shared_ptr<LayoutElement> ShareLayoutRoot() const noexcept;
+	/**
+	 * @brief Resolves a path in the layout of the buffer, the handle is valid for every buffer of the layout
+	*/
+	template<typename T>
+	ElementHandle<T> MakeHandle( const std::string& path ) const IFNOEXCEPT { return pTable->MakeHandle<T>( pLayoutRoot.get(), path ); }
+	template<typename T>
+	ArrayHandle<T> MakeArrayHandle( const std::string& path ) const IFNOEXCEPT { return pTable->MakeArrayHandle<T>( pLayoutRoot.get(), path ); }
+	/**
+	 * @brief Reads the element of the handle, no keys are compared and no types are checked
+	*/
+	template<typename T>
+	const T& Get( const ElementHandle<T>& handle ) const noexcept
+	{
+		assert( handle.pRoot == pLayoutRoot.get() );
+		return *reinterpret_cast<const T*>( bytes.data() + handle.offset );
+	}
+	template<typename T>
+	void Set( const ElementHandle<T>& handle, const T& value ) noexcept
+	{
+		assert( handle.pRoot == pLayoutRoot.get() );
+		auto& dest = *reinterpret_cast<T*>( bytes.data() + handle.offset );
+		if( std::memcmp( &dest, &value, sizeof( T ) ) != 0 )
+		{
+			dest = value;
+			MarkDirty( handle.offset, sizeof( T ) );
+		}
+	}
+	/**
+	 * @brief Typed view of all elements of the array, written in bulk, so the whole array is marked dirty
+	*/
+	template<typename T>
+	StridedView<T> GetSpan( const ArrayHandle<T>& handle ) noexcept
+	{
+		assert( handle.pRoot == pLayoutRoot.get() );
+		MarkDirty( handle.offset, handle.stride * handle.size );
+		return { bytes.data() + handle.offset, handle.stride, handle.size };
+	}
+	template<typename T>
+	StridedView<const T> GetSpan( const ArrayHandle<T>& handle ) const noexcept
+	{
+		assert( handle.pRoot == pLayoutRoot.get() );
+		return { bytes.data() + handle.offset, handle.stride, handle.size };
+	}
+
+	struct BenchmarkStats
+	{
+		size_t accessCount = 0u;
+		// average time of a write and a read of an element
+		float keyedTime = 0.f;
+		float handleTime = 0.f;
+	};
+	/**
+	 * @brief Times keyed and handle access to a material buffer and a blur kernel
+	*/
+	static BenchmarkStats Benchmark( size_t iterations );
+private:
+	// marks the registers in which the bytes differ from the old bytes
+	void MarkDifferences( const std::byte* pOld ) noexcept;
 private:
 	std::shared_ptr<LayoutElement> pLayoutRoot;
+	const LayoutTable* pTable;
 	std::vector<std::byte> bytes;
+	std::vector<DirtyRange> dirtyRanges;
 };
 
 #ifndef DCB_IMPL_SOURCE
@@ -8,27 +8,217 @@
  */
 #include "DynamicLayout.h"
 
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
 CookedLayout DynamicLayout::Resolve( RawLayout&& layout ) IFNOEXCEPT
 {
-	auto sig = layout.GetSignature();
+	// the hash of an unfinalized tree has no offsets, but offsets follow from the structure
+	auto key = uint64_t( layout.pRoot->GetStructureHash() );
 	auto& map = Get_().map;
-	const auto i = map.find( sig );
-	// idential layout already exists
-	if( i != map.end() )
-	{
-		// input layout is expected to be cleared after Resolve
-		// so just throw away the layout tree
-		layout.ClearRoot();
-		return { i->second };
+	for( auto i = map.find( key ); i != map.end(); i = map.find( ++key ) )
+	{
+		// idential layout already exists
+		if( i->second.pRoot->HasSameStructure( *layout.pRoot ) )
+		{
+			// input layout is expected to be cleared after Resolve
+			// so just throw away the layout tree
+			layout.ClearRoot();
+			return { i->second.pRoot, i->second.pTable.get() };
+		}
 	}
-	// otherwise add layout root element to map
-	auto result = map.insert( { std::move( sig ),layout.DeliverRoot() } );
+	// otherwise add layout root element and its compiled table to map
+	auto pRoot = layout.DeliverRoot();
+	auto pTable = std::make_unique<const LayoutTable>( *pRoot );
+	assert( "Layout table doesn't match the layout tree" && pTable->Matches( *pRoot ) );
+	const auto& entry = map.emplace( key, Entry{ std::move( pRoot ), std::move( pTable ) } ).first->second;
 	// return layout with additional reference to root
-	return { result.first->second };
+	return { entry.pRoot, entry.pTable.get() };
+}
+
+DynamicLayout::BenchmarkStats DynamicLayout::Benchmark( size_t iterations )
+{
+	using namespace std::chrono;
+	BenchmarkStats stats;
+	iterations = std::max<size_t>( iterations, 1u );
+
+	// layouts like the ones the engine builds: a material, an array of lights and a blur kernel
+	const auto makeRaws = []()
+	{
+		std::vector<RawLayout> raws( 3u );
+		raws[0].Add<Float3>( "materialColor" );
+		raws[0].Add<Float3>( "specularColor" );
+		raws[0].Add<Float>( "specularWeight" );
+		raws[0].Add<Float>( "specularGloss" );
+		raws[0].Add<Bool>( "useGlossAlpha" );
+		raws[0].Add<Bool>( "useSpecularMap" );
+		raws[0].Add<Bool>( "useNormalMap" );
+		raws[0].Add<Float>( "normalMapWeight" );
+		raws[1].Add<Integer>( "count" );
+		raws[1].Add<Array>( "lights" );
+		raws[1]["lights"].Set<Struct>( 8u );
+		raws[1]["lights"].T().Add<Float3>( "pos" );
+		raws[1]["lights"].T().Add<Float3>( "diffuseColor" );
+		raws[1]["lights"].T().Add<Float>( "diffuseIntensity" );
+		raws[1]["lights"].T().Add<Float>( "attConst" );
+		raws[1]["lights"].T().Add<Float>( "attLin" );
+		raws[1]["lights"].T().Add<Float>( "attQuad" );
+		raws[2].Add<Integer>( "nTaps" );
+		raws[2].Add<Array>( "coefficients" );
+		raws[2]["coefficients"].Set<Float>( 15u );
+		return raws;
+	};
+	auto raws = makeRaws();
+	std::vector<std::string> signatures;
+	std::vector<uint64_t> hashes;
+	for( const auto& raw : raws )
+	{
+		signatures.push_back( raw.GetSignature() );
+		hashes.push_back( uint64_t( raw.pRoot->GetStructureHash() ) );
+	}
+	std::vector<CookedLayout> cooked;
+	for( auto& raw : raws )
+	{
+		cooked.push_back( Resolve( std::move( raw ) ) );
+	}
+	stats.layouts = cooked.size();
+
+	// maps of both keys with the same entries, so only building the key and looking it up differ
+	std::unordered_map<std::string, const LayoutElement*> signatureMap;
+	std::unordered_map<uint64_t, const LayoutElement*> hashMap;
+	for( size_t i = 0; i < cooked.size(); i++ )
+	{
+		signatureMap.emplace( signatures[i], cooked[i].pRoot.get() );
+		hashMap.emplace( hashes[i], cooked[i].pRoot.get() );
+	}
+
+	std::vector<std::vector<std::string>> paths( cooked.size() );
+	for( size_t i = 0; i < cooked.size(); i++ )
+	{
+		const auto& table = cooked[i].GetTable();
+		// every leaf record, named by walking the table from the root
+		std::vector<std::pair<uint32_t, std::string>> pending{ { 0u, "" } };
+		while( !pending.empty() )
+		{
+			const auto [index, path] = pending.back();
+			pending.pop_back();
+			const auto& r = table.GetRecords()[index];
+			if( r.type == Struct )
+			{
+				for( uint32_t m = r.first; m < r.first + r.count; m++ )
+				{
+					pending.push_back( { m, path + ( path.empty() ? "" : "." ) + LayoutTable::GetName( table.GetRecords()[m].name ) } );
+				}
+			}
+			else if( r.type == Array )
+			{
+				for( uint32_t e = 0; e < r.count; e++ )
+				{
+					pending.push_back( { r.first, path + "[" + std::to_string( e ) + "]" } );
+				}
+			}
+			else
+			{
+				paths[i].push_back( path );
+			}
+		}
+	}
+
+	size_t sink = 0u;
+	const auto time = [&]( auto&& op, size_t opsPerIteration )
+	{
+		const auto start = steady_clock::now();
+		for( size_t it = 0; it < iterations; it++ )
+		{
+			op();
+		}
+		return duration<float, std::nano>( steady_clock::now() - start ).count() / float( iterations * opsPerIteration );
+	};
+
+	// a fresh raw layout every iteration, like the Resolves of the loaders
+	auto keyRaws = makeRaws();
+	stats.signatureKeyTime = time( [&]()
+	{
+		for( const auto& raw : keyRaws )
+		{
+			sink += signatureMap.find( raw.GetSignature() ) != signatureMap.end();
+		}
+	}, keyRaws.size() );
+	stats.hashKeyTime = time( [&]()
+	{
+		for( const auto& raw : keyRaws )
+		{
+			const auto i = hashMap.find( uint64_t( raw.pRoot->GetStructureHash() ) );
+			sink += i != hashMap.end() && i->second->HasSameStructure( *raw.pRoot );
+		}
+	}, keyRaws.size() );
+
+	size_t pathCount = 0u;
+	for( const auto& p : paths )
+	{
+		pathCount += p.size();
+	}
+	stats.treePathTime = time( [&]()
+	{
+		for( size_t i = 0; i < cooked.size(); i++ )
+		{
+			for( const auto& path : paths[i] )
+			{
+				const auto [offset, pElement] = cooked[i].pRoot->ResolvePath( path );
+				sink += offset + pElement->GetOffsetBegin();
+			}
+		}
+	}, pathCount );
+	stats.tablePathTime = time( [&]()
+	{
+		for( size_t i = 0; i < cooked.size(); i++ )
+		{
+			for( const auto& path : paths[i] )
+			{
+				sink += cooked[i].GetTable().ResolvePath( path ).first;
+			}
+		}
+	}, pathCount );
+
+	// the tree version shares the root and walks it for the size, like Buffer did before the table
+	stats.treeBufferTime = time( [&]()
+	{
+		for( const auto& c : cooked )
+		{
+			const auto pRoot = c.ShareRoot();
+			std::vector<char> bytes( pRoot->GetOffsetEnd() );
+			sink += bytes.size();
+		}
+	}, cooked.size() );
+	stats.tableBufferTime = time( [&]()
+	{
+		for( const auto& c : cooked )
+		{
+			Buffer buf( c );
+			sink += buf.GetSizeInBytes();
+		}
+	}, cooked.size() );
+
+	for( size_t i = 0; i < cooked.size(); i++ )
+	{
+		stats.mismatches += !cooked[i].GetTable().Matches( *cooked[i].pRoot );
+		for( const auto& path : paths[i] )
+		{
+			const auto [treeOffset, pElement] = cooked[i].pRoot->ResolvePath( path );
+			const auto [tableOffset, pRecord] = cooked[i].GetTable().ResolvePath( path );
+			stats.mismatches += pRecord == nullptr || pRecord->type != pElement->GetType() ||
+				tableOffset != treeOffset + pElement->GetOffsetBegin();
+		}
+	}
+	// keeps the timed loops from being optimized away
+	static volatile size_t benchmarkSink;
+	benchmarkSink = sink;
+	return stats;
 }
 
 DynamicLayout& DynamicLayout::Get_() noexcept
 {
 	static DynamicLayout codex;
 	return codex;
-}
\ No newline at end of file
+}
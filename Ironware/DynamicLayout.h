@@ -16,10 +16,42 @@
 
 class DynamicLayout
 {
+public:
+	/**
+	 * @brief Timings of the tree and of the compiled table, in nanoseconds per operation
+	*/
+	struct BenchmarkStats
+	{
+		size_t layouts = 0u;
+		// building the key of a layout and finding it in the map
+		float signatureKeyTime = 0.f;
+		float hashKeyTime = 0.f;
+		// resolving every leaf path of a layout
+		float treePathTime = 0.f;
+		float tablePathTime = 0.f;
+		// constructing a Buffer of a cooked layout
+		float treeBufferTime = 0.f;
+		float tableBufferTime = 0.f;
+		// paths that the table resolves differently than the tree
+		size_t mismatches = 0u;
+	};
+
 public:
 	static CookedLayout Resolve( RawLayout&& layout ) IFNOEXCEPT;
+	/**
+	 * @brief Times the signature string key and the tree walks against the structural hash and the tables
+	*/
+	static BenchmarkStats Benchmark( size_t iterations );
+
+private:
+	struct Entry
+	{
+		std::shared_ptr<LayoutElement> pRoot;
+		std::unique_ptr<const LayoutTable> pTable;
+	};
 
 private:
 	static DynamicLayout& Get_() noexcept;
-	std::unordered_map<std::string, std::shared_ptr<LayoutElement>> map;
-};
\ No newline at end of file
+	// keyed by the structural hash, colliding layouts of different structure probe the following keys
+	std::unordered_map<uint64_t, Entry> map;
+};
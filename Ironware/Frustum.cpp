@@ -0,0 +1,259 @@
+/*!
+ * \file Frustum.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ *
+ */
+#include "Frustum.h"
+#include "Camera.h"
+#include "Drawable.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+namespace dx = DirectX;
+
+void Frustum::Update( const Camera& cam ) noexcept
+{
+	Update( cam.GetMatrix() * cam.GetProjection() );
+}
+
+void Frustum::Update( dx::FXMMATRIX viewProj ) noexcept
+{
+	// rows of the transposed matrix are the columns of the clip transform
+	const auto m = dx::XMMatrixTranspose( viewProj );
+	const dx::XMVECTOR clipPlanes[PLANE_COUNT] = {
+		dx::XMVectorAdd( m.r[3], m.r[0] ),      // left
+		dx::XMVectorSubtract( m.r[3], m.r[0] ), // right
+		dx::XMVectorAdd( m.r[3], m.r[1] ),      // bottom
+		dx::XMVectorSubtract( m.r[3], m.r[1] ), // top
+		m.r[2],                                 // near, clip z starts at 0 in D3D
+		dx::XMVectorSubtract( m.r[3], m.r[2] ), // far
+	};
+	for( size_t i = 0; i < PLANE_COUNT; i++ )
+	{
+		dx::XMStoreFloat4( &planes[i], dx::XMPlaneNormalize( clipPlanes[i] ) );
+	}
+	// the view is a rigid transform, so the y row keeps the length of the projection scale
+	dx::XMStoreFloat4( &depthPlane, m.r[3] );
+	projectionScale = dx::XMVectorGetX( dx::XMVector3Length( m.r[1] ) );
+	// eye is the point with zero clip x, y and w, for a perspective projection that is the z axis of clip space
+	const auto eyeH = dx::XMVector4Transform( dx::g_XMIdentityR2, dx::XMMatrixInverse( nullptr, viewProj ) );
+	const float eyeW = dx::XMVectorGetW( eyeH );
+	hasEye = std::abs( eyeW ) > 1e-6f;
+	if( hasEye )
+	{
+		dx::XMStoreFloat3( &eye, dx::XMVectorScale( eyeH, 1.f / eyeW ) );
+	}
+
+	visibleCount.store( 0u, std::memory_order_relaxed );
+	culledCount.store( 0u, std::memory_order_relaxed );
+	meshletTriangles.store( 0u, std::memory_order_relaxed );
+	frustumCulledTriangles.store( 0u, std::memory_order_relaxed );
+	coneCulledTriangles.store( 0u, std::memory_order_relaxed );
+	meshletRanges.store( 0u, std::memory_order_relaxed );
+	// jobs of the previous frame that referred to the ranges are executed by now
+	for( auto& b : rangeBuckets )
+	{
+		b.ranges.clear();
+	}
+}
+
+uint32_t Frustum::Test( const BoundingBoxSet::Block& block ) const noexcept
+{
+	if( !enabled )
+	{
+		return ( 1u << BoundingBoxSet::BLOCK_SIZE ) - 1u;
+	}
+
+	const auto load = []( const float* lanes )
+	{
+		return dx::XMLoadFloat4A( reinterpret_cast<const dx::XMFLOAT4A*>( lanes ) );
+	};
+	const auto cx = load( block.centerX );
+	const auto cy = load( block.centerY );
+	const auto cz = load( block.centerZ );
+	const auto ex = load( block.extentX );
+	const auto ey = load( block.extentY );
+	const auto ez = load( block.extentZ );
+
+	// box is outside if it is fully behind any of the planes
+	auto outside = dx::XMVectorFalseInt();
+	for( const auto& p : planes )
+	{
+		const auto distance =
+			dx::XMVectorMultiplyAdd( dx::XMVectorReplicate( p.x ), cx,
+			dx::XMVectorMultiplyAdd( dx::XMVectorReplicate( p.y ), cy,
+			dx::XMVectorMultiplyAdd( dx::XMVectorReplicate( p.z ), cz,
+			dx::XMVectorReplicate( p.w ) ) ) );
+		const auto radius =
+			dx::XMVectorMultiplyAdd( dx::XMVectorReplicate( std::abs( p.x ) ), ex,
+			dx::XMVectorMultiplyAdd( dx::XMVectorReplicate( std::abs( p.y ) ), ey,
+			dx::XMVectorMultiply( dx::XMVectorReplicate( std::abs( p.z ) ), ez ) ) );
+		outside = dx::XMVectorOrInt( outside, dx::XMVectorLess( dx::XMVectorAdd( distance, radius ), dx::XMVectorZero() ) );
+	}
+
+	uint32_t lanes[BoundingBoxSet::BLOCK_SIZE];
+	dx::XMStoreInt4( lanes, outside );
+	uint32_t mask = 0u;
+	for( uint32_t i = 0; i < BoundingBoxSet::BLOCK_SIZE; i++ )
+	{
+		mask |= ( lanes[i] == 0u ) ? ( 1u << i ) : 0u;
+	}
+	return mask;
+}
+
+MeshletSet::Visible Frustum::CullMeshlets( const MeshletSet& meshlets, dx::FXMMATRIX world, bool cullBackfaces ) const noexcept
+{
+	// a local point is inside where the world point is, so plane * transpose( world ) is the local plane,
+	// normalized again to measure distances in local units; the sign of the view direction dotted with
+	// the normal doesn't change either, so both tests stay exact under non-uniform scale
+	const auto toLocalPlane = dx::XMMatrixTranspose( world );
+	dx::XMFLOAT4 localPlanes[PLANE_COUNT];
+	for( size_t i = 0; i < PLANE_COUNT; i++ )
+	{
+		dx::XMStoreFloat4( &localPlanes[i], dx::XMPlaneNormalize( dx::XMVector4Transform( dx::XMLoadFloat4( &planes[i] ), toLocalPlane ) ) );
+	}
+	dx::XMVECTOR determinant;
+	const auto toLocal = dx::XMMatrixInverse( &determinant, world );
+	const bool testCones = cullBackfaces && hasEye && dx::XMVectorGetX( determinant ) > 0.f;
+	const auto localEye = dx::XMVector3TransformCoord( dx::XMLoadFloat3( &eye ), toLocal );
+	const auto eyeX = dx::XMVectorSplatX( localEye );
+	const auto eyeY = dx::XMVectorSplatY( localEye );
+	const auto eyeZ = dx::XMVectorSplatZ( localEye );
+
+	const auto load = []( const float* lanes )
+	{
+		return dx::XMLoadFloat4A( reinterpret_cast<const dx::XMFLOAT4A*>( lanes ) );
+	};
+	assert( "Meshlets are culled only by the threads of the frame scheduler" && TaskScheduler::IsFrameThread() );
+	auto& ranges = rangeBuckets[TaskScheduler::GetFrameThreadIndex()].ranges;
+	MeshletSet::Visible visible = { &ranges, (uint32_t)ranges.size(), 0u };
+	const auto& list = meshlets.GetMeshlets();
+	size_t triangles = 0u;
+	size_t outsideTriangles = 0u;
+	size_t backfacingTriangles = 0u;
+	for( size_t b = 0; b < meshlets.GetBlockCount(); b++ )
+	{
+		const auto& block = meshlets.GetBlock( b );
+		const auto cx = load( block.centerX );
+		const auto cy = load( block.centerY );
+		const auto cz = load( block.centerZ );
+		const auto radius = load( block.radius );
+
+		// sphere is outside if it is fully behind any of the planes
+		const auto negRadius = dx::XMVectorNegate( radius );
+		auto outside = dx::XMVectorFalseInt();
+		for( const auto& p : localPlanes )
+		{
+			const auto distance =
+				dx::XMVectorMultiplyAdd( dx::XMVectorReplicate( p.x ), cx,
+				dx::XMVectorMultiplyAdd( dx::XMVectorReplicate( p.y ), cy,
+				dx::XMVectorMultiplyAdd( dx::XMVectorReplicate( p.z ), cz,
+				dx::XMVectorReplicate( p.w ) ) ) );
+			outside = dx::XMVectorOrInt( outside, dx::XMVectorLess( distance, negRadius ) );
+		}
+
+		// all of the triangles face away if the view direction stays inside of the cone around the axis
+		auto backfacing = dx::XMVectorFalseInt();
+		if( testCones )
+		{
+			const auto vx = dx::XMVectorSubtract( cx, eyeX );
+			const auto vy = dx::XMVectorSubtract( cy, eyeY );
+			const auto vz = dx::XMVectorSubtract( cz, eyeZ );
+			const auto length = dx::XMVectorSqrt( dx::XMVectorMultiplyAdd( vx, vx, dx::XMVectorMultiplyAdd( vy, vy, dx::XMVectorMultiply( vz, vz ) ) ) );
+			const auto along = dx::XMVectorMultiplyAdd( vx, load( block.axisX ),
+				dx::XMVectorMultiplyAdd( vy, load( block.axisY ), dx::XMVectorMultiply( vz, load( block.axisZ ) ) ) );
+			backfacing = dx::XMVectorGreaterOrEqual( along, dx::XMVectorMultiplyAdd( load( block.cutoff ), length, radius ) );
+		}
+
+		uint32_t outsideLanes[MeshletSet::BLOCK_SIZE];
+		uint32_t backfacingLanes[MeshletSet::BLOCK_SIZE];
+		dx::XMStoreInt4( outsideLanes, outside );
+		dx::XMStoreInt4( backfacingLanes, backfacing );
+		const size_t count = std::min( MeshletSet::BLOCK_SIZE, list.size() - b * MeshletSet::BLOCK_SIZE );
+		for( size_t lane = 0; lane < count; lane++ )
+		{
+			const auto& m = list[b * MeshletSet::BLOCK_SIZE + lane];
+			triangles += m.indexCount / 3u;
+			if( outsideLanes[lane] )
+			{
+				outsideTriangles += m.indexCount / 3u;
+			}
+			else if( backfacingLanes[lane] )
+			{
+				backfacingTriangles += m.indexCount / 3u;
+			}
+			else if( visible.count > 0u && ranges.back().startIndex + ranges.back().indexCount == m.startIndex )
+			{
+				ranges.back().indexCount += m.indexCount;
+			}
+			else
+			{
+				ranges.push_back( { m.startIndex, m.indexCount } );
+				visible.count++;
+			}
+		}
+	}
+
+	meshletTriangles.fetch_add( triangles, std::memory_order_relaxed );
+	frustumCulledTriangles.fetch_add( outsideTriangles, std::memory_order_relaxed );
+	coneCulledTriangles.fetch_add( backfacingTriangles, std::memory_order_relaxed );
+	meshletRanges.fetch_add( visible.count, std::memory_order_relaxed );
+	return visible;
+}
+
+Frustum::Containment Frustum::Classify( const dx::XMFLOAT3& center, const dx::XMFLOAT3& extents ) const noexcept
+{
+	if( !enabled )
+	{
+		return Containment::Inside;
+	}
+
+	auto result = Containment::Inside;
+	for( const auto& p : planes )
+	{
+		const float distance = p.x * center.x + p.y * center.y + p.z * center.z + p.w;
+		const float radius = std::abs( p.x ) * extents.x + std::abs( p.y ) * extents.y + std::abs( p.z ) * extents.z;
+		if( distance + radius < 0.f )
+		{
+			return Containment::Outside;
+		}
+		if( distance - radius < 0.f )
+		{
+			result = Containment::Intersects;
+		}
+	}
+	return result;
+}
+
+float Frustum::GetScreenSize( const dx::XMFLOAT3& center, const dx::XMFLOAT3& extents ) const noexcept
+{
+	const float radius = std::sqrt( extents.x * extents.x + extents.y * extents.y + extents.z * extents.z );
+	const float depth = depthPlane.x * center.x + depthPlane.y * center.y + depthPlane.z * center.z + depthPlane.w;
+	const float nearest = depth - radius;
+	if( nearest <= 0.f )
+	{
+		return FLT_MAX;
+	}
+	return radius * projectionScale / nearest;
+}
+
+size_t Frustum::SelectLod( const Drawable& drawable, const dx::XMFLOAT3& center, const dx::XMFLOAT3& extents ) const noexcept
+{
+	if( drawable.GetLodCount() < 2u )
+	{
+		return 0u;
+	}
+	return drawable.SelectLod( GetScreenSize( center, extents ), lodThreshold );
+}
+
+void Frustum::AddStats( size_t visible, size_t culled ) const noexcept
+{
+	visibleCount.fetch_add( visible, std::memory_order_relaxed );
+	culledCount.fetch_add( culled, std::memory_order_relaxed );
+}
@@ -0,0 +1,134 @@
+/*!
+ * \file Frustum.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief View frustum that is used for CPU culling of bounding boxes
+ *
+ * \note Visible/culled counters are accumulated by the submitting threads
+ * and are reset every time the frustum is updated
+ * \note Meshlets are tested in the local space of their mesh, planes and eye are moved there
+ * once per mesh. Ranges of the visible meshlets are stored per thread until the next update.
+ */
+#pragma once
+
+#include "BoundingBoxSet.h"
+#include "MeshletSet.h"
+#include "TaskScheduler.h"
+
+#include <DirectXMath.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+class Camera;
+class Drawable;
+
+class Frustum
+{
+public:
+	enum class Containment
+	{
+		Outside,
+		Intersects,
+		Inside,
+	};
+
+public:
+	Frustum() = default;
+	Frustum( const Frustum& ) = delete;
+	Frustum& operator=( const Frustum& ) = delete;
+	/**
+	 * @brief Extracts planes from the view and projection of the camera and resets the counters
+	*/
+	void Update( const Camera& cam ) noexcept;
+	void Update( DirectX::FXMMATRIX viewProj ) noexcept;
+	/**
+	 * @brief Tests 4 boxes of the block at once
+	 * @return mask with bit i set if box i of the block intersects the frustum
+	*/
+	uint32_t Test( const BoundingBoxSet::Block& block ) const noexcept;
+	/**
+	 * @brief Classifies single box, used for the hierarchy nodes
+	*/
+	Containment Classify( const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents ) const noexcept;
+	/**
+	 * @brief Tests meshlets against the planes and, for single sided meshes, their normal cones against the eye
+	 * @param world transform of the mesh, mirroring ones skip the cone test
+	 * @return ranges of the visible meshlets, neighbors in the index buffer are merged into one range
+	*/
+	MeshletSet::Visible CullMeshlets( const MeshletSet& meshlets, DirectX::FXMMATRIX world, bool cullBackfaces ) const noexcept;
+	/**
+	 * @brief Projected radius of the box bounds in units of half the viewport height
+	 * @note Distance is taken to the nearest point of the bounding sphere, so it grows without
+	 * * limit when the camera is inside of the bounds
+	*/
+	float GetScreenSize( const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents ) const noexcept;
+	/**
+	 * @brief Level of detail of the drawable for its bounds as seen from this frustum
+	*/
+	size_t SelectLod( const Drawable& drawable, const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents ) const noexcept;
+	/**
+	 * @param threshold largest projected simplification error in units of half the viewport height,
+	 * * 0 keeps all of the drawables at full detail
+	*/
+	void SetLodThreshold( float threshold ) noexcept { lodThreshold = threshold; }
+	float GetLodThreshold() const noexcept { return lodThreshold; }
+	void AddStats( size_t visible, size_t culled ) const noexcept;
+	size_t GetVisibleCount() const noexcept { return visibleCount.load( std::memory_order_relaxed ); }
+	size_t GetCulledCount() const noexcept { return culledCount.load( std::memory_order_relaxed ); }
+	/**
+	 * @brief Triangles of the meshes that were culled by meshlets, the rest of them were drawn
+	*/
+	size_t GetMeshletTriangleCount() const noexcept { return meshletTriangles.load( std::memory_order_relaxed ); }
+	size_t GetFrustumCulledTriangleCount() const noexcept { return frustumCulledTriangles.load( std::memory_order_relaxed ); }
+	size_t GetConeCulledTriangleCount() const noexcept { return coneCulledTriangles.load( std::memory_order_relaxed ); }
+	// draws of the merged visible ranges
+	size_t GetMeshletRangeCount() const noexcept { return meshletRanges.load( std::memory_order_relaxed ); }
+	void SetEnabled( bool enabled_in ) noexcept { enabled = enabled_in; }
+	bool IsEnabled() const noexcept { return enabled; }
+	void SetMeshletCulling( bool enabled_in ) noexcept { meshletCulling = enabled_in; }
+	/**
+	 * @return true if meshes with meshlets should be submitted through CullMeshlets
+	*/
+	bool CullsMeshlets() const noexcept { return enabled && meshletCulling; }
+	bool IsMeshletCullingEnabled() const noexcept { return meshletCulling; }
+
+public:
+	// about a pixel at 1080 lines
+	static constexpr float DEFAULT_LOD_THRESHOLD = 2.f / 1080.f;
+
+private:
+	static constexpr size_t PLANE_COUNT = 6u;
+
+private:
+	// padded to cache line, so the threads don't write to the same line on push_back
+	struct alignas( 64 ) RangeBucket
+	{
+		std::vector<MeshletSet::Range> ranges;
+	};
+
+private:
+	// normals point inside, ax + by + cz + d >= 0 for the points inside
+	DirectX::XMFLOAT4 planes[PLANE_COUNT] = {};
+	// view depth of a point is its dot product with the clip w row
+	DirectX::XMFLOAT4 depthPlane = { 0.f, 0.f, 0.f, 1.f };
+	// length that a unit at unit depth has in clip y
+	float projectionScale = 1.f;
+	// orthographic projections have no eye point, cones aren't tested for them
+	DirectX::XMFLOAT3 eye = {};
+	bool hasEye = false;
+	float lodThreshold = DEFAULT_LOD_THRESHOLD;
+	bool enabled = true;
+	bool meshletCulling = true;
+	mutable std::atomic<size_t> visibleCount = 0u;
+	mutable std::atomic<size_t> culledCount = 0u;
+	mutable std::atomic<size_t> meshletTriangles = 0u;
+	mutable std::atomic<size_t> frustumCulledTriangles = 0u;
+	mutable std::atomic<size_t> coneCulledTriangles = 0u;
+	mutable std::atomic<size_t> meshletRanges = 0u;
+	mutable std::array<RangeBucket, TaskScheduler::MAX_THREADS> rangeBuckets;
+};
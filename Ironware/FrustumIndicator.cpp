@@ -61,6 +61,7 @@ FrustumIndicator::FrustumIndicator( Graphics& gfx, float width, float height, fl
 			struct PSColorConstant
 			{
 				dx::XMFLOAT3A color = { 0.6f,0.2f,0.2f };
+				CBUFFER_FIELDS( PSColorConstant, CBUFFER_FIELD( color ) )
 			} colorConst;
 			unoccluded.AddBindable( PixelConstantBuffer<PSColorConstant>::Resolve( gfx, colorConst, 1u ) );
 
@@ -82,6 +83,7 @@ FrustumIndicator::FrustumIndicator( Graphics& gfx, float width, float height, fl
 			struct PSColorConstant2
 			{
 				dx::XMFLOAT3A color = { 0.25f, 0.08f, 0.08f };
+				CBUFFER_FIELDS( PSColorConstant2, CBUFFER_FIELD( color ) )
 			} colorConst;
 			occluded.AddBindable( PixelConstantBuffer<PSColorConstant2>::Resolve( gfx, colorConst, 1u ) );
 
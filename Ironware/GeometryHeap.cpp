@@ -0,0 +1,210 @@
+/*!
+ * \file GeometryHeap.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ *
+ */
+#include "GeometryHeap.h"
+#include "GraphicsExceptionMacros.h"
+#include "Vertex.h"
+
+#include <algorithm>
+#include <cassert>
+
+GeometryHeap::Pool::Pool( Graphics& gfx, UINT elementSize, DXGI_FORMAT indexFormat, size_t capacity ) :
+	elementSize( elementSize ),
+	indexFormat( indexFormat ),
+	allocator( capacity ),
+	pBuffer( CreateBuffer( gfx, capacity ) )
+{}
+
+RangeAllocator::Handle GeometryHeap::Pool::Allocate( Graphics& gfx, const void* pData, size_t count )
+{
+	assert( count > 0u && "Geometry heap can't hold empty ranges" );
+	auto handle = allocator.Allocate( count );
+	if( handle == RangeAllocator::INVALID_HANDLE )
+	{
+		// contents of the old buffer keep their offsets in the larger one
+		const size_t capacity = allocator.GetCapacity();
+		const size_t grown = std::max( capacity * 2u, capacity + count );
+		auto pGrown = CreateBuffer( gfx, grown );
+		CopyRange( gfx, pGrown.Get(), 0u, 0u, capacity );
+		pBuffer = std::move( pGrown );
+		allocator.Grow( grown );
+		handle = allocator.Allocate( count );
+	}
+
+	const size_t offset = allocator.GetOffset( handle );
+	const D3D11_BOX box = { UINT( offset * elementSize ), 0u, 0u, UINT( ( offset + count ) * elementSize ), 1u, 1u };
+	GetContext( gfx )->UpdateSubresource( pBuffer.Get(), 0u, &box, pData, 0u, 0u );
+	return handle;
+}
+
+size_t GeometryHeap::Pool::Defragment( Graphics& gfx )
+{
+	const auto moves = allocator.Defragment();
+	if( moves.empty() )
+	{
+		return 0u;
+	}
+	// everything before the first move is packed already, the rest are the moves
+	auto pPacked = CreateBuffer( gfx, allocator.GetCapacity() );
+	CopyRange( gfx, pPacked.Get(), 0u, 0u, moves.front().to );
+	size_t moved = 0u;
+	for( const auto& m : moves )
+	{
+		CopyRange( gfx, pPacked.Get(), m.to, m.from, m.size );
+		moved += m.size;
+	}
+	pBuffer = std::move( pPacked );
+	return moved;
+}
+
+void GeometryHeap::Pool::Bind( Graphics& gfx ) IFNOEXCEPT
+{
+	if( indexFormat == DXGI_FORMAT_UNKNOWN )
+	{
+		if( GetStateCache( gfx ).Set( PipelineStateCache::Stage::IAVertexBuffer, pBuffer.Get(), 0u ) )
+		{
+			const UINT offset = 0u;
+			GetContext( gfx )->IASetVertexBuffers( 0u, 1u, pBuffer.GetAddressOf(), &elementSize, &offset );
+		}
+	}
+	else if( GetStateCache( gfx ).Set( PipelineStateCache::Stage::IAIndexBuffer, pBuffer.Get() ) )
+	{
+		GetContext( gfx )->IASetIndexBuffer( pBuffer.Get(), indexFormat, 0u );
+	}
+}
+
+Microsoft::WRL::ComPtr<ID3D11Buffer> GeometryHeap::Pool::CreateBuffer( Graphics& gfx, size_t capacity ) const
+{
+	INFOMAN( gfx );
+
+	D3D11_BUFFER_DESC desc = {};
+	desc.BindFlags = indexFormat == DXGI_FORMAT_UNKNOWN ? D3D11_BIND_VERTEX_BUFFER : D3D11_BIND_INDEX_BUFFER;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.CPUAccessFlags = 0u;
+	desc.MiscFlags = 0u;
+	desc.ByteWidth = UINT( capacity * elementSize );
+	desc.StructureByteStride = elementSize;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> pNew;
+	GFX_CALL_THROW_INFO( GetDevice( gfx )->CreateBuffer( &desc, nullptr, &pNew ) );
+	// new buffer may take the address of a released one
+	GetStateCache( gfx ).Invalidate( indexFormat == DXGI_FORMAT_UNKNOWN ? PipelineStateCache::Stage::IAVertexBuffer : PipelineStateCache::Stage::IAIndexBuffer );
+	return pNew;
+}
+
+void GeometryHeap::Pool::CopyRange( Graphics& gfx, ID3D11Buffer* pDst, size_t to, size_t from, size_t count ) const noexcept
+{
+	if( count == 0u )
+	{
+		return;
+	}
+	const D3D11_BOX box = { UINT( from * elementSize ), 0u, 0u, UINT( ( from + count ) * elementSize ), 1u, 1u };
+	GetContext( gfx )->CopySubresourceRegion( pDst, 0u, UINT( to * elementSize ), 0u, 0u, pBuffer.Get(), 0u, &box );
+}
+
+GeometryHeap::Allocation::Allocation( Pool& vertexPool, RangeAllocator::Handle vertexRange, Pool& indexPool, RangeAllocator::Handle indexRange, UINT indexCount ) noexcept :
+	vertexPool( vertexPool ),
+	indexPool( indexPool ),
+	vertexRange( vertexRange ),
+	indexRange( indexRange ),
+	indexCount( indexCount )
+{}
+
+GeometryHeap::Allocation::~Allocation()
+{
+	vertexPool.Free( vertexRange );
+	indexPool.Free( indexRange );
+}
+
+void GeometryHeap::Allocation::Bind( Graphics& gfx ) const IFNOEXCEPT
+{
+	vertexPool.Bind( gfx );
+	indexPool.Bind( gfx );
+}
+
+std::shared_ptr<GeometryHeap::Allocation> GeometryHeap::Resolve( Graphics& gfx, const std::wstring& tag, const VertexByteBuffer& vertices, const IndexByteBuffer& indices )
+{
+	return Resolve( gfx, tag, vertices.GetLayout(), vertices.GetData(), vertices.SizeBytes(), indices.GetFormat(), indices.GetData(), indices.Count() );
+}
+
+std::shared_ptr<GeometryHeap::Allocation> GeometryHeap::Resolve( Graphics& gfx, const std::wstring& tag, const VertexLayout& layout, const std::byte* pVertices, size_t vertexBytes,
+	IndexByteBuffer::Format indexFormat, const void* pIndices, size_t indexCount )
+{
+	auto& heap = Get();
+	auto& pCached = heap.allocations[tag];
+	if( auto pAllocation = pCached.lock() )
+	{
+		return pAllocation;
+	}
+
+	const UINT stride = (UINT)layout.Size();
+	auto& pVertexPool = heap.vertexPools[layout.GetCode()];
+	if( !pVertexPool )
+	{
+		pVertexPool = std::make_unique<Pool>( gfx, stride, DXGI_FORMAT_UNKNOWN, std::max( INITIAL_VERTEX_CAPACITY, vertexBytes / stride ) );
+	}
+	auto& pIndexPool = heap.indexPools[(size_t)indexFormat];
+	if( !pIndexPool )
+	{
+		pIndexPool = std::make_unique<Pool>( gfx, (UINT)IndexByteBuffer::SizeOf( indexFormat ), IndexByteBuffer::DxgiFormat( indexFormat ),
+			std::max( INITIAL_INDEX_CAPACITY, indexCount ) );
+	}
+
+	const auto vertexRange = pVertexPool->Allocate( gfx, pVertices, vertexBytes / stride );
+	const auto indexRange = pIndexPool->Allocate( gfx, pIndices, indexCount );
+	auto pAllocation = std::make_shared<Allocation>( *pVertexPool, vertexRange, *pIndexPool, indexRange, (UINT)indexCount );
+	pCached = pAllocation;
+	return pAllocation;
+}
+
+size_t GeometryHeap::Defragment( Graphics& gfx )
+{
+	auto& heap = Get();
+	size_t moved = 0u;
+	for( auto& [code, pPool] : heap.vertexPools )
+	{
+		moved += pPool->Defragment( gfx );
+	}
+	for( auto& pPool : heap.indexPools )
+	{
+		if( pPool )
+		{
+			moved += pPool->Defragment( gfx );
+		}
+	}
+	// tags of destroyed meshes are dropped as well
+	for( auto it = heap.allocations.begin(); it != heap.allocations.end(); )
+	{
+		it = it->second.expired() ? heap.allocations.erase( it ) : std::next( it );
+	}
+	return moved;
+}
+
+std::vector<GeometryHeap::PoolStats> GeometryHeap::GetStats()
+{
+	const auto& heap = Get();
+	std::vector<PoolStats> stats;
+	for( const auto& [code, pPool] : heap.vertexPools )
+	{
+		stats.push_back( { code, pPool->GetElementSize(), pPool->GetStats() } );
+	}
+	const wchar_t* formatNames[] = { L"16-bit indices", L"32-bit indices" };
+	for( size_t i = 0; i < heap.indexPools.size(); i++ )
+	{
+		if( heap.indexPools[i] )
+		{
+			stats.push_back( { formatNames[i], heap.indexPools[i]->GetElementSize(), heap.indexPools[i]->GetStats() } );
+		}
+	}
+	return stats;
+}
+
+GeometryHeap& GeometryHeap::Get() noexcept
+{
+	static GeometryHeap heap;
+	return heap;
+}
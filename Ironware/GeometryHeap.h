@@ -0,0 +1,135 @@
+/*!
+ * \file GeometryHeap.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Header file that contains GeometryHeap, vertex and index buffers that are shared by meshes
+ *
+ * \note There is one vertex buffer for every vertex layout and one index buffer for every index format,
+ * * meshes take ranges of them and are drawn with a start index and a base vertex, so consecutive jobs
+ * * of meshes with the same layout don't rebind the input assembler. Ranges are resolved by tag like the
+ * * buffers of BindableCollection and go back to the heap when the last mesh that uses them is destroyed.
+ * \note Heap is used from the render thread only, the allocation logic lives in RangeAllocator
+*/
+#pragma once
+
+#include "GraphicsResource.h"
+#include "RangeAllocator.h"
+#include "IndexByteBuffer.h"
+
+#include <array>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class VertexLayout;
+class VertexByteBuffer;
+
+class GeometryHeap
+{
+public:
+	/**
+	 * @brief Buffer of elements of one size that ranges are suballocated from, doubles when it's full
+	*/
+	class Pool : public GraphicsResource
+	{
+	public:
+		/**
+		 * @param indexFormat format of the index buffer, DXGI_FORMAT_UNKNOWN for a vertex buffer
+		*/
+		Pool( Graphics& gfx, UINT elementSize, DXGI_FORMAT indexFormat, size_t capacity );
+		/**
+		 * @brief Takes a range and uploads the elements into it
+		*/
+		RangeAllocator::Handle Allocate( Graphics& gfx, const void* pData, size_t count );
+		void Free( RangeAllocator::Handle handle ) noexcept { allocator.Free( handle ); }
+		/**
+		 * @brief Packs the ranges into a new buffer, so all of the free space is at the end
+		 * @return number of elements that were moved
+		*/
+		size_t Defragment( Graphics& gfx );
+		void Bind( Graphics& gfx ) IFNOEXCEPT;
+		size_t GetOffset( RangeAllocator::Handle handle ) const noexcept { return allocator.GetOffset( handle ); }
+		UINT GetElementSize() const noexcept { return elementSize; }
+		RangeAllocator::Stats GetStats() const noexcept { return allocator.GetStats(); }
+
+	private:
+		Microsoft::WRL::ComPtr<ID3D11Buffer> CreateBuffer( Graphics& gfx, size_t capacity ) const;
+		void CopyRange( Graphics& gfx, ID3D11Buffer* pDst, size_t to, size_t from, size_t count ) const noexcept;
+
+	private:
+		UINT elementSize;
+		DXGI_FORMAT indexFormat;
+		RangeAllocator allocator;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> pBuffer;
+	};
+
+	/**
+	 * @brief Vertex and index ranges of a mesh, they're freed when it's destroyed
+	*/
+	class Allocation
+	{
+	public:
+		Allocation( Pool& vertexPool, RangeAllocator::Handle vertexRange, Pool& indexPool, RangeAllocator::Handle indexRange, UINT indexCount ) noexcept;
+		Allocation( const Allocation& ) = delete;
+		Allocation& operator=( const Allocation& ) = delete;
+		~Allocation();
+		void Bind( Graphics& gfx ) const IFNOEXCEPT;
+		UINT GetBaseVertex() const noexcept { return (UINT)vertexPool.GetOffset( vertexRange ); }
+		UINT GetStartIndex() const noexcept { return (UINT)indexPool.GetOffset( indexRange ); }
+		UINT GetIndexCount() const noexcept { return indexCount; }
+		/**
+		 * @return true if both allocations are in the same vertex and index buffers
+		*/
+		bool SharesPools( const Allocation& other ) const noexcept { return &vertexPool == &other.vertexPool && &indexPool == &other.indexPool; }
+		const Pool& GetVertexPool() const noexcept { return vertexPool; }
+		const Pool& GetIndexPool() const noexcept { return indexPool; }
+
+	private:
+		Pool& vertexPool;
+		Pool& indexPool;
+		RangeAllocator::Handle vertexRange;
+		RangeAllocator::Handle indexRange;
+		UINT indexCount;
+	};
+
+	struct PoolStats
+	{
+		// vertex layout code or index format
+		std::wstring name;
+		UINT elementSize = 0u;
+		RangeAllocator::Stats ranges;
+	};
+
+public:
+	/**
+	 * @brief Allocation of the tag if there is one, otherwise the geometry is uploaded into new ranges
+	*/
+	static std::shared_ptr<Allocation> Resolve( Graphics& gfx, const std::wstring& tag, const VertexByteBuffer& vertices, const IndexByteBuffer& indices );
+	/**
+	 * @brief Resolves geometry straight from the bytes of a layout, e.g. a mapped cooked file
+	*/
+	static std::shared_ptr<Allocation> Resolve( Graphics& gfx, const std::wstring& tag, const VertexLayout& layout, const std::byte* pVertices, size_t vertexBytes,
+		IndexByteBuffer::Format indexFormat, const void* pIndices, size_t indexCount );
+	/**
+	 * @brief Packs every buffer, offsets of the allocations change, so it mustn't be called while jobs are queued
+	 * @return number of elements that were moved
+	*/
+	static size_t Defragment( Graphics& gfx );
+	static std::vector<PoolStats> GetStats();
+
+private:
+	static GeometryHeap& Get() noexcept;
+
+private:
+	static constexpr size_t INITIAL_VERTEX_CAPACITY = 1u << 16u;
+	static constexpr size_t INITIAL_INDEX_CAPACITY = 1u << 18u;
+
+private:
+	// by layout code
+	std::unordered_map<std::wstring, std::unique_ptr<Pool>> vertexPools;
+	std::array<std::unique_ptr<Pool>, 2u> indexPools;
+	std::unordered_map<std::wstring, std::weak_ptr<Allocation>> allocations;
+};
@@ -23,6 +23,7 @@
 #include "GraphicsExceptionMacros.h"
 #include "DepthStencilView.h"
 #include "RenderTarget.h"
+#include "ConstantUploadRing.h"
 
 #include <imgui/imgui_impl_dx11.h>
 #include <imgui/imgui_impl_win32.h>
@@ -107,6 +108,8 @@ Graphics::Graphics( HWND hWnd )
 	pImmediateContext->RSSetViewports( 1u, &vp );
 
 	ImGui_ImplDX11_Init( pDevice.Get(), pImmediateContext.Get() );
+
+	pConstantRing = std::make_unique<ConstantUploadRing>( *this );
 }
 
 Graphics::~Graphics()
@@ -130,6 +133,12 @@ void Graphics::BeginFrame( float red, float green, float blue ) noexcept
 	ID3D11ShaderResourceView* const pNullTex = nullptr;
 	pImmediateContext->PSSetShaderResources( 0, 1, &pNullTex ); // fullscreen input texture
 	pImmediateContext->PSSetShaderResources( 3, 1, &pNullTex ); // shadow map texture
+	stateCache.NewFrame();
+	lastFrameDraws = frameDraws;
+	frameDraws = {};
+	lastFrameUploads = frameUploads;
+	frameUploads = {};
+	transformStage.NewFrame();
 }
 
 void Graphics::EndFrame()
@@ -142,6 +151,7 @@ void Graphics::EndFrame()
 		ImGui::Render();
 		ImGui_ImplDX11_RenderDrawData( ImGui::GetDrawData() );
 	}
+	pConstantRing->EndFrame( *this );
 
 	HRESULT hr;
 #ifndef NDEBUG
@@ -160,9 +170,18 @@ void Graphics::EndFrame()
 	}
 	}
 
-void Graphics::DrawIndexed( UINT count ) IFNOEXCEPT
+void Graphics::DrawIndexed( UINT count, UINT startIndex, INT baseVertex ) IFNOEXCEPT
+{
+	frameDraws.drawCalls++;
+	frameDraws.instances++;
+	GFX_CALL_THROW_INFO_ONLY( pImmediateContext->DrawIndexed( count, startIndex, baseVertex ) );
+}
+
+void Graphics::DrawIndexedInstanced( UINT count, UINT instanceCount, UINT startIndex, INT baseVertex, UINT startInstance ) IFNOEXCEPT
 {
-	GFX_CALL_THROW_INFO_ONLY( pImmediateContext->DrawIndexed( count, 0u, 0 ) );
+	frameDraws.drawCalls++;
+	frameDraws.instances += instanceCount;
+	GFX_CALL_THROW_INFO_ONLY( pImmediateContext->DrawIndexedInstanced( count, instanceCount, startIndex, baseVertex, startInstance ) );
 }
 
 #pragma endregion Graphics
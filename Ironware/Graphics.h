@@ -18,6 +18,8 @@
 #include "CommonMacros.h"
 #include <DXErr/dxerr.h>
 #include "DxgiInfoManager.h"
+#include "PipelineStateCache.h"
+#include "TransformStage.h"
 
 #include <vector>
 #include <d3d11.h>
@@ -27,6 +29,7 @@
 #include <random>
 
 class RenderTarget;
+class ConstantUploadRing;
 
 class Graphics
 {
@@ -79,6 +82,21 @@ public:
 		std::wstring info;
 	};
 
+	struct DrawStats
+	{
+		size_t drawCalls = 0u;
+		// drawn instances, a draw without instancing counts as one
+		size_t instances = 0u;
+	};
+
+	struct UploadStats
+	{
+		// map calls that wrote buffers, the ones of constant buffers among them
+		size_t maps = 0u;
+		size_t constantMaps = 0u;
+		size_t constantBytes = 0u;
+	};
+
 public:
 	Graphics( HWND hWnd );
 	Graphics( const Graphics& ) = delete;
@@ -87,7 +105,11 @@ public:
 
 	void BeginFrame( float red, float green, float blue ) noexcept;
 	void EndFrame();
-	void DrawIndexed( UINT count ) IFNOEXCEPT;
+	/**
+	 * @param baseVertex added to every index, so meshes of a shared vertex buffer keep indices of their own vertices
+	*/
+	void DrawIndexed( UINT count, UINT startIndex = 0u, INT baseVertex = 0 ) IFNOEXCEPT;
+	void DrawIndexedInstanced( UINT count, UINT instanceCount, UINT startIndex = 0u, INT baseVertex = 0, UINT startInstance = 0u ) IFNOEXCEPT;
 
 	std::shared_ptr<RenderTarget> GetTarget() { return pTarget; }
 	UINT GetWidth() const noexcept { return width; }
@@ -99,6 +121,35 @@ public:
 	void EnableImGui() noexcept { imGuiEnabled = true; }
 	void DisableImGui() noexcept { imGuiEnabled = false; }
 	bool IsImGuiEnabled() const noexcept { return imGuiEnabled; }
+	/**
+	 * @return bind counters of the previous frame (issued and dropped as redundant)
+	*/
+	const PipelineStateCache::Stats& GetBindStats() const noexcept { return stateCache.GetFrameStats(); }
+	void EnableBindCache( bool enable ) noexcept { stateCache.SetEnabled( enable ); }
+	/**
+	 * @return draw counters of the previous frame
+	*/
+	const DrawStats& GetDrawStats() const noexcept { return lastFrameDraws; }
+	/**
+	 * @return draw calls issued since the frame began
+	*/
+	size_t GetDrawCallCount() const noexcept { return frameDraws.drawCalls; }
+	bool IsBindCacheEnabled() const noexcept { return stateCache.IsEnabled(); }
+	/**
+	 * @return map counters of the previous frame
+	*/
+	const UploadStats& GetUploadStats() const noexcept { return lastFrameUploads; }
+	/**
+	 * @brief Per draw constants go through the ring if it's enabled and the device supports it,
+	 * * otherwise every bind maps a buffer of its own
+	*/
+	ConstantUploadRing& GetConstantRing() noexcept { return *pConstantRing; }
+	const ConstantUploadRing& GetConstantRing() const noexcept { return *pConstantRing; }
+	/**
+	 * @brief Transforms of the drawables drawn in this frame, batched per camera by the queue passes
+	*/
+	TransformStage& GetTransformStage() noexcept { return transformStage; }
+	const TransformStage& GetTransformStage() const noexcept { return transformStage; }
 
 private:
 	DirectX::XMMATRIX projection = {};
@@ -106,6 +157,12 @@ private:
 	bool imGuiEnabled = true;
 	UINT width = 0u;
 	UINT height = 0u;
+	PipelineStateCache stateCache;
+	DrawStats frameDraws;
+	DrawStats lastFrameDraws;
+	UploadStats frameUploads;
+	UploadStats lastFrameUploads;
+	TransformStage transformStage;
 
 #ifndef NDEBUG
 	DxgiInfoManager infoManager;
@@ -114,4 +171,5 @@ private:
 	Microsoft::WRL::ComPtr<IDXGISwapChain> pSwapChain;
 	Microsoft::WRL::ComPtr<ID3D11DeviceContext> pImmediateContext;
 	std::shared_ptr<RenderTarget> pTarget;
+	std::unique_ptr<ConstantUploadRing> pConstantRing;
 };
\ No newline at end of file
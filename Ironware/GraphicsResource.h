@@ -15,6 +15,22 @@ class GraphicsResource
 protected:
 	static ID3D11DeviceContext* GetContext( Graphics& gfx ) noexcept { return gfx.pImmediateContext.Get(); }
 	static ID3D11Device* GetDevice( Graphics& gfx ) noexcept { return gfx.pDevice.Get(); }
+	/**
+	 * @brief Shadow state of the context, ask it before issuing Set calls
+	*/
+	static PipelineStateCache& GetStateCache( Graphics& gfx ) noexcept { return gfx.stateCache; }
+	/**
+	 * @brief Counts a map of a buffer that is written, for the upload statistics of the frame
+	*/
+	static void CountMap( Graphics& gfx, size_t bytes, bool constants = false ) noexcept
+	{
+		gfx.frameUploads.maps++;
+		if( constants )
+		{
+			gfx.frameUploads.constantMaps++;
+			gfx.frameUploads.constantBytes += bytes;
+		}
+	}
 
 	/**
 	 * @brief Avoid calling this function directly, instead call INFOMAN macro
@@ -9,13 +9,18 @@
 #include "IndexBuffer.h"
 #include "GraphicsExceptionMacros.h"
 
-IndexBuffer::IndexBuffer( Graphics & gfx, const std::vector<uint16_t>& indices ) :
+IndexBuffer::IndexBuffer( Graphics & gfx, const IndexByteBuffer& indices ) :
 	IndexBuffer( gfx, L"?", indices )
 {}
 
-IndexBuffer::IndexBuffer( Graphics& gfx, const std::wstring& tag, const std::vector<uint16_t>& indices ) :
+IndexBuffer::IndexBuffer( Graphics& gfx, const std::wstring& tag, const IndexByteBuffer& indices ) :
+	IndexBuffer( gfx, tag, indices.GetFormat(), indices.GetData(), indices.Count() )
+{}
+
+IndexBuffer::IndexBuffer( Graphics& gfx, const std::wstring& tag, IndexByteBuffer::Format format, const void* pIndices, size_t count_in ) :
 	tag( tag ),
-	count( (UINT)indices.size() )
+	count( (UINT)count_in ),
+	format( format )
 {
 	INFOMAN( gfx );
 
@@ -24,15 +29,21 @@ IndexBuffer::IndexBuffer( Graphics& gfx, const std::wstring& tag, const std::vec
 	descInputBuffer.Usage = D3D11_USAGE_DEFAULT;
 	descInputBuffer.CPUAccessFlags = 0u;
 	descInputBuffer.MiscFlags = 0u;
-	descInputBuffer.ByteWidth = UINT( count * sizeof( uint16_t ) );
-	descInputBuffer.StructureByteStride = sizeof( uint16_t );
+	descInputBuffer.ByteWidth = UINT( count * IndexByteBuffer::SizeOf( format ) );
+	descInputBuffer.StructureByteStride = UINT( IndexByteBuffer::SizeOf( format ) );
 	D3D11_SUBRESOURCE_DATA subresInputData = {};
-	subresInputData.pSysMem = indices.data();
+	subresInputData.pSysMem = pIndices;
 	GFX_CALL_THROW_INFO( GetDevice( gfx )->CreateBuffer( &descInputBuffer, &subresInputData, &pIndexBuffer ) );
 }
 
-std::shared_ptr<IndexBuffer> IndexBuffer::Resolve( Graphics& gfx, const std::wstring& tag, const std::vector<uint16_t>& indices )
+std::shared_ptr<IndexBuffer> IndexBuffer::Resolve( Graphics& gfx, const std::wstring& tag, const IndexByteBuffer& indices )
 {
 	assert( tag != L"?" );
 	return BindableCollection::Resolve<IndexBuffer>( gfx, tag, indices );
 }
+
+std::shared_ptr<IndexBuffer> IndexBuffer::Resolve( Graphics& gfx, const std::wstring& tag, IndexByteBuffer::Format format, const void* pIndices, size_t count )
+{
+	assert( tag != L"?" );
+	return BindableCollection::Resolve<IndexBuffer>( gfx, tag, format, pIndices, count );
+}
@@ -13,6 +13,7 @@
 #include "Bindable.h"
 #include "BindableCollection.h"
 #include "IronUtils.h"
+#include "IndexByteBuffer.h"
 
 /*!
  * \class IndexBuffer
@@ -32,14 +33,28 @@
 class IndexBuffer : public Bindable
 {
 public:
-	IndexBuffer( Graphics& gfx, const std::vector<uint16_t>& indices );
-	IndexBuffer( Graphics& gfx, const std::wstring& tag, const std::vector<uint16_t>& indices );
+	IndexBuffer( Graphics& gfx, const IndexByteBuffer& indices );
+	IndexBuffer( Graphics& gfx, const std::wstring& tag, const IndexByteBuffer& indices );
+	/**
+	 * @brief Creates buffer straight from index data of the format, e.g. a mapped cooked file
+	*/
+	IndexBuffer( Graphics& gfx, const std::wstring& tag, IndexByteBuffer::Format format, const void* pIndices, size_t count );
 
-	void Bind( Graphics& gfx ) IFNOEXCEPT override { GetContext( gfx )->IASetIndexBuffer( pIndexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0u ); }
+	void Bind( Graphics& gfx ) IFNOEXCEPT override
+	{
+		if( GetStateCache( gfx ).Set( PipelineStateCache::Stage::IAIndexBuffer, pIndexBuffer.Get() ) )
+		{
+			GetContext( gfx )->IASetIndexBuffer( pIndexBuffer.Get(), IndexByteBuffer::DxgiFormat( format ), 0u );
+		}
+	}
 	UINT GetCount() const noexcept { return count; }
-	static std::shared_ptr<IndexBuffer> Resolve( Graphics& gfx, const std::wstring& tag, const std::vector<uint16_t>& indices );
+	IndexByteBuffer::Format GetFormat() const noexcept { return format; }
+	static std::shared_ptr<IndexBuffer> Resolve( Graphics& gfx, const std::wstring& tag, const IndexByteBuffer& indices );
+	static std::shared_ptr<IndexBuffer> Resolve( Graphics& gfx, const std::wstring& tag, IndexByteBuffer::Format format, const void* pIndices, size_t count );
 	std::wstring GetUID() const noexcept override { return GenerateUID_( tag ); }
 
+	template<TPACK Ignore>
+	static size_t GenerateKey( const std::wstring& tag, Ignore&&... ignore ) noexcept { return hash_values( tag ); }
 	template<TPACK Ignore>
 	static std::wstring GenerateUID( const std::wstring& tag, Ignore&&... ignore )
 	{
@@ -52,6 +67,7 @@ private:
 protected:
 	std::wstring tag;
 	UINT count;
+	IndexByteBuffer::Format format;
 	Microsoft::WRL::ComPtr<ID3D11Buffer> pIndexBuffer;
 };
 
@@ -0,0 +1,119 @@
+/*!
+ * \file IndexByteBuffer.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ *
+ */
+#include "IndexByteBuffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+IndexByteBuffer::IndexByteBuffer( Format format, size_t count ) :
+	format( format ),
+	buffer( count * SizeOf( format ) )
+{}
+
+IndexByteBuffer::IndexByteBuffer( Format format, const void* pData, size_t count ) :
+	format( format ),
+	buffer( count * SizeOf( format ) )
+{
+	if( !buffer.empty() )
+	{
+		std::memcpy( buffer.data(), pData, buffer.size() );
+	}
+}
+
+IndexByteBuffer::IndexByteBuffer( const std::vector<uint16_t>& indices ) :
+	IndexByteBuffer( Format::UInt16, indices.data(), indices.size() )
+{}
+
+IndexByteBuffer::IndexByteBuffer( const std::vector<uint32_t>& indices ) :
+	IndexByteBuffer( Format::UInt32, indices.data(), indices.size() )
+{
+	Compact();
+}
+
+uint32_t IndexByteBuffer::operator[]( size_t i ) const noexcept
+{
+	// memcpy, as the byte buffer gives no alignment guarantees
+	if( format == Format::UInt16 )
+	{
+		uint16_t value;
+		std::memcpy( &value, buffer.data() + i * sizeof( uint16_t ), sizeof( value ) );
+		return value;
+	}
+	uint32_t value;
+	std::memcpy( &value, buffer.data() + i * sizeof( uint32_t ), sizeof( value ) );
+	return value;
+}
+
+void IndexByteBuffer::Set( size_t i, uint32_t value ) IFNOEXCEPT
+{
+	if( format == Format::UInt16 )
+	{
+		assert( value <= std::numeric_limits<uint16_t>::max() && "Index doesn't fit 16-bit buffer" );
+		const auto narrow = (uint16_t)value;
+		std::memcpy( buffer.data() + i * sizeof( uint16_t ), &narrow, sizeof( narrow ) );
+	}
+	else
+	{
+		std::memcpy( buffer.data() + i * sizeof( uint32_t ), &value, sizeof( value ) );
+	}
+}
+
+void IndexByteBuffer::PushBack( uint32_t value )
+{
+	if( format == Format::UInt16 && value > std::numeric_limits<uint16_t>::max() )
+	{
+		Widen();
+	}
+	buffer.resize( buffer.size() + SizeOf( format ) );
+	Set( Count() - 1u, value );
+}
+
+uint32_t IndexByteBuffer::GetMaxIndex() const noexcept
+{
+	uint32_t maxIndex = 0u;
+	const size_t count = Count();
+	for( size_t i = 0; i < count; i++ )
+	{
+		maxIndex = std::max( maxIndex, ( *this )[i] );
+	}
+	return maxIndex;
+}
+
+bool IndexByteBuffer::Compact()
+{
+	if( format == Format::UInt16 || GetMaxIndex() > std::numeric_limits<uint16_t>::max() )
+	{
+		return false;
+	}
+	const size_t count = Count();
+	IndexByteBuffer narrow( Format::UInt16, count );
+	for( size_t i = 0; i < count; i++ )
+	{
+		narrow.Set( i, ( *this )[i] );
+	}
+	*this = std::move( narrow );
+	return true;
+}
+
+void IndexByteBuffer::Widen()
+{
+	if( format == Format::UInt32 )
+	{
+		return;
+	}
+	const size_t count = Count();
+	IndexByteBuffer wide( Format::UInt32, count );
+	for( size_t i = 0; i < count; i++ )
+	{
+		wide.Set( i, ( *this )[i] );
+	}
+	*this = std::move( wide );
+}
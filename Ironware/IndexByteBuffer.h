@@ -0,0 +1,96 @@
+/*!
+ * \file IndexByteBuffer.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Header file that contains IndexByteBuffer
+ *
+ * \note Indices are stored as 16-bit whenever every index fits, 32-bit only for
+ * * meshes that address more than 65536 vertices
+*/
+#pragma once
+
+#include "CommonMacros.h"
+
+#include <dxgiformat.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Index data of a mesh in the narrowest format that can address its vertices
+*/
+class IndexByteBuffer
+{
+public:
+	enum class Format
+	{
+		UInt16,
+		UInt32
+	};
+
+public:
+	IndexByteBuffer() = default;
+	IndexByteBuffer( Format format, size_t count = 0u );
+	/**
+	 * @brief Copies indices of existing raw data, e.g. a mapped cooked file
+	*/
+	IndexByteBuffer( Format format, const void* pData, size_t count );
+	IndexByteBuffer( const std::vector<uint16_t>& indices );
+	/**
+	 * @brief Stores the indices as 16-bit if all of them fit
+	*/
+	IndexByteBuffer( const std::vector<uint32_t>& indices );
+
+	/**
+	 * @brief Narrowest format that can address the vertices
+	*/
+	static constexpr Format SelectFormat( size_t vertexCount ) noexcept { return vertexCount <= 0x10000u ? Format::UInt16 : Format::UInt32; }
+	static constexpr size_t SizeOf( Format format ) noexcept { return format == Format::UInt16 ? sizeof( uint16_t ) : sizeof( uint32_t ); }
+	static constexpr DXGI_FORMAT DxgiFormat( Format format ) noexcept { return format == Format::UInt16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT; }
+	/**
+	 * @brief Indices of triangles in the format that SelectFormat picks for the vertex count
+	 * @param pFaces faces with mNumIndices and mIndices, e.g. aiFace
+	*/
+	template<typename Face>
+	static IndexByteBuffer FromTriangles( size_t vertexCount, const Face* pFaces, size_t faceCount ) IFNOEXCEPT
+	{
+		IndexByteBuffer indices( SelectFormat( vertexCount ), faceCount * 3u );
+		for( size_t i = 0; i < faceCount; i++ )
+		{
+			const auto& face = pFaces[i];
+			assert( face.mNumIndices == 3 );
+			indices.Set( i * 3u, face.mIndices[0] );
+			indices.Set( i * 3u + 1u, face.mIndices[1] );
+			indices.Set( i * 3u + 2u, face.mIndices[2] );
+		}
+		return indices;
+	}
+
+	Format GetFormat() const noexcept { return format; }
+	DXGI_FORMAT GetDxgiFormat() const noexcept { return DxgiFormat( format ); }
+	size_t Count() const noexcept { return buffer.size() / SizeOf( format ); }
+	bool Empty() const noexcept { return buffer.empty(); }
+	size_t SizeBytes() const noexcept { return buffer.size(); }
+	const std::byte* GetData() const noexcept { return buffer.data(); }
+	uint32_t operator[]( size_t i ) const noexcept;
+	/**
+	 * @note Value has to fit the format, 16-bit buffers are widened with Widen first
+	*/
+	void Set( size_t i, uint32_t value ) IFNOEXCEPT;
+	void PushBack( uint32_t value );
+	uint32_t GetMaxIndex() const noexcept;
+	/**
+	 * @brief Transcodes 32-bit indices to 16-bit when the largest index fits
+	 * @return true if the buffer was narrowed
+	*/
+	bool Compact();
+	void Widen();
+
+private:
+	Format format = Format::UInt16;
+	std::vector<std::byte> buffer;
+};
@@ -14,7 +14,9 @@
 #pragma once
 
 #include "CommonMacros.h"
+#include "StridedView.h"
 
+#include <cstdint>
 #include <vector>
 
 #include <DirectXMath.h>
@@ -33,23 +35,26 @@ class IndexedTriangleList
 {
 public:
 	IndexedTriangleList() = default;
-	IndexedTriangleList( std::vector<T> verts_in, std::vector<uint16_t> indices_in ) :
+	IndexedTriangleList( std::vector<T> verts_in, std::vector<uint32_t> indices_in ) :
 		vertices( std::move( verts_in ) ),
 		indices( std::move( indices_in ) )
 	{
 		assert( vertices.size() > 2 );
 		assert( indices.size() % 3 == 0 );
 	}
+	IndexedTriangleList( std::vector<T> verts_in, const std::vector<uint16_t>& indices_in ) :
+		IndexedTriangleList( std::move( verts_in ), std::vector<uint32_t>( indices_in.begin(), indices_in.end() ) )
+	{}
 
+	/**
+	 * @brief Transforms positions of the vertices as one strided stream
+	 * @note Matrix is expected to be affine
+	*/
 	void Transform( DirectX::FXMMATRIX matrix )
 	{
-		for( auto& v : vertices )
+		if( !vertices.empty() )
 		{
-			const DirectX::XMVECTOR pos = DirectX::XMLoadFloat3( &v.pos );
-			DirectX::XMStoreFloat3(
-				&v.pos,
-				DirectX::XMVector3Transform( pos, matrix )
-			);
+			transform_coord_stream( { &vertices.front().pos, sizeof( T ), vertices.size() }, matrix );
 		}
 	}
 
@@ -77,5 +82,6 @@ public:
 
 public:
 	std::vector<T> vertices;
-	std::vector<uint16_t> indices;
+	// kept 32-bit while the geometry is generated, IndexByteBuffer narrows them for the GPU when they fit
+	std::vector<uint32_t> indices;
 };
\ No newline at end of file
@@ -8,14 +8,20 @@
  */
 #include "InputLayout.h"
 #include "GraphicsExceptionMacros.h"
+#include "InstanceBuffer.h"
 
-InputLayout::InputLayout( Graphics& gfx, const VertexLayout& layout_in, const VertexShader& vs ) :
+InputLayout::InputLayout( Graphics& gfx, const VertexLayout& layout_in, const VertexShader& vs, bool instanced ) :
 	layout( layout_in ),
+	instanced( instanced ),
 	pVShader( &vs )
 {
 	INFOMAN( gfx );
 
-	const auto d3dlayout = layout.GetD3DLayout();
+	auto d3dlayout = layout.GetD3DLayout();
+	if( instanced )
+	{
+		InstanceBuffer::AppendElements( d3dlayout );
+	}
 	const auto pBytecode = pVShader->GetBytecode();
 
 	GFX_CALL_THROW_INFO( GetDevice( gfx )->CreateInputLayout(
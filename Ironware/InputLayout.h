@@ -34,17 +34,29 @@
 class InputLayout : public Bindable
 {
 public:
+	/**
+	 * @param instanced appends the per instance transform elements of InstanceBuffer to the layout
+	*/
 	InputLayout( Graphics& gfx,
 		const VertexLayout& layout_in,
-		const VertexShader& vs );
+		const VertexShader& vs,
+		bool instanced = false );
 
-	void Bind( Graphics& gfx ) IFNOEXCEPT override { GetContext( gfx )->IASetInputLayout( pInputLayout.Get() ); }
-	static std::shared_ptr<InputLayout> Resolve( Graphics& gfx, const VertexLayout& layout, const VertexShader& vs ) { return BindableCollection::Resolve<InputLayout>( gfx, layout, vs ); }
-	static std::wstring GenerateUID( const VertexLayout& layout, const VertexShader& vs ) { return GET_CLASS_WNAME( InputLayout ) + L"#" + layout.GetCode() + L"#" + vs.GetUID(); }
-	std::wstring GetUID() const noexcept override { return GenerateUID( layout, *pVShader ); }
+	void Bind( Graphics& gfx ) IFNOEXCEPT override
+	{
+		if( GetStateCache( gfx ).Set( PipelineStateCache::Stage::IAInputLayout, pInputLayout.Get() ) )
+		{
+			GetContext( gfx )->IASetInputLayout( pInputLayout.Get() );
+		}
+	}
+	static std::shared_ptr<InputLayout> Resolve( Graphics& gfx, const VertexLayout& layout, const VertexShader& vs, bool instanced = false ) { return BindableCollection::Resolve<InputLayout>( gfx, layout, vs, instanced ); }
+	static size_t GenerateKey( const VertexLayout& layout, const VertexShader& vs, bool instanced = false ) noexcept { return hash_values( layout.GetHash(), vs.GetKey(), instanced ); }
+	static std::wstring GenerateUID( const VertexLayout& layout, const VertexShader& vs, bool instanced = false ) { return GET_CLASS_WNAME( InputLayout ) + L"#" + layout.GetCode() + L"#" + vs.GetUID() + ( instanced ? L"#instanced" : L"" ); }
+	std::wstring GetUID() const noexcept override { return GenerateUID( layout, *pVShader, instanced ); }
 
 protected:
 	const VertexShader* pVShader;
 	const VertexLayout& layout;
+	bool instanced;
 	Microsoft::WRL::ComPtr<ID3D11InputLayout> pInputLayout;
 };
\ No newline at end of file
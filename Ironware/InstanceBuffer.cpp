@@ -0,0 +1,84 @@
+/*!
+ * \file InstanceBuffer.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ *
+ */
+#include "InstanceBuffer.h"
+#include "GraphicsExceptionMacros.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace dx = DirectX;
+
+InstanceBuffer::InstanceBuffer( Graphics& gfx, size_t capacity ) :
+	capacity( capacity ),
+	cameraBuffer( gfx, CAMERA_SLOT )
+{
+	Create( gfx );
+}
+
+void InstanceBuffer::Update( Graphics& gfx, const std::vector<Instance>& instances )
+{
+	INFOMAN( gfx );
+
+	if( instances.size() > capacity )
+	{
+		capacity = std::max( instances.size(), capacity * 2u );
+		Create( gfx );
+	}
+	if( !instances.empty() )
+	{
+		D3D11_MAPPED_SUBRESOURCE subresMap;
+		GFX_CALL_THROW_INFO( GetContext( gfx )->Map( pInstanceBuffer.Get(), 0u, D3D11_MAP_WRITE_DISCARD, 0u, &subresMap ) );
+		std::memcpy( subresMap.pData, instances.data(), instances.size() * sizeof( Instance ) );
+		GetContext( gfx )->Unmap( pInstanceBuffer.Get(), 0u );
+		CountMap( gfx, instances.size() * sizeof( Instance ) );
+	}
+
+	const auto view = gfx.GetCameraXM();
+	cameraBuffer.Update( gfx, {
+		dx::XMMatrixTranspose( view ),
+		dx::XMMatrixTranspose( view * gfx.GetProjection() )
+	} );
+}
+
+void InstanceBuffer::Bind( Graphics& gfx ) IFNOEXCEPT
+{
+	if( GetStateCache( gfx ).Set( PipelineStateCache::Stage::IAVertexBuffer, SLOT, pInstanceBuffer.Get() ) )
+	{
+		const UINT stride = sizeof( Instance );
+		const UINT offset = 0u;
+		GetContext( gfx )->IASetVertexBuffers( SLOT, 1u, pInstanceBuffer.GetAddressOf(), &stride, &offset );
+	}
+	cameraBuffer.Bind( gfx );
+}
+
+void InstanceBuffer::AppendElements( std::vector<D3D11_INPUT_ELEMENT_DESC>& desc ) noexcept
+{
+	for( UINT row = 0u; row < 4u; row++ )
+	{
+		desc.push_back( { "InstanceTransform", row, DXGI_FORMAT_R32G32B32A32_FLOAT, SLOT,
+			UINT( row * sizeof( dx::XMFLOAT4 ) ), D3D11_INPUT_PER_INSTANCE_DATA, 1u } );
+	}
+}
+
+void InstanceBuffer::Create( Graphics& gfx )
+{
+	INFOMAN( gfx );
+
+	D3D11_BUFFER_DESC descInstanceBuffer = {};
+	descInstanceBuffer.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	descInstanceBuffer.Usage = D3D11_USAGE_DYNAMIC;
+	descInstanceBuffer.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	descInstanceBuffer.MiscFlags = 0u;
+	descInstanceBuffer.ByteWidth = UINT( capacity * sizeof( Instance ) );
+	descInstanceBuffer.StructureByteStride = sizeof( Instance );
+	pInstanceBuffer.Reset();
+	GFX_CALL_THROW_INFO( GetDevice( gfx )->CreateBuffer( &descInstanceBuffer, nullptr, &pInstanceBuffer ) );
+	// new buffer may reuse the address of the released one
+	GetStateCache( gfx ).Invalidate( PipelineStateCache::Stage::IAVertexBuffer );
+}
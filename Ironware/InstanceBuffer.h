@@ -0,0 +1,62 @@
+/*!
+ * \file InstanceBuffer.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Header file that contains InstanceBuffer, model transforms of the instanced draws of a pass
+ *
+ * \note Instances of all batches of a pass are uploaded at once and every batch draws its own range
+ * * with the start instance location. The buffer is bound to the second input slot, where the input
+ * * layouts of the instanced shaders read the model matrix as four per instance rows.
+*/
+#pragma once
+
+#include "GraphicsResource.h"
+#include "ConstantBuffers.h"
+
+#include <DirectXMath.h>
+
+#include <vector>
+
+class InstanceBuffer : public GraphicsResource
+{
+public:
+	struct Instance
+	{
+		// not transposed, rows are read by the shader and multiplied as in DirectXMath
+		DirectX::XMFLOAT4X4 model;
+	};
+
+	static constexpr UINT SLOT = 1u;
+	// vertex shader slot of the camera transforms, b0 and b1 are taken by the model and shadow transforms
+	static constexpr UINT CAMERA_SLOT = 2u;
+
+private:
+	struct CameraTransforms
+	{
+		DirectX::XMMATRIX view;
+		DirectX::XMMATRIX viewProj;
+	};
+
+public:
+	InstanceBuffer( Graphics& gfx, size_t capacity = 1024u );
+	/**
+	 * @brief Uploads the instances and the camera of the graphics, grows the buffer if they don't fit
+	*/
+	void Update( Graphics& gfx, const std::vector<Instance>& instances );
+	void Bind( Graphics& gfx ) IFNOEXCEPT;
+	size_t GetCapacity() const noexcept { return capacity; }
+	/**
+	 * @brief Appends the per instance elements, that are read from SLOT, to the layout of the geometry
+	*/
+	static void AppendElements( std::vector<D3D11_INPUT_ELEMENT_DESC>& desc ) noexcept;
+
+private:
+	void Create( Graphics& gfx );
+
+private:
+	Microsoft::WRL::ComPtr<ID3D11Buffer> pInstanceBuffer;
+	size_t capacity;
+	VertexConstantBuffer<CameraTransforms> cameraBuffer;
+};
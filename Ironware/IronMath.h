@@ -61,6 +61,13 @@ constexpr T gauss(T x, T sigma) noexcept
 	return ( (T)1.0 / sqrt( (T)2.0 * (T)PI_D * sigsq ) ) * exp( -sq( x ) / ( (T)2.0 * sigsq ) );
 }
 
+struct Ray
+{
+	DirectX::XMFLOAT3 origin;
+	// normalized
+	DirectX::XMFLOAT3 direction;
+};
+
 DirectX::XMFLOAT3 extract_euler_angles( const DirectX::XMFLOAT4X4& matrix ) noexcept;
 
 DirectX::XMFLOAT3 extract_translation( const DirectX::XMFLOAT4X4& matrix ) noexcept;
@@ -18,6 +18,9 @@
 #include <vector>
 #include <algorithm>
 #include <iterator>
+#include <functional>
+#include <string_view>
+#include <cstdint>
 
 // default buffer size
 constexpr size_t DEFAULT_BUFFER_SIZE = 512;
@@ -84,4 +87,54 @@ void split_string_iter( const std::string& s, const std::string& delim, Iter out
 
 std::vector<std::string> split_string( const std::string& s, const std::string& delim );
 
+/**
+ * @brief Mixes hash of the value into the seed
+ * @param seed accumulated hash value
+ * @param v value that will be hashed with std::hash
+*/
+template<typename T>
+void hash_combine( size_t& seed, const T& v ) noexcept
+{
+	seed ^= std::hash<T>{}( v ) + 0x9e3779b97f4a7c15ull + ( seed << 6 ) + ( seed >> 2 );
+}
+
+/**
+ * @brief Hashes all of the values into a single seed
+ * @param vs values that will be hashed with std::hash
+*/
+template<typename... Ts>
+size_t hash_values( const Ts&... vs ) noexcept
+{
+	size_t seed = 0u;
+	( hash_combine( seed, vs ), ... );
+	return seed;
+}
+
+/**
+ * @brief 64-bit FNV-1a hash of the string, usable in constant expressions
+*/
+constexpr uint64_t hash_fnv1a( std::string_view s ) noexcept
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for( const char c : s )
+	{
+		hash ^= (uint8_t)c;
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+/**
+ * @brief Compile-time id of the type, hash of the function signature that contains the type name
+*/
+template<typename T>
+constexpr uint64_t type_id() noexcept
+{
+#ifdef _MSC_VER
+	return hash_fnv1a( __FUNCSIG__ );
+#else
+	return hash_fnv1a( __PRETTY_FUNCTION__ );
+#endif
+}
+
 bool string_contains( std::string_view haystack, std::string_view needle );
\ No newline at end of file
@@ -10,15 +10,66 @@
 #include "Graphics.h"
 #include "Drawable.h"
 #include "RenderStep.h"
+#include "IronUtils.h"
 
-Job::Job( const RenderStep* pStep, const Drawable * pDrawable ) :
+Job::Job( const RenderStep* pStep, const Drawable * pDrawable, size_t lod, MeshletSet::Visible visible ) :
+	pDrawable( pDrawable ),
 	pStep( pStep ),
-	pDrawable( pDrawable )
+	lod( lod ),
+	visible( visible ),
+	startIndex( pDrawable->GetStartIndex() ),
+	baseVertex( pDrawable->GetBaseVertex() )
 {}
 
-void Job::Execute( Graphics & gfx ) const IFNOEXCEPT
+void Job::Execute( Graphics & gfx, bool bindGeometry ) const IFNOEXCEPT
 {
-	pDrawable->Bind( gfx );
+	if( bindGeometry )
+	{
+		pDrawable->Bind( gfx );
+	}
 	pStep->Bind( gfx );
-	gfx.DrawIndexed( pDrawable->GetIndexCount() );
+	if( visible.pStorage )
+	{
+		const auto& ranges = *visible.pStorage;
+		for( uint32_t i = visible.first; i < visible.first + visible.count; i++ )
+		{
+			gfx.DrawIndexed( ranges[i].indexCount, startIndex + ranges[i].startIndex, baseVertex );
+		}
+		return;
+	}
+	const auto range = pDrawable->GetLod( lod );
+	gfx.DrawIndexed( range.indexCount, startIndex + range.startIndex, baseVertex );
+}
+
+void Job::ExecuteInstanced( Graphics& gfx, uint32_t instanceCount, uint32_t startInstance, bool bindGeometry ) const IFNOEXCEPT
+{
+	if( bindGeometry )
+	{
+		pDrawable->Bind( gfx );
+	}
+	pStep->BindInstanced( gfx );
+	const auto range = pDrawable->GetLod( lod );
+	gfx.DrawIndexedInstanced( range.indexCount, instanceCount, startIndex + range.startIndex, baseVertex, startInstance );
+}
+
+bool Job::IsInstanceable() const noexcept
+{
+	return pStep->IsInstanceable() && !visible.pStorage;
+}
+
+size_t Job::GetInstanceKey() const noexcept
+{
+	return hash_values( pStep->GetInstanceKey(), pDrawable->GetBuffersKey(), startIndex, baseVertex, lod );
+}
+
+bool Job::CanInstance( const Job& other ) const noexcept
+{
+	if( !pStep->SharesBindables( *other.pStep ) || !pDrawable->SharesBuffers( *other.pDrawable ) ||
+		startIndex != other.startIndex || baseVertex != other.baseVertex )
+	{
+		return false;
+	}
+	const auto range = pDrawable->GetLod( lod );
+	const auto otherRange = other.pDrawable->GetLod( other.lod );
+	return range.startIndex == otherRange.startIndex && range.indexCount == otherRange.indexCount;
 }
@@ -9,6 +9,10 @@
 #pragma once
 
 #include "CommonMacros.h"
+#include "MeshletSet.h"
+
+#include <cstddef>
+#include <cstdint>
 
  /**
   * @brief Class that is responsible for managing drawing objects
@@ -17,11 +21,53 @@
 class Job
 {
 public:
-	Job( const class RenderStep* pStep, const class Drawable* pDrawable );
-	void Execute( class Graphics& gfx ) const IFNOEXCEPT;
+	/**
+	 * @param lod level of detail of the drawable that is drawn
+	 * @param visible if it has storage, only these ranges of the level are drawn
+	*/
+	Job( const class RenderStep* pStep, const class Drawable* pDrawable, size_t lod = 0u, MeshletSet::Visible visible = {} );
+	/**
+	 * @param bindGeometry false if the buffers of the drawable are bound already, see Drawable::SharesBuffers
+	*/
+	void Execute( class Graphics& gfx, bool bindGeometry = true ) const IFNOEXCEPT;
+	/**
+	 * @brief Draws the job geometry once for every instance of the range, the transforms are read from the instance buffer
+	*/
+	void ExecuteInstanced( class Graphics& gfx, uint32_t instanceCount, uint32_t startInstance, bool bindGeometry = true ) const IFNOEXCEPT;
+	/**
+	 * @brief Job can be merged with others if its step has an instanced shader and it draws a whole level
+	*/
+	bool IsInstanceable() const noexcept;
+	/**
+	 * @brief Hash of the step bindables and of the drawn range, equal for jobs that can be merged
+	*/
+	size_t GetInstanceKey() const noexcept;
+	/**
+	 * @return true if the jobs share every bindable but the transforms and draw the same range of the same buffers
+	*/
+	bool CanInstance( const Job& other ) const noexcept;
+	const Drawable& GetDrawable() const noexcept { return *pDrawable; }
+	const RenderStep& GetStep() const noexcept { return *pStep; }
+	/**
+	 * @brief Key that is used by the owning pass to order its queue before execution
+	*/
+	uint64_t GetSortKey() const noexcept { return sortKey; }
+	void SetSortKey( uint64_t key ) noexcept { sortKey = key; }
+	/**
+	 * @brief Slot of the drawable in the transform stage of the frame, set by the owning pass
+	*/
+	uint32_t GetTransformSlot() const noexcept { return transformSlot; }
+	void SetTransformSlot( uint32_t slot ) noexcept { transformSlot = slot; }
 
 private:
 	const Drawable* pDrawable;
 	const RenderStep* pStep;
+	size_t lod;
+	MeshletSet::Visible visible;
+	// offsets of the drawable in the shared buffers, the ranges of the level are relative to them
+	uint32_t startIndex;
+	int32_t baseVertex;
+	uint64_t sortKey = 0u;
+	uint32_t transformSlot = ~0u;
 };
 
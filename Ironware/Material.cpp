@@ -11,39 +11,46 @@
 #include "TransformCBufferScaling.h"
 #include "DepthStencilState.h"
 #include "IronChannels.h"
+#include "ModelException.h"
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+
+Material::Material( const aiMaterial& material, const std::filesystem::path& path ) IFNOEXCEPT :
+	Material( ReadDesc( material, path ), path )
+{}
+
+Material::Material( Desc desc_in, const std::filesystem::path& path ) IFNOEXCEPT :
+	vtxLayout( MakeVertexLayout( desc_in ) ),
+	modelPath( path.wstring() ),
+	desc( std::move( desc_in ) )
+{}
 
 Material::Material( Graphics& gfx, const aiMaterial& material, const std::filesystem::path& path ) IFNOEXCEPT :
-modelPath( path.wstring() )
+	Material( material, path )
+{
+	Create( gfx );
+}
+
+void Material::Create( Graphics& gfx, const SurfaceMap* pSurfaces ) IFNOEXCEPT
 {
-	const auto rootPath = path.parent_path().wstring() + L"\\";
-	{
-		aiString tempName;
-		material.Get( AI_MATKEY_NAME, tempName );
-		name = to_wide( tempName.C_Str() );
-	}
 	// phong technique
 	{
 		RenderTechnique phong{ L"Phong", IR_CH::main };
 		RenderStep step( "lambertian" );
 		std::wstring shaderCode = L"Phong";
-		aiString texFileName;
 
-		// common (pre)
-		vtxLayout.Append( VertexLayout::ElementType::Position3D );
-		vtxLayout.Append( VertexLayout::ElementType::Normal );
 		RawLayout pscLayout;
-		bool hasTexture = false;
+		const bool hasTexture = desc.diffusePath || desc.specularPath || desc.normalPath;
 		bool hasGlossAlpha = false;
 
 		// diffuse
 		{
 			bool hasAlpha = false;
-			if( material.GetTexture( aiTextureType_DIFFUSE, 0u, &texFileName ) == aiReturn_SUCCESS )
+			if( desc.diffusePath )
 			{
-				hasTexture = true;
 				shaderCode += L"Dif";
-				vtxLayout.Append( VertexLayout::ElementType::Texture2D );
-				auto tex = Texture::Resolve( gfx, rootPath + to_wide( texFileName.C_Str() ) );
+				auto tex = ResolveTexture( gfx, *desc.diffusePath, 0u, pSurfaces );
 				if( tex->HasAlpha() )
 				{
 					hasAlpha = true;
@@ -56,15 +63,14 @@ modelPath( path.wstring() )
 				pscLayout.Add<Float3>( "materialColor" );
 			}
 			step.AddBindable( RasterizerState::Resolve( gfx, hasAlpha ) );
+			twoSided = hasAlpha;
 		}
 		// specular
 		{
-			if( material.GetTexture( aiTextureType_SPECULAR, 0, &texFileName ) == aiReturn_SUCCESS )
+			if( desc.specularPath )
 			{
-				hasTexture = true;
 				shaderCode += L"Spc";
-				vtxLayout.Append( VertexLayout::ElementType::Texture2D );
-				auto tex = Texture::Resolve( gfx, rootPath + to_wide( texFileName.C_Str() ), 1 );
+				auto tex = ResolveTexture( gfx, *desc.specularPath, 1u, pSurfaces );
 				hasGlossAlpha = tex->HasAlpha();
 				step.AddBindable( std::move( tex ) );
 				pscLayout.Add<Bool>( "useGlossAlpha" );
@@ -76,14 +82,10 @@ modelPath( path.wstring() )
 		}
 		// normal
 		{
-			if( material.GetTexture( aiTextureType_NORMALS, 0, &texFileName ) == aiReturn_SUCCESS )
+			if( desc.normalPath )
 			{
-				hasTexture = true;
 				shaderCode += L"Nrm";
-				vtxLayout.Append( VertexLayout::ElementType::Texture2D );
-				vtxLayout.Append( VertexLayout::ElementType::Tangent );
-				vtxLayout.Append( VertexLayout::ElementType::Bitangent );
-				step.AddBindable( Texture::Resolve( gfx, rootPath + to_wide( texFileName.C_Str() ), 2 ) );
+				step.AddBindable( ResolveTexture( gfx, *desc.normalPath, 2u, pSurfaces ) );
 				pscLayout.Add<Bool>( "useNormalMap" );
 				pscLayout.Add<Float>( "normalMapWeight" );
 			}
@@ -101,27 +103,12 @@ modelPath( path.wstring() )
 			}
 			// PS material params (cbuf)
 			Buffer buf{ std::move( pscLayout ) };
-			if( auto r = buf["materialColor"]; r.Exists() )
-			{
-				aiColor3D color = { 0.45f,0.45f,0.85f };
-				material.Get( AI_MATKEY_COLOR_DIFFUSE, color );
-				r = reinterpret_cast<DirectX::XMFLOAT3&>( color );
-			}
+			buf["materialColor"].SetIfExists( desc.materialColor );
 			buf["useGlossAlpha"].SetIfExists( hasGlossAlpha );
 			buf["useSpecMap"].SetIfExists( true );
-			if( auto r = buf["specularColor"]; r.Exists() )
-			{
-				aiColor3D color = { 0.18f,0.18f,0.18f };
-				material.Get( AI_MATKEY_COLOR_SPECULAR, color );
-				r = reinterpret_cast<DirectX::XMFLOAT3&>( color );
-			}
+			buf["specularColor"].SetIfExists( desc.specularColor );
 			buf["specularWeight"].SetIfExists( 1.f );
-			if( auto r = buf["specularGloss"]; r.Exists() )
-			{
-				float gloss = 8.f;
-				material.Get( AI_MATKEY_SHININESS, gloss );
-				r = gloss;
-			}
+			buf["specularGloss"].SetIfExists( desc.specularGloss );
 			buf["useNormalMap"].SetIfExists( true );
 			buf["normalMapWeight"].SetIfExists( 1.f );
 			step.AddBindable( std::make_unique<CachingPixelConstantBufferEx>( gfx, std::move( buf ), 1u ) );
@@ -136,6 +123,7 @@ modelPath( path.wstring() )
 			RenderStep mask( "outlineMask" );
 
 			mask.AddBindable( InputLayout::Resolve( gfx, vtxLayout, *VertexShader::Resolve( gfx, L"Solid_VS.cso" ) ) );
+			mask.SetInstancedShader( gfx, vtxLayout, L"SolidInst_VS.cso" );
 
 			mask.AddBindable( std::make_shared<TransformCBuffer>( gfx ) );
 
@@ -156,6 +144,7 @@ modelPath( path.wstring() )
 			}
 
 			draw.AddBindable( InputLayout::Resolve( gfx, vtxLayout, *VertexShader::Resolve( gfx, L"Solid_VS.cso" ) ) );
+			draw.SetInstancedShader( gfx, vtxLayout, L"SolidInst_VS.cso" );
 
 			draw.AddBindable( std::make_shared<TransformCBuffer>( gfx ) );
 
@@ -170,6 +159,7 @@ modelPath( path.wstring() )
 			RenderStep draw( "shadowMap" );
 
 			draw.AddBindable( InputLayout::Resolve( gfx, vtxLayout, *VertexShader::Resolve( gfx, L"Solid_VS.cso" ) ) );
+			draw.SetInstancedShader( gfx, vtxLayout, L"SolidInst_VS.cso" );
 
 			draw.AddBindable( std::make_shared<TransformCBuffer>( gfx ) );
 
@@ -179,48 +169,125 @@ modelPath( path.wstring() )
 	}
 }
 
-VertexByteBuffer Material::ExtractVertices( const aiMesh& mesh ) const noexcept
+VertexByteBuffer Material::ExtractVertices( const aiMesh& mesh, float scale, TaskScheduler* pScheduler ) const
+{
+	return { vtxLayout, mesh, scale, pScheduler };
+}
+
+IndexByteBuffer Material::ExtractIndices( const aiMesh & mesh ) const
 {
-	return { vtxLayout, mesh };
+	return IndexByteBuffer::FromTriangles( mesh.mNumVertices, mesh.mFaces, mesh.mNumFaces );
 }
 
-std::vector<uint16_t> Material::ExtractIndices( const aiMesh & mesh ) const noexcept
+std::vector<std::wstring> Material::GetTexturePaths() const
 {
-	std::vector<uint16_t> indices;
-	indices.reserve( (size_t)mesh.mNumFaces * 3 );
-	for( uint32_t i = 0; i < mesh.mNumFaces; i++ )
+	std::vector<std::wstring> paths;
+	for( const auto& p : { desc.diffusePath, desc.specularPath, desc.normalPath } )
 	{
-		const auto& face = mesh.mFaces[i];
-		assert( face.mNumIndices == 3 );
-		indices.push_back( face.mIndices[0] );
-		indices.push_back( face.mIndices[1] );
-		indices.push_back( face.mIndices[2] );
+		if( p )
+		{
+			paths.push_back( *p );
+		}
 	}
-	return indices;
+	return paths;
 }
 
-std::shared_ptr<VertexBuffer> Material::MakeVertexBindable( Graphics & gfx, const aiMesh & mesh, float scale ) const noexcept( !IS_DEBUG )
+std::vector<RenderTechnique> Material::GetTechniques() const noexcept
 {
-	auto vtc = ExtractVertices( mesh );
-	if( scale != 1.f )
+	return techniques;
+}
+
+VertexByteBuffer::FillBenchmarkStats Material::BenchmarkVertexFill( const std::wstring& path, float scale, TaskScheduler& scheduler )
+{
+	Assimp::Importer importer;
+	const auto pScene = importer.ReadFile(
+		to_narrow( path ),
+		aiProcess_Triangulate |
+		aiProcess_JoinIdenticalVertices |
+		aiProcess_ConvertToLeftHanded |
+		aiProcess_GenNormals |
+		aiProcess_CalcTangentSpace
+	);
+	if( !pScene )
+	{
+		throw ModelException( __LINE__, WFILE, importer.GetErrorString() );
+	}
+	std::vector<Material> materials;
+	materials.reserve( pScene->mNumMaterials );
+	for( size_t i = 0; i < pScene->mNumMaterials; i++ )
 	{
-		for( auto i = 0u; i < vtc.Size(); i++ )
+		materials.emplace_back( *pScene->mMaterials[i], path );
+	}
+	VertexByteBuffer::FillBenchmarkStats stats;
+	for( size_t i = 0; i < pScene->mNumMeshes; i++ )
+	{
+		const auto& mesh = *pScene->mMeshes[i];
+		VertexByteBuffer::BenchmarkAiMeshFill( stats, materials[mesh.mMaterialIndex].vtxLayout, mesh, scale, scheduler );
+	}
+	return stats;
+}
+
+VertexLayout Material::MakeVertexLayout( const Desc& desc, bool packed ) IFNOEXCEPT
+{
+	using Type = VertexLayout::ElementType;
+	VertexLayout layout;
+	layout.Append( Type::Position3D );
+	layout.Append( packed ? Type::NormalPacked : Type::Normal );
+	if( desc.diffusePath || desc.specularPath || desc.normalPath )
+	{
+		layout.Append( packed ? Type::Texture2DHalf : Type::Texture2D );
+	}
+	if( desc.normalPath )
+	{
+		if( packed )
+		{
+			layout.Append( Type::TangentFrame );
+		}
+		else
 		{
-			DirectX::XMFLOAT3& pos = vtc[i].Attribute<VertexLayout::ElementType::Position3D>();
-			pos.x *= scale;
-			pos.y *= scale;
-			pos.z *= scale;
+			layout.Append( Type::Tangent );
+			layout.Append( Type::Bitangent );
 		}
 	}
-	return VertexBuffer::Resolve( gfx, MakeMeshTag( mesh ), std::move( vtc ) );
+	return layout;
 }
 
-std::shared_ptr<IndexBuffer> Material::MakeIndexBindable( Graphics & gfx, const aiMesh & mesh ) const noexcept( !IS_DEBUG )
+Material::Desc Material::ReadDesc( const aiMaterial& material, const std::filesystem::path& path )
 {
-	return IndexBuffer::Resolve( gfx, MakeMeshTag( mesh ), ExtractIndices( mesh ) );
+	const auto rootPath = path.parent_path().wstring() + L"\\";
+	Desc desc;
+	aiString str;
+	material.Get( AI_MATKEY_NAME, str );
+	desc.name = to_wide( str.C_Str() );
+	if( material.GetTexture( aiTextureType_DIFFUSE, 0u, &str ) == aiReturn_SUCCESS )
+	{
+		desc.diffusePath = rootPath + to_wide( str.C_Str() );
+	}
+	else
+	{
+		material.Get( AI_MATKEY_COLOR_DIFFUSE, reinterpret_cast<aiColor3D&>( desc.materialColor ) );
+	}
+	if( material.GetTexture( aiTextureType_SPECULAR, 0, &str ) == aiReturn_SUCCESS )
+	{
+		desc.specularPath = rootPath + to_wide( str.C_Str() );
+	}
+	material.Get( AI_MATKEY_COLOR_SPECULAR, reinterpret_cast<aiColor3D&>( desc.specularColor ) );
+	material.Get( AI_MATKEY_SHININESS, desc.specularGloss );
+	if( material.GetTexture( aiTextureType_NORMALS, 0, &str ) == aiReturn_SUCCESS )
+	{
+		desc.normalPath = rootPath + to_wide( str.C_Str() );
+	}
+	return desc;
 }
 
-std::vector<RenderTechnique> Material::GetTechniques() const noexcept
+std::shared_ptr<Texture> Material::ResolveTexture( Graphics& gfx, const std::wstring& path, UINT slot, const SurfaceMap* pSurfaces )
 {
-	return techniques;
+	if( pSurfaces )
+	{
+		if( const auto i = pSurfaces->find( path ); i != pSurfaces->cend() )
+		{
+			return Texture::Resolve( gfx, path, slot, i->second );
+		}
+	}
+	return Texture::Resolve( gfx, path, slot );
 }
\ No newline at end of file
@@ -9,31 +9,88 @@
 #pragma once
 
 #include "Vertex.h"
+#include "IndexByteBuffer.h"
 #include "RenderTechnique.h"
 #include "DynamicConstantBuffer.h"
 #include "ConstantBuffersEx.h"
 #define IR_INCLUDE_TEXTURE
 #include "BindableCommon.h"
+#include "SurfaceEx.h"
 
 #include <vector>
 #include <filesystem>
+#include <optional>
+#include <unordered_map>
 
 class Material
 {
 public:
+	// decoded textures by their path
+	using SurfaceMap = std::unordered_map<std::wstring, SurfaceEx>;
+
+	/**
+	 * @brief Parameters and texture paths of the material as read from the source file
+	*/
+	struct Desc
+	{
+		std::wstring name;
+		std::optional<std::wstring> diffusePath;
+		std::optional<std::wstring> specularPath;
+		std::optional<std::wstring> normalPath;
+		DirectX::XMFLOAT3 materialColor = { 0.45f,0.45f,0.85f };
+		DirectX::XMFLOAT3 specularColor = { 0.18f,0.18f,0.18f };
+		float specularGloss = 8.f;
+	};
+
+public:
+	/**
+	 * @brief Reads parameters and texture paths of the material without touching the GPU,
+	 * * so it can be constructed by loader threads
+	*/
+	Material( const aiMaterial& material, const std::filesystem::path& path ) IFNOEXCEPT;
+	Material( Desc desc, const std::filesystem::path& path ) IFNOEXCEPT;
 	Material( Graphics& gfx, const aiMaterial& material, const std::filesystem::path& path ) IFNOEXCEPT;
-	VertexByteBuffer ExtractVertices( const aiMesh& mesh ) const noexcept;
-	std::vector<uint16_t> ExtractIndices( const aiMesh& mesh ) const noexcept;
-	std::shared_ptr<VertexBuffer> MakeVertexBindable( Graphics& gfx, const aiMesh& mesh, float scale = 1.f ) const IFNOEXCEPT;
-	std::shared_ptr<IndexBuffer> MakeIndexBindable( Graphics& gfx, const aiMesh& mesh ) const IFNOEXCEPT;
+	/**
+	 * @brief Creates bindables of the techniques, has to be called from the render thread
+	 * @param pSurfaces already decoded textures, the ones missing are loaded from file
+	*/
+	void Create( Graphics& gfx, const SurfaceMap* pSurfaces = nullptr ) IFNOEXCEPT;
+	std::vector<std::wstring> GetTexturePaths() const;
+	const Desc& GetDesc() const noexcept { return desc; }
+	const VertexLayout& GetVertexLayout() const noexcept { return vtxLayout; }
+	/**
+	 * @return true if back faces are drawn, known after Create as it depends on the diffuse alpha
+	*/
+	bool IsTwoSided() const noexcept { return twoSided; }
+	/**
+	 * @brief Vertex layout of the material description
+	 * @param packed if false, the full precision float layout that was used before the packed elements,
+	 * * only its size is meaningful, shaders of the material expect the packed tangent frame
+	*/
+	static VertexLayout MakeVertexLayout( const Desc& desc, bool packed = true ) IFNOEXCEPT;
+	/**
+	 * @param pScheduler if given, large meshes are filled in parallel on it
+	*/
+	VertexByteBuffer ExtractVertices( const aiMesh& mesh, float scale = 1.f, TaskScheduler* pScheduler = nullptr ) const;
+	/**
+	 * @brief Extracts indices as 16-bit unless the mesh has more vertices than 16-bit indices can address
+	*/
+	IndexByteBuffer ExtractIndices( const aiMesh& mesh ) const;
+	std::wstring MakeMeshTag( const aiMesh& mesh ) const noexcept { return modelPath + L"$" + to_wide( mesh.mName.C_Str() ); }
 	std::vector<RenderTechnique> GetTechniques() const noexcept;
+	/**
+	 * @brief Imports the model and times the vertex fill paths on all of its meshes
+	*/
+	static VertexByteBuffer::FillBenchmarkStats BenchmarkVertexFill( const std::wstring& path, float scale, TaskScheduler& scheduler );
 
 private:
-	std::wstring MakeMeshTag( const aiMesh& mesh ) const noexcept { return modelPath + L"$" + to_wide( mesh.mName.C_Str() ); }
+	static Desc ReadDesc( const aiMaterial& material, const std::filesystem::path& path );
+	static std::shared_ptr<Texture> ResolveTexture( Graphics& gfx, const std::wstring& path, UINT slot, const SurfaceMap* pSurfaces );
 
 private:
 	VertexLayout vtxLayout;
 	std::vector<RenderTechnique> techniques;
 	std::wstring modelPath;
-	std::wstring name;
+	Desc desc;
+	bool twoSided = false;
 };
\ No newline at end of file
@@ -8,13 +8,131 @@
  */
 #include "Mesh.h"
 #include "Material.h"
+#include "TransformHierarchy.h"
+#include "MeshSimplifier.h"
+#include "Frustum.h"
+
+#include <assimp/scene.h>
+
+#include <cassert>
+#include <cfloat>
+#include <chrono>
+#include <utility>
 
 Mesh::Mesh( Graphics & gfx, const Material & mat, const aiMesh & mesh, float scale ) noexcept( !IS_DEBUG ) :
-	Drawable( gfx, mat, mesh, scale )
+	Mesh( gfx, mat, Extract( mat, mesh, scale ) )
 {}
 
-void Mesh::Submit( size_t channelFilter, DirectX::FXMMATRIX accumulatedTransform ) const IFNOEXCEPT
+Mesh::Mesh( Graphics& gfx, const Material& mat, const Data& data ) noexcept( !IS_DEBUG ) :
+	Drawable( gfx, mat, data.tag, data.vertices, data.indices ),
+	boundsCenter( data.boundsCenter ),
+	boundsExtents( data.boundsExtents ),
+	meshlets( data.meshlets ),
+	cullBackfaces( !mat.IsTwoSided() )
+{
+	SetLods( data.lods );
+}
+
+Mesh::Mesh( Graphics& gfx, const Material& mat, std::shared_ptr<GeometryHeap::Allocation> pGeometry,
+	const DirectX::XMFLOAT3& boundsCenter, const DirectX::XMFLOAT3& boundsExtents, std::vector<Lod> lods,
+	std::vector<MeshletSet::Meshlet> meshlets_in ) noexcept( !IS_DEBUG ) :
+	Drawable( gfx, mat, std::move( pGeometry ) ),
+	boundsCenter( boundsCenter ),
+	boundsExtents( boundsExtents ),
+	meshlets( std::move( meshlets_in ) ),
+	cullBackfaces( !mat.IsTwoSided() )
+{
+	SetLods( std::move( lods ) );
+}
+
+Mesh::Data Mesh::Extract( const Material& mat, const aiMesh& mesh, float scale, TaskScheduler* pScheduler ) noexcept( !IS_DEBUG )
+{
+	namespace dx = DirectX;
+	Data data{ mat.MakeMeshTag( mesh ), mat.ExtractVertices( mesh, scale, pScheduler ), mat.ExtractIndices( mesh ) };
+	if( mesh.mNumVertices == 0u )
+	{
+		return data;
+	}
+	data.optimizeStats = MeshOptimizer::Optimize( data.vertices, data.indices,
+		mesh.mNumFaces >= MESHLET_MIN_TRIANGLES ? &data.meshlets : nullptr );
+	{
+		const auto start = std::chrono::steady_clock::now();
+		data.lods = BuildLods( data.indices, std::as_const( data.vertices ).View<VertexLayout::ElementType::Position3D>() );
+		data.simplifyTime = std::chrono::duration<float, std::milli>( std::chrono::steady_clock::now() - start ).count();
+	}
+	// positions of the buffer are already scaled
+	auto minPos = dx::XMVectorReplicate( FLT_MAX );
+	auto maxPos = dx::XMVectorReplicate( -FLT_MAX );
+	for( const auto& p : std::as_const( data.vertices ).View<VertexLayout::ElementType::Position3D>() )
+	{
+		const auto pos = dx::XMLoadFloat3( &p );
+		minPos = dx::XMVectorMin( minPos, pos );
+		maxPos = dx::XMVectorMax( maxPos, pos );
+	}
+	dx::XMStoreFloat3( &data.boundsCenter, dx::XMVectorScale( dx::XMVectorAdd( minPos, maxPos ), 0.5f ) );
+	dx::XMStoreFloat3( &data.boundsExtents, dx::XMVectorScale( dx::XMVectorSubtract( maxPos, minPos ), 0.5f ) );
+	return data;
+}
+
+std::vector<Drawable::Lod> Mesh::BuildLods( IndexByteBuffer& indices, StridedView<const DirectX::XMFLOAT3> positions )
+{
+	std::vector<uint32_t> all( indices.Count() );
+	for( size_t i = 0; i < all.size(); i++ )
+	{
+		all[i] = indices[i];
+	}
+	std::vector<Lod> lods{ { 0u, (UINT)all.size(), 0.f } };
+
+	// errors of the levels add up, each one is simplified from the previous
+	float error = 0.f;
+	std::vector<uint32_t> previous = all;
+	while( lods.size() < MAX_LOD_COUNT && previous.size() / 3u >= LOD_MIN_TRIANGLES )
+	{
+		float levelError = 0.f;
+		const size_t target = size_t( float( previous.size() / 3u ) * LOD_INDEX_RATIO ) * 3u;
+		auto level = MeshSimplifier::Simplify( previous, positions, target, LOD_MAX_ERROR - error, &levelError );
+		// levels that barely shrink cost index memory for nothing
+		if( level.size() > previous.size() - previous.size() / 5u )
+		{
+			break;
+		}
+		error += levelError;
+		level = MeshOptimizer::OptimizeVertexCache( level, positions.size() );
+		lods.push_back( { (UINT)all.size(), (UINT)level.size(), error } );
+		all.insert( all.end(), level.begin(), level.end() );
+		previous = std::move( level );
+	}
+	if( lods.size() > 1u )
+	{
+		indices = IndexByteBuffer( all );
+	}
+	return lods;
+}
+
+void Mesh::Submit( size_t channelFilter, const Frustum& frustum, const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents ) const noexcept( !IS_DEBUG )
+{
+	// meshlets partition the full level only, coarser levels are small on screen anyway
+	const auto lod = frustum.SelectLod( *this, center, extents );
+	if( lod != 0u || meshlets.IsEmpty() || !frustum.CullsMeshlets() )
+	{
+		Drawable::Submit( channelFilter, lod );
+		return;
+	}
+	const auto visible = frustum.CullMeshlets( meshlets, GetTransformXM(), cullBackfaces );
+	if( visible.count > 0u )
+	{
+		Drawable::Submit( channelFilter, lod, visible );
+	}
+}
+
+void Mesh::SetTransformSource( const TransformHierarchy& transforms, uint32_t slot ) noexcept
+{
+	pTransforms = &transforms;
+	transformSlot = slot;
+}
+
+DirectX::XMMATRIX Mesh::GetTransformXM() const noexcept
 {
-	DirectX::XMStoreFloat4x4( &transform, accumulatedTransform );
-	Drawable::Submit( channelFilter );
+	assert( pTransforms );
+	return pTransforms->GetWorldXM( transformSlot );
 }
\ No newline at end of file
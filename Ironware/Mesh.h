@@ -10,16 +10,96 @@
 
 #include "Graphics.h"
 #include "Drawable.h"
+#include "Vertex.h"
+#include "IndexByteBuffer.h"
+#include "MeshOptimizer.h"
+#include "MeshletSet.h"
+
+#include <string>
+#include <vector>
 
 class Material;
+class TransformHierarchy;
+class TaskScheduler;
+class Frustum;
 
 class Mesh : public Drawable
 {
+public:
+	/**
+	 * @brief Geometry of the mesh extracted on the CPU, buffers are created from it on the render thread
+	*/
+	struct Data
+	{
+		std::wstring tag;
+		VertexByteBuffer vertices;
+		IndexByteBuffer indices;
+		DirectX::XMFLOAT3 boundsCenter = {};
+		DirectX::XMFLOAT3 boundsExtents = {};
+		MeshOptimizer::Stats optimizeStats;
+		// levels of detail follow the full mesh in the index buffer
+		std::vector<Drawable::Lod> lods;
+		float simplifyTime = 0.f;
+		// clusters of the full level, empty for small meshes
+		std::vector<MeshletSet::Meshlet> meshlets;
+	};
+
 public:
 	Mesh( Graphics& gfx, const Material& mat, const aiMesh& mesh, float scale = 1.f ) IFNOEXCEPT;
-	void Submit( size_t channelFilter, DirectX::FXMMATRIX accumulatedTransform ) const IFNOEXCEPT;
-	DirectX::XMMATRIX GetTransformXM() const noexcept override { return DirectX::XMLoadFloat4x4( &transform ); }
+	Mesh( Graphics& gfx, const Material& mat, const Data& data ) IFNOEXCEPT;
+	Mesh( Graphics& gfx, const Material& mat, std::shared_ptr<GeometryHeap::Allocation> pGeometry,
+		const DirectX::XMFLOAT3& boundsCenter, const DirectX::XMFLOAT3& boundsExtents, std::vector<Lod> lods = {},
+		std::vector<MeshletSet::Meshlet> meshlets = {} ) IFNOEXCEPT;
+	/**
+	 * @brief Extracts vertices, indices and bounds of the mesh, doesn't touch the GPU
+	 * @note Triangles and vertices are reordered by MeshOptimizer, which groups the triangles of large
+	 * * meshes into meshlets, then up to MAX_LOD_COUNT - 1 simplified levels are appended to the indices
+	*/
+	static Data Extract( const Material& mat, const aiMesh& mesh, float scale = 1.f, TaskScheduler* pScheduler = nullptr ) IFNOEXCEPT;
+	/**
+	 * @brief Makes the mesh read its world matrix from the slot of the model hierarchy
+	 * @note Mesh referenced by several nodes takes the transform of the last attached one
+	*/
+	void SetTransformSource( const TransformHierarchy& transforms, uint32_t slot ) noexcept;
+	using Drawable::Submit;
+	/**
+	 * @brief Submits the level of detail that the frustum selects for the world bounds,
+	 * * the full level is culled by meshlets if the mesh has them
+	*/
+	void Submit( size_t channelFilter, const Frustum& frustum, const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents ) const IFNOEXCEPT;
+	DirectX::XMMATRIX GetTransformXM() const noexcept override;
+	/**
+	 * @brief Local space axis aligned bounds of the vertices, scale is already applied
+	*/
+	const DirectX::XMFLOAT3& GetBoundsCenter() const noexcept { return boundsCenter; }
+	const DirectX::XMFLOAT3& GetBoundsExtents() const noexcept { return boundsExtents; }
+	const MeshletSet& GetMeshlets() const noexcept { return meshlets; }
+
+public:
+	static constexpr size_t MAX_LOD_COUNT = 4u;
+	// smaller meshes are culled as a whole, a couple of meshlets wouldn't pay for the extra draws
+	static constexpr size_t MESHLET_MIN_TRIANGLES = 4u * MeshletSet::MAX_TRIANGLES;
+
+private:
+	/**
+	 * @brief Simplifies the indices level by level and appends the levels to them
+	*/
+	static std::vector<Lod> BuildLods( IndexByteBuffer& indices, StridedView<const DirectX::XMFLOAT3> positions );
+
+private:
+	// each level keeps about half of the triangles of the previous one
+	static constexpr float LOD_INDEX_RATIO = 0.5f;
+	// largest error of a level relative to the radius of the bounds
+	static constexpr float LOD_MAX_ERROR = 0.05f;
+	// meshes and levels with fewer triangles aren't simplified further
+	static constexpr size_t LOD_MIN_TRIANGLES = 64u;
 
 private:
-	mutable DirectX::XMFLOAT4X4 transform = {};
+	DirectX::XMFLOAT3 boundsCenter = {};
+	DirectX::XMFLOAT3 boundsExtents = {};
+	MeshletSet meshlets;
+	// two sided materials show the back faces, so their meshlets aren't cone tested
+	bool cullBackfaces;
+	const TransformHierarchy* pTransforms = nullptr;
+	uint32_t transformSlot = 0u;
 };
\ No newline at end of file
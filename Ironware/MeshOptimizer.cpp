@@ -0,0 +1,382 @@
+/*!
+ * \file MeshOptimizer.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ *
+ */
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <numeric>
+#include <utility>
+
+namespace
+{
+	constexpr uint32_t NO_VERTEX = ~0u;
+
+	/**
+	 * @brief FIFO cache of vertex indices, a vertex is cached while fewer than size misses followed it
+	*/
+	class CacheSimulator
+	{
+	public:
+		CacheSimulator( size_t vertexCount, size_t size ) :
+			stamps( vertexCount, 0u ),
+			time( size + 1u ),
+			size( size )
+		{}
+
+		/**
+		 * @return 1 if the vertex had to be transformed
+		*/
+		size_t Touch( uint32_t v ) noexcept
+		{
+			if( time - stamps[v] > size )
+			{
+				stamps[v] = time++;
+				return 1u;
+			}
+			return 0u;
+		}
+		void Flush() noexcept { time += size + 1u; }
+
+	private:
+		std::vector<size_t> stamps;
+		size_t time;
+		size_t size;
+	};
+}
+
+MeshOptimizer::Stats MeshOptimizer::Optimize( VertexByteBuffer& vertices, IndexByteBuffer& indices, std::vector<MeshletSet::Meshlet>* pMeshlets )
+{
+	using namespace std::chrono;
+	const auto start = steady_clock::now();
+
+	std::vector<uint32_t> list( indices.Count() );
+	for( size_t i = 0; i < list.size(); i++ )
+	{
+		list[i] = indices[i];
+	}
+	Stats stats;
+	stats.triangleCount = list.size() / 3u;
+	stats.vertexCount = vertices.Size();
+	stats.transformsBefore = CountTransforms( list, stats.vertexCount );
+
+	list = OptimizeVertexCache( list, stats.vertexCount );
+	if( vertices.GetLayout().Has( VertexLayout::ElementType::Position3D ) )
+	{
+		const auto positions = std::as_const( vertices ).View<VertexLayout::ElementType::Position3D>();
+		list = OptimizeOverdraw( list, positions );
+		if( pMeshlets )
+		{
+			*pMeshlets = MeshletSet::Build( list, positions );
+		}
+	}
+	stats.transformsAfter = CountTransforms( list, OptimizeVertexFetch( vertices, list ) );
+	// dropped vertices can make the mesh fit 16-bit indices
+	indices = IndexByteBuffer( list );
+
+	stats.time = duration<float, std::milli>( steady_clock::now() - start ).count();
+	return stats;
+}
+
+std::vector<uint32_t> MeshOptimizer::OptimizeVertexCache( const std::vector<uint32_t>& indices, size_t vertexCount, size_t cacheSize )
+{
+	const size_t triangleCount = indices.size() / 3u;
+
+	// triangles of all vertices in one array, those of vertex v start at offsets[v]
+	std::vector<uint32_t> liveTriangles( vertexCount, 0u );
+	for( const auto v : indices )
+	{
+		liveTriangles[v]++;
+	}
+	std::vector<uint32_t> offsets( vertexCount + 1u, 0u );
+	for( size_t v = 0; v < vertexCount; v++ )
+	{
+		offsets[v + 1u] = offsets[v] + liveTriangles[v];
+	}
+	std::vector<uint32_t> adjacency( indices.size() );
+	{
+		std::vector<uint32_t> cursors( offsets.begin(), offsets.end() - 1 );
+		for( size_t i = 0; i < indices.size(); i++ )
+		{
+			adjacency[cursors[indices[i]]++] = uint32_t( i / 3u );
+		}
+	}
+
+	std::vector<size_t> cacheTime( vertexCount, 0u );
+	std::vector<bool> emitted( triangleCount, false );
+	std::vector<uint32_t> deadEnd;
+	deadEnd.reserve( indices.size() );
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> result;
+	result.reserve( triangleCount * 3u );
+	size_t time = cacheSize + 1u;
+	size_t cursor = 0u;
+
+	// recently used vertices with live triangles first, then the first live vertex of the input
+	const auto skipDeadEnd = [&]()
+	{
+		while( !deadEnd.empty() )
+		{
+			const auto v = deadEnd.back();
+			deadEnd.pop_back();
+			if( liveTriangles[v] > 0u )
+			{
+				return v;
+			}
+		}
+		for( ; cursor < vertexCount; cursor++ )
+		{
+			if( liveTriangles[cursor] > 0u )
+			{
+				return uint32_t( cursor );
+			}
+		}
+		return NO_VERTEX;
+	};
+
+	auto fan = skipDeadEnd();
+	while( fan != NO_VERTEX )
+	{
+		// emit all of the remaining triangles around the fanning vertex
+		candidates.clear();
+		for( auto a = offsets[fan]; a < offsets[fan + 1u]; a++ )
+		{
+			const auto t = adjacency[a];
+			if( emitted[t] )
+			{
+				continue;
+			}
+			emitted[t] = true;
+			for( size_t k = 0; k < 3u; k++ )
+			{
+				const auto v = indices[t * 3u + k];
+				result.push_back( v );
+				deadEnd.push_back( v );
+				candidates.push_back( v );
+				liveTriangles[v]--;
+				if( time - cacheTime[v] > cacheSize )
+				{
+					cacheTime[v] = time++;
+				}
+			}
+		}
+
+		// the oldest candidate that stays in the cache while its remaining triangles are emitted
+		fan = NO_VERTEX;
+		int64_t bestPriority = -1;
+		for( const auto v : candidates )
+		{
+			if( liveTriangles[v] == 0u )
+			{
+				continue;
+			}
+			int64_t priority = 0;
+			if( time - cacheTime[v] + 2u * liveTriangles[v] <= cacheSize )
+			{
+				priority = int64_t( time - cacheTime[v] );
+			}
+			if( priority > bestPriority )
+			{
+				bestPriority = priority;
+				fan = v;
+			}
+		}
+		if( fan == NO_VERTEX )
+		{
+			fan = skipDeadEnd();
+		}
+	}
+	return result;
+}
+
+std::vector<uint32_t> MeshOptimizer::OptimizeOverdraw( const std::vector<uint32_t>& indices, StridedView<const DirectX::XMFLOAT3> positions,
+	float threshold, size_t cacheSize )
+{
+	namespace dx = DirectX;
+	const size_t triangleCount = indices.size() / 3u;
+	if( triangleCount < 2u )
+	{
+		return indices;
+	}
+
+	// hard boundaries, where all three vertices of a triangle miss and the order restarts,
+	// with the misses of every hard cluster in the input order
+	std::vector<size_t> hard;
+	std::vector<size_t> hardMisses;
+	{
+		CacheSimulator cache( positions.size(), cacheSize );
+		for( size_t t = 0; t < triangleCount; t++ )
+		{
+			const auto misses = cache.Touch( indices[t * 3u] ) + cache.Touch( indices[t * 3u + 1u] ) + cache.Touch( indices[t * 3u + 2u] );
+			if( t == 0u || misses == 3u )
+			{
+				hard.push_back( t );
+				hardMisses.push_back( 0u );
+			}
+			hardMisses.back() += misses;
+		}
+		hard.push_back( triangleCount );
+	}
+
+	// soft boundaries split a cluster wherever its running ACMR is close enough to that of
+	// the whole cluster in the input order. The cache is assumed empty at the start of every
+	// cluster, vertices left in it by the cluster drawn before can only save misses, so the
+	// reordered clusters stay within the threshold of the input
+	std::vector<size_t> clusters;
+	{
+		CacheSimulator cache( positions.size(), cacheSize );
+		const auto touch = [&]( size_t t )
+		{
+			return cache.Touch( indices[t * 3u] ) + cache.Touch( indices[t * 3u + 1u] ) + cache.Touch( indices[t * 3u + 2u] );
+		};
+		const auto coldMisses = [&]( size_t begin, size_t end )
+		{
+			cache.Flush();
+			size_t misses = 0u;
+			for( size_t t = begin; t < end; t++ )
+			{
+				misses += touch( t );
+			}
+			return misses;
+		};
+		for( size_t h = 0; h + 1u < hard.size(); h++ )
+		{
+			const size_t begin = hard[h];
+			const size_t end = hard[h + 1u];
+			const float target = threshold * float( hardMisses[h] ) / float( end - begin );
+
+			const size_t first = clusters.size();
+			clusters.push_back( begin );
+			cache.Flush();
+			size_t runningMisses = 0u;
+			size_t runningTriangles = 0u;
+			for( size_t t = begin; t < end; t++ )
+			{
+				runningMisses += touch( t );
+				runningTriangles++;
+				if( float( runningMisses ) / float( runningTriangles ) <= target )
+				{
+					clusters.push_back( t + 1u );
+					cache.Flush();
+					runningMisses = 0u;
+					runningTriangles = 0u;
+				}
+			}
+			if( clusters.back() == end )
+			{
+				clusters.pop_back();
+			}
+			// tail that didn't reach the target is merged into the clusters before it until it does
+			else if( float( runningMisses ) / float( runningTriangles ) > target )
+			{
+				while( clusters.size() - first > 1u )
+				{
+					clusters.pop_back();
+					if( float( coldMisses( clusters.back(), end ) ) / float( end - clusters.back() ) <= target )
+					{
+						break;
+					}
+				}
+			}
+		}
+		clusters.push_back( triangleCount );
+	}
+	const size_t clusterCount = clusters.size() - 1u;
+	if( clusterCount < 2u )
+	{
+		return indices;
+	}
+
+	// area weighted centroids and normals of the clusters and of the mesh
+	std::vector<dx::XMFLOAT3> centroids( clusterCount );
+	std::vector<dx::XMFLOAT3> normals( clusterCount );
+	auto meshCentroid = dx::XMVectorZero();
+	float meshArea = 0.f;
+	for( size_t c = 0; c < clusterCount; c++ )
+	{
+		auto centroid = dx::XMVectorZero();
+		auto normal = dx::XMVectorZero();
+		float area = 0.f;
+		for( size_t t = clusters[c]; t < clusters[c + 1u]; t++ )
+		{
+			const auto p0 = dx::XMLoadFloat3( &positions[indices[t * 3u]] );
+			const auto p1 = dx::XMLoadFloat3( &positions[indices[t * 3u + 1u]] );
+			const auto p2 = dx::XMLoadFloat3( &positions[indices[t * 3u + 2u]] );
+			const auto n = dx::XMVector3Cross( dx::XMVectorSubtract( p1, p0 ), dx::XMVectorSubtract( p2, p0 ) );
+			const float a = dx::XMVectorGetX( dx::XMVector3Length( n ) );
+			centroid = dx::XMVectorMultiplyAdd( dx::XMVectorAdd( dx::XMVectorAdd( p0, p1 ), p2 ), dx::XMVectorReplicate( a / 3.f ), centroid );
+			normal = dx::XMVectorAdd( normal, n );
+			area += a;
+		}
+		meshCentroid = dx::XMVectorAdd( meshCentroid, centroid );
+		meshArea += area;
+		dx::XMStoreFloat3( &centroids[c], area > 0.f ? dx::XMVectorScale( centroid, 1.f / area ) : centroid );
+		dx::XMStoreFloat3( &normals[c], dx::XMVector3Normalize( normal ) );
+	}
+	if( meshArea > 0.f )
+	{
+		meshCentroid = dx::XMVectorScale( meshCentroid, 1.f / meshArea );
+	}
+
+	// clusters on the outside that face away from the center occlude the others, they go first
+	std::vector<float> keys( clusterCount );
+	for( size_t c = 0; c < clusterCount; c++ )
+	{
+		const auto toCluster = dx::XMVectorSubtract( dx::XMLoadFloat3( &centroids[c] ), meshCentroid );
+		keys[c] = dx::XMVectorGetX( dx::XMVector3Dot( toCluster, dx::XMLoadFloat3( &normals[c] ) ) );
+	}
+	std::vector<size_t> order( clusterCount );
+	std::iota( order.begin(), order.end(), size_t( 0u ) );
+	std::stable_sort( order.begin(), order.end(), [&keys]( size_t lhs, size_t rhs ) { return keys[lhs] > keys[rhs]; } );
+
+	std::vector<uint32_t> result;
+	result.reserve( indices.size() );
+	for( const auto c : order )
+	{
+		result.insert( result.end(), indices.begin() + clusters[c] * 3u, indices.begin() + clusters[c + 1u] * 3u );
+	}
+	return result;
+}
+
+size_t MeshOptimizer::OptimizeVertexFetch( VertexByteBuffer& vertices, std::vector<uint32_t>& indices )
+{
+	std::vector<uint32_t> remap( vertices.Size(), NO_VERTEX );
+	uint32_t next = 0u;
+	for( auto& i : indices )
+	{
+		if( remap[i] == NO_VERTEX )
+		{
+			remap[i] = next++;
+		}
+		i = remap[i];
+	}
+
+	const size_t stride = vertices.GetLayout().Size();
+	VertexByteBuffer reordered( vertices.GetLayout(), next );
+	for( size_t v = 0; v < remap.size(); v++ )
+	{
+		if( remap[v] != NO_VERTEX )
+		{
+			std::memcpy( reordered.GetData() + remap[v] * stride, vertices.GetData() + v * stride, stride );
+		}
+	}
+	vertices = std::move( reordered );
+	return next;
+}
+
+size_t MeshOptimizer::CountTransforms( const std::vector<uint32_t>& indices, size_t vertexCount, size_t cacheSize )
+{
+	CacheSimulator cache( vertexCount, cacheSize );
+	size_t misses = 0u;
+	for( const auto v : indices )
+	{
+		misses += cache.Touch( v );
+	}
+	return misses;
+}
@@ -0,0 +1,74 @@
+/*!
+ * \file MeshOptimizer.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Header file that contains MeshOptimizer, the import stage that reorders mesh geometry
+ *
+ * \note Triangles are ordered with Tipsify (Sander et al. 2007) for the post-transform cache,
+ * * then clusters of that order are sorted so outward facing ones are drawn first, which cuts
+ * * overdraw and keeps most of the cache locality. Vertices are finally stored in the order
+ * * of their first use, so vertex fetch walks memory forward.
+*/
+#pragma once
+
+#include "Vertex.h"
+#include "IndexByteBuffer.h"
+#include "StridedView.h"
+#include "MeshletSet.h"
+
+#include <DirectXMath.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class MeshOptimizer
+{
+public:
+	/**
+	 * @brief Simulated post-transform cache misses of the mesh before and after the optimization
+	 * @note ACMR is transforms per triangle, ATVR transforms per vertex, 1 is the optimum of ATVR
+	*/
+	struct Stats
+	{
+		size_t triangleCount = 0u;
+		size_t vertexCount = 0u;
+		size_t transformsBefore = 0u;
+		size_t transformsAfter = 0u;
+		// milliseconds
+		float time = 0.f;
+	};
+
+public:
+	/**
+	 * @brief Reorders triangles for the vertex cache and overdraw, then vertices for fetch locality
+	 * @note Vertices that no triangle references are dropped
+	 * @param pMeshlets if given, receives meshlets that the triangles are grouped into before the vertices are reordered
+	*/
+	static Stats Optimize( VertexByteBuffer& vertices, IndexByteBuffer& indices, std::vector<MeshletSet::Meshlet>* pMeshlets = nullptr );
+	/**
+	 * @brief Tipsify triangle order for a cache of cacheSize vertices
+	*/
+	static std::vector<uint32_t> OptimizeVertexCache( const std::vector<uint32_t>& indices, size_t vertexCount, size_t cacheSize = CACHE_SIZE );
+	/**
+	 * @brief Splits the cache optimized order into clusters and sorts them front to back from the outside
+	 * @param threshold ACMR of the clusters may grow by this factor, larger values give smaller clusters
+	*/
+	static std::vector<uint32_t> OptimizeOverdraw( const std::vector<uint32_t>& indices, StridedView<const DirectX::XMFLOAT3> positions,
+		float threshold = 1.05f, size_t cacheSize = CACHE_SIZE );
+	/**
+	 * @brief Moves vertices into the order of their first use and rewrites the indices
+	 * @return count of the referenced vertices, which is the new size of the buffer
+	*/
+	static size_t OptimizeVertexFetch( VertexByteBuffer& vertices, std::vector<uint32_t>& indices );
+	/**
+	 * @brief Misses of a FIFO post-transform cache of cacheSize vertices
+	*/
+	static size_t CountTransforms( const std::vector<uint32_t>& indices, size_t vertexCount, size_t cacheSize = CACHE_SIZE );
+
+public:
+	// FIFO size the orders are optimized and measured for, a common size of post-transform caches
+	static constexpr size_t CACHE_SIZE = 16u;
+};
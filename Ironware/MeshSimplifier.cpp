@@ -0,0 +1,323 @@
+/*!
+ * \file MeshSimplifier.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ *
+ */
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace dx = DirectX;
+
+namespace
+{
+	/**
+	 * @brief Sum of squared distances to the planes of triangles, weighted by their areas
+	 * @note Doubles, as the terms of large and small triangles are summed
+	*/
+	struct Quadric
+	{
+		double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+		double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+		double c = 0.0;
+		double weight = 0.0;
+
+		static Quadric FromPlane( double x, double y, double z, double d, double weight ) noexcept
+		{
+			Quadric q;
+			q.a00 = x * x * weight; q.a01 = x * y * weight; q.a02 = x * z * weight;
+			q.a11 = y * y * weight; q.a12 = y * z * weight; q.a22 = z * z * weight;
+			q.b0 = x * d * weight; q.b1 = y * d * weight; q.b2 = z * d * weight;
+			q.c = d * d * weight;
+			q.weight = weight;
+			return q;
+		}
+		Quadric& operator+=( const Quadric& rhs ) noexcept
+		{
+			a00 += rhs.a00; a01 += rhs.a01; a02 += rhs.a02;
+			a11 += rhs.a11; a12 += rhs.a12; a22 += rhs.a22;
+			b0 += rhs.b0; b1 += rhs.b1; b2 += rhs.b2;
+			c += rhs.c;
+			weight += rhs.weight;
+			return *this;
+		}
+		/**
+		 * @return weighted mean of the squared distances of the point to the planes
+		*/
+		double Evaluate( const dx::XMFLOAT3& p ) const noexcept
+		{
+			const double x = p.x, y = p.y, z = p.z;
+			const double error =
+				a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z +
+				a11 * y * y + 2.0 * a12 * y * z + a22 * z * z +
+				2.0 * ( b0 * x + b1 * y + b2 * z ) + c;
+			return weight > 0.0 ? std::abs( error ) / weight : 0.0;
+		}
+	};
+
+	struct Collapse
+	{
+		uint32_t from;
+		uint32_t to;
+		double error;
+	};
+
+	constexpr uint64_t edge_key( uint32_t a, uint32_t b ) noexcept
+	{
+		return ( uint64_t( a ) << 32u ) | b;
+	}
+}
+
+std::vector<uint32_t> MeshSimplifier::Simplify( const std::vector<uint32_t>& indices, StridedView<const dx::XMFLOAT3> positions,
+	size_t targetIndexCount, float targetError, float* pError )
+{
+	const size_t vertexCount = positions.size();
+	std::vector<uint32_t> result = indices;
+	if( pError )
+	{
+		*pError = 0.f;
+	}
+	if( result.size() <= targetIndexCount || vertexCount == 0u )
+	{
+		return result;
+	}
+
+	// vertices that share a position are seams of normals or texture coordinates,
+	// positions are compared by their bits, as JoinIdenticalVertices left them exact
+	std::vector<uint32_t> wedge( vertexCount );
+	std::vector<bool> locked( vertexCount, false );
+	{
+		struct PositionHash
+		{
+			size_t operator()( const dx::XMFLOAT3& p ) const noexcept
+			{
+				uint32_t bits[3];
+				std::memcpy( bits, &p, sizeof( bits ) );
+				return ( bits[0] * 73856093u ) ^ ( bits[1] * 19349663u ) ^ ( bits[2] * 83492791u );
+			}
+		};
+		struct PositionEqual
+		{
+			bool operator()( const dx::XMFLOAT3& lhs, const dx::XMFLOAT3& rhs ) const noexcept
+			{
+				return std::memcmp( &lhs, &rhs, sizeof( dx::XMFLOAT3 ) ) == 0;
+			}
+		};
+		std::unordered_map<dx::XMFLOAT3, uint32_t, PositionHash, PositionEqual> firstAt;
+		firstAt.reserve( vertexCount );
+		for( uint32_t v = 0; v < vertexCount; v++ )
+		{
+			const auto [it, inserted] = firstAt.emplace( positions[v], v );
+			wedge[v] = it->second;
+			if( !inserted )
+			{
+				locked[v] = true;
+				locked[it->second] = true;
+			}
+		}
+	}
+
+	// edges of a single triangle are open borders, their vertices are locked as well
+	{
+		std::unordered_set<uint64_t> edges;
+		edges.reserve( result.size() );
+		for( size_t i = 0; i < result.size(); i += 3u )
+		{
+			for( size_t k = 0; k < 3u; k++ )
+			{
+				edges.insert( edge_key( wedge[result[i + k]], wedge[result[i + ( k + 1u ) % 3u]] ) );
+			}
+		}
+		for( size_t i = 0; i < result.size(); i += 3u )
+		{
+			for( size_t k = 0; k < 3u; k++ )
+			{
+				const auto a = result[i + k];
+				const auto b = result[i + ( k + 1u ) % 3u];
+				if( edges.count( edge_key( wedge[b], wedge[a] ) ) == 0u )
+				{
+					locked[a] = true;
+					locked[b] = true;
+				}
+			}
+		}
+	}
+
+	// quadrics and the radius that the error is relative to
+	std::vector<Quadric> quadrics( vertexCount );
+	auto minPos = dx::XMVectorReplicate( FLT_MAX );
+	auto maxPos = dx::XMVectorReplicate( -FLT_MAX );
+	for( size_t i = 0; i < result.size(); i += 3u )
+	{
+		const auto p0 = dx::XMLoadFloat3( &positions[result[i]] );
+		const auto p1 = dx::XMLoadFloat3( &positions[result[i + 1u]] );
+		const auto p2 = dx::XMLoadFloat3( &positions[result[i + 2u]] );
+		minPos = dx::XMVectorMin( minPos, dx::XMVectorMin( p0, dx::XMVectorMin( p1, p2 ) ) );
+		maxPos = dx::XMVectorMax( maxPos, dx::XMVectorMax( p0, dx::XMVectorMax( p1, p2 ) ) );
+		const auto n = dx::XMVector3Cross( dx::XMVectorSubtract( p1, p0 ), dx::XMVectorSubtract( p2, p0 ) );
+		const float length = dx::XMVectorGetX( dx::XMVector3Length( n ) );
+		if( length <= 0.f )
+		{
+			continue;
+		}
+		dx::XMFLOAT3 normal;
+		dx::XMStoreFloat3( &normal, dx::XMVectorScale( n, 1.f / length ) );
+		const float d = -dx::XMVectorGetX( dx::XMVector3Dot( dx::XMLoadFloat3( &normal ), p0 ) );
+		const auto q = Quadric::FromPlane( normal.x, normal.y, normal.z, d, length * 0.5f );
+		for( size_t k = 0; k < 3u; k++ )
+		{
+			quadrics[result[i + k]] += q;
+		}
+	}
+	const float radius = dx::XMVectorGetX( dx::XMVector3Length( dx::XMVectorSubtract( maxPos, minPos ) ) ) * 0.5f;
+	const double errorLimit = double( targetError ) * radius * double( targetError ) * radius;
+
+	std::vector<uint32_t> offsets( vertexCount + 1u );
+	std::vector<uint32_t> adjacency;
+	std::vector<Collapse> collapses;
+	std::vector<uint32_t> remap( vertexCount );
+	std::vector<bool> touched( vertexCount );
+	double maxError = 0.0;
+
+	// the triangle around the moved vertex must not turn over or degenerate
+	const auto flips = [&]( uint32_t from, uint32_t to )
+	{
+		const auto target = dx::XMLoadFloat3( &positions[to] );
+		for( auto a = offsets[from]; a < offsets[from + 1u]; a++ )
+		{
+			const auto t = adjacency[a] * 3u;
+			const uint32_t tri[3] = { result[t], result[t + 1u], result[t + 2u] };
+			if( tri[0] == to || tri[1] == to || tri[2] == to )
+			{
+				continue;
+			}
+			dx::XMVECTOR before[3];
+			dx::XMVECTOR after[3];
+			for( size_t k = 0; k < 3u; k++ )
+			{
+				before[k] = dx::XMLoadFloat3( &positions[tri[k]] );
+				after[k] = tri[k] == from ? target : before[k];
+			}
+			const auto n0 = dx::XMVector3Cross( dx::XMVectorSubtract( before[1], before[0] ), dx::XMVectorSubtract( before[2], before[0] ) );
+			const auto n1 = dx::XMVector3Cross( dx::XMVectorSubtract( after[1], after[0] ), dx::XMVectorSubtract( after[2], after[0] ) );
+			// normal may turn by up to 45 degrees, the product of the lengths keeps the test scale free
+			const float dot = dx::XMVectorGetX( dx::XMVector3Dot( n0, n1 ) );
+			const float lengths = dx::XMVectorGetX( dx::XMVector3Length( n0 ) ) * dx::XMVectorGetX( dx::XMVector3Length( n1 ) );
+			if( dot <= 0.7071f * lengths )
+			{
+				return true;
+			}
+		}
+		return false;
+	};
+
+	while( result.size() > targetIndexCount )
+	{
+		// triangles of all vertices in one array, those of vertex v start at offsets[v]
+		std::fill( offsets.begin(), offsets.end(), 0u );
+		for( const auto v : result )
+		{
+			offsets[v + 1u]++;
+		}
+		for( size_t v = 0; v < vertexCount; v++ )
+		{
+			offsets[v + 1u] += offsets[v];
+		}
+		adjacency.resize( result.size() );
+		{
+			std::vector<uint32_t> cursors( offsets.begin(), offsets.end() - 1 );
+			for( size_t i = 0; i < result.size(); i++ )
+			{
+				adjacency[cursors[result[i]]++] = uint32_t( i / 3u );
+			}
+		}
+
+		// every directed edge out of a free vertex is a candidate, the cheapest ones are applied first
+		collapses.clear();
+		for( size_t i = 0; i < result.size(); i += 3u )
+		{
+			for( size_t k = 0; k < 3u; k++ )
+			{
+				const auto from = result[i + k];
+				const auto to = result[i + ( k + 1u ) % 3u];
+				if( locked[from] )
+				{
+					continue;
+				}
+				Quadric q = quadrics[from];
+				q += quadrics[to];
+				const double error = q.Evaluate( positions[to] );
+				if( error <= errorLimit )
+				{
+					collapses.push_back( { from, to, error } );
+				}
+			}
+		}
+		std::sort( collapses.begin(), collapses.end(), []( const Collapse& lhs, const Collapse& rhs ) { return lhs.error < rhs.error; } );
+
+		// collapses of a pass don't share triangles, so each of them is checked against the current mesh
+		for( uint32_t v = 0; v < vertexCount; v++ )
+		{
+			remap[v] = v;
+		}
+		std::fill( touched.begin(), touched.end(), false );
+		const size_t removeTarget = ( result.size() - targetIndexCount ) / 3u;
+		size_t removed = 0u;
+		for( const auto& c : collapses )
+		{
+			if( touched[c.from] || touched[c.to] || flips( c.from, c.to ) )
+			{
+				continue;
+			}
+			remap[c.from] = c.to;
+			quadrics[c.to] += quadrics[c.from];
+			maxError = std::max( maxError, c.error );
+			for( auto a = offsets[c.from]; a < offsets[c.from + 1u]; a++ )
+			{
+				const auto t = adjacency[a] * 3u;
+				const bool shared = result[t] == c.to || result[t + 1u] == c.to || result[t + 2u] == c.to;
+				removed += shared ? 1u : 0u;
+				touched[result[t]] = true;
+				touched[result[t + 1u]] = true;
+				touched[result[t + 2u]] = true;
+			}
+			if( removed >= removeTarget )
+			{
+				break;
+			}
+		}
+		if( removed == 0u )
+		{
+			break;
+		}
+
+		size_t write = 0u;
+		for( size_t i = 0; i < result.size(); i += 3u )
+		{
+			const auto a = remap[result[i]];
+			const auto b = remap[result[i + 1u]];
+			const auto c = remap[result[i + 2u]];
+			if( a != b && b != c && c != a )
+			{
+				result[write++] = a;
+				result[write++] = b;
+				result[write++] = c;
+			}
+		}
+		result.resize( write );
+	}
+
+	if( pError && radius > 0.f )
+	{
+		*pError = float( std::sqrt( maxError ) / radius );
+	}
+	return result;
+}
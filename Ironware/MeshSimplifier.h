@@ -0,0 +1,36 @@
+/*!
+ * \file MeshSimplifier.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Header file that contains MeshSimplifier, quadric error metric edge collapse
+ *
+ * \note Collapses move a vertex onto one of its neighbors (Garland and Heckbert 1997 with
+ * * endpoint placement), so a simplified index list addresses the vertices of the original
+ * * mesh and can share its vertex buffer. Vertices on open borders and on seams, where
+ * * several vertices share a position, are locked to keep the mesh watertight and textured.
+*/
+#pragma once
+
+#include "StridedView.h"
+
+#include <DirectXMath.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class MeshSimplifier
+{
+public:
+	/**
+	 * @brief Collapses edges in the order of their error until the index count is reached
+	 * @param targetIndexCount count of indices to stop at, the result may stay above it
+	 * @param targetError largest error of a collapse relative to the radius of the mesh bounds
+	 * @param pError if given, receives the largest error of the applied collapses relative to the radius
+	 * @return indices of the simplified triangles
+	*/
+	static std::vector<uint32_t> Simplify( const std::vector<uint32_t>& indices, StridedView<const DirectX::XMFLOAT3> positions,
+		size_t targetIndexCount, float targetError, float* pError = nullptr );
+};
@@ -0,0 +1,274 @@
+/*!
+ * \file MeshletSet.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ *
+ */
+#include "MeshletSet.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace dx = DirectX;
+
+namespace
+{
+	constexpr uint32_t NO_TRIANGLE = ~0u;
+	constexpr uint32_t NO_MESHLET = ~0u;
+	// normals that spread wider than about 84 degrees from the axis leave no cone worth testing
+	constexpr float MIN_CONE_DOT = 0.1f;
+
+	/**
+	 * @brief Sphere around the box of the vertices and cone around the area weighted normal
+	*/
+	void compute_bounds( MeshletSet::Meshlet& m, const std::vector<uint32_t>& indices, StridedView<const dx::XMFLOAT3> positions ) noexcept
+	{
+		auto minPos = dx::XMVectorReplicate( FLT_MAX );
+		auto maxPos = dx::XMVectorReplicate( -FLT_MAX );
+		auto axis = dx::XMVectorZero();
+		for( size_t i = m.startIndex; i < m.startIndex + m.indexCount; i += 3u )
+		{
+			const auto p0 = dx::XMLoadFloat3( &positions[indices[i]] );
+			const auto p1 = dx::XMLoadFloat3( &positions[indices[i + 1u]] );
+			const auto p2 = dx::XMLoadFloat3( &positions[indices[i + 2u]] );
+			minPos = dx::XMVectorMin( minPos, dx::XMVectorMin( p0, dx::XMVectorMin( p1, p2 ) ) );
+			maxPos = dx::XMVectorMax( maxPos, dx::XMVectorMax( p0, dx::XMVectorMax( p1, p2 ) ) );
+			axis = dx::XMVectorAdd( axis, dx::XMVector3Cross( dx::XMVectorSubtract( p1, p0 ), dx::XMVectorSubtract( p2, p0 ) ) );
+		}
+		const auto center = dx::XMVectorScale( dx::XMVectorAdd( minPos, maxPos ), 0.5f );
+		float radius = 0.f;
+		for( size_t i = m.startIndex; i < m.startIndex + m.indexCount; i++ )
+		{
+			const auto p = dx::XMLoadFloat3( &positions[indices[i]] );
+			radius = std::max( radius, dx::XMVectorGetX( dx::XMVector3Length( dx::XMVectorSubtract( p, center ) ) ) );
+		}
+		dx::XMStoreFloat3( &m.center, center );
+		m.radius = radius;
+
+		m.coneAxis = { 0.f, 0.f, 0.f };
+		m.coneCutoff = 1.f;
+		if( dx::XMVectorGetX( dx::XMVector3LengthSq( axis ) ) <= 0.f )
+		{
+			return;
+		}
+		axis = dx::XMVector3Normalize( axis );
+		float minDot = 1.f;
+		for( size_t i = m.startIndex; i < m.startIndex + m.indexCount; i += 3u )
+		{
+			const auto p0 = dx::XMLoadFloat3( &positions[indices[i]] );
+			const auto p1 = dx::XMLoadFloat3( &positions[indices[i + 1u]] );
+			const auto p2 = dx::XMLoadFloat3( &positions[indices[i + 2u]] );
+			const auto n = dx::XMVector3Cross( dx::XMVectorSubtract( p1, p0 ), dx::XMVectorSubtract( p2, p0 ) );
+			if( dx::XMVectorGetX( dx::XMVector3LengthSq( n ) ) <= 0.f )
+			{
+				continue;
+			}
+			minDot = std::min( minDot, dx::XMVectorGetX( dx::XMVector3Dot( dx::XMVector3Normalize( n ), axis ) ) );
+		}
+		dx::XMStoreFloat3( &m.coneAxis, axis );
+		if( minDot > MIN_CONE_DOT )
+		{
+			// all normals are within acos( minDot ) of the axis, the view direction has to be
+			// more than that away from the plane of the triangles
+			m.coneCutoff = std::sqrt( 1.f - minDot * minDot );
+		}
+	}
+}
+
+MeshletSet::MeshletSet( std::vector<Meshlet> meshlets_in ) :
+	meshlets( std::move( meshlets_in ) ),
+	blocks( ( meshlets.size() + BLOCK_SIZE - 1u ) / BLOCK_SIZE )
+{
+	for( auto& b : blocks )
+	{
+		// lanes past the size never pass the cone test
+		std::fill( std::begin( b.cutoff ), std::end( b.cutoff ), 1.f );
+	}
+	for( size_t i = 0; i < meshlets.size(); i++ )
+	{
+		const auto& m = meshlets[i];
+		auto& b = blocks[i / BLOCK_SIZE];
+		const size_t lane = i % BLOCK_SIZE;
+		b.centerX[lane] = m.center.x;
+		b.centerY[lane] = m.center.y;
+		b.centerZ[lane] = m.center.z;
+		b.radius[lane] = m.radius;
+		b.axisX[lane] = m.coneAxis.x;
+		b.axisY[lane] = m.coneAxis.y;
+		b.axisZ[lane] = m.coneAxis.z;
+		b.cutoff[lane] = m.coneCutoff;
+	}
+}
+
+std::vector<MeshletSet::Meshlet> MeshletSet::Build( std::vector<uint32_t>& indices, StridedView<const dx::XMFLOAT3> positions,
+	size_t maxVertices, size_t maxTriangles )
+{
+	const size_t vertexCount = positions.size();
+	const size_t triangleCount = indices.size() / 3u;
+	std::vector<Meshlet> meshlets;
+	if( triangleCount == 0u )
+	{
+		return meshlets;
+	}
+
+	// triangles of all vertices in one array, those of vertex v start at offsets[v]
+	std::vector<uint32_t> offsets( vertexCount + 1u, 0u );
+	for( const auto v : indices )
+	{
+		offsets[v + 1u]++;
+	}
+	for( size_t v = 0; v < vertexCount; v++ )
+	{
+		offsets[v + 1u] += offsets[v];
+	}
+	std::vector<uint32_t> adjacency( indices.size() );
+	{
+		std::vector<uint32_t> cursors( offsets.begin(), offsets.end() - 1 );
+		for( size_t i = 0; i < indices.size(); i++ )
+		{
+			adjacency[cursors[indices[i]]++] = uint32_t( i / 3u );
+		}
+	}
+
+	std::vector<bool> emitted( triangleCount, false );
+	// meshlet that the vertex was last added to
+	std::vector<uint32_t> owner( vertexCount, NO_MESHLET );
+	std::vector<uint32_t> result;
+	result.reserve( indices.size() );
+	std::vector<uint32_t> triangles;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> local;
+	std::vector<uint32_t> globals;
+	size_t vertices = 0u;
+	size_t seed = 0u;
+	auto centroid = dx::XMVectorZero();
+
+	const auto newVertices = [&]( uint32_t t, uint32_t id )
+	{
+		return size_t( owner[indices[t * 3u]] != id ) + size_t( owner[indices[t * 3u + 1u]] != id ) + size_t( owner[indices[t * 3u + 2u]] != id );
+	};
+	const auto triangleCenter = [&]( uint32_t t )
+	{
+		return dx::XMVectorScale( dx::XMVectorAdd( dx::XMVectorAdd(
+			dx::XMLoadFloat3( &positions[indices[t * 3u]] ),
+			dx::XMLoadFloat3( &positions[indices[t * 3u + 1u]] ) ),
+			dx::XMLoadFloat3( &positions[indices[t * 3u + 2u]] ) ), 1.f / 3.f );
+	};
+	const auto nextSeed = [&]()
+	{
+		while( seed < triangleCount && emitted[seed] )
+		{
+			seed++;
+		}
+		return seed < triangleCount ? uint32_t( seed ) : NO_TRIANGLE;
+	};
+
+	for( auto first = nextSeed(); first != NO_TRIANGLE; first = nextSeed() )
+	{
+		const auto id = uint32_t( meshlets.size() );
+		triangles.clear();
+		candidates.clear();
+		vertices = 0u;
+		auto sum = dx::XMVectorZero();
+		const auto add = [&]( uint32_t t )
+		{
+			emitted[t] = true;
+			triangles.push_back( t );
+			for( size_t k = 0; k < 3u; k++ )
+			{
+				const auto v = indices[t * 3u + k];
+				if( owner[v] == id )
+				{
+					continue;
+				}
+				owner[v] = id;
+				vertices++;
+				sum = dx::XMVectorAdd( sum, dx::XMLoadFloat3( &positions[v] ) );
+				for( auto a = offsets[v]; a < offsets[v + 1u]; a++ )
+				{
+					if( !emitted[adjacency[a]] )
+					{
+						candidates.push_back( adjacency[a] );
+					}
+				}
+			}
+			centroid = dx::XMVectorScale( sum, 1.f / float( vertices ) );
+		};
+
+		add( first );
+		while( triangles.size() < maxTriangles )
+		{
+			// neighbor that adds the fewest vertices, the one closest to the centroid among those
+			uint32_t best = NO_TRIANGLE;
+			size_t bestNew = 4u;
+			float bestDistance = FLT_MAX;
+			size_t write = 0u;
+			for( const auto t : candidates )
+			{
+				if( emitted[t] )
+				{
+					continue;
+				}
+				candidates[write++] = t;
+				const size_t added = newVertices( t, id );
+				if( vertices + added > maxVertices || added > bestNew )
+				{
+					continue;
+				}
+				const float distance = dx::XMVectorGetX( dx::XMVector3LengthSq( dx::XMVectorSubtract( triangleCenter( t ), centroid ) ) );
+				if( added < bestNew || distance < bestDistance )
+				{
+					best = t;
+					bestNew = added;
+					bestDistance = distance;
+				}
+			}
+			candidates.resize( write );
+			// disconnected pieces, like the leaves of a plant, are packed together in the input order
+			if( best == NO_TRIANGLE && vertices + 3u <= maxVertices )
+			{
+				best = nextSeed();
+			}
+			if( best == NO_TRIANGLE )
+			{
+				break;
+			}
+			add( best );
+		}
+
+		// growth order isn't cache friendly, the triangles are reordered on the few local vertices of the meshlet
+		local.clear();
+		globals.clear();
+		for( const auto t : triangles )
+		{
+			for( size_t k = 0; k < 3u; k++ )
+			{
+				const auto v = indices[t * 3u + k];
+				const auto found = std::find( globals.begin(), globals.end(), v );
+				local.push_back( uint32_t( found - globals.begin() ) );
+				if( found == globals.end() )
+				{
+					globals.push_back( v );
+				}
+			}
+		}
+		local = MeshOptimizer::OptimizeVertexCache( local, globals.size() );
+
+		Meshlet m = {};
+		m.startIndex = uint32_t( result.size() );
+		m.indexCount = uint32_t( local.size() );
+		for( const auto v : local )
+		{
+			result.push_back( globals[v] );
+		}
+		compute_bounds( m, result, positions );
+		meshlets.push_back( m );
+	}
+
+	indices = std::move( result );
+	return meshlets;
+}
@@ -0,0 +1,95 @@
+/*!
+ * \file MeshletSet.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Header file that contains MeshletSet, small clusters of a mesh that are culled one by one
+ *
+ * \note Every meshlet owns a contiguous range of the index buffer, so the visible ones are drawn
+ * * as a few merged ranges of the same buffer. Bounds are a sphere and a cone of the triangle
+ * * normals, both kept in the local space of the mesh and in blocks of 4 for SIMD tests.
+*/
+#pragma once
+
+#include "StridedView.h"
+
+#include <DirectXMath.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class MeshletSet
+{
+public:
+	static constexpr size_t BLOCK_SIZE = 4u;
+	// limits of a meshlet, 124 triangles keep the index range a multiple of 4
+	static constexpr size_t MAX_VERTICES = 64u;
+	static constexpr size_t MAX_TRIANGLES = 124u;
+
+	/**
+	 * @brief Index range and bounds of a meshlet, as built and as stored in cooked files
+	 * @note Meshlet faces away from the eye if dot( center - eye, coneAxis ) >= coneCutoff * |center - eye| + radius,
+	 * * coneCutoff is 1 for meshlets whose normals spread too much to ever pass
+	*/
+	struct Meshlet
+	{
+		uint32_t startIndex;
+		uint32_t indexCount;
+		DirectX::XMFLOAT3 center;
+		float radius;
+		DirectX::XMFLOAT3 coneAxis;
+		float coneCutoff;
+	};
+
+	struct alignas( 16 ) Block
+	{
+		float centerX[BLOCK_SIZE];
+		float centerY[BLOCK_SIZE];
+		float centerZ[BLOCK_SIZE];
+		float radius[BLOCK_SIZE];
+		float axisX[BLOCK_SIZE];
+		float axisY[BLOCK_SIZE];
+		float axisZ[BLOCK_SIZE];
+		float cutoff[BLOCK_SIZE];
+	};
+
+	struct Range
+	{
+		uint32_t startIndex;
+		uint32_t indexCount;
+	};
+
+	/**
+	 * @brief Ranges of the visible meshlets of one submission
+	 * @note Ranges are kept in storage of the culling frustum, which lives until the frame is drawn,
+	 * * so submissions refer to it by offset while other threads append to it
+	*/
+	struct Visible
+	{
+		const std::vector<Range>* pStorage = nullptr;
+		uint32_t first = 0u;
+		uint32_t count = 0u;
+	};
+
+public:
+	MeshletSet() = default;
+	explicit MeshletSet( std::vector<Meshlet> meshlets_in );
+	/**
+	 * @brief Groups triangles into meshlets and reorders the indices so every meshlet is contiguous
+	 * @note Meshlets grow from the first free triangle of the input order over the neighbors that add the
+	 * * fewest vertices, so the cache and overdraw orders of the input are mostly kept
+	*/
+	static std::vector<Meshlet> Build( std::vector<uint32_t>& indices, StridedView<const DirectX::XMFLOAT3> positions,
+		size_t maxVertices = MAX_VERTICES, size_t maxTriangles = MAX_TRIANGLES );
+	const std::vector<Meshlet>& GetMeshlets() const noexcept { return meshlets; }
+	const Block& GetBlock( size_t b ) const noexcept { return blocks[b]; }
+	size_t GetBlockCount() const noexcept { return blocks.size(); }
+	size_t GetSize() const noexcept { return meshlets.size(); }
+	bool IsEmpty() const noexcept { return meshlets.empty(); }
+
+private:
+	std::vector<Meshlet> meshlets;
+	std::vector<Block> blocks;
+};
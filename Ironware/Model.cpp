@@ -21,18 +21,84 @@
 #include <unordered_map>
 #include <sstream>
 #include <filesystem>
+#include <algorithm>
 #include "Node.h"
 #include "ModelException.h"
 #include "Mesh.h"
 #include "Material.h"
+#include "Frustum.h"
+#include "CookedModel.h"
+#include "StaticBatcher.h"
 
 namespace dx = DirectX;
 
-Model::Model( Graphics& gfx, std::wstring path, float scale, DirectX::XMFLOAT3 startingPos ) :
+namespace
+{
+	/**
+	 * @brief Creates the meshes that kept some of their references with makeMesh, followed by the batches
+	*/
+	template<typename F>
+	void make_batched_meshes( Graphics& gfx, const StaticBatcher::Result& batched, const std::vector<Material>& materials,
+		std::vector<std::unique_ptr<Mesh>>& meshPtrs, F&& makeMesh ) noexcept( !IS_DEBUG )
+	{
+		meshPtrs.reserve( batched.keptMeshCount + batched.batches.size() );
+		for( size_t i = 0; i < batched.meshRemap.size(); i++ )
+		{
+			if( batched.meshRemap[i] != StaticBatcher::NO_MESH )
+			{
+				meshPtrs.push_back( makeMesh( i ) );
+			}
+		}
+		for( const auto& b : batched.batches )
+		{
+			meshPtrs.push_back( std::make_unique<Mesh>( gfx, materials[b.materialIndex], b.data ) );
+		}
+	}
+}
+
+Model::Model( Graphics& gfx, std::wstring path, float scale, DirectX::XMFLOAT3 startingPos, bool staticBatching ) :
 	scale( scale ),
 	path( path )
 {
+	// cooked file replaces the import and the vertex extraction
+	if( const auto pCooked = CookedModel::Open( path, scale ) )
+	{
+		std::vector<Material> materials;
+		materials.reserve( pCooked->GetMaterialCount() );
+		for( size_t i = 0; i < pCooked->GetMaterialCount(); i++ )
+		{
+			materials.emplace_back( pCooked->GetMaterialDesc( i ), path );
+			materials.back().Create( gfx );
+		}
+
+		const auto materialOf = [&]( size_t i ) -> const Material& { return materials[pCooked->GetMesh( i ).materialIndex]; };
+		if( staticBatching )
+		{
+			std::vector<StaticBatcher::Source> sources;
+			sources.reserve( pCooked->GetMeshCount() );
+			for( size_t i = 0; i < pCooked->GetMeshCount(); i++ )
+			{
+				sources.push_back( StaticBatcher::MakeSource( *pCooked, i, materialOf( i ).GetVertexLayout() ) );
+			}
+			const auto batched = StaticBatcher::Build( sources, pCooked->GetNodes(), scale, path );
+			make_batched_meshes( gfx, batched, materials, meshPtrs, [&]( size_t i ) { return pCooked->MakeMesh( gfx, i, materialOf( i ) ); } );
+			batchStats = batched.stats;
+			ParseRoot( batched.nodes, startingPos );
+			return;
+		}
+
+		meshPtrs.reserve( pCooked->GetMeshCount() );
+		for( size_t i = 0; i < pCooked->GetMeshCount(); i++ )
+		{
+			meshPtrs.push_back( pCooked->MakeMesh( gfx, i, materialOf( i ) ) );
+		}
+
+		ParseRoot( pCooked->GetNodes(), startingPos );
+		return;
+	}
+
 	Assimp::Importer importer;
+	const auto& io = CookedModel::RecordDependencies( importer );
 	auto pScene = importer.ReadFile(
 		to_narrow( path ),
 		aiProcess_Triangulate |
@@ -55,21 +121,93 @@ Model::Model( Graphics& gfx, std::wstring path, float scale, DirectX::XMFLOAT3 s
 		materials.emplace_back( gfx, *pScene->mMaterials[i], path );
 	}
 
-	meshPtrs.reserve( pScene->mNumMeshes );
+	// extracted data is kept until the cooked file is written
+	std::vector<Mesh::Data> meshData;
+	std::vector<CookedModel::MeshSource> cookSources;
+	meshData.reserve( pScene->mNumMeshes );
 	for( size_t i = 0; i < pScene->mNumMeshes; i++ )
 	{
 		const auto& mesh = *pScene->mMeshes[i];
-		meshPtrs.push_back( std::make_unique<Mesh>( gfx, materials[mesh.mMaterialIndex], mesh, scale ) );
+		meshData.push_back( Mesh::Extract( materials[mesh.mMaterialIndex], mesh, scale ) );
+	}
+	for( size_t i = 0; i < meshData.size(); i++ )
+	{
+		cookSources.push_back( { &meshData[i], pScene->mMeshes[i]->mMaterialIndex } );
 	}
 
-	pRoot = ParseNode( *pScene->mRootNode, scale );
-	pRoot->SetAppliedTransform( DirectX::XMMatrixTranslationFromVector( DirectX::XMLoadFloat3( &startingPos ) ) );
+	std::vector<Material::Desc> descs;
+	for( const auto& m : materials )
+	{
+		descs.push_back( m.GetDesc() );
+	}
+	const auto nodes = FlattenNodes( *pScene->mRootNode );
+	// failing to write the cache only costs the next load another import
+	CookedModel::Write( path, scale, io.GetOpenedFiles(), descs, cookSources, nodes );
+
+	const auto materialOf = [&]( size_t i ) -> const Material& { return materials[pScene->mMeshes[i]->mMaterialIndex]; };
+	if( staticBatching )
+	{
+		std::vector<StaticBatcher::Source> sources;
+		sources.reserve( meshData.size() );
+		for( size_t i = 0; i < meshData.size(); i++ )
+		{
+			sources.push_back( StaticBatcher::MakeSource( meshData[i], materialOf( i ).GetVertexLayout(), pScene->mMeshes[i]->mMaterialIndex ) );
+		}
+		const auto batched = StaticBatcher::Build( sources, nodes, scale, path );
+		make_batched_meshes( gfx, batched, materials, meshPtrs, [&]( size_t i ) { return std::make_unique<Mesh>( gfx, materialOf( i ), meshData[i] ); } );
+		batchStats = batched.stats;
+		ParseRoot( batched.nodes, startingPos );
+		return;
+	}
+
+	meshPtrs.reserve( meshData.size() );
+	for( size_t i = 0; i < meshData.size(); i++ )
+	{
+		meshPtrs.push_back( std::make_unique<Mesh>( gfx, materialOf( i ), meshData[i] ) );
+	}
+
+	ParseRoot( nodes, startingPos );
+}
+
+Model::Model( std::vector<std::unique_ptr<Mesh>> meshPtrs, const std::vector<NodeDesc>& nodes, std::wstring path, float scale, DirectX::XMFLOAT3 startingPos ) IFNOEXCEPT :
+	meshPtrs( std::move( meshPtrs ) ),
+	path( std::move( path ) ),
+	scale( scale )
+{
+	ParseRoot( nodes, startingPos );
 }
 
-void Model::Submit( size_t channelFilter ) const IFNOEXCEPT
+void Model::UpdateTransforms() noexcept
+{
+	transforms.Update();
+	for( size_t i = 0; i < instanceMeshes.size(); i++ )
+	{
+		const auto slot = instanceSlots[i];
+		if( transforms.WasUpdated( slot ) )
+		{
+			const auto pMesh = instanceMeshes[i];
+			instanceBounds.SetTransformed( i, pMesh->GetBoundsCenter(), pMesh->GetBoundsExtents(), transforms.GetWorldXM( slot ) );
+		}
+	}
+}
+
+void Model::Submit( size_t channelFilter, const Frustum& frustum ) const IFNOEXCEPT
 {
 	/*pModelWindow->ApplyParameters();*/
-	pRoot->Submit( channelFilter, dx::XMMatrixIdentity() );
+	SubmitRange( channelFilter, frustum, 0u, instanceMeshes.size() );
+}
+
+void Model::Submit( size_t channelFilter, const Frustum& frustum, TaskScheduler& scheduler, TaskScheduler::Group& group ) const IFNOEXCEPT
+{
+	static_assert( PARALLEL_CHUNK_SIZE % BoundingBoxSet::BLOCK_SIZE == 0u, "Chunks must not split bounding box blocks" );
+	for( size_t begin = 0; begin < instanceMeshes.size(); begin += PARALLEL_CHUNK_SIZE )
+	{
+		const size_t end = std::min( begin + PARALLEL_CHUNK_SIZE, instanceMeshes.size() );
+		scheduler.Run( group, [this, channelFilter, &frustum, begin, end]
+		{
+			SubmitRange( channelFilter, frustum, begin, end );
+		} );
+	}
 }
 
 void Model::SetRootTransform( DirectX::FXMMATRIX tf ) noexcept
@@ -92,24 +230,99 @@ void Model::LinkTechniques( RenderGraph & rg )
 
 Model::~Model() noexcept = default;
 
-std::unique_ptr<Node> Model::ParseNode( const aiNode & node, float scale ) IFNOEXCEPT
+std::vector<Model::NodeDesc> Model::FlattenNodes( const aiNode& root )
 {
-	const auto parentTransform = scale_translation( dx::XMMatrixTranspose( dx::XMLoadFloat4x4( reinterpret_cast<const dx::XMFLOAT4X4*>( &node.mTransformation ) ) ), scale );
-
-	std::vector<Mesh*> curMeshPtrs;
-	curMeshPtrs.reserve( (size_t)node.mNumMeshes );
-	for( uint32_t i = 0; i < node.mNumMeshes; i++ )
+	std::vector<const aiNode*> sources{ &root };
+	std::vector<NodeDesc> nodes;
+	nodes.push_back( { {}, TransformHierarchy::NO_PARENT } );
+	for( size_t i = 0; i < sources.size(); i++ )
 	{
-		const auto meshIdx = node.mMeshes[i];
-		curMeshPtrs.push_back( meshPtrs.at( meshIdx ).get() );
+		const auto& node = *sources[i];
+		// children are appended only after the node is filled, which invalidates the reference
+		auto& desc = nodes[i];
+		desc.name = node.mName.C_Str();
+		dx::XMStoreFloat4x4( &desc.transform, dx::XMMatrixTranspose( dx::XMLoadFloat4x4( reinterpret_cast<const dx::XMFLOAT4X4*>( &node.mTransformation ) ) ) );
+		desc.meshes.assign( node.mMeshes, node.mMeshes + node.mNumMeshes );
+		for( uint32_t j = 0; j < node.mNumChildren; j++ )
+		{
+			sources.push_back( node.mChildren[j] );
+			nodes.push_back( { {}, (uint32_t)i } );
+		}
 	}
+	return nodes;
+}
+
+void Model::ParseRoot( const std::vector<NodeDesc>& nodes, DirectX::XMFLOAT3 startingPos ) IFNOEXCEPT
+{
+	pRoot = ParseNodes( nodes, scale );
+	pRoot->SetAppliedTransform( DirectX::XMMatrixTranslationFromVector( DirectX::XMLoadFloat3( &startingPos ) ) );
+}
 
-	auto pNode = std::make_unique<Node>( std::move( curMeshPtrs ), node.mName.C_Str(), (uint32_t)nodeNum++, parentTransform );
+std::unique_ptr<Node> Model::ParseNodes( const std::vector<NodeDesc>& nodes, float scale ) IFNOEXCEPT
+{
+	std::unique_ptr<Node> pRootNode;
+	for( const auto& node : nodes )
+	{
+		const auto localTransform = scale_translation( dx::XMLoadFloat4x4( &node.transform ), scale );
 
-	for( uint32_t i = 0; i < node.mNumChildren; i++ )
+		std::vector<Mesh*> curMeshPtrs;
+		curMeshPtrs.reserve( node.meshes.size() );
+		for( const auto meshIdx : node.meshes )
+		{
+			curMeshPtrs.push_back( meshPtrs.at( meshIdx ).get() );
+		}
+
+		// parents precede their children, so the parent node already exists
+		Node* const pParent = node.parent != TransformHierarchy::NO_PARENT ? nodePtrs.at( node.parent ) : nullptr;
+		const auto slot = transforms.Add( pParent ? pParent->GetID() : TransformHierarchy::NO_PARENT, localTransform );
+		auto pNode = std::make_unique<Node>( std::move( curMeshPtrs ), node.name, slot, transforms );
+		nodePtrs.push_back( pNode.get() );
+
+		if( pParent )
+		{
+			pParent->AddChild( std::move( pNode ) );
+		}
+		else
+		{
+			pRootNode = std::move( pNode );
+		}
+	}
+
+	// meshes read their transform from the slot of the node, while culling works on the flat instance list
+	for( const auto pNode : nodePtrs )
 	{
-		pNode->AddChild( ParseNode( *node.mChildren[i], scale ) );
+		for( const auto pMesh : pNode->meshPtrs )
+		{
+			pMesh->SetTransformSource( transforms, pNode->GetID() );
+			instanceMeshes.push_back( pMesh );
+			instanceSlots.push_back( pNode->GetID() );
+		}
 	}
+	instanceBounds.Resize( instanceMeshes.size() );
+
+	return pRootNode;
+}
 
-	return pNode;
+void Model::SubmitRange( size_t channelFilter, const Frustum& frustum, size_t begin, size_t end ) const IFNOEXCEPT
+{
+	assert( begin % BoundingBoxSet::BLOCK_SIZE == 0u );
+	size_t visible = 0u;
+	for( size_t b = begin; b < end; b += BoundingBoxSet::BLOCK_SIZE )
+	{
+		const auto& block = instanceBounds.GetBlock( b / BoundingBoxSet::BLOCK_SIZE );
+		const auto mask = frustum.Test( block );
+		const size_t count = std::min( BoundingBoxSet::BLOCK_SIZE, end - b );
+		for( size_t lane = 0; lane < count; lane++ )
+		{
+			if( mask & ( 1u << lane ) )
+			{
+				const auto& mesh = *instanceMeshes[b + lane];
+				const dx::XMFLOAT3 center = { block.centerX[lane], block.centerY[lane], block.centerZ[lane] };
+				const dx::XMFLOAT3 extents = { block.extentX[lane], block.extentY[lane], block.extentZ[lane] };
+				mesh.Submit( channelFilter, frustum, center, extents );
+				visible++;
+			}
+		}
+	}
+	frustum.AddStats( visible, ( end - begin ) - visible );
 }
\ No newline at end of file
@@ -12,6 +12,9 @@
 #include "CommonMacros.h"
 #include "IronException.h"
 #include "DynamicConstantBuffer.h"
+#include "TaskScheduler.h"
+#include "TransformHierarchy.h"
+#include "BoundingBoxSet.h"
 
 #include <assimp/scene.h>
 #include <imgui/imgui.h>
@@ -19,10 +22,12 @@
 
 #include <optional>
 #include <type_traits>
+#include <vector>
 
 class Node;
 class Mesh;
 class RenderGraph;
+class Frustum;
 
 /**
  * @brief Responsible class for drawing a mesh from specified file
@@ -30,18 +35,93 @@ class RenderGraph;
 class Model
 {
 public:
-	Model( Graphics& gfx, std::wstring path, float scale = 1.f, DirectX::XMFLOAT3 startingPos = { 0.f, 0.f, 0.f } );
-	void Submit( size_t channelFilter ) const IFNOEXCEPT;
+	/**
+	 * @brief Node of the file hierarchy, nodes are listed breadth-first so parents precede their children
+	*/
+	struct NodeDesc
+	{
+		std::string name;
+		uint32_t parent;
+		// local transform of the file, model scale is not applied yet
+		DirectX::XMFLOAT4X4 transform;
+		std::vector<uint32_t> meshes;
+	};
+
+	/**
+	 * @brief Result of merging the static mesh references at load, see StaticBatcher
+	*/
+	struct BatchStats
+	{
+		// mesh references of the file and the ones that were merged into batches
+		size_t instanceCount = 0u;
+		size_t batchedInstanceCount = 0u;
+		size_t batchCount = 0u;
+		float buildTime = 0.f;
+	};
+
+public:
+	/**
+	 * @param staticBatching merges references of meshes that share a material into batches, nodes whose
+	 * * references were merged don't move them anymore, only the root transform does
+	*/
+	Model( Graphics& gfx, std::wstring path, float scale = 1.f, DirectX::XMFLOAT3 startingPos = { 0.f, 0.f, 0.f }, bool staticBatching = false );
+	/**
+	 * @brief Recomputes world matrices and world bounds of the nodes that were moved since the last call
+	 * @note Has to be called once per frame before the model is submitted
+	*/
+	void UpdateTransforms() noexcept;
+	/**
+	 * @brief Submits the meshes whose world bounds intersect the frustum
+	*/
+	void Submit( size_t channelFilter, const Frustum& frustum ) const IFNOEXCEPT;
+	/**
+	 * @brief Queues culling and submission of the meshes to the scheduler in chunks
+	 * @note Caller has to wait for the group before the render graph is executed,
+	 * frustum has to outlive the group
+	*/
+	void Submit( size_t channelFilter, const Frustum& frustum, TaskScheduler& scheduler, TaskScheduler::Group& group ) const IFNOEXCEPT;
 	void SetRootTransform( DirectX::FXMMATRIX tf ) noexcept;
 
 	void Accept( class ModelProbe& probe );
 	void LinkTechniques( RenderGraph& rg );
-	size_t GetNodeSize() const noexcept { return nodeNum; }
+	size_t GetNodeSize() const noexcept { return transforms.GetSize(); }
+	TransformHierarchy& GetTransforms() noexcept { return transforms; }
+	bool WereTransformsUpdated() const noexcept { return transforms.GetStats().updatedCount != 0u; }
+	Node& GetNode( uint32_t id ) noexcept { return *nodePtrs[id]; }
+	/**
+	 * @brief Mesh instances are the mesh references of all nodes, in hierarchy order
+	*/
+	size_t GetInstanceCount() const noexcept { return instanceMeshes.size(); }
+	const Mesh& GetInstanceMesh( size_t i ) const noexcept { return *instanceMeshes[i]; }
+	uint32_t GetInstanceNode( size_t i ) const noexcept { return instanceSlots[i]; }
+	void GetInstanceBounds( size_t i, DirectX::XMFLOAT3& center, DirectX::XMFLOAT3& extents ) const noexcept { instanceBounds.Get( i, center, extents ); }
+	/**
+	 * @return statistics of the static batching, zero if the model was loaded without it
+	*/
+	const BatchStats& GetBatchStats() const noexcept { return batchStats; }
 	~Model() noexcept;
+	/**
+	 * @brief Flattens the assimp node tree breadth-first, so it can outlive the scene
+	*/
+	static std::vector<NodeDesc> FlattenNodes( const aiNode& root );
 
 private:
+	friend class ModelLoader;
+	/**
+	 * @brief Assembles model from meshes whose resources were created by the loader
+	*/
+	Model( std::vector<std::unique_ptr<Mesh>> meshPtrs, const std::vector<NodeDesc>& nodes, std::wstring path, float scale, DirectX::XMFLOAT3 startingPos ) IFNOEXCEPT;
+	void ParseRoot( const std::vector<NodeDesc>& nodes, DirectX::XMFLOAT3 startingPos ) IFNOEXCEPT;
 	static std::unique_ptr<Mesh> ParseMesh( Graphics& gfx, const aiMesh& mesh, const aiMaterial* const* pMaterials ) IFNOEXCEPT;
-	std::unique_ptr<Node> ParseNode( const aiNode& node, float scale ) IFNOEXCEPT;
+	/**
+	 * @brief Builds node tree from the flattened nodes and adds them to the transform hierarchy in the same order
+	*/
+	std::unique_ptr<Node> ParseNodes( const std::vector<NodeDesc>& nodes, float scale ) IFNOEXCEPT;
+	void SubmitRange( size_t channelFilter, const Frustum& frustum, size_t begin, size_t end ) const IFNOEXCEPT;
+
+private:
+	// instances culled and submitted by a single task, multiple of the bounding box block size
+	static constexpr size_t PARALLEL_CHUNK_SIZE = 64u;
 
 private:
 	std::vector<std::unique_ptr<Mesh>> meshPtrs;
@@ -49,9 +129,17 @@ private:
 	// other nodes are used when the draw 
 	// has been called
 	std::unique_ptr<Node> pRoot;
+	// nodes indexed by their hierarchy slot
+	std::vector<Node*> nodePtrs;
+	// world matrices of the nodes, meshes read their transform from here
+	TransformHierarchy transforms;
+	// every mesh reference of every node, in hierarchy order
+	std::vector<const Mesh*> instanceMeshes;
+	std::vector<uint32_t> instanceSlots;
+	BoundingBoxSet instanceBounds;
 	std::wstring path;
 	float scale;
+	BatchStats batchStats;
 	// pImpl
 	/*std::unique_ptr<class ModelWindow> pModelWindow{ std::make_unique<ModelWindow>() };*/
-	size_t nodeNum;
 };
\ No newline at end of file
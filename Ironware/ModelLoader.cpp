@@ -0,0 +1,435 @@
+/*!
+ * \file ModelLoader.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ *
+ */
+#include "IronWin.h"
+#include "ModelLoader.h"
+#include "ModelException.h"
+#include "IronUtils.h"
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <objbase.h>
+
+#include <algorithm>
+
+using namespace std::chrono;
+
+ModelLoader::ModelLoader( TaskScheduler& scheduler, std::wstring path, float scale, DirectX::XMFLOAT3 startingPos, bool staticBatching ) :
+	scheduler( scheduler ),
+	path( std::move( path ) ),
+	scale( scale ),
+	startingPos( startingPos ),
+	staticBatching( staticBatching ),
+	loadStart( Clock::now() )
+{
+	scheduler.Run( group, [this] { Import(); } );
+}
+
+ModelLoader::~ModelLoader() noexcept
+{
+	// tasks reference the loader, so they have to finish before it goes away
+	try
+	{
+		scheduler.Wait( group );
+	}
+	catch( ... )
+	{
+	}
+}
+
+bool ModelLoader::IsCpuDone()
+{
+	if( !cpuDone )
+	{
+		// without workers nobody else would run the tasks
+		if( !group.IsDone() && scheduler.GetThreadCount() > 1u )
+		{
+			return false;
+		}
+		scheduler.Wait( group );
+		cpuDone = true;
+	}
+	return true;
+}
+
+void ModelLoader::WaitCpu()
+{
+	scheduler.Wait( group );
+	cpuDone = true;
+}
+
+bool ModelLoader::Poll( Graphics& gfx, float budget )
+{
+	if( ready )
+	{
+		return true;
+	}
+	if( !IsCpuDone() )
+	{
+		return false;
+	}
+
+	const auto start = Clock::now();
+	const auto overBudget = [this, start, budget]
+	{
+		return ElapsedSince( start ) >= budget;
+	};
+
+	if( surfaces.empty() )
+	{
+		for( size_t i = 0; i < texturePaths.size(); i++ )
+		{
+			surfaces.emplace( texturePaths[i], std::move( *decoded[i] ) );
+		}
+		decoded.clear();
+	}
+	// materials first, meshes copy their techniques
+	while( publishedMaterials < materials.size() )
+	{
+		materials[publishedMaterials++]->Create( gfx, &surfaces );
+		if( overBudget() )
+		{
+			publishTime += ElapsedSince( start );
+			return false;
+		}
+	}
+	while( publishedMeshes < meshMaterials.size() )
+	{
+		// meshes whose references were all merged are never created
+		if( !meshRemap.empty() && meshRemap[publishedMeshes] == StaticBatcher::NO_MESH )
+		{
+			if( !pCooked )
+			{
+				meshData[publishedMeshes].reset();
+			}
+			publishedMeshes++;
+			continue;
+		}
+		const auto& mat = *materials[meshMaterials[publishedMeshes]];
+		if( pCooked )
+		{
+			meshPtrs.push_back( pCooked->MakeMesh( gfx, publishedMeshes, mat ) );
+		}
+		else
+		{
+			meshPtrs.push_back( std::make_unique<Mesh>( gfx, mat, *meshData[publishedMeshes] ) );
+			meshData[publishedMeshes].reset();
+		}
+		publishedMeshes++;
+		if( overBudget() )
+		{
+			publishTime += ElapsedSince( start );
+			return false;
+		}
+	}
+
+	while( publishedBatches < batches.size() )
+	{
+		const auto& b = batches[publishedBatches++];
+		meshPtrs.push_back( std::make_unique<Mesh>( gfx, *materials[b.materialIndex], b.data ) );
+		if( overBudget() )
+		{
+			publishTime += ElapsedSince( start );
+			return false;
+		}
+	}
+
+	pModel.reset( new Model( std::move( meshPtrs ), nodes, path, scale, startingPos ) );
+	pModel->batchStats = batchStats;
+	ready = true;
+
+	// CPU side data is not needed anymore
+	surfaces.clear();
+	materials.clear();
+	meshData.clear();
+	meshMaterials.clear();
+	nodes.clear();
+	dependencies.clear();
+	batches.clear();
+	meshRemap.clear();
+	pCooked.reset();
+	pScene = nullptr;
+	pImporter.reset();
+
+	publishTime += ElapsedSince( start );
+	totalTime = ElapsedSince( loadStart );
+	return true;
+}
+
+ModelLoader::Stats ModelLoader::GetStats() const noexcept
+{
+	Stats stats;
+	stats.materialCount = materialCount;
+	stats.textureCount = textureCount;
+	stats.meshCount = meshCount;
+	stats.vertexBytes = vertexBytes;
+	stats.unpackedVertexBytes = unpackedVertexBytes;
+	stats.cooked = cooked;
+	// batches are built by the last CPU stage
+	if( cpuDone )
+	{
+		stats.batches = batchStats;
+	}
+	stats.importTime = importTime / 1000.f;
+	stats.materialTime = materialTime / 1000.f;
+	stats.decodeTime = decodeTime / 1000.f;
+	stats.extractTime = extractTime / 1000.f;
+	stats.optimizeTime = optimizeTime / 1000.f;
+	stats.simplifyTime = simplifyTime / 1000.f;
+	stats.triangleCount = triangleCount;
+	stats.coarsestTriangleCount = coarsestTriangleCount;
+	stats.lodCount = lodCount;
+	stats.meshletCount = meshletCount;
+	stats.meshletMeshCount = meshletMeshCount;
+	if( optimizedTriangles > 0u )
+	{
+		stats.acmrBefore = float( transformsBefore ) / float( optimizedTriangles );
+		stats.acmrAfter = float( transformsAfter ) / float( optimizedTriangles );
+		stats.atvrBefore = float( transformsBefore ) / float( optimizedVertices );
+		stats.atvrAfter = float( transformsAfter ) / float( optimizedVertices );
+	}
+	stats.cookTime = cookTime / 1000.f;
+	stats.cpuTime = cpuEndTime / 1000.f;
+	stats.publishTime = publishTime;
+	stats.totalTime = totalTime;
+	return stats;
+}
+
+void ModelLoader::Import()
+{
+	const auto start = Clock::now();
+	// vertices of the cooked file are used from the mapping as they are, only textures are left to decode
+	pCooked = CookedModel::Open( path, scale );
+	if( pCooked )
+	{
+		materials.resize( pCooked->GetMaterialCount() );
+		for( size_t i = 0; i < materials.size(); i++ )
+		{
+			materials[i].emplace( pCooked->GetMaterialDesc( i ), path );
+		}
+		meshMaterials.resize( pCooked->GetMeshCount() );
+		for( size_t i = 0; i < meshMaterials.size(); i++ )
+		{
+			const auto view = pCooked->GetMesh( i );
+			meshMaterials[i] = view.materialIndex;
+			const auto& mat = *materials[view.materialIndex];
+			AddVertexBytes( mat, view.vertexBytes / mat.GetVertexLayout().Size() );
+			AddLods( view.lods );
+			AddMeshlets( view.meshletCount );
+		}
+		nodes = pCooked->GetNodes();
+		materialCount = materials.size();
+		meshCount = meshMaterials.size();
+		cooked = true;
+		AddTime( importTime, start );
+		BuildBatches();
+		StartDataStages();
+		return;
+	}
+
+	pImporter = std::make_unique<Assimp::Importer>();
+	const auto& io = CookedModel::RecordDependencies( *pImporter );
+	pScene = pImporter->ReadFile(
+		to_narrow( path ),
+		aiProcess_Triangulate |
+		aiProcess_JoinIdenticalVertices |
+		aiProcess_ConvertToLeftHanded |
+		aiProcess_GenNormals |
+		aiProcess_CalcTangentSpace
+	);
+	if( !pScene )
+	{
+		throw ModelException( __LINE__, WFILE, pImporter->GetErrorString() );
+	}
+	dependencies = io.GetOpenedFiles();
+	AddTime( importTime, start );
+
+	materials.resize( pScene->mNumMaterials );
+	meshData.resize( pScene->mNumMeshes );
+	meshMaterials.resize( pScene->mNumMeshes );
+	for( size_t i = 0; i < meshMaterials.size(); i++ )
+	{
+		meshMaterials[i] = pScene->mMeshes[i]->mMaterialIndex;
+	}
+	nodes = Model::FlattenNodes( *pScene->mRootNode );
+	materialCount = pScene->mNumMaterials;
+	meshCount = pScene->mNumMeshes;
+	if( pScene->mNumMaterials == 0u )
+	{
+		StartDataStages();
+		return;
+	}
+	pendingMaterials = pScene->mNumMaterials;
+	for( size_t i = 0; i < pScene->mNumMaterials; i++ )
+	{
+		scheduler.Run( group, [this, i] { ParseMaterial( i ); } );
+	}
+}
+
+void ModelLoader::ParseMaterial( size_t i )
+{
+	const auto start = Clock::now();
+	materials[i].emplace( *pScene->mMaterials[i], path );
+	AddTime( materialTime, start );
+	if( pendingMaterials.fetch_sub( 1u ) == 1u )
+	{
+		StartDataStages();
+	}
+}
+
+void ModelLoader::StartDataStages()
+{
+	// materials share textures, every file is decoded once
+	for( const auto& m : materials )
+	{
+		for( auto& p : m->GetTexturePaths() )
+		{
+			if( std::find( texturePaths.begin(), texturePaths.end(), p ) == texturePaths.end() )
+			{
+				texturePaths.push_back( std::move( p ) );
+			}
+		}
+	}
+	decoded.resize( texturePaths.size() );
+	textureCount = texturePaths.size();
+	for( size_t i = 0; i < texturePaths.size(); i++ )
+	{
+		scheduler.Run( group, [this, i] { DecodeTexture( i ); } );
+	}
+	if( pCooked )
+	{
+		return;
+	}
+	if( meshData.empty() )
+	{
+		WriteCooked();
+		return;
+	}
+	pendingMeshes = meshData.size();
+	for( size_t i = 0; i < meshData.size(); i++ )
+	{
+		scheduler.Run( group, [this, i] { ExtractMesh( i ); } );
+	}
+}
+
+void ModelLoader::DecodeTexture( size_t i )
+{
+	// WIC decoding needs COM, threads keep it initialized for their lifetime
+	static thread_local const HRESULT comResult = CoInitializeEx( nullptr, COINIT_MULTITHREADED );
+	(void)comResult;
+
+	const auto start = Clock::now();
+	decoded[i].emplace( SurfaceEx::FromFile( texturePaths[i] ) );
+	AddTime( decodeTime, start );
+}
+
+void ModelLoader::ExtractMesh( size_t i )
+{
+	const auto start = Clock::now();
+	const auto& mesh = *pScene->mMeshes[i];
+	// large meshes are split further, so a single one doesn't serialize the stage
+	meshData[i].emplace( Mesh::Extract( *materials[mesh.mMaterialIndex], mesh, scale, &scheduler ) );
+	// optimization drops unreferenced vertices, so the count is taken from the extracted buffer
+	AddVertexBytes( *materials[mesh.mMaterialIndex], meshData[i]->vertices.Size() );
+	const auto& optimized = meshData[i]->optimizeStats;
+	optimizedTriangles += optimized.triangleCount;
+	optimizedVertices += optimized.vertexCount;
+	transformsBefore += optimized.transformsBefore;
+	transformsAfter += optimized.transformsAfter;
+	optimizeTime += int64_t( optimized.time * 1000.f );
+	simplifyTime += int64_t( meshData[i]->simplifyTime * 1000.f );
+	AddLods( meshData[i]->lods );
+	AddMeshlets( meshData[i]->meshlets.size() );
+	AddTime( extractTime, start );
+	if( pendingMeshes.fetch_sub( 1u ) == 1u )
+	{
+		// cooked file keeps the meshes and nodes of the source, batches are merged on every load
+		WriteCooked();
+		BuildBatches();
+	}
+}
+
+void ModelLoader::WriteCooked()
+{
+	const auto start = Clock::now();
+	std::vector<Material::Desc> descs;
+	descs.reserve( materials.size() );
+	for( const auto& m : materials )
+	{
+		descs.push_back( m->GetDesc() );
+	}
+	std::vector<CookedModel::MeshSource> sources;
+	sources.reserve( meshData.size() );
+	for( size_t i = 0; i < meshData.size(); i++ )
+	{
+		sources.push_back( { &*meshData[i], meshMaterials[i] } );
+	}
+	// failing to write only costs the next load another import
+	CookedModel::Write( path, scale, dependencies, descs, sources, nodes );
+	AddTime( cookTime, start );
+}
+
+void ModelLoader::BuildBatches()
+{
+	if( !staticBatching )
+	{
+		return;
+	}
+	std::vector<StaticBatcher::Source> sources;
+	sources.reserve( meshMaterials.size() );
+	for( size_t i = 0; i < meshMaterials.size(); i++ )
+	{
+		const auto& layout = materials[meshMaterials[i]]->GetVertexLayout();
+		sources.push_back( pCooked ? StaticBatcher::MakeSource( *pCooked, i, layout ) : StaticBatcher::MakeSource( *meshData[i], layout, meshMaterials[i] ) );
+	}
+	auto batched = StaticBatcher::Build( sources, nodes, scale, path );
+	batches = std::move( batched.batches );
+	nodes = std::move( batched.nodes );
+	meshRemap = std::move( batched.meshRemap );
+	batchStats = batched.stats;
+}
+
+void ModelLoader::AddVertexBytes( const Material& mat, size_t vertexCount ) noexcept
+{
+	vertexBytes += vertexCount * mat.GetVertexLayout().Size();
+	unpackedVertexBytes += vertexCount * Material::MakeVertexLayout( mat.GetDesc(), false ).Size();
+}
+
+void ModelLoader::AddLods( const std::vector<Drawable::Lod>& lods ) noexcept
+{
+	if( lods.empty() )
+	{
+		return;
+	}
+	triangleCount += lods.front().indexCount / 3u;
+	coarsestTriangleCount += lods.back().indexCount / 3u;
+	lodCount += lods.size();
+}
+
+void ModelLoader::AddMeshlets( size_t count ) noexcept
+{
+	meshletCount += count;
+	meshletMeshCount += count > 0u ? 1u : 0u;
+}
+
+void ModelLoader::AddTime( std::atomic<int64_t>& counter, Clock::time_point start ) noexcept
+{
+	const auto end = Clock::now();
+	counter += duration_cast<microseconds>( end - start ).count();
+	// CPU stages end when the last of their tasks does
+	const int64_t sinceLoad = duration_cast<microseconds>( end - loadStart ).count();
+	int64_t prev = cpuEndTime.load();
+	while( prev < sinceLoad && !cpuEndTime.compare_exchange_weak( prev, sinceLoad ) )
+	{
+	}
+}
+
+float ModelLoader::ElapsedSince( Clock::time_point start ) const noexcept
+{
+	return duration<float, std::milli>( Clock::now() - start ).count();
+}
@@ -0,0 +1,213 @@
+/*!
+ * \file ModelLoader.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Handle of a model that is being loaded in the background
+ *
+ * \note Import, material parsing, texture decoding and vertex/index extraction run
+ * on the scheduler. GPU resources are created by Poll, which has to be called from
+ * the render thread and spreads the work over frames by a time budget.
+ * When a valid cooked file of the model exists, the import and the extraction are replaced by
+ * mapping it, otherwise the cooked file is written once the extraction is finished.
+ */
+#pragma once
+
+#include "Model.h"
+#include "CookedModel.h"
+#include "StaticBatcher.h"
+#include "Material.h"
+#include "Mesh.h"
+#include "SurfaceEx.h"
+#include "TaskScheduler.h"
+
+#include <DirectXMath.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Assimp
+{
+	class Importer;
+}
+
+class ModelLoader
+{
+public:
+	struct Stats
+	{
+		size_t materialCount = 0u;
+		size_t textureCount = 0u;
+		size_t meshCount = 0u;
+		// vertex memory of the packed layouts and what the full precision float layouts would take
+		size_t vertexBytes = 0u;
+		size_t unpackedVertexBytes = 0u;
+		// post-transform cache of the imported meshes before and after MeshOptimizer,
+		// zero for cooked loads, whose meshes were optimized when they were cooked
+		float acmrBefore = 0.f;
+		float acmrAfter = 0.f;
+		float atvrBefore = 0.f;
+		float atvrAfter = 0.f;
+		// triangles of the full meshes and of their coarsest levels of detail
+		size_t triangleCount = 0u;
+		size_t coarsestTriangleCount = 0u;
+		size_t lodCount = 0u;
+		// meshlets of the large meshes and the meshes that have them
+		size_t meshletCount = 0u;
+		size_t meshletMeshCount = 0u;
+		// loaded from the cooked file instead of the source
+		bool cooked = false;
+		// mesh references that were merged into static batches, see StaticBatcher
+		Model::BatchStats batches;
+		// wall time of the assimp import or of mapping the cooked file
+		float importTime = 0.f;
+		// summed task times of the parallel stages
+		float materialTime = 0.f;
+		float decodeTime = 0.f;
+		float extractTime = 0.f;
+		float optimizeTime = 0.f;
+		float simplifyTime = 0.f;
+		// time spent writing the cooked file
+		float cookTime = 0.f;
+		// wall time from the start until the last CPU stage finished
+		float cpuTime = 0.f;
+		// time spent in Poll creating GPU resources
+		float publishTime = 0.f;
+		// wall time from the start until the model was ready
+		float totalTime = 0.f;
+	};
+
+public:
+	/**
+	 * @brief Starts CPU stages of the load on the scheduler
+	 * @param staticBatching merges static mesh references after the extraction, see Model::Model
+	 * @note Scheduler has to outlive the loader
+	*/
+	ModelLoader( TaskScheduler& scheduler, std::wstring path, float scale = 1.f, DirectX::XMFLOAT3 startingPos = { 0.f, 0.f, 0.f }, bool staticBatching = false );
+	ModelLoader( const ModelLoader& ) = delete;
+	ModelLoader& operator=( const ModelLoader& ) = delete;
+	~ModelLoader() noexcept;
+
+	/**
+	 * @brief Checks whether CPU stages are finished, rethrows the first exception of the stages
+	*/
+	bool IsCpuDone();
+	/**
+	 * @brief Blocks until CPU stages are finished, the calling thread takes part in them
+	 * @note Together with GetMeshData this is the CPU-only path of the pipeline, it needs no Graphics
+	*/
+	void WaitCpu();
+	/**
+	 * @brief Creates GPU resources from the finished CPU stages on the calling thread
+	 * @param budget milliseconds after which remaining resources are left for the next call
+	 * @return true once the model is ready to be taken
+	*/
+	bool Poll( Graphics& gfx, float budget = 4.f );
+	bool IsReady() const noexcept { return ready; }
+	/**
+	 * @brief Hands over ownership of the loaded model, can be called once after Poll returned true
+	*/
+	std::unique_ptr<Model> Take() noexcept { return std::move( pModel ); }
+	const std::wstring& GetPath() const noexcept { return path; }
+	Stats GetStats() const noexcept;
+	/**
+	 * @brief Extracted geometry of the mesh, available after CPU stages until the mesh is published
+	*/
+	const Mesh::Data* GetMeshData( size_t i ) const noexcept { return i < meshData.size() && meshData[i] ? &*meshData[i] : nullptr; }
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+private:
+	void Import();
+	void ParseMaterial( size_t i );
+	/**
+	 * @brief Queues texture decoding and mesh extraction, called by the last finished material task
+	*/
+	void StartDataStages();
+	void DecodeTexture( size_t i );
+	void ExtractMesh( size_t i );
+	/**
+	 * @brief Writes the cooked file, called by the last finished extraction task
+	*/
+	void WriteCooked();
+	/**
+	 * @brief Merges the static mesh references and replaces the nodes, called once every mesh is available
+	*/
+	void BuildBatches();
+	void AddVertexBytes( const Material& mat, size_t vertexCount ) noexcept;
+	void AddLods( const std::vector<Drawable::Lod>& lods ) noexcept;
+	void AddMeshlets( size_t count ) noexcept;
+	void AddTime( std::atomic<int64_t>& counter, Clock::time_point start ) noexcept;
+	float ElapsedSince( Clock::time_point start ) const noexcept;
+
+private:
+	TaskScheduler& scheduler;
+	TaskScheduler::Group group;
+	std::wstring path;
+	float scale;
+	DirectX::XMFLOAT3 startingPos;
+	bool staticBatching;
+	Clock::time_point loadStart;
+
+	// CPU stages, released once the model is published
+	std::unique_ptr<Assimp::Importer> pImporter;
+	const aiScene* pScene = nullptr;
+	// files that the import opened, written to the cooked file
+	std::vector<std::string> dependencies;
+	std::vector<std::optional<Material>> materials;
+	std::atomic<size_t> pendingMaterials = 0u;
+	std::vector<std::wstring> texturePaths;
+	std::vector<std::optional<SurfaceEx>> decoded;
+	std::vector<std::optional<Mesh::Data>> meshData;
+	std::atomic<size_t> pendingMeshes = 0u;
+	std::unique_ptr<CookedModel> pCooked;
+	std::vector<uint32_t> meshMaterials;
+	std::vector<Model::NodeDesc> nodes;
+	// batches and the new indices of the meshes, empty without static batching
+	std::vector<StaticBatcher::Batch> batches;
+	std::vector<uint32_t> meshRemap;
+	Model::BatchStats batchStats;
+	bool cpuDone = false;
+
+	// publishing on the render thread
+	Material::SurfaceMap surfaces;
+	std::vector<std::unique_ptr<Mesh>> meshPtrs;
+	size_t publishedMaterials = 0u;
+	size_t publishedMeshes = 0u;
+	size_t publishedBatches = 0u;
+	std::unique_ptr<Model> pModel;
+	bool ready = false;
+
+	// instrumentation, task times are summed in microseconds
+	std::atomic<size_t> materialCount = 0u;
+	std::atomic<size_t> textureCount = 0u;
+	std::atomic<size_t> meshCount = 0u;
+	std::atomic<size_t> vertexBytes = 0u;
+	std::atomic<size_t> unpackedVertexBytes = 0u;
+	std::atomic<size_t> optimizedTriangles = 0u;
+	std::atomic<size_t> optimizedVertices = 0u;
+	std::atomic<size_t> transformsBefore = 0u;
+	std::atomic<size_t> transformsAfter = 0u;
+	std::atomic<size_t> triangleCount = 0u;
+	std::atomic<size_t> coarsestTriangleCount = 0u;
+	std::atomic<size_t> lodCount = 0u;
+	std::atomic<size_t> meshletCount = 0u;
+	std::atomic<size_t> meshletMeshCount = 0u;
+	std::atomic<bool> cooked = false;
+	std::atomic<int64_t> importTime = 0;
+	std::atomic<int64_t> materialTime = 0;
+	std::atomic<int64_t> decodeTime = 0;
+	std::atomic<int64_t> extractTime = 0;
+	std::atomic<int64_t> optimizeTime = 0;
+	std::atomic<int64_t> simplifyTime = 0;
+	std::atomic<int64_t> cookTime = 0;
+	std::atomic<int64_t> cpuEndTime = 0;
+	float publishTime = 0.f;
+	float totalTime = 0.f;
+};
@@ -11,31 +11,12 @@
 #include "Model.h"
 #include "ModelProbe.h"
 
-Node::Node( std::vector<Mesh*> meshPtrs, const std::string & name, uint32_t index, const DirectX::XMMATRIX & transform_in ) noexcept( !IS_DEBUG ) :
+Node::Node( std::vector<Mesh*> meshPtrs, const std::string & name, uint32_t index, TransformHierarchy& transforms ) noexcept( !IS_DEBUG ) :
 	meshPtrs( std::move( meshPtrs ) ),
 	name( name ),
-	index( index )
-{
-	dx::XMStoreFloat4x4( &parentTransform, transform_in );
-	dx::XMStoreFloat4x4( &appliedTransform, dx::XMMatrixIdentity() );
-}
-
-void Node::Submit( size_t channelFilter, dx::FXMMATRIX accumulatedTransform ) const IFNOEXCEPT
-{
-	const auto built =
-		dx::XMLoadFloat4x4( &appliedTransform ) *
-		dx::XMLoadFloat4x4( &parentTransform ) *
-		accumulatedTransform;
-	for( const auto pm : meshPtrs )
-	{
-		pm->Submit( channelFilter, built );
-	}
-
-	for( const auto& pc : childPtrs )
-	{
-		pc->Submit( channelFilter, built );
-	}
-}
+	index( index ),
+	pTransforms( &transforms )
+{}
 
 void Node::Accept( ModelProbe & probe )
 {
@@ -10,6 +10,7 @@
 
 #include "Graphics.h"
 #include "DynamicConstantBuffer.h"
+#include "TransformHierarchy.h"
 
 class Mesh;
 
@@ -18,16 +19,18 @@ class Node
 	friend class Model;
 	friend class ModelWindow;
 public:
-	Node( std::vector<Mesh*> meshPtrs, const std::string& name, uint32_t index, const DirectX::XMMATRIX& transform_in ) IFNOEXCEPT;
-	void Submit( size_t channelFilter, DirectX::FXMMATRIX accumulatedTransform ) const IFNOEXCEPT;
+	/**
+	 * @param index slot of the node in the transform hierarchy of the model
+	*/
+	Node( std::vector<Mesh*> meshPtrs, const std::string& name, uint32_t index, TransformHierarchy& transforms ) IFNOEXCEPT;
 	void Accept( class ModelProbe& probe );
 	void Accept( class TechniqueProbe& probe );
 
 	bool HasChildren() const noexcept { return !childPtrs.empty(); }
 	const std::string& GetName() const noexcept { return name; }
 	uint32_t GetID() const noexcept { return index; }
-	void SetAppliedTransform( DirectX::FXMMATRIX transform ) noexcept { DirectX::XMStoreFloat4x4( &appliedTransform, transform ); }
-	const DirectX::XMFLOAT4X4& GetAppliedTransform() const noexcept { return appliedTransform; }
+	void SetAppliedTransform( DirectX::FXMMATRIX transform ) noexcept { pTransforms->SetApplied( index, transform ); }
+	const DirectX::XMFLOAT4X4& GetAppliedTransform() const noexcept { return pTransforms->GetApplied( index ); }
 
 private:
 	void AddChild( std::unique_ptr<Node> pChild ) IFNOEXCEPT;
@@ -37,6 +40,5 @@ private:
 	uint32_t index;
 	std::vector<Mesh*> meshPtrs;
 	std::vector<std::unique_ptr<Node>> childPtrs;
-	DirectX::XMFLOAT4X4 parentTransform;
-	DirectX::XMFLOAT4X4 appliedTransform;
+	TransformHierarchy* pTransforms;
 };
\ No newline at end of file
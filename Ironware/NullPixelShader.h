@@ -18,8 +18,15 @@ class NullPixelShader : public Bindable
 {
 public:
 	NullPixelShader( Graphics& gfx ) {}
-	void Bind( Graphics& gfx ) IFNOEXCEPT override { GetContext( gfx )->PSSetShader( nullptr, nullptr, 0u ); }
+	void Bind( Graphics& gfx ) IFNOEXCEPT override
+	{
+		if( GetStateCache( gfx ).Set( PipelineStateCache::Stage::PSShader, nullptr ) )
+		{
+			GetContext( gfx )->PSSetShader( nullptr, nullptr, 0u );
+		}
+	}
 	static std::shared_ptr<NullPixelShader> Resolve( Graphics& gfx ) { return BindableCollection::Resolve<NullPixelShader>( gfx ); }
+	static size_t GenerateKey() noexcept { return 0u; }
 	static std::wstring GenerateUID() { return GET_CLASS_WNAME( NullPixelShader ); }
 	std::wstring GetUID() const noexcept override { return GenerateUID(); }
 };
\ No newline at end of file
@@ -12,15 +12,17 @@ struct VSOut
     float4 pos : SV_Position;
 };
 
-VSOut main( float3 pos : Position, float3 n : Normal, float2 tex : TexCoord, float3 tan : Tangent, float3 bitan : Bitangent )
+VSOut main( float3 pos : Position, float3 n : Normal, float2 tex : TexCoord, float4 tan : Tangent )
 {
     float4 pos4 = float4( pos, 1.f );
+    // w of the packed tangent frame is the handedness of the bitangent
+    const float3 bitan = cross( n, tan.xyz ) * tan.w;
     
     VSOut vso;
     vso.viewPos = (float3)mul( pos4, modelView );
     vso.viewN = mul( n, (float3x3)modelView );
     vso.tex = tex;
-    vso.viewTan = mul( tan, (float3x3)modelView );
+    vso.viewTan = mul( tan.xyz, (float3x3)modelView );
     vso.viewBitan = mul( bitan, (float3x3)modelView );
     vso.pos = mul( pos4, modelViewProjection );
     vso.shadowHomoPos = to_shadow_homo_space( pos, model );
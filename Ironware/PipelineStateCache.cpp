@@ -0,0 +1,65 @@
+/*!
+ * \file PipelineStateCache.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ *
+ */
+#include "PipelineStateCache.h"
+
+bool PipelineStateCache::Set( Stage stage, unsigned slot, const void* pObject, uint64_t extra ) noexcept
+{
+	if( slot >= MAX_SLOTS )
+	{
+		current.issued++;
+		return true;
+	}
+
+	auto& e = entries[(size_t)stage][slot];
+	if( enabled && e.valid && e.pObject == pObject && e.extra == extra )
+	{
+		current.skipped++;
+		return false;
+	}
+
+	e.pObject = pObject;
+	e.extra = extra;
+	e.valid = true;
+	current.issued++;
+	return true;
+}
+
+void PipelineStateCache::Invalidate() noexcept
+{
+	for( size_t i = 0; i < (size_t)Stage::Count; i++ )
+	{
+		Invalidate( (Stage)i );
+	}
+}
+
+void PipelineStateCache::Invalidate( Stage stage ) noexcept
+{
+	for( auto& e : entries[(size_t)stage] )
+	{
+		e.valid = false;
+	}
+}
+
+void PipelineStateCache::OutputTargetsChanged() noexcept
+{
+	Invalidate( Stage::PSShaderResource );
+}
+
+void PipelineStateCache::NewFrame() noexcept
+{
+	lastFrame = current;
+	current = {};
+	Invalidate();
+}
+
+void PipelineStateCache::SetEnabled( bool enabled_in ) noexcept
+{
+	enabled = enabled_in;
+	Invalidate();
+}
@@ -0,0 +1,88 @@
+/*!
+ * \file PipelineStateCache.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Shadow copy of the pipeline bindings that is used to drop redundant Set calls
+ *
+ * \note Doesn't depend on d3d, bindables ask the cache before calling into the context
+ * * and only issue the call if the cache reports a change
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+class PipelineStateCache
+{
+public:
+	enum class Stage
+	{
+		IATopology,
+		IAInputLayout,
+		IAVertexBuffer,
+		IAIndexBuffer,
+		VSShader,
+		VSConstantBuffer,
+		PSShader,
+		PSConstantBuffer,
+		PSShaderResource,
+		PSSampler,
+		RSState,
+		OMBlendState,
+		OMDepthStencilState,
+		Count,
+	};
+
+	struct Stats
+	{
+		size_t issued = 0u;
+		size_t skipped = 0u;
+	};
+
+	// slots above this limit are never cached, binds are always issued
+	static constexpr unsigned MAX_SLOTS = 16u;
+
+public:
+	/**
+	 * @brief Records the object bound to the stage slot
+	 * @param pObject d3d object (or any other identity) that is being bound
+	 * @param extra additional bind parameters that are part of the state (offsets, formats, factors)
+	 * @return true if the bind changes pipeline state and has to be issued
+	*/
+	bool Set( Stage stage, unsigned slot, const void* pObject, uint64_t extra = 0u ) noexcept;
+	bool Set( Stage stage, const void* pObject, uint64_t extra = 0u ) noexcept { return Set( stage, 0u, pObject, extra ); }
+	/**
+	 * @brief Forget everything, must be called whenever state is changed behind the cache's back
+	*/
+	void Invalidate() noexcept;
+	void Invalidate( Stage stage ) noexcept;
+	/**
+	 * @brief Must be called after render targets or depth stencil are bound, the runtime unbinds
+	 * * any shader resource view that aliases the new targets
+	*/
+	void OutputTargetsChanged() noexcept;
+	/**
+	 * @brief Publishes counters of the finished frame and invalidates the cache
+	*/
+	void NewFrame() noexcept;
+	const Stats& GetFrameStats() const noexcept { return lastFrame; }
+	void SetEnabled( bool enabled_in ) noexcept;
+	bool IsEnabled() const noexcept { return enabled; }
+
+private:
+	struct Entry
+	{
+		const void* pObject = nullptr;
+		uint64_t extra = 0u;
+		bool valid = false;
+	};
+
+private:
+	std::array<std::array<Entry, MAX_SLOTS>, (size_t)Stage::Count> entries;
+	Stats current;
+	Stats lastFrame;
+	bool enabled = true;
+};
@@ -72,19 +72,19 @@ public:
 			}
 		}
 
-		std::vector<uint16_t> indices;
+		std::vector<uint32_t> indices;
 		indices.reserve( (size_t)sq( divisions_x * divisions_y ) * 6 );
 		{
 			// vertex x and y to index
 			const auto vxy2i = [nVertices_x]( size_t x, size_t y )
 			{
-				return (uint16_t)( y * nVertices_x + x );
+				return (uint32_t)( y * nVertices_x + x );
 			};
 			for( size_t y = 0; y < divisions_y; y++ )
 			{
 				for( size_t x = 0; x < divisions_x; x++ )
 				{
-					const std::array<uint16_t, 4> indexArray =
+					const std::array<uint32_t, 4> indexArray =
 					{ vxy2i( x, y ), vxy2i( x + 1, y ), vxy2i( x, y + 1 ), vxy2i( x + 1, y + 1 ) };
 					indices.push_back( indexArray[0] );
 					indices.push_back( indexArray[2] );
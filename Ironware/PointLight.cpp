@@ -12,10 +12,7 @@
 #include <imgui/imgui.h>
 
 PointLight::PointLight( Graphics& gfx, DirectX::XMFLOAT3A homePos, float radius ) :
-	mesh( gfx, radius ),
-	cbuffer( gfx )
-{
-	homeLightCbuf = {
+	homeLightCbuf{
 		homePos,
 		{ 0.05f, 0.05f, 0.05f },
 		{ 1.f, 1.f, 1.f },
@@ -23,8 +20,11 @@ PointLight::PointLight( Graphics& gfx, DirectX::XMFLOAT3A homePos, float radius
 		1.f,
 		0.045f,
 		0.0075f,
-	};
-	Reset();
+	},
+	cbufData( homeLightCbuf ),
+	mesh( gfx, radius ),
+	cbuffer( gfx, ReflectedLayout<PointLightCBuf>::MakeBuffer( homeLightCbuf ), 0u )
+{
 	pCamera = std::make_shared<Camera>( gfx, "Light", homePos, 0.f, 0.f, true );
 }
 
@@ -78,7 +78,8 @@ void PointLight::Bind( Graphics& gfx, DirectX::FXMMATRIX view ) const noexcept
 	const auto pos = DirectX::XMLoadFloat3( &cbufData.pos );
 	DirectX::XMStoreFloat3A( &dataCopy.pos, DirectX::XMVector3Transform( pos, view ) );
 	// ------------------------------------------------------------------------------
-	cbuffer.Update( gfx, dataCopy );
+	// a light that didn't move relative to the camera uploads nothing
+	cbuffer.SetData( &dataCopy, sizeof( dataCopy ) );
 	cbuffer.Bind( gfx );
 }
 
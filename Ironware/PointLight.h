@@ -15,7 +15,8 @@
 
 #include "Graphics.h"
 #include "SolidSphere.h"
-#include "ConstantBuffers.h"
+#include "ConstantBuffersEx.h"
+#include "PointLightCBuf.h"
 #include "CommonMacros.h"
 
 class RenderGraph;
@@ -32,23 +33,11 @@ public:
 	void Reset() noexcept;
 	std::shared_ptr<Camera> ShareCamera() const noexcept;
 
-private:
-	struct PointLightCBuf
-	{
-		// GPU expects 16 byte val
-		DirectX::XMFLOAT3A pos;
-		DirectX::XMFLOAT3A ambient;
-		DirectX::XMFLOAT3 diffuseColor;
-		float diffuseIntensity;
-		float attConst;
-		float attLin;
-		float attQuad;
-	};
-
 private:
 	PointLightCBuf homeLightCbuf;
 	std::shared_ptr<Camera> pCamera;
 	PointLightCBuf cbufData;
 	mutable SolidSphere mesh;
-	mutable PixelConstantBuffer<PointLightCBuf> cbuffer;
+	// cooked from the struct, so only the changed registers are uploaded
+	mutable CachingPixelConstantBufferEx cbuffer;
 };
\ No newline at end of file
@@ -0,0 +1,30 @@
+/*!
+ * \file PointLightCBuf.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Header file that contains PointLightCBuf, the constant buffer of PointLight
+ *
+ * \note Kept apart from PointLight so the packing can be checked without a d3d device.
+*/
+#pragma once
+
+#include "ReflectedLayout.h"
+
+#include <DirectXMath.h>
+
+struct PointLightCBuf
+{
+	// GPU expects 16 byte val
+	DirectX::XMFLOAT3A pos;
+	DirectX::XMFLOAT3A ambient;
+	DirectX::XMFLOAT3 diffuseColor;
+	float diffuseIntensity;
+	float attConst;
+	float attLin;
+	float attQuad;
+	CBUFFER_FIELDS( PointLightCBuf,
+		CBUFFER_FIELD( pos ), CBUFFER_FIELD( ambient ), CBUFFER_FIELD( diffuseColor ), CBUFFER_FIELD( diffuseIntensity ),
+		CBUFFER_FIELD( attConst ), CBUFFER_FIELD( attLin ), CBUFFER_FIELD( attQuad ) )
+};
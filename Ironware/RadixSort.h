@@ -0,0 +1,80 @@
+/*!
+ * \file RadixSort.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief LSD radix sort for containers that are ordered by a 64-bit key
+ */
+#pragma once
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstdint>
+
+/**
+ * @brief Stable least significant digit radix sort by 64-bit key (8 bits per pass)
+ * * Digits that are equal for every item are skipped, so sparse keys sort faster
+ * @tparam T type of the sorted items, needs to be copy assignable
+ * @param items container that will be sorted in place
+ * @param scratch reusable ping-pong buffer, keeps its capacity between calls
+ * @param key functor that returns uint64_t key of the item
+*/
+template<typename T, typename KeyFunc>
+void radix_sort( std::vector<T>& items, std::vector<T>& scratch, KeyFunc&& key )
+{
+	constexpr size_t radixBits = 8u;
+	constexpr size_t nBuckets = size_t( 1u ) << radixBits;
+	constexpr uint64_t digitMask = nBuckets - 1u;
+	constexpr size_t nPasses = sizeof( uint64_t ) * 8u / radixBits;
+
+	const size_t count = items.size();
+	if( count < 2u )
+	{
+		return;
+	}
+	scratch.resize( count, items.front() );
+
+	// histogram of every digit is gathered in a single sweep
+	std::array<std::array<size_t, nBuckets>, nPasses> histograms = {};
+	for( const auto& item : items )
+	{
+		const uint64_t k = key( item );
+		for( size_t p = 0; p < nPasses; p++ )
+		{
+			histograms[p][( k >> ( p * radixBits ) ) & digitMask]++;
+		}
+	}
+
+	T* pSrc = items.data();
+	T* pDst = scratch.data();
+	for( size_t p = 0; p < nPasses; p++ )
+	{
+		const auto shift = p * radixBits;
+		auto& hist = histograms[p];
+		// every key has the same digit, nothing to reorder
+		if( hist[( key( *pSrc ) >> shift ) & digitMask] == count )
+		{
+			continue;
+		}
+		// exclusive prefix sum turns counts into bucket offsets
+		size_t sum = 0u;
+		for( auto& h : hist )
+		{
+			const auto n = h;
+			h = sum;
+			sum += n;
+		}
+		for( size_t i = 0; i < count; i++ )
+		{
+			pDst[hist[( key( pSrc[i] ) >> shift ) & digitMask]++] = pSrc[i];
+		}
+		std::swap( pSrc, pDst );
+	}
+
+	if( pSrc != items.data() )
+	{
+		std::copy( pSrc, pSrc + count, items.data() );
+	}
+}
@@ -0,0 +1,167 @@
+/*!
+ * \file RangeAllocator.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ *
+ */
+#include "RangeAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+RangeAllocator::RangeAllocator( size_t capacity ) :
+	capacity( capacity )
+{
+	if( capacity > 0u )
+	{
+		freeRanges.emplace( 0u, capacity );
+	}
+}
+
+RangeAllocator::Handle RangeAllocator::Allocate( size_t size )
+{
+	if( size == 0u )
+	{
+		return INVALID_HANDLE;
+	}
+	auto best = freeRanges.end();
+	for( auto it = freeRanges.begin(); it != freeRanges.end(); ++it )
+	{
+		if( it->second >= size && ( best == freeRanges.end() || it->second < best->second ) )
+		{
+			best = it;
+			if( it->second == size )
+			{
+				break;
+			}
+		}
+	}
+	if( best == freeRanges.end() )
+	{
+		return INVALID_HANDLE;
+	}
+
+	const size_t offset = best->first;
+	const size_t rest = best->second - size;
+	freeRanges.erase( best );
+	if( rest > 0u )
+	{
+		freeRanges.emplace( offset + size, rest );
+	}
+
+	Handle handle;
+	if( !freeHandles.empty() )
+	{
+		handle = freeHandles.back();
+		freeHandles.pop_back();
+	}
+	else
+	{
+		handle = Handle( allocations.size() );
+		allocations.emplace_back();
+	}
+	allocations[handle] = { offset, size, true };
+	used += size;
+	return handle;
+}
+
+void RangeAllocator::Free( Handle handle ) noexcept
+{
+	assert( handle < allocations.size() && allocations[handle].live );
+	auto& a = allocations[handle];
+	a.live = false;
+	used -= a.size;
+	AddFreeRange( a.offset, a.size );
+	freeHandles.push_back( handle );
+}
+
+void RangeAllocator::Grow( size_t capacity_in )
+{
+	if( capacity_in <= capacity )
+	{
+		return;
+	}
+	const size_t offset = capacity;
+	capacity = capacity_in;
+	AddFreeRange( offset, capacity - offset );
+}
+
+std::vector<RangeAllocator::Move> RangeAllocator::Defragment()
+{
+	std::vector<Handle> live;
+	live.reserve( allocations.size() - freeHandles.size() );
+	for( Handle h = 0u; h < allocations.size(); h++ )
+	{
+		if( allocations[h].live )
+		{
+			live.push_back( h );
+		}
+	}
+	std::sort( live.begin(), live.end(), [this]( Handle lhs, Handle rhs ) { return allocations[lhs].offset < allocations[rhs].offset; } );
+
+	std::vector<Move> moves;
+	size_t offset = 0u;
+	for( const auto h : live )
+	{
+		auto& a = allocations[h];
+		if( a.offset != offset )
+		{
+			// neighbors that move by the same distance are copied at once
+			if( !moves.empty() && moves.back().from + moves.back().size == a.offset && moves.back().to + moves.back().size == offset )
+			{
+				moves.back().size += a.size;
+			}
+			else
+			{
+				moves.push_back( { a.offset, offset, a.size } );
+			}
+			a.offset = offset;
+		}
+		offset += a.size;
+	}
+
+	freeRanges.clear();
+	if( offset < capacity )
+	{
+		freeRanges.emplace( offset, capacity - offset );
+	}
+	return moves;
+}
+
+RangeAllocator::Stats RangeAllocator::GetStats() const noexcept
+{
+	Stats stats;
+	stats.capacity = capacity;
+	stats.used = used;
+	stats.allocationCount = allocations.size() - freeHandles.size();
+	stats.freeRangeCount = freeRanges.size();
+	for( const auto& r : freeRanges )
+	{
+		stats.largestFreeRange = std::max( stats.largestFreeRange, r.second );
+	}
+	return stats;
+}
+
+void RangeAllocator::AddFreeRange( size_t offset, size_t size )
+{
+	auto next = freeRanges.lower_bound( offset );
+	if( next != freeRanges.begin() )
+	{
+		auto prev = std::prev( next );
+		if( prev->first + prev->second == offset )
+		{
+			offset = prev->first;
+			size += prev->second;
+			freeRanges.erase( prev );
+		}
+	}
+	if( next != freeRanges.end() && offset + size == next->first )
+	{
+		size += next->second;
+		freeRanges.erase( next );
+	}
+	freeRanges.emplace( offset, size );
+}
@@ -0,0 +1,86 @@
+/*!
+ * \file RangeAllocator.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Header file that contains RangeAllocator, suballocation of ranges of a linear buffer
+ *
+ * \note Doesn't depend on d3d, it only keeps offsets. Ranges are referred to by handles, so their
+ * * offsets can change when the allocator is defragmented, and the owner of the memory applies
+ * * the returned moves. Free ranges are kept ordered by offset and merged with their neighbors.
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+class RangeAllocator
+{
+public:
+	using Handle = uint32_t;
+	static constexpr Handle INVALID_HANDLE = ~0u;
+
+	struct Stats
+	{
+		size_t capacity = 0u;
+		size_t used = 0u;
+		size_t allocationCount = 0u;
+		size_t freeRangeCount = 0u;
+		size_t largestFreeRange = 0u;
+	};
+
+	/**
+	 * @brief Range that has to be copied for the offsets after defragmentation to be valid
+	*/
+	struct Move
+	{
+		size_t from;
+		size_t to;
+		size_t size;
+	};
+
+public:
+	explicit RangeAllocator( size_t capacity = 0u );
+	/**
+	 * @brief Takes the smallest free range that fits, the lowest one among equal sizes
+	 * @return INVALID_HANDLE if no free range is large enough
+	*/
+	Handle Allocate( size_t size );
+	void Free( Handle handle ) noexcept;
+	/**
+	 * @brief Appends free space to the end, the range before it is merged with the space
+	*/
+	void Grow( size_t capacity_in );
+	/**
+	 * @brief Packs the allocations to the start in the order of their offsets, leaving a single free range
+	 * @return moves in the order of increasing offset, every move goes to a lower or equal offset
+	*/
+	std::vector<Move> Defragment();
+	size_t GetOffset( Handle handle ) const noexcept { return allocations[handle].offset; }
+	size_t GetSize( Handle handle ) const noexcept { return allocations[handle].size; }
+	size_t GetCapacity() const noexcept { return capacity; }
+	Stats GetStats() const noexcept;
+
+private:
+	struct Allocation
+	{
+		size_t offset = 0u;
+		size_t size = 0u;
+		bool live = false;
+	};
+
+private:
+	void AddFreeRange( size_t offset, size_t size );
+
+private:
+	size_t capacity;
+	size_t used = 0u;
+	// indexed by handle, handles of freed allocations are reused
+	std::vector<Allocation> allocations;
+	std::vector<Handle> freeHandles;
+	// offset -> size
+	std::map<size_t, size_t> freeRanges;
+};
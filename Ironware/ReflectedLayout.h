@@ -0,0 +1,233 @@
+/*!
+ * \file ReflectedLayout.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Header file that contains ReflectedLayout, the hlsl packing of C++ constant buffer structs
+ * * derived and checked at compile time
+ *
+ * \note Structs list their members with CBUFFER_FIELDS, offsets of the members are compared with the offsets
+ * * that the packing rules of LayoutElement give them, so a struct that the shader would read differently
+ * * doesn't compile. The same fields cook into a CookedLayout whose buffers have the bytes of the struct,
+ * * so static buffers can still be edited through a Buffer by probes.
+ * * Bools of hlsl are 4 bytes, they're declared as BOOL and reflected as Integer.
+*/
+#pragma once
+
+#include "DynamicConstantBuffer.h"
+#include "DynamicLayout.h"
+
+#include <DirectXMath.h>
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @brief Member of a reflected struct
+*/
+struct ReflectedField
+{
+	const char* name = nullptr;
+	// offset of the member in the C++ struct
+	size_t offset = 0u;
+	// leaf type of the member or of the elements of an array member
+	Type type = Empty;
+	// elements of an array member, 0 for leaves
+	size_t count = 0u;
+	// size of the member or of one element of an array member in the C++ struct
+	size_t size = 0u;
+};
+
+// leaf type of a member type
+template<typename T>
+struct FieldTraits
+{
+	static constexpr bool valid = ReverseMap<T>::valid;
+	static constexpr Type type = valid ? ReverseMap<std::conditional_t<valid, T, float>>::type : Empty;
+	static constexpr size_t count = 0u;
+};
+// aligned vectors only add padding after the vector
+template<> struct FieldTraits<DirectX::XMFLOAT3A> : FieldTraits<DirectX::XMFLOAT3> {};
+template<> struct FieldTraits<DirectX::XMFLOAT4A> : FieldTraits<DirectX::XMFLOAT4> {};
+template<typename T, size_t N>
+struct FieldTraits<T[N]>
+{
+	// arrays of arrays aren't supported
+	static constexpr bool valid = FieldTraits<T>::valid && FieldTraits<T>::count == 0u;
+	static constexpr Type type = FieldTraits<T>::type;
+	static constexpr size_t count = N;
+};
+
+template<typename F>
+constexpr ReflectedField make_reflected_field( const char* name, size_t offset ) noexcept
+{
+	static_assert( FieldTraits<F>::valid, "Unsupported type of a reflected constant buffer member" );
+	return { name, offset, FieldTraits<F>::type, FieldTraits<F>::count, sizeof( std::remove_extent_t<F> ) };
+}
+
+// lists the members of a constant buffer struct in the order of declaration, placed inside the struct
+#define CBUFFER_FIELDS( S, ... ) \
+	static constexpr auto GetReflectedFields() noexcept \
+	{ \
+		using Self = S; \
+		return std::array{ __VA_ARGS__ }; \
+	}
+#define CBUFFER_FIELD( member ) make_reflected_field<decltype( Self::member )>( #member, offsetof( Self, member ) )
+
+/**
+ * @brief Walks the fields like LayoutElement::Finalize walks a root Struct
+ * @return size of the struct in hlsl, 0 if a field isn't where hlsl puts it
+*/
+template<size_t N>
+constexpr size_t pack_hlsl( const std::array<ReflectedField, N>& fields ) noexcept
+{
+	size_t offset = 0u;
+	for( const auto& f : fields )
+	{
+		const auto leafSize = LayoutElement::GetLeafSize( f.type );
+		if( f.count == 0u )
+		{
+			offset = LayoutElement::AdvanceIfCrossesBoundary( offset, leafSize );
+			if( f.offset != offset || f.size < leafSize )
+			{
+				return 0u;
+			}
+			offset += leafSize;
+		}
+		else
+		{
+			// arrays start on a boundary and every element takes whole 16 byte registers
+			const auto stride = LayoutElement::AdvanceToBoundary( leafSize );
+			offset = LayoutElement::AdvanceToBoundary( offset );
+			if( f.offset != offset || f.size != stride )
+			{
+				return 0u;
+			}
+			offset += stride * f.count;
+		}
+	}
+	return LayoutElement::AdvanceToBoundary( offset );
+}
+
+/**
+ * @brief Layout of the fields as hlsl packs them, a field of an array type becomes an Array of its leaf type
+*/
+template<size_t N>
+RawLayout make_raw_layout( const std::array<ReflectedField, N>& fields ) IFNOEXCEPT
+{
+	RawLayout raw;
+	for( const auto& f : fields )
+	{
+		if( f.count == 0u )
+		{
+			raw.Add( f.type, f.name );
+		}
+		else
+		{
+			raw.Add( Array, f.name );
+			raw[f.name].Set( f.type, f.count );
+		}
+	}
+	return raw;
+}
+
+/**
+ * @param size of the C++ struct that the fields belong to
+ * @return true if every field has the offset, type and stride of the element of the same name in the layout
+*/
+template<size_t N>
+bool matches_layout( const std::array<ReflectedField, N>& fields, size_t size, const LayoutElement& root ) IFNOEXCEPT
+{
+	if( root.GetSizeInBytes() != size )
+	{
+		return false;
+	}
+	for( const auto& f : fields )
+	{
+		const auto& el = root[f.name];
+		if( f.count == 0u )
+		{
+			if( el.GetType() != f.type || el.GetOffsetBegin() != f.offset )
+			{
+				return false;
+			}
+		}
+		else if( el.GetType() != Array || el.T().GetType() != f.type || el.GetOffsetBegin() != f.offset ||
+			el.GetArraySize() != f.count || el.GetArrayStride() != f.size )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+template<typename S, typename = void>
+struct IsReflected : std::false_type {};
+template<typename S>
+struct IsReflected<S, std::void_t<decltype( S::GetReflectedFields() )>> : std::true_type {};
+
+template<typename S>
+class ReflectedLayout
+{
+	static_assert( IsReflected<S>::value, "Struct doesn't list its members with CBUFFER_FIELDS" );
+
+public:
+	static constexpr auto fields = S::GetReflectedFields();
+	static_assert( std::is_standard_layout_v<S>, "Reflected constant buffer has to be a standard layout struct" );
+	static_assert( fields.size() != 0u, "Reflected constant buffer has no fields" );
+	static_assert( pack_hlsl( fields ) != 0u, "Member of the constant buffer isn't where hlsl packs it, align it to 16 bytes" );
+	static_assert( pack_hlsl( fields ) == sizeof( S ), "Size of the constant buffer doesn't match its size in hlsl" );
+	static constexpr bool packed = true;
+
+public:
+	/**
+	 * @brief Layout with the same fields, resolved through DynamicLayout like the layouts built at runtime
+	*/
+	static CookedLayout Cook() IFNOEXCEPT
+	{
+		auto cooked = DynamicLayout::Resolve( make_raw_layout( fields ) );
+		assert( "Cooked layout doesn't match the struct" && MatchesLayout( *cooked.ShareRoot() ) );
+		return cooked;
+	}
+	/**
+	 * @return true if every field has the offset, type and stride of the element of the same name in the layout
+	*/
+	static bool MatchesLayout( const LayoutElement& root ) IFNOEXCEPT
+	{
+		return matches_layout( fields, sizeof( S ), root );
+	}
+	/**
+	 * @brief Buffer of the cooked layout that holds the bytes of the struct
+	*/
+	static Buffer MakeBuffer( const S& data ) IFNOEXCEPT
+	{
+		Buffer buf( Cook() );
+		buf.CopyFrom( &data, sizeof( S ) );
+		return buf;
+	}
+	static void Load( const Buffer& buf, S& data ) IFNOEXCEPT
+	{
+		assert( buf.GetSizeInBytes() == sizeof( S ) );
+		std::memcpy( &data, buf.GetData(), sizeof( S ) );
+	}
+};
+
+/**
+ * @return false if the struct is reflected and the shader would read it differently, true otherwise
+*/
+template<typename S>
+constexpr bool is_packed_for_hlsl() noexcept
+{
+	if constexpr( IsReflected<S>::value )
+	{
+		return ReflectedLayout<S>::packed;
+	}
+	else
+	{
+		return true;
+	}
+}
@@ -13,10 +13,13 @@
 #include "BindableCommon.h"
 #include "RenderGraphCompileException.h"
 #include "RenderQueuePass.h"
+#include "ConstantUploadRing.h"
 #include "Sink.h"
 #include "Source.h"
 #include "SurfaceEx.h"
 
+#include <imgui/imgui.h>
+
 #include <sstream>
 
 RenderGraph::RenderGraph( Graphics& gfx ) :
@@ -219,4 +222,72 @@ RenderQueuePass& RenderGraph::GetRenderQueue( const std::string& passName )
 void RenderGraph::StoreDepth( Graphics & gfx, const std::wstring & path )
 {
 	masterDepth->ToSurface( gfx ).Save( path );
+}
+
+void RenderGraph::RenderQueueWindow( Graphics& gfx )
+{
+	if( ImGui::Begin( "Render Queues" ) )
+	{
+		const auto& bindStats = gfx.GetBindStats();
+		ImGui::Text( "Binds: %zu issued, %zu skipped", bindStats.issued, bindStats.skipped );
+		const auto& drawStats = gfx.GetDrawStats();
+		ImGui::Text( "Draws: %zu calls, %zu instances", drawStats.drawCalls, drawStats.instances );
+		bool cacheBinds = gfx.IsBindCacheEnabled();
+		if( ImGui::Checkbox( "Skip redundant binds", &cacheBinds ) )
+		{
+			gfx.EnableBindCache( cacheBinds );
+		}
+		const auto& uploadStats = gfx.GetUploadStats();
+		ImGui::Text( "Maps: %zu, %zu of constant buffers with %.1f KB",
+			uploadStats.maps, uploadStats.constantMaps, uploadStats.constantBytes / 1024.f );
+		const auto& exStats = ConstantBufferEx::GetTotalUploadStats();
+		ImGui::Text( "Dynamic buffers: %zu uploads, %zu skipped, %zu partial with %zu ranges, %.1f KB in total",
+			exStats.uploads, exStats.skipped, exStats.partialUploads, exStats.ranges, exStats.bytes / 1024.f );
+		auto& ring = gfx.GetConstantRing();
+		if( ring.IsSupported() )
+		{
+			bool useRing = ring.IsActive();
+			if( ImGui::Checkbox( "Upload constants through frame ring", &useRing ) )
+			{
+				ring.SetEnabled( useRing );
+			}
+			const auto ringStats = ring.GetStats();
+			ImGui::Text( "Ring: %.1f KB of %.1f MB in %zu frames, %.1f KB last frame",
+				ringStats.ring.used / 1024.f, ringStats.ring.capacity / ( 1024.f * 1024.f ), ringStats.ring.pendingFrames, ringStats.frameBytes / 1024.f );
+			ImGui::Text( "%zu wraps, %zu stalls, %zu growths, %zu staged and %zu immediate writes in total",
+				ringStats.ring.wraps, ringStats.ring.stalls, ringStats.growths, ringStats.stagedWrites, ringStats.immediateWrites );
+		}
+		else
+		{
+			ImGui::Text( "Ring: constant buffer offsets aren't supported by the device" );
+		}
+		ImGui::Separator();
+		const char* modeNames[] = { "None", "State First", "Front To Back", "Back To Front" };
+		for( auto& p : passes )
+		{
+			auto pQueue = dynamic_cast<RenderQueuePass*>( p.get() );
+			if( !pQueue )
+			{
+				continue;
+			}
+			const auto& stats = pQueue->GetStats();
+			ImGui::PushID( pQueue );
+			ImGui::Text( "%s: %zu jobs, %zu state changes, sort %.3f ms",
+				pQueue->GetName().c_str(), stats.jobCount, stats.stateChanges, stats.sortTime );
+			ImGui::Text( "%zu draw calls, %zu jobs in %zu instanced draws", stats.drawCalls, stats.instancedJobs, stats.instancedDraws );
+			ImGui::Text( "%zu geometry binds", stats.geometryBinds );
+			int mode = (int)pQueue->GetSortMode();
+			if( ImGui::Combo( "Sort", &mode, modeNames, (int)std::size( modeNames ) ) )
+			{
+				pQueue->SetSortMode( (RenderQueuePass::SortMode)mode );
+			}
+			bool instancing = pQueue->IsInstancingEnabled();
+			if( ImGui::Checkbox( "Instancing", &instancing ) )
+			{
+				pQueue->SetInstancing( instancing );
+			}
+			ImGui::PopID();
+		}
+	}
+	ImGui::End();
 }
\ No newline at end of file
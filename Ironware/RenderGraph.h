@@ -31,6 +31,10 @@ protected:
 	void Finalize();
 	void AppendPass( std::unique_ptr<Pass> pass );
 	Pass& FindPassByName( const std::string& name );
+	/**
+	 * @brief ImGui window with per queue job statistics and sort mode selection
+	*/
+	void RenderQueueWindow( Graphics& gfx );
 
 private:
 	void LinkSinks( Pass& pass );
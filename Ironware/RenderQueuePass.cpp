@@ -3,27 +3,283 @@
  *
  * \author Yernar Aldabergenov
  * \date May 2021
- *
  * 
  */
 #include "RenderQueuePass.h"
+#include "RenderStep.h"
+#include "Drawable.h"
+#include "RadixSort.h"
+#include "ConstantUploadRing.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstring>
+
+namespace dx = DirectX;
+
+RenderQueuePass::RenderQueuePass( std::string name, std::vector<std::shared_ptr<Bindable>> binds, SortMode sortMode ) :
+	BindingPass( std::move( name ), std::move( binds ) ),
+	sortMode( sortMode )
+{}
 
 void RenderQueuePass::Accept( Job job ) noexcept
 {
-	jobs.push_back( job );
+	assert( "Jobs are accepted only from the threads of the frame scheduler" && TaskScheduler::IsFrameThread() );
+	buckets[TaskScheduler::GetFrameThreadIndex()].jobs.push_back( job );
 }
 
 void RenderQueuePass::Execute( Graphics& gfx ) const IFNOEXCEPT
 {
 	BindAll( gfx );
 
-	for( const auto& j : jobs )
+	MergeBuckets();
+	AcquireTransforms( gfx );
+	SortJobs( gfx );
+	BuildBatches();
+	UploadInstances( gfx );
+	PrepareTransforms( gfx );
+	UploadConstants( gfx );
+
+	const size_t drawCallsBefore = gfx.GetDrawCallCount();
+	stats.jobCount = jobs.size();
+	stats.stateChanges = 0u;
+	stats.instancedJobs = 0u;
+	stats.instancedDraws = 0u;
+	stats.geometryBinds = 0u;
+	const RenderStep* pPrevStep = nullptr;
+	const Drawable* pBoundGeometry = nullptr;
+	bool passShaderReplaced = false;
+	for( const auto& b : batches )
 	{
-		j.Execute( gfx );
+		const auto& j = jobs[b.first];
+		if( !pPrevStep || pPrevStep->GetStateKey() != j.GetStep().GetStateKey() )
+		{
+			stats.stateChanges++;
+		}
+		pPrevStep = &j.GetStep();
+		// meshes of the geometry heap with the same layout are drawn from the buffers that are bound
+		const bool bindGeometry = !pBoundGeometry || !pBoundGeometry->SharesBuffers( j.GetDrawable() );
+		if( bindGeometry )
+		{
+			pBoundGeometry = &j.GetDrawable();
+			stats.geometryBinds++;
+		}
+		if( b.count > 1u )
+		{
+			j.ExecuteInstanced( gfx, uint32_t( b.count ), b.startInstance, bindGeometry );
+			stats.instancedJobs += b.count;
+			stats.instancedDraws++;
+			passShaderReplaced = true;
+			continue;
+		}
+		// instanced shader may have replaced the one of the pass, which the next step relies on
+		if( passShaderReplaced )
+		{
+			BindAll( gfx );
+			passShaderReplaced = false;
+		}
+		j.Execute( gfx, bindGeometry );
 	}
+	stats.drawCalls = gfx.GetDrawCallCount() - drawCallsBefore;
+	// the next pass may draw with another camera
+	gfx.GetTransformStage().UnbindCamera();
 }
 
 void RenderQueuePass::Reset() IFNOEXCEPT
 {
 	jobs.clear();
-}
\ No newline at end of file
+	for( auto& b : buckets )
+	{
+		b.jobs.clear();
+	}
+}
+
+void RenderQueuePass::MergeBuckets() const noexcept
+{
+	size_t count = 0u;
+	for( const auto& b : buckets )
+	{
+		count += b.jobs.size();
+	}
+	jobs.clear();
+	jobs.reserve( count );
+	for( auto& b : buckets )
+	{
+		jobs.insert( jobs.end(), b.jobs.begin(), b.jobs.end() );
+		// capacity of the bucket is kept for the next frame
+		b.jobs.clear();
+	}
+}
+
+void RenderQueuePass::AcquireTransforms( Graphics& gfx ) const
+{
+	auto& stage = gfx.GetTransformStage();
+	for( auto& j : jobs )
+	{
+		j.SetTransformSlot( stage.Acquire( j.GetDrawable() ) );
+	}
+}
+
+void RenderQueuePass::BuildBatches() const
+{
+	batches.clear();
+	batchOfKey.clear();
+	jobBatches.resize( jobs.size() );
+	// blended queues have to be drawn in their order
+	const bool merge = instancing && sortMode != SortMode::BackToFront;
+	for( size_t i = 0; i < jobs.size(); i++ )
+	{
+		const auto& j = jobs[i];
+		if( merge && j.IsInstanceable() )
+		{
+			const auto [it, inserted] = batchOfKey.try_emplace( j.GetInstanceKey(), batches.size() );
+			// on a collision of the keys the job is drawn on its own
+			if( !inserted && jobs[batches[it->second].first].CanInstance( j ) )
+			{
+				jobBatches[i] = it->second;
+				batches[it->second].count++;
+				continue;
+			}
+		}
+		jobBatches[i] = batches.size();
+		batches.push_back( { i, 1u, 0u } );
+	}
+	if( batches.size() == jobs.size() )
+	{
+		return;
+	}
+
+	// counting sort by batch keeps the order of the batches and of the jobs inside them
+	size_t offset = 0u;
+	for( auto& b : batches )
+	{
+		const size_t count = b.count;
+		b.first = offset;
+		b.count = 0u;
+		offset += count;
+	}
+	sortScratch.resize( jobs.size(), jobs.front() );
+	for( size_t i = 0; i < jobs.size(); i++ )
+	{
+		auto& b = batches[jobBatches[i]];
+		sortScratch[b.first + b.count++] = jobs[i];
+	}
+	jobs.swap( sortScratch );
+}
+
+void RenderQueuePass::UploadInstances( Graphics& gfx ) const
+{
+	const auto& stage = gfx.GetTransformStage();
+	instances.clear();
+	for( auto& b : batches )
+	{
+		if( b.count < 2u )
+		{
+			continue;
+		}
+		b.startInstance = uint32_t( instances.size() );
+		for( size_t i = b.first; i < b.first + b.count; i++ )
+		{
+			InstanceBuffer::Instance instance;
+			dx::XMStoreFloat4x4( &instance.model, stage.GetModel( jobs[i].GetTransformSlot() ) );
+			instances.push_back( instance );
+		}
+	}
+	if( instances.empty() )
+	{
+		return;
+	}
+	if( !pInstanceBuffer )
+	{
+		pInstanceBuffer = std::make_unique<InstanceBuffer>( gfx, instances.size() );
+	}
+	pInstanceBuffer->Update( gfx, instances );
+	pInstanceBuffer->Bind( gfx );
+}
+
+void RenderQueuePass::PrepareTransforms( Graphics& gfx ) const
+{
+	auto& stage = gfx.GetTransformStage();
+	if( !stage.IsEnabled() )
+	{
+		return;
+	}
+	stage.BindCamera( gfx.GetCameraXM(), gfx.GetProjection() );
+	for( const auto& b : batches )
+	{
+		if( b.count == 1u )
+		{
+			stage.Request( jobs[b.first].GetTransformSlot() );
+		}
+	}
+	stage.Compute();
+}
+
+void RenderQueuePass::UploadConstants( Graphics& gfx ) const IFNOEXCEPT
+{
+	auto& ring = gfx.GetConstantRing();
+	if( !ring.IsActive() )
+	{
+		return;
+	}
+	for( const auto& b : batches )
+	{
+		if( b.count == 1u )
+		{
+			jobs[b.first].GetStep().StageConstants( gfx );
+		}
+	}
+	ring.Flush( gfx );
+}
+
+void RenderQueuePass::SortJobs( Graphics& gfx ) const IFNOEXCEPT
+{
+	using namespace std::chrono;
+	if( sortMode == SortMode::None )
+	{
+		stats.sortTime = 0.f;
+		return;
+	}
+
+	const auto start = steady_clock::now();
+
+	constexpr unsigned stateBits = RenderStep::STATE_KEY_BITS;
+	constexpr unsigned depthBits = 64u - stateBits;
+	constexpr uint64_t depthMask = ( uint64_t( 1u ) << depthBits ) - 1u;
+	const auto view = gfx.GetCameraXM();
+	const auto& stage = gfx.GetTransformStage();
+	for( auto& j : jobs )
+	{
+		const uint64_t state = j.GetStep().GetStateKey();
+		// view space depth of the drawable origin
+		const auto origin = stage.GetModel( j.GetTransformSlot() ).r[3];
+		const uint64_t depth = QuantizeDepth( dx::XMVectorGetZ( dx::XMVector3Transform( origin, view ) ) );
+		switch( sortMode )
+		{
+		case SortMode::StateFirst:
+			j.SetSortKey( ( state << depthBits ) | depth );
+			break;
+		case SortMode::FrontToBack:
+			j.SetSortKey( ( depth << stateBits ) | state );
+			break;
+		case SortMode::BackToFront:
+			j.SetSortKey( ( ( ~depth & depthMask ) << stateBits ) | state );
+			break;
+		}
+	}
+
+	radix_sort( jobs, sortScratch, []( const Job& j ) { return j.GetSortKey(); } );
+
+	stats.sortTime = duration<float, std::milli>( steady_clock::now() - start ).count();
+}
+
+uint64_t RenderQueuePass::QuantizeDepth( float viewZ ) noexcept
+{
+	constexpr unsigned depthBits = 64u - RenderStep::STATE_KEY_BITS;
+	// bit pattern of positive IEEE floats is monotonic, so the top bits
+	// of the float keep the ordering without knowing the depth range
+	viewZ = viewZ > 0.f ? viewZ : 0.f;
+	uint32_t bits;
+	std::memcpy( &bits, &viewZ, sizeof( bits ) );
+	return uint64_t( bits >> ( 32u - depthBits ) );
+}
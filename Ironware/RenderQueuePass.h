@@ -3,24 +3,129 @@
  *
  * \author Yernar Aldabergenov
  * \date May 2021
- *
  * 
+ * \note Jobs are sorted by 64-bit key before execution, see SortMode
+ * \note Accept is safe to call from the threads of the frame TaskScheduler, every thread
+ * fills its own bucket and buckets are merged when the pass is executed
+ * \note Jobs that share every bindable but the transforms and draw the same geometry are
+ * merged into one instanced draw at the position of the first of them, see Job::CanInstance
+ * \note Per draw constants of the queue are uploaded to the frame ring before the draws, see ConstantUploadRing
  */
 #pragma once
 
 #include "BindingPass.h"
 #include "Job.h"
+#include "TaskScheduler.h"
+#include "InstanceBuffer.h"
 
+#include <array>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 class RenderQueuePass : public BindingPass
 {
 public:
-	using BindingPass::BindingPass;
+	/**
+	 * @brief Ordering of the queue that is applied right before execution
+	*/
+	enum class SortMode
+	{
+		None,        // submission order
+		StateFirst,  // group by pipeline state, front-to-back inside a state group
+		FrontToBack, // by view depth, then state (early-z friendly)
+		BackToFront, // by view depth descending, then state (blending)
+	};
+
+	/**
+	 * @brief Per frame queue statistics
+	*/
+	struct Stats
+	{
+		size_t jobCount = 0u;
+		// number of times pipeline state key changes between consecutive jobs
+		size_t stateChanges = 0u;
+		float sortTime = 0.f;
+		size_t drawCalls = 0u;
+		// jobs that were drawn as instances and the instanced draws of them
+		size_t instancedJobs = 0u;
+		size_t instancedDraws = 0u;
+		// jobs that bound their vertex and index buffers, the others draw from those of the previous job
+		size_t geometryBinds = 0u;
+	};
+
+public:
+	RenderQueuePass( std::string name, std::vector<std::shared_ptr<Bindable>> binds = {}, SortMode sortMode = SortMode::StateFirst );
 	void Accept( Job job ) noexcept;
 	void Execute( Graphics& gfx ) const IFNOEXCEPT override;
 	void Reset() IFNOEXCEPT override;
+	void SetSortMode( SortMode mode ) noexcept { sortMode = mode; }
+	SortMode GetSortMode() const noexcept { return sortMode; }
+	/**
+	 * @brief Merging of jobs into instanced draws, queues sorted back to front are never merged
+	*/
+	void SetInstancing( bool enabled ) noexcept { instancing = enabled; }
+	bool IsInstancingEnabled() const noexcept { return instancing; }
+	const Stats& GetStats() const noexcept { return stats; }
+
+private:
+	/**
+	 * @brief Builds sort keys with current camera of the graphics and radix sorts the queue
+	*/
+	void SortJobs( Graphics& gfx ) const IFNOEXCEPT;
+	/**
+	 * @brief Moves jobs of every thread bucket into the execution queue
+	*/
+	void MergeBuckets() const noexcept;
+	/**
+	 * @brief Takes the slots of the drawables in the transform stage, so model matrices are read once per frame
+	*/
+	void AcquireTransforms( Graphics& gfx ) const;
+	/**
+	 * @brief Groups the jobs that can be drawn instanced and moves every group to the position of its first job
+	*/
+	void BuildBatches() const;
+	/**
+	 * @brief Gathers transforms of the batches into the instance buffer
+	*/
+	void UploadInstances( Graphics& gfx ) const;
+	/**
+	 * @brief Computes the transforms of the jobs that aren't drawn instanced for the camera of the pass in one batch
+	*/
+	void PrepareTransforms( Graphics& gfx ) const;
+	/**
+	 * @brief Stages the per draw constants of the jobs that aren't drawn instanced and uploads them with a single map
+	*/
+	void UploadConstants( Graphics& gfx ) const IFNOEXCEPT;
+	static uint64_t QuantizeDepth( float viewZ ) noexcept;
+
+private:
+	// padded to cache line, so the threads don't write to the same line on push_back
+	struct alignas( 64 ) Bucket
+	{
+		std::vector<Job> jobs;
+	};
+	// contiguous jobs of the queue that are drawn with a single draw call
+	struct Batch
+	{
+		size_t first;
+		size_t count;
+		uint32_t startInstance;
+	};
 
 private:
-	std::vector<Job> jobs;
-};
\ No newline at end of file
+	SortMode sortMode;
+	mutable std::array<Bucket, TaskScheduler::MAX_THREADS> buckets;
+	// queue is ordered in place during execution
+	mutable std::vector<Job> jobs;
+	mutable std::vector<Job> sortScratch;
+	mutable Stats stats;
+	bool instancing = true;
+	mutable std::vector<Batch> batches;
+	// batch of every job of the queue while batches are built
+	mutable std::vector<size_t> jobBatches;
+	mutable std::unordered_map<size_t, size_t> batchOfKey;
+	mutable std::vector<InstanceBuffer::Instance> instances;
+	// created on the first instanced draw, as passes are constructed without graphics
+	mutable std::unique_ptr<InstanceBuffer> pInstanceBuffer;
+};
@@ -10,12 +10,16 @@
 #include "Drawable.h"
 #include "RenderQueuePass.h"
 #include "RenderGraph.h"
+#include "BindableCommon.h"
+#include "IronUtils.h"
 
 RenderStep::RenderStep( std::string targetPassName ) :
 	targetPassName{ std::move( targetPassName ) }
 {}
 
 RenderStep::RenderStep( const RenderStep & src ) noexcept :
+	pInstancedShader( src.pInstancedShader ),
+	pInstancedLayout( src.pInstancedLayout ),
 	targetPassName( src.targetPassName )
 {
 	bindables.reserve( src.bindables.size() );
@@ -32,9 +36,9 @@ RenderStep::RenderStep( const RenderStep & src ) noexcept :
 	}
 }
 
-void RenderStep::Submit( const Drawable & drawable ) const
+void RenderStep::Submit( const Drawable & drawable, size_t lod, MeshletSet::Visible visible ) const
 {
-	pTargetPass->Accept( Job{ this, &drawable } );
+	pTargetPass->Accept( Job{ this, &drawable, lod, visible } );
 }
 
 void RenderStep::Bind( Graphics & gfx ) const IFNOEXCEPT
@@ -45,6 +49,38 @@ void RenderStep::Bind( Graphics & gfx ) const IFNOEXCEPT
 	}
 }
 
+void RenderStep::StageConstants( Graphics& gfx ) const IFNOEXCEPT
+{
+	for( const auto& b : bindables )
+	{
+		b->StageConstants( gfx );
+	}
+}
+
+void RenderStep::BindInstanced( Graphics& gfx ) const IFNOEXCEPT
+{
+	assert( IsInstanceable() );
+	for( auto* pb : sharedBindables )
+	{
+		pb->Bind( gfx );
+	}
+	pInstancedLayout->Bind( gfx );
+	pInstancedShader->Bind( gfx );
+}
+
+void RenderStep::SetInstancedShader( Graphics& gfx, const VertexLayout& layout, const std::wstring& path )
+{
+	pInstancedShader = VertexShader::Resolve( gfx, path );
+	pInstancedLayout = InputLayout::Resolve( gfx, layout, *pInstancedShader, true );
+}
+
+bool RenderStep::SharesBindables( const RenderStep& other ) const noexcept
+{
+	return pInstancedShader == other.pInstancedShader &&
+		pInstancedLayout == other.pInstancedLayout &&
+		sharedBindables == other.sharedBindables;
+}
+
 void RenderStep::InitializeParentReferences( const Drawable & parent ) noexcept
 {
 	for( auto& b : bindables )
@@ -66,4 +102,57 @@ void RenderStep::Link( RenderGraph & rg )
 {
 	assert( !pTargetPass );
 	pTargetPass = &rg.GetRenderQueue( targetPassName );
+	UpdateStateKey();
+	UpdateInstanceKey();
+}
+
+void RenderStep::UpdateStateKey() noexcept
+{
+	size_t shaderHash = 0u;
+	size_t fixedHash = 0u;
+	size_t resourceHash = 0u;
+	for( const auto& pb : bindables )
+	{
+		const Bindable* p = pb.get();
+		// cloned bindables (transforms etc.) are unique per drawable, they can't be shared between jobs
+		if( dynamic_cast<const CloningBindable*>( p ) )
+		{
+			continue;
+		}
+		if( dynamic_cast<const VertexShader*>( p ) || dynamic_cast<const PixelShader*>( p ) )
+		{
+			hash_combine( shaderHash, p );
+		}
+		else if( dynamic_cast<const InputLayout*>( p ) || dynamic_cast<const RasterizerState*>( p ) ||
+			dynamic_cast<const BlendState*>( p ) || dynamic_cast<const DepthStencilState*>( p ) )
+		{
+			hash_combine( fixedHash, p );
+		}
+		else // textures, samplers, material buffers
+		{
+			hash_combine( resourceHash, p );
+		}
+	}
+	// [shaders:16][fixed function:8][resources:16]
+	stateKey =
+		( uint64_t( shaderHash & 0xFFFFu ) << 24u ) |
+		( uint64_t( fixedHash & 0xFFu ) << 16u ) |
+		uint64_t( resourceHash & 0xFFFFu );
+	static_assert( STATE_KEY_BITS == 40u, "State key packing must match STATE_KEY_BITS" );
+}
+
+void RenderStep::UpdateInstanceKey() noexcept
+{
+	sharedBindables.clear();
+	instanceKey = hash_values( pInstancedShader.get(), pInstancedLayout.get() );
+	for( const auto& pb : bindables )
+	{
+		Bindable* p = pb.get();
+		if( dynamic_cast<const CloningBindable*>( p ) || dynamic_cast<const VertexShader*>( p ) || dynamic_cast<const InputLayout*>( p ) )
+		{
+			continue;
+		}
+		sharedBindables.push_back( p );
+		hash_combine( instanceKey, p );
+	}
 }
\ No newline at end of file
@@ -11,11 +11,15 @@
 #include "Graphics.h"
 #include "Bindable.h"
 #include "TechniqueProbe.h"
+#include "MeshletSet.h"
 
 #include <vector>
 
 class RenderQueuePass;
 class RenderGraph;
+class VertexLayout;
+class VertexShader;
+class InputLayout;
 
 /**
  * @brief Class that is responsible for submitting steps of the object rendering
@@ -30,11 +34,37 @@ public:
 	RenderStep& operator=( const RenderStep& ) = delete;
 	RenderStep& operator=( RenderStep&& ) = delete;
 	void AddBindable( std::shared_ptr<Bindable> bind_in ) noexcept { bindables.push_back( std::move( bind_in ) ); }
-	void Submit( const class Drawable& drawable ) const;
+	void Submit( const class Drawable& drawable, size_t lod = 0u, MeshletSet::Visible visible = {} ) const;
 	void Bind( Graphics& gfx ) const IFNOEXCEPT;
+	void StageConstants( Graphics& gfx ) const IFNOEXCEPT;
 	void InitializeParentReferences( const class Drawable& parent ) noexcept;
 	void Accept( TechniqueProbe& probe );
 	void Link( RenderGraph& rg );
+	/**
+	 * @brief Identity of the pipeline state that is set by the step bindables
+	 * * (shaders in the top bits, then fixed function states, then resources)
+	 * @return key that fits in STATE_KEY_BITS bits, valid after linking
+	*/
+	uint64_t GetStateKey() const noexcept { return stateKey; }
+	/**
+	 * @brief Sets the variant of the step vertex shader that reads model transforms from the instance buffer,
+	 * * jobs of steps with the same bindables that draw the same geometry are then merged into instanced draws
+	 * @param layout vertex layout of the geometry that is drawn with the step
+	*/
+	void SetInstancedShader( Graphics& gfx, const VertexLayout& layout, const std::wstring& path );
+	bool IsInstanceable() const noexcept { return pInstancedShader != nullptr; }
+	/**
+	 * @brief Binds the bindables that are shared by the instances and the instanced shader with its layout
+	*/
+	void BindInstanced( Graphics& gfx ) const IFNOEXCEPT;
+	/**
+	 * @brief Hash of the shared bindables, equal for steps that can be drawn as instances of each other
+	 * @return key that is valid after linking
+	*/
+	size_t GetInstanceKey() const noexcept { return instanceKey; }
+	bool SharesBindables( const RenderStep& other ) const noexcept;
+
+	static constexpr unsigned STATE_KEY_BITS = 40u;
 
 protected:
 	/**
@@ -45,10 +75,20 @@ protected:
 	template<typename B>
 	B* QueryBindable() const;
 
+private:
+	void UpdateStateKey() noexcept;
+	void UpdateInstanceKey() noexcept;
+
 private:
 	std::vector<std::shared_ptr<Bindable>> bindables;
+	std::shared_ptr<VertexShader> pInstancedShader;
+	std::shared_ptr<InputLayout> pInstancedLayout;
+	// bindables except the cloned ones and the shader and layout that the instanced variants replace
+	std::vector<Bindable*> sharedBindables;
+	size_t instanceKey = 0u;
 	RenderQueuePass* pTargetPass = nullptr;
 	std::string targetPassName;
+	uint64_t stateKey = 0u;
 };
 
 template<typename B>
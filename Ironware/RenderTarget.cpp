@@ -90,6 +90,7 @@ void RenderTarget::BindAsBuffer( Graphics& gfx, ID3D11DepthStencilView* pDepthSt
 {
 	INFOMAN_NOHR( gfx );
 	GFX_CALL_THROW_INFO_ONLY( GetContext( gfx )->OMSetRenderTargets( 1, pTargetView.GetAddressOf(), pDepthStencilView ) );
+	GetStateCache( gfx ).OutputTargetsChanged();
 
 	// configure viewport
 	D3D11_VIEWPORT vp;
@@ -145,6 +146,10 @@ ShaderInputRenderTarget::ShaderInputRenderTarget( Graphics& gfx, UINT width, UIN
 
 void ShaderInputRenderTarget::Bind( Graphics& gfx ) IFNOEXCEPT
 {
+	if( !GetStateCache( gfx ).Set( PipelineStateCache::Stage::PSShaderResource, slot, pShaderResourceView.Get() ) )
+	{
+		return;
+	}
 	INFOMAN_NOHR( gfx );
 	GFX_CALL_THROW_INFO_ONLY( GetContext( gfx )->PSSetShaderResources( slot, 1, pShaderResourceView.GetAddressOf() ) );
 }
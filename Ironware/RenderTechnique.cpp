@@ -36,13 +36,13 @@ void RenderTechnique::Accept( TechniqueProbe & probe )
 	}
 }
 
-void RenderTechnique::Submit( const Drawable & drawable, size_t channelFilter ) const noexcept
+void RenderTechnique::Submit( const Drawable & drawable, size_t channelFilter, size_t lod, MeshletSet::Visible visible ) const noexcept
 {
 	if( active && ( ( channels & channelFilter ) != 0ull ) )
 	{
 		for( const auto& step : steps )
 		{
-			step.Submit( drawable );
+			step.Submit( drawable, lod, visible );
 		}
 	}
 }
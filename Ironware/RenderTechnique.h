@@ -28,7 +28,7 @@ public:
 	void Accept( TechniqueProbe& probe );
 	void Link( RenderGraph& rg );
 	void AddStep( RenderStep step ) noexcept { steps.push_back( std::move( step ) ); }
-	void Submit( const Drawable& drawable, size_t channelFilter ) const noexcept;
+	void Submit( const Drawable& drawable, size_t channelFilter, size_t lod = 0u, MeshletSet::Visible visible = {} ) const noexcept;
 	bool IsActive() const noexcept { return active; }
 	void SetActive( bool active_val ) noexcept { active = active_val; }
 	const std::wstring& GetName() const noexcept { return name; }
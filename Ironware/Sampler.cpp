@@ -39,8 +39,10 @@ Sampler::Sampler( Graphics & gfx, Type type, bool reflect, UINT slot ) :
 
 void Sampler::Bind( Graphics & gfx ) IFNOEXCEPT
 {
-	INFOMAN_NOHR( gfx );
-	GetContext( gfx )->PSSetSamplers( slot, 1u, pSampler.GetAddressOf() );
+	if( GetStateCache( gfx ).Set( PipelineStateCache::Stage::PSSampler, slot, pSampler.Get() ) )
+	{
+		GetContext( gfx )->PSSetSamplers( slot, 1u, pSampler.GetAddressOf() );
+	}
 }
 
 std::wstring Sampler::GenerateUID( Type type, bool reflect, UINT slot )
@@ -44,6 +44,7 @@ public:
 	Sampler( Graphics& gfx, Type type, bool reflect, UINT slot = 0u );
 	void Bind( Graphics& gfx ) IFNOEXCEPT override;
 	static std::shared_ptr<Sampler> Resolve( Graphics& gfx, Type type = Type::Anisotropic, bool reflect = false, UINT slot = 0u ) { return BindableCollection::Resolve<Sampler>( gfx, type, reflect, slot ); }
+	static size_t GenerateKey( Type type, bool reflect, UINT slot ) noexcept { return hash_values( type, reflect, slot ); }
 	static std::wstring GenerateUID( Type type, bool reflect, UINT slot );
 	std::wstring GetUID() const noexcept override { return GenerateUID( type, reflection, slot ); }
 
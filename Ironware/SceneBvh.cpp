@@ -0,0 +1,160 @@
+/*!
+ * \file SceneBvh.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ *
+ */
+#include "SceneBvh.h"
+#include "Model.h"
+#include "Mesh.h"
+#include "Frustum.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+namespace dx = DirectX;
+
+void SceneBvh::AddModel( Model& model )
+{
+	models.push_back( &model );
+	for( size_t i = 0; i < model.GetInstanceCount(); i++ )
+	{
+		items.push_back( { &model, &model.GetInstanceMesh( i ), (uint32_t)i } );
+	}
+	built = false;
+}
+
+void SceneBvh::Update()
+{
+	if( !built )
+	{
+		GatherBoxes();
+		bvh.Build( boxes );
+		built = true;
+		return;
+	}
+
+	const bool moved = std::any_of( models.begin(), models.end(), []( const Model* pModel )
+	{
+		return pModel->WereTransformsUpdated();
+	} );
+	if( moved )
+	{
+		GatherBoxes();
+		bvh.Refit( boxes );
+	}
+}
+
+void SceneBvh::Submit( size_t channelFilter, const Frustum& frustum, TaskScheduler& scheduler, TaskScheduler::Group& group ) const
+{
+	scheduler.Run( group, [this, channelFilter, &frustum, &scheduler, &group]
+	{
+		// shared by the submission tasks, released by the last of them
+		auto pVisible = std::make_shared<std::vector<uint32_t>>();
+		bvh.Query( frustum, *pVisible );
+		frustum.AddStats( pVisible->size(), items.size() - pVisible->size() );
+		for( size_t begin = 0; begin < pVisible->size(); begin += PARALLEL_CHUNK_SIZE )
+		{
+			const size_t end = std::min( begin + PARALLEL_CHUNK_SIZE, pVisible->size() );
+			scheduler.Run( group, [this, pVisible, channelFilter, &frustum, begin, end]
+			{
+				for( size_t i = begin; i < end; i++ )
+				{
+					const auto item = ( *pVisible )[i];
+					const auto& box = boxes[item];
+					const dx::XMFLOAT3 center = { ( box.min.x + box.max.x ) * 0.5f, ( box.min.y + box.max.y ) * 0.5f, ( box.min.z + box.max.z ) * 0.5f };
+					const dx::XMFLOAT3 extents = { ( box.max.x - box.min.x ) * 0.5f, ( box.max.y - box.min.y ) * 0.5f, ( box.max.z - box.min.z ) * 0.5f };
+					items[item].pMesh->Submit( channelFilter, frustum, center, extents );
+				}
+			} );
+		}
+	} );
+}
+
+std::optional<SceneBvh::PickResult> SceneBvh::Pick( const Ray& ray ) const noexcept
+{
+	if( const auto hit = bvh.Raycast( ray ) )
+	{
+		const auto& item = items[hit->item];
+		return PickResult{ item.pModel, item.pModel->GetInstanceNode( item.instance ), hit->distance };
+	}
+	return std::nullopt;
+}
+
+void SceneBvh::Benchmark( size_t copies, const Frustum& frustum, const Ray& ray )
+{
+	using namespace std::chrono;
+	constexpr size_t frustumQueries = 100u;
+	constexpr size_t rayQueries = 1000u;
+
+	GatherBoxes();
+	if( boxes.empty() || copies == 0u )
+	{
+		return;
+	}
+
+	// copies are laid out next to each other along x
+	float minX = boxes.front().min.x;
+	float maxX = boxes.front().max.x;
+	for( const auto& b : boxes )
+	{
+		minX = std::min( minX, b.min.x );
+		maxX = std::max( maxX, b.max.x );
+	}
+	const float stride = ( maxX - minX ) * 1.1f;
+	std::vector<BoundingVolumeHierarchy::Box> benchBoxes;
+	benchBoxes.reserve( boxes.size() * copies );
+	for( size_t c = 0; c < copies; c++ )
+	{
+		const float offset = stride * c;
+		for( const auto& b : boxes )
+		{
+			benchBoxes.push_back( { { b.min.x + offset, b.min.y, b.min.z }, { b.max.x + offset, b.max.y, b.max.z } } );
+		}
+	}
+
+	BoundingVolumeHierarchy benchBvh;
+	benchBvh.Build( benchBoxes );
+	benchBvh.Refit( benchBoxes );
+
+	std::vector<uint32_t> visible;
+	visible.reserve( benchBoxes.size() );
+	auto start = steady_clock::now();
+	for( size_t i = 0; i < frustumQueries; i++ )
+	{
+		visible.clear();
+		benchBvh.Query( frustum, visible );
+	}
+	const float frustumTime = duration<float, std::milli>( steady_clock::now() - start ).count();
+
+	start = steady_clock::now();
+	for( size_t i = 0; i < rayQueries; i++ )
+	{
+		benchBvh.Raycast( ray );
+	}
+	const float rayTime = duration<float, std::milli>( steady_clock::now() - start ).count();
+
+	const auto& s = benchBvh.GetStats();
+	benchStats.copies = copies;
+	benchStats.itemCount = s.itemCount;
+	benchStats.nodeCount = s.nodeCount;
+	benchStats.buildTime = s.buildTime;
+	benchStats.refitTime = s.refitTime;
+	benchStats.frustumQueryTime = frustumTime / frustumQueries;
+	benchStats.rayQueryTime = rayTime / rayQueries;
+}
+
+void SceneBvh::GatherBoxes()
+{
+	boxes.resize( items.size() );
+	for( size_t i = 0; i < items.size(); i++ )
+	{
+		dx::XMFLOAT3 c;
+		dx::XMFLOAT3 e;
+		items[i].pModel->GetInstanceBounds( items[i].instance, c, e );
+		boxes[i] = { { c.x - e.x, c.y - e.y, c.z - e.z }, { c.x + e.x, c.y + e.y, c.z + e.z } };
+	}
+}
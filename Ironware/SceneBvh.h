@@ -0,0 +1,91 @@
+/*!
+ * \file SceneBvh.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Bounding volume hierarchy over the mesh instances of all registered models
+ *
+ * \note Hierarchy is built once and refitted when node transforms of any model change,
+ * so it should be updated after the models have updated their transforms
+ */
+#pragma once
+
+#include "BoundingVolumeHierarchy.h"
+#include "TaskScheduler.h"
+#include "IronMath.h"
+
+#include <optional>
+#include <vector>
+
+class Model;
+class Mesh;
+class Frustum;
+
+class SceneBvh
+{
+public:
+	struct PickResult
+	{
+		Model* pModel;
+		uint32_t nodeId;
+		float distance;
+	};
+
+	struct BenchmarkStats
+	{
+		size_t copies = 0u;
+		size_t itemCount = 0u;
+		size_t nodeCount = 0u;
+		float buildTime = 0.f;
+		float refitTime = 0.f;
+		// average time of a single query
+		float frustumQueryTime = 0.f;
+		float rayQueryTime = 0.f;
+	};
+
+public:
+	void AddModel( Model& model );
+	/**
+	 * @brief Builds the hierarchy on first call or after models were added, refits it when models moved
+	*/
+	void Update();
+	/**
+	 * @brief Queues frustum query and submission of the visible meshes to the scheduler
+	 * @note Frustum has to outlive the group
+	*/
+	void Submit( size_t channelFilter, const Frustum& frustum, TaskScheduler& scheduler, TaskScheduler::Group& group ) const;
+	/**
+	 * @brief Finds node whose mesh bounds are hit first by the ray
+	*/
+	std::optional<PickResult> Pick( const Ray& ray ) const noexcept;
+	/**
+	 * @brief Times build, refit and queries of a hierarchy over the scene duplicated the given number of times
+	*/
+	void Benchmark( size_t copies, const Frustum& frustum, const Ray& ray );
+	const BoundingVolumeHierarchy::Stats& GetStats() const noexcept { return bvh.GetStats(); }
+	const BenchmarkStats& GetBenchmarkStats() const noexcept { return benchStats; }
+
+private:
+	struct Item
+	{
+		Model* pModel;
+		const Mesh* pMesh;
+		uint32_t instance;
+	};
+
+private:
+	void GatherBoxes();
+
+private:
+	// visible items submitted by a single task
+	static constexpr size_t PARALLEL_CHUNK_SIZE = 64u;
+
+private:
+	std::vector<Model*> models;
+	std::vector<Item> items;
+	std::vector<BoundingVolumeHierarchy::Box> boxes;
+	BoundingVolumeHierarchy bvh;
+	bool built = false;
+	BenchmarkStats benchStats;
+};
@@ -0,0 +1,2 @@
+#define IR_INSTANCED
+#include "Shadow_VS.hlsl"
\ No newline at end of file
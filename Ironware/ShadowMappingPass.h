@@ -34,7 +34,7 @@ public:
 	}
 
 	ShadowMappingPass( Graphics& gfx, std::string name ) :
-		RenderQueuePass( std::move( name ) )
+		RenderQueuePass( std::move( name ), {}, SortMode::FrontToBack )
 	{
 		depthStencil = std::make_unique<ShaderInputDepthStencil>( gfx, 3, DepthStencilView::Usage::ShadowDepth );
 		AddBind( VertexShader::Resolve( gfx, L"Solid_VS.cso" ) );
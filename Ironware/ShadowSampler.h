@@ -14,7 +14,13 @@ class ShadowSampler : public Bindable
 {
 public:
 	ShadowSampler( Graphics& gfx );
-	void Bind( Graphics& gfx ) IFNOEXCEPT override { GetContext( gfx )->PSSetSamplers( 1u, 1u, pSampler.GetAddressOf() ); };
+	void Bind( Graphics& gfx ) IFNOEXCEPT override
+	{
+		if( GetStateCache( gfx ).Set( PipelineStateCache::Stage::PSSampler, 1u, pSampler.Get() ) )
+		{
+			GetContext( gfx )->PSSetSamplers( 1u, 1u, pSampler.GetAddressOf() );
+		}
+	}
 
 protected:
 	Microsoft::WRL::ComPtr<ID3D11SamplerState> pSampler;
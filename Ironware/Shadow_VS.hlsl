@@ -10,8 +10,9 @@ struct VSOut
     float4 pos : SV_Position;
 };
 
-VSOut main( float3 pos : Position, float3 n : Normal, float2 tc : Texcoord )
+VSOut main( float3 pos : Position, float3 n : Normal, float2 tc : Texcoord IR_INSTANCE_INPUT )
 {
+    IR_LOAD_TRANSFORMS();
     VSOut vso;
     vso.viewPos = (float3)mul( float4( pos, 1.f ), modelView );
     vso.viewNormal = mul( n, (float3x3)modelView );
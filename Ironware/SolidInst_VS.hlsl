@@ -0,0 +1,2 @@
+#define IR_INSTANCED
+#include "Solid_VS.hlsl"
\ No newline at end of file
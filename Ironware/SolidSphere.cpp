@@ -44,6 +44,7 @@ SolidSphere::SolidSphere( Graphics& gfx, float radius )
 		auto pVertexShader = VertexShader::Resolve( gfx, L"Solid_VS.cso" );
 
 		only.AddBindable( InputLayout::Resolve( gfx, vbuff.GetLayout(), *pVertexShader ) );
+		only.SetInstancedShader( gfx, vbuff.GetLayout(), L"SolidInst_VS.cso" );
 
 		only.AddBindable( std::move( pVertexShader ) );
 
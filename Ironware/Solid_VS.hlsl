@@ -1,10 +1,7 @@
-cbuffer CBuf
-{
-    matrix modelView;
-    matrix modelViewProj;
-};
+#include "CommonTransforms.hlsli"
 
-float4 main( float3 pos : Position ) : SV_Position
+float4 main( float3 pos : Position IR_INSTANCE_INPUT ) : SV_Position
 {
-    return mul( float4( pos, 1.f ), modelViewProj );
+    IR_LOAD_TRANSFORMS();
+    return mul( float4( pos, 1.f ), modelViewProjection );
 }
\ No newline at end of file
@@ -62,18 +62,18 @@ public:
 		// =======================================================================
 		// add the cap vertices
 		// -----------------------------------------------------------------------
-		const auto iNorthPole = (uint16_t)vertices.size();
+		const auto iNorthPole = (uint32_t)vertices.size();
 		vertices.emplace_back();
 		dx::XMStoreFloat3( &vertices.back().pos, base );
-		const auto iSouthPole = (uint16_t)vertices.size();
+		const auto iSouthPole = (uint32_t)vertices.size();
 		vertices.emplace_back();
 		dx::XMStoreFloat3( &vertices.back().pos, dx::XMVectorNegate( base ) );
 		// TODO: remove latDiv
-		const auto calcIdx = [longDiv]( uint16_t iLong, uint16_t iLat )
+		const auto calcIdx = [longDiv]( uint32_t iLong, uint32_t iLat )
 		{
 			return iLat * longDiv + iLong;
 		};
-		std::vector<uint16_t> indices;
+		std::vector<uint32_t> indices;
 		// latdiv - 2, because we haven't set 2 rows of the vector
 		// we skipped the first & last rows.
 		for( uint16_t iLat = 0; iLat < latDiv - 2; iLat++ )
@@ -0,0 +1,387 @@
+/*!
+ * \file StaticBatcher.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ *
+ */
+#include "StaticBatcher.h"
+#include "CookedModel.h"
+#include "IronMath.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <utility>
+
+namespace dx = DirectX;
+
+struct StaticBatcher::Instance
+{
+	uint32_t mesh;
+	// transform of the node relative to the root
+	dx::XMFLOAT4X4 transform;
+	// bounds in the space of the root
+	dx::XMFLOAT3 center;
+	dx::XMFLOAT3 extents;
+};
+
+namespace
+{
+	uint32_t read_index( const std::byte* pIndices, IndexByteBuffer::Format format, size_t i ) noexcept
+	{
+		if( format == IndexByteBuffer::Format::UInt16 )
+		{
+			uint16_t index;
+			std::memcpy( &index, pIndices + i * sizeof( uint16_t ), sizeof( uint16_t ) );
+			return index;
+		}
+		uint32_t index;
+		std::memcpy( &index, pIndices + i * sizeof( uint32_t ), sizeof( uint32_t ) );
+		return index;
+	}
+
+	Drawable::Lod get_level( const StaticBatcher::Source& mesh, size_t level ) noexcept
+	{
+		if( mesh.lods.empty() )
+		{
+			return { 0u, (UINT)mesh.indexCount, 0.f };
+		}
+		return mesh.lods[std::min( level, mesh.lods.size() - 1u )];
+	}
+
+	void normalize_stream( StridedView<dx::XMFLOAT3> view ) noexcept
+	{
+		for( auto& v : view )
+		{
+			dx::XMStoreFloat3( &v, dx::XMVector3Normalize( dx::XMLoadFloat3( &v ) ) );
+		}
+	}
+
+	/**
+	 * @brief Transforms packed directions in place, w is multiplied by the sign
+	*/
+	void transform_packed_stream( StridedView<dx::PackedVector::XMSHORTN4> view, dx::FXMMATRIX matrix, float wSign ) noexcept
+	{
+		for( auto& v : view )
+		{
+			const auto packed = dx::PackedVector::XMLoadShortN4( &v );
+			const auto direction = dx::XMVector3Normalize( dx::XMVector3TransformNormal( packed, matrix ) );
+			dx::PackedVector::XMStoreShortN4( &v, dx::XMVectorSetW( direction, dx::XMVectorGetW( packed ) * wSign ) );
+		}
+	}
+}
+
+StaticBatcher::Source StaticBatcher::MakeSource( const Mesh::Data& data, const VertexLayout& layout, uint32_t materialIndex )
+{
+	return {
+		&layout, materialIndex,
+		data.vertices.GetData(), data.vertices.Size(),
+		data.indices.GetData(), data.indices.GetFormat(), data.indices.Count(),
+		data.boundsCenter, data.boundsExtents, data.lods
+	};
+}
+
+StaticBatcher::Source StaticBatcher::MakeSource( const CookedModel& cooked, size_t mesh, const VertexLayout& layout )
+{
+	auto view = cooked.GetMesh( mesh );
+	return {
+		&layout, view.materialIndex,
+		view.pVertices, view.vertexBytes / layout.Size(),
+		view.pIndices, view.indexFormat, view.indexCount,
+		view.boundsCenter, view.boundsExtents, std::move( view.lods )
+	};
+}
+
+StaticBatcher::Result StaticBatcher::Build( const std::vector<Source>& meshes, const std::vector<Model::NodeDesc>& nodes, float scale, const std::wstring& tag )
+{
+	const auto start = std::chrono::steady_clock::now();
+	Result result;
+	result.nodes = nodes;
+	result.meshRemap.resize( meshes.size() );
+	if( nodes.empty() )
+	{
+		for( uint32_t i = 0; i < meshes.size(); i++ )
+		{
+			result.meshRemap[i] = i;
+		}
+		result.keptMeshCount = meshes.size();
+		return result;
+	}
+
+	// transforms of the nodes as the hierarchy builds them before anything is applied, relative to the root
+	std::vector<dx::XMFLOAT4X4> world( nodes.size() );
+	for( size_t i = 0; i < nodes.size(); i++ )
+	{
+		const auto local = scale_translation( dx::XMLoadFloat4x4( &nodes[i].transform ), scale );
+		dx::XMStoreFloat4x4( &world[i], i == 0u ? local : local * dx::XMLoadFloat4x4( &world[nodes[i].parent] ) );
+	}
+	const auto toRoot = dx::XMMatrixInverse( nullptr, dx::XMLoadFloat4x4( &world[0] ) );
+
+	// every mesh reference, in the order of the nodes and of their mesh lists
+	std::vector<Instance> instances;
+	auto minPos = dx::XMVectorReplicate( FLT_MAX );
+	auto maxPos = dx::XMVectorReplicate( -FLT_MAX );
+	for( size_t i = 0; i < nodes.size(); i++ )
+	{
+		const auto transform = dx::XMLoadFloat4x4( &world[i] ) * toRoot;
+		for( const auto m : nodes[i].meshes )
+		{
+			Instance instance = { m };
+			dx::XMStoreFloat4x4( &instance.transform, transform );
+			const auto& e = meshes[m].boundsExtents;
+			const auto extents = dx::XMVectorAdd( dx::XMVectorAdd(
+				dx::XMVectorScale( dx::XMVectorAbs( transform.r[0] ), e.x ),
+				dx::XMVectorScale( dx::XMVectorAbs( transform.r[1] ), e.y ) ),
+				dx::XMVectorScale( dx::XMVectorAbs( transform.r[2] ), e.z ) );
+			const auto center = dx::XMVector3Transform( dx::XMLoadFloat3( &meshes[m].boundsCenter ), transform );
+			dx::XMStoreFloat3( &instance.center, center );
+			dx::XMStoreFloat3( &instance.extents, extents );
+			minPos = dx::XMVectorMin( minPos, dx::XMVectorSubtract( center, extents ) );
+			maxPos = dx::XMVectorMax( maxPos, dx::XMVectorAdd( center, extents ) );
+			instances.push_back( instance );
+		}
+	}
+	result.stats.instanceCount = instances.size();
+	dx::XMFLOAT3 size;
+	dx::XMStoreFloat3( &size, dx::XMVectorSubtract( maxPos, minPos ) );
+	const float maxExtent = std::max( { size.x, size.y, size.z } ) * MAX_BATCH_EXTENT;
+
+	// references of a material, empty meshes can't be merged
+	std::map<uint32_t, std::vector<uint32_t>> groups;
+	for( uint32_t i = 0; i < instances.size(); i++ )
+	{
+		const auto& mesh = meshes[instances[i].mesh];
+		if( mesh.vertexCount > 0u && mesh.indexCount > 0u && mesh.pLayout->Has( VertexLayout::ElementType::Position3D ) )
+		{
+			groups[mesh.materialIndex].push_back( i );
+		}
+	}
+
+	// groups are halved along the axis of the widest spread until they are small enough
+	std::vector<std::pair<uint32_t*, uint32_t*>> leaves;
+	const auto split = [&]( auto& self, uint32_t* pFirst, uint32_t* pLast ) -> void
+	{
+		auto lo = dx::XMVectorReplicate( FLT_MAX );
+		auto hi = dx::XMVectorReplicate( -FLT_MAX );
+		auto centerLo = dx::XMVectorReplicate( FLT_MAX );
+		auto centerHi = dx::XMVectorReplicate( -FLT_MAX );
+		size_t vertices = 0u;
+		for( auto p = pFirst; p != pLast; p++ )
+		{
+			const auto& instance = instances[*p];
+			const auto center = dx::XMLoadFloat3( &instance.center );
+			const auto extents = dx::XMLoadFloat3( &instance.extents );
+			lo = dx::XMVectorMin( lo, dx::XMVectorSubtract( center, extents ) );
+			hi = dx::XMVectorMax( hi, dx::XMVectorAdd( center, extents ) );
+			centerLo = dx::XMVectorMin( centerLo, center );
+			centerHi = dx::XMVectorMax( centerHi, center );
+			vertices += meshes[instance.mesh].vertexCount;
+		}
+		dx::XMFLOAT3 bounds;
+		dx::XMStoreFloat3( &bounds, dx::XMVectorSubtract( hi, lo ) );
+		const size_t count = size_t( pLast - pFirst );
+		if( count < 2u || ( vertices <= MAX_BATCH_VERTICES && std::max( { bounds.x, bounds.y, bounds.z } ) <= maxExtent ) )
+		{
+			leaves.emplace_back( pFirst, pLast );
+			return;
+		}
+		dx::XMFLOAT3 spread;
+		dx::XMStoreFloat3( &spread, dx::XMVectorSubtract( centerHi, centerLo ) );
+		const size_t axis = spread.x >= spread.y && spread.x >= spread.z ? 0u : ( spread.y >= spread.z ? 1u : 2u );
+		const auto pMid = pFirst + count / 2u;
+		std::nth_element( pFirst, pMid, pLast, [&]( uint32_t lhs, uint32_t rhs )
+		{
+			return ( &instances[lhs].center.x )[axis] < ( &instances[rhs].center.x )[axis];
+		} );
+		self( self, pFirst, pMid );
+		self( self, pMid, pLast );
+	};
+	for( auto& [material, group] : groups )
+	{
+		split( split, group.data(), group.data() + group.size() );
+	}
+
+	// a single reference gains nothing from merging, it keeps its mesh with the levels and meshlets
+	std::vector<bool> merged( instances.size(), false );
+	for( const auto& [pFirst, pLast] : leaves )
+	{
+		if( pLast - pFirst < 2 )
+		{
+			continue;
+		}
+		std::sort( pFirst, pLast );
+		for( auto p = pFirst; p != pLast; p++ )
+		{
+			merged[*p] = true;
+		}
+		const auto material = meshes[instances[*pFirst].mesh].materialIndex;
+		auto data = Merge( meshes, instances, pFirst, pLast, tag + L"#batch" + std::to_wstring( result.batches.size() ) );
+		result.batches.push_back( { material, std::move( data ) } );
+		result.stats.batchedInstanceCount += size_t( pLast - pFirst );
+	}
+	result.stats.batchCount = result.batches.size();
+
+	// meshes that lost all their references are dropped, the rest keep their order
+	std::vector<size_t> references( meshes.size(), 0u );
+	std::vector<size_t> kept( meshes.size(), 0u );
+	size_t instance = 0u;
+	for( auto& node : result.nodes )
+	{
+		std::vector<uint32_t> remaining;
+		for( const auto m : node.meshes )
+		{
+			references[m]++;
+			if( !merged[instance++] )
+			{
+				remaining.push_back( m );
+				kept[m]++;
+			}
+		}
+		node.meshes = std::move( remaining );
+	}
+	for( size_t m = 0; m < meshes.size(); m++ )
+	{
+		// meshes that no node referenced are left as they were
+		result.meshRemap[m] = references[m] > 0u && kept[m] == 0u ? NO_MESH : uint32_t( result.keptMeshCount++ );
+	}
+	for( auto& node : result.nodes )
+	{
+		for( auto& m : node.meshes )
+		{
+			m = result.meshRemap[m];
+		}
+	}
+	for( size_t b = 0; b < result.batches.size(); b++ )
+	{
+		result.nodes[0].meshes.push_back( uint32_t( result.keptMeshCount + b ) );
+	}
+
+	result.stats.buildTime = std::chrono::duration<float, std::milli>( std::chrono::steady_clock::now() - start ).count();
+	return result;
+}
+
+Mesh::Data StaticBatcher::Merge( const std::vector<Source>& meshes, const std::vector<Instance>& instances,
+	const uint32_t* pFirst, const uint32_t* pLast, std::wstring tag )
+{
+	using Type = VertexLayout::ElementType;
+	const auto& layout = *meshes[instances[*pFirst].mesh].pLayout;
+	const size_t stride = layout.Size();
+	size_t vertexCount = 0u;
+	size_t levelCount = 1u;
+	for( auto p = pFirst; p != pLast; p++ )
+	{
+		const auto& mesh = meshes[instances[*p].mesh];
+		vertexCount += mesh.vertexCount;
+		levelCount = std::max( levelCount, mesh.lods.size() );
+	}
+
+	Mesh::Data data{ std::move( tag ), VertexByteBuffer( layout, vertexCount ) };
+	std::vector<uint32_t> indices;
+	std::vector<uint32_t> baseVertices;
+	size_t base = 0u;
+	for( auto p = pFirst; p != pLast; p++ )
+	{
+		const auto& instance = instances[*p];
+		const auto& mesh = meshes[instance.mesh];
+		std::memcpy( data.vertices.GetData() + base * stride, mesh.pVertices, mesh.vertexCount * stride );
+
+		// normals go through the inverse transpose, mirroring flips the winding and the bitangent sign
+		const auto transform = dx::XMLoadFloat4x4( &instance.transform );
+		const auto normalTransform = dx::XMMatrixTranspose( dx::XMMatrixInverse( nullptr, transform ) );
+		const bool mirrored = dx::XMVectorGetX( dx::XMMatrixDeterminant( transform ) ) < 0.f;
+		const size_t end = base + mesh.vertexCount;
+		transform_coord_stream( data.vertices.View<Type::Position3D>().Slice( base, end ), transform );
+		if( layout.Has( Type::Normal ) )
+		{
+			const auto normals = data.vertices.View<Type::Normal>().Slice( base, end );
+			transform_normal_stream( normals, normalTransform );
+			normalize_stream( normals );
+		}
+		if( layout.Has( Type::Tangent ) )
+		{
+			const auto tangents = data.vertices.View<Type::Tangent>().Slice( base, end );
+			transform_normal_stream( tangents, transform );
+			normalize_stream( tangents );
+		}
+		if( layout.Has( Type::Bitangent ) )
+		{
+			const auto bitangents = data.vertices.View<Type::Bitangent>().Slice( base, end );
+			transform_normal_stream( bitangents, transform );
+			normalize_stream( bitangents );
+		}
+		if( layout.Has( Type::NormalPacked ) )
+		{
+			transform_packed_stream( data.vertices.View<Type::NormalPacked>().Slice( base, end ), normalTransform, 1.f );
+		}
+		if( layout.Has( Type::TangentFrame ) )
+		{
+			transform_packed_stream( data.vertices.View<Type::TangentFrame>().Slice( base, end ), transform, mirrored ? -1.f : 1.f );
+		}
+
+		const auto full = get_level( mesh, 0u );
+		for( size_t i = full.startIndex; i < full.startIndex + full.indexCount; i += 3u )
+		{
+			const auto i0 = read_index( mesh.pIndices, mesh.indexFormat, i );
+			const auto i1 = read_index( mesh.pIndices, mesh.indexFormat, i + 1u );
+			const auto i2 = read_index( mesh.pIndices, mesh.indexFormat, i + 2u );
+			indices.push_back( uint32_t( base ) + i0 );
+			indices.push_back( uint32_t( base ) + ( mirrored ? i2 : i1 ) );
+			indices.push_back( uint32_t( base ) + ( mirrored ? i1 : i2 ) );
+		}
+		baseVertices.push_back( uint32_t( base ) );
+		base = end;
+	}
+
+	const auto positions = std::as_const( data.vertices ).View<Type::Position3D>();
+	auto minPos = dx::XMVectorReplicate( FLT_MAX );
+	auto maxPos = dx::XMVectorReplicate( -FLT_MAX );
+	for( const auto& p : positions )
+	{
+		const auto pos = dx::XMLoadFloat3( &p );
+		minPos = dx::XMVectorMin( minPos, pos );
+		maxPos = dx::XMVectorMax( maxPos, pos );
+	}
+	dx::XMStoreFloat3( &data.boundsCenter, dx::XMVectorScale( dx::XMVectorAdd( minPos, maxPos ), 0.5f ) );
+	dx::XMStoreFloat3( &data.boundsExtents, dx::XMVectorScale( dx::XMVectorSubtract( maxPos, minPos ), 0.5f ) );
+	const float radius = dx::XMVectorGetX( dx::XMVector3Length( dx::XMLoadFloat3( &data.boundsExtents ) ) );
+
+	// the merged full level is regrouped into meshlets, the sources were only grouped if they were large
+	if( indices.size() / 3u >= Mesh::MESHLET_MIN_TRIANGLES )
+	{
+		data.meshlets = MeshletSet::Build( indices, positions );
+	}
+
+	// coarser levels take the same level of every source or its coarsest one, errors are relative to the batch radius
+	data.lods.push_back( { 0u, (UINT)indices.size(), 0.f } );
+	for( size_t level = 1u; level < levelCount; level++ )
+	{
+		const auto startIndex = (UINT)indices.size();
+		float error = 0.f;
+		size_t k = 0u;
+		for( auto p = pFirst; p != pLast; p++, k++ )
+		{
+			const auto& instance = instances[*p];
+			const auto& mesh = meshes[instance.mesh];
+			const auto lod = get_level( mesh, level );
+			const bool mirrored = dx::XMVectorGetX( dx::XMMatrixDeterminant( dx::XMLoadFloat4x4( &instance.transform ) ) ) < 0.f;
+			for( size_t i = lod.startIndex; i < lod.startIndex + lod.indexCount; i += 3u )
+			{
+				const auto i0 = read_index( mesh.pIndices, mesh.indexFormat, i );
+				const auto i1 = read_index( mesh.pIndices, mesh.indexFormat, i + 1u );
+				const auto i2 = read_index( mesh.pIndices, mesh.indexFormat, i + 2u );
+				indices.push_back( baseVertices[k] + i0 );
+				indices.push_back( baseVertices[k] + ( mirrored ? i2 : i1 ) );
+				indices.push_back( baseVertices[k] + ( mirrored ? i1 : i2 ) );
+			}
+			const float sourceRadius = dx::XMVectorGetX( dx::XMVector3Length( dx::XMLoadFloat3( &instance.extents ) ) );
+			error = std::max( error, radius > 0.f ? lod.error * sourceRadius / radius : 0.f );
+		}
+		data.lods.push_back( { startIndex, (UINT)indices.size() - startIndex, error } );
+	}
+	data.indices = IndexByteBuffer( indices );
+	return data;
+}
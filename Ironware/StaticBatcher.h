@@ -0,0 +1,88 @@
+/*!
+ * \file StaticBatcher.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Header file that contains StaticBatcher, merging of the static mesh references of a model at load
+ *
+ * \note Mesh references of every material are split into spatial groups, the references of a group are
+ * * transformed into the space of the root node and merged into one mesh with combined bounds, levels
+ * * and meshlets. Batches hang off the root, so the root transform still moves the whole model, while
+ * * the nodes whose references were merged don't move them anymore. Nothing here touches the GPU.
+*/
+#pragma once
+
+#include "Model.h"
+#include "Mesh.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class StaticBatcher
+{
+public:
+	static constexpr uint32_t NO_MESH = ~0u;
+
+	/**
+	 * @brief Geometry of a mesh of the model, as extracted or as mapped from the cooked file
+	*/
+	struct Source
+	{
+		const VertexLayout* pLayout;
+		uint32_t materialIndex;
+		const std::byte* pVertices;
+		size_t vertexCount;
+		const std::byte* pIndices;
+		IndexByteBuffer::Format indexFormat;
+		size_t indexCount;
+		DirectX::XMFLOAT3 boundsCenter;
+		DirectX::XMFLOAT3 boundsExtents;
+		// empty if all indices are the only level
+		std::vector<Drawable::Lod> lods;
+	};
+
+	struct Batch
+	{
+		uint32_t materialIndex;
+		Mesh::Data data;
+	};
+
+	struct Result
+	{
+		std::vector<Batch> batches;
+		// nodes without the merged references, the root references the batches after the kept meshes
+		std::vector<Model::NodeDesc> nodes;
+		// new index of every mesh, NO_MESH if all of its references were merged
+		std::vector<uint32_t> meshRemap;
+		size_t keptMeshCount = 0u;
+		Model::BatchStats stats;
+	};
+
+public:
+	static Source MakeSource( const Mesh::Data& data, const VertexLayout& layout, uint32_t materialIndex );
+	static Source MakeSource( const class CookedModel& cooked, size_t mesh, const VertexLayout& layout );
+	/**
+	 * @param scale scale of the model, which node translations are multiplied by
+	 * @param tag prefix of the tags of the batches, the path of the model
+	*/
+	static Result Build( const std::vector<Source>& meshes, const std::vector<Model::NodeDesc>& nodes, float scale, const std::wstring& tag );
+
+private:
+	// mesh reference of a node
+	struct Instance;
+
+private:
+	/**
+	 * @brief Transforms and concatenates the geometry of the instances, levels are merged level by level
+	*/
+	static Mesh::Data Merge( const std::vector<Source>& meshes, const std::vector<Instance>& instances,
+		const uint32_t* pFirst, const uint32_t* pLast, std::wstring tag );
+
+private:
+	// batches are kept addressable by 16-bit indices
+	static constexpr size_t MAX_BATCH_VERTICES = 0x10000u;
+	// batches are split until they are smaller than this part of the static geometry bounds, so they can be culled
+	static constexpr float MAX_BATCH_EXTENT = 0.5f;
+};
@@ -0,0 +1,124 @@
+/*!
+ * \file StridedView.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Header file that contains StridedView, a typed view of one member of interleaved data
+ *
+ * \note Offset and stride are resolved once when the view is created, element access is
+ * * a multiply-add. Views are random access ranges, so they work with std algorithms.
+*/
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+template<typename T>
+class StridedView
+{
+	// const T views are made of const bytes
+	using Byte = std::conditional_t<std::is_const_v<T>, const std::byte, std::byte>;
+
+public:
+	class Iterator
+	{
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = std::remove_const_t<T>;
+		using difference_type = std::ptrdiff_t;
+		using pointer = T*;
+		using reference = T&;
+
+	public:
+		Iterator() = default;
+		Iterator( Byte* p, size_t stride ) noexcept : p( p ), stride( stride ) {}
+
+		reference operator*() const noexcept { return *reinterpret_cast<T*>( p ); }
+		pointer operator->() const noexcept { return reinterpret_cast<T*>( p ); }
+		reference operator[]( difference_type n ) const noexcept { return *( *this + n ); }
+
+		Iterator& operator++() noexcept { p += stride; return *this; }
+		Iterator operator++( int ) noexcept { auto tmp = *this; ++*this; return tmp; }
+		Iterator& operator--() noexcept { p -= stride; return *this; }
+		Iterator operator--( int ) noexcept { auto tmp = *this; --*this; return tmp; }
+		Iterator& operator+=( difference_type n ) noexcept { p += n * (difference_type)stride; return *this; }
+		Iterator& operator-=( difference_type n ) noexcept { p -= n * (difference_type)stride; return *this; }
+		friend Iterator operator+( Iterator it, difference_type n ) noexcept { return it += n; }
+		friend Iterator operator+( difference_type n, Iterator it ) noexcept { return it += n; }
+		friend Iterator operator-( Iterator it, difference_type n ) noexcept { return it -= n; }
+		friend difference_type operator-( const Iterator& lhs, const Iterator& rhs ) noexcept { return ( lhs.p - rhs.p ) / (difference_type)lhs.stride; }
+
+		bool operator==( const Iterator& rhs ) const noexcept { return p == rhs.p; }
+		bool operator!=( const Iterator& rhs ) const noexcept { return p != rhs.p; }
+		bool operator<( const Iterator& rhs ) const noexcept { return p < rhs.p; }
+		bool operator>( const Iterator& rhs ) const noexcept { return p > rhs.p; }
+		bool operator<=( const Iterator& rhs ) const noexcept { return p <= rhs.p; }
+		bool operator>=( const Iterator& rhs ) const noexcept { return p >= rhs.p; }
+
+	private:
+		Byte* p = nullptr;
+		size_t stride = 0u;
+	};
+
+public:
+	StridedView() = default;
+	/**
+	 * @param pFirst address of the member in the first element
+	 * @param stride distance between the members of two neighboring elements in bytes
+	*/
+	StridedView( Byte* pFirst, size_t stride, size_t count ) noexcept :
+		pFirst( pFirst ),
+		stride( stride ),
+		count( count )
+	{}
+	StridedView( T* pFirst, size_t stride, size_t count ) noexcept :
+		StridedView( reinterpret_cast<Byte*>( pFirst ), stride, count )
+	{}
+
+	T& operator[]( size_t i ) const noexcept
+	{
+		assert( i < count );
+		return *reinterpret_cast<T*>( pFirst + i * stride );
+	}
+	Iterator begin() const noexcept { return { pFirst, stride }; }
+	Iterator end() const noexcept { return { pFirst + count * stride, stride }; }
+	size_t size() const noexcept { return count; }
+	bool empty() const noexcept { return count == 0u; }
+	size_t GetStride() const noexcept { return stride; }
+	T* GetData() const noexcept { return reinterpret_cast<T*>( pFirst ); }
+	/**
+	 * @brief View of the elements [begin, end)
+	*/
+	StridedView Slice( size_t begin, size_t end ) const noexcept
+	{
+		assert( begin <= end && end <= count );
+		return { pFirst + begin * stride, stride, end - begin };
+	}
+
+private:
+	Byte* pFirst = nullptr;
+	size_t stride = 0u;
+	size_t count = 0u;
+};
+
+/**
+ * @brief Transforms positions of the view in place with the strided SIMD stream of DirectXMath
+ * @note Result is divided by w, which is a no-op for affine matrices
+*/
+inline void transform_coord_stream( StridedView<DirectX::XMFLOAT3> view, DirectX::FXMMATRIX matrix ) noexcept
+{
+	DirectX::XMVector3TransformCoordStream( view.GetData(), view.GetStride(), view.GetData(), view.GetStride(), view.size(), matrix );
+}
+
+/**
+ * @brief Transforms directions of the view in place, translation of the matrix is ignored
+*/
+inline void transform_normal_stream( StridedView<DirectX::XMFLOAT3> view, DirectX::FXMMATRIX matrix ) noexcept
+{
+	DirectX::XMVector3TransformNormalStream( view.GetData(), view.GetStride(), view.GetData(), view.GetStride(), view.size(), matrix );
+}
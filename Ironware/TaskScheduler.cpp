@@ -0,0 +1,185 @@
+/*!
+ * \file TaskScheduler.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ *
+ */
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <cassert>
+
+thread_local TaskScheduler::ThreadSlot TaskScheduler::threadSlot;
+const TaskScheduler* TaskScheduler::pFrameScheduler = nullptr;
+
+TaskScheduler::TaskScheduler( size_t nWorkers, Role role ) :
+	role( role )
+{
+	if( role == Role::Frame )
+	{
+		// per-thread data of the frame is indexed by the threads of a single scheduler
+		assert( "Only one frame scheduler can exist" && pFrameScheduler == nullptr );
+		pFrameScheduler = this;
+	}
+	nWorkers = std::min( nWorkers, MAX_THREADS - 1u );
+	queues.reserve( nWorkers + 1u );
+	for( size_t i = 0; i <= nWorkers; i++ )
+	{
+		queues.push_back( std::make_unique<Queue>() );
+	}
+	workers.reserve( nWorkers );
+	for( size_t i = 1; i <= nWorkers; i++ )
+	{
+		workers.emplace_back( &TaskScheduler::WorkerLoop, this, i );
+	}
+}
+
+TaskScheduler::~TaskScheduler() noexcept
+{
+	{
+		std::lock_guard<std::mutex> lock( sleepMtx );
+		running = false;
+	}
+	sleepCv.notify_all();
+	for( auto& w : workers )
+	{
+		w.join();
+	}
+	if( role == Role::Frame )
+	{
+		pFrameScheduler = nullptr;
+	}
+}
+
+void TaskScheduler::Run( Group& group, Task task )
+{
+	group.pending.fetch_add( 1u, std::memory_order_relaxed );
+	{
+		auto& q = *queues[GetThreadIndex()];
+		std::lock_guard<std::mutex> lock( q.mtx );
+		q.entries.push_back( { std::move( task ), &group } );
+	}
+	{
+		// taking the lock makes sure a worker that is about to sleep sees the new count
+		std::lock_guard<std::mutex> lock( sleepMtx );
+		queuedCount.fetch_add( 1u, std::memory_order_release );
+	}
+	sleepCv.notify_one();
+}
+
+void TaskScheduler::Wait( Group& group )
+{
+	while( !group.IsDone() )
+	{
+		if( !TryRunOne( GetThreadIndex() ) )
+		{
+			std::this_thread::yield();
+		}
+	}
+	if( group.pException )
+	{
+		auto pException = group.pException;
+		group.pException = nullptr;
+		std::rethrow_exception( pException );
+	}
+}
+
+size_t TaskScheduler::GetFrameThreadIndex() noexcept
+{
+	return threadSlot.pOwner != nullptr && threadSlot.pOwner == pFrameScheduler ? threadSlot.index : 0u;
+}
+
+bool TaskScheduler::IsFrameThread() noexcept
+{
+	return threadSlot.pOwner == nullptr || threadSlot.pOwner == pFrameScheduler;
+}
+
+size_t TaskScheduler::DefaultWorkerCount() noexcept
+{
+	const size_t hwThreads = std::thread::hardware_concurrency();
+	return hwThreads > 1u ? hwThreads - 1u : 0u;
+}
+
+void TaskScheduler::WorkerLoop( size_t index )
+{
+	threadSlot = { this, index };
+	while( true )
+	{
+		if( TryRunOne( index ) )
+		{
+			continue;
+		}
+		std::unique_lock<std::mutex> lock( sleepMtx );
+		sleepCv.wait( lock, [this]
+		{
+			return !running || queuedCount.load( std::memory_order_acquire ) > 0u;
+		} );
+		if( !running )
+		{
+			return;
+		}
+	}
+}
+
+bool TaskScheduler::TryRunOne( size_t index )
+{
+	Entry entry;
+	if( TryPop( index, entry ) || TrySteal( index, entry ) )
+	{
+		queuedCount.fetch_sub( 1u, std::memory_order_relaxed );
+		Execute( entry );
+		return true;
+	}
+	return false;
+}
+
+bool TaskScheduler::TryPop( size_t index, Entry& out )
+{
+	auto& q = *queues[index];
+	std::lock_guard<std::mutex> lock( q.mtx );
+	if( q.entries.empty() )
+	{
+		return false;
+	}
+	// newest task first, its data is most likely still in cache
+	out = std::move( q.entries.back() );
+	q.entries.pop_back();
+	return true;
+}
+
+bool TaskScheduler::TrySteal( size_t thief, Entry& out )
+{
+	const size_t count = queues.size();
+	for( size_t i = 1; i < count; i++ )
+	{
+		auto& q = *queues[( thief + i ) % count];
+		std::lock_guard<std::mutex> lock( q.mtx );
+		if( !q.entries.empty() )
+		{
+			// oldest task is stolen, it's usually the biggest chunk of work
+			out = std::move( q.entries.front() );
+			q.entries.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void TaskScheduler::Execute( Entry& entry ) noexcept
+{
+	try
+	{
+		entry.task();
+	}
+	catch( ... )
+	{
+		std::lock_guard<std::mutex> lock( entry.pGroup->exceptionMtx );
+		if( !entry.pGroup->pException )
+		{
+			entry.pGroup->pException = std::current_exception();
+		}
+	}
+	entry.pGroup->pending.fetch_sub( 1u, std::memory_order_acq_rel );
+}
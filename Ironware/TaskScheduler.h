@@ -0,0 +1,140 @@
+/*!
+ * \file TaskScheduler.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Work-stealing task scheduler of the engine
+ *
+ * \note Every worker owns a deque: it pushes/pops its own tasks at the back and
+ * idle workers steal from the front of the others. Thread that created the
+ * scheduler takes part in execution while it waits for a task group.
+ * \note Indices of the threads are per scheduler, per-thread data of the frame
+ * (render queue buckets, culling ranges) is addressed by the index in the frame scheduler.
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TaskScheduler
+{
+public:
+	using Task = std::function<void()>;
+
+	/**
+	 * @brief Set of tasks that can be waited on as a whole
+	 * * First exception thrown by a task of the group is rethrown by TaskScheduler::Wait
+	*/
+	class Group
+	{
+		friend class TaskScheduler;
+	public:
+		Group() = default;
+		Group( const Group& ) = delete;
+		Group& operator=( const Group& ) = delete;
+		bool IsDone() const noexcept { return pending.load( std::memory_order_acquire ) == 0u; }
+
+	private:
+		std::atomic<size_t> pending = 0u;
+		std::mutex exceptionMtx;
+		std::exception_ptr pException;
+	};
+
+	/**
+	 * @brief Threads of the frame scheduler fill the per-thread data of the frame,
+	 * * background schedulers (streaming) must not touch it
+	*/
+	enum class Role
+	{
+		Frame,
+		Background,
+	};
+
+	// upper limit of threads (workers + submitting thread) that may take part in execution
+	static constexpr size_t MAX_THREADS = 32u;
+
+public:
+	/**
+	 * @param nWorkers number of spawned worker threads, defaults to hardware threads minus the calling one
+	*/
+	explicit TaskScheduler( size_t nWorkers = DefaultWorkerCount(), Role role = Role::Frame );
+	TaskScheduler( const TaskScheduler& ) = delete;
+	TaskScheduler& operator=( const TaskScheduler& ) = delete;
+	~TaskScheduler() noexcept;
+
+	/**
+	 * @brief Queues task on the deque of the calling thread, threads that aren't workers
+	 * * of this scheduler queue on the deque of the non-worker threads
+	*/
+	void Run( Group& group, Task task );
+	/**
+	 * @brief Executes queued tasks on the calling thread until every task of the group is finished
+	*/
+	void Wait( Group& group );
+	/**
+	 * @brief Number of threads that execute tasks, including the submitting one
+	*/
+	size_t GetThreadCount() const noexcept { return queues.size(); }
+	/**
+	 * @brief Index of the calling thread in this scheduler, 0 for threads that are not its workers
+	*/
+	size_t GetThreadIndex() const noexcept { return threadSlot.pOwner == this ? threadSlot.index : 0u; }
+	/**
+	 * @brief Index of the calling thread in the frame scheduler, 0 for threads that are not workers
+	 * @note Can be used to address per-thread data of the frame without locking, given
+	 * that only one non-worker thread submits tasks and the caller is a frame thread
+	*/
+	static size_t GetFrameThreadIndex() noexcept;
+	/**
+	 * @return true for the workers of the frame scheduler and for threads that are workers of no scheduler
+	*/
+	static bool IsFrameThread() noexcept;
+	static size_t DefaultWorkerCount() noexcept;
+
+private:
+	struct Entry
+	{
+		Task task;
+		Group* pGroup;
+	};
+	struct Queue
+	{
+		std::mutex mtx;
+		std::deque<Entry> entries;
+	};
+
+private:
+	void WorkerLoop( size_t index );
+	bool TryRunOne( size_t index );
+	bool TryPop( size_t index, Entry& out );
+	bool TrySteal( size_t thief, Entry& out );
+	static void Execute( Entry& entry ) noexcept;
+
+private:
+	// scheduler the calling thread works for and its index there, no owner for non-worker threads
+	struct ThreadSlot
+	{
+		const TaskScheduler* pOwner = nullptr;
+		size_t index = 0u;
+	};
+
+private:
+	static thread_local ThreadSlot threadSlot;
+	static const TaskScheduler* pFrameScheduler;
+	Role role;
+	// queue 0 belongs to the non-worker threads
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> workers;
+	std::atomic<size_t> queuedCount = 0u;
+	std::atomic<bool> running = true;
+	std::mutex sleepMtx;
+	std::condition_variable sleepCv;
+};
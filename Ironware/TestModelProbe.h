@@ -125,8 +125,49 @@ public:
 			TP probe;
 			pSelectedNode->Accept( probe );
 		}
+		ImGui::Columns( 1 );
+		if( ImGui::CollapsingHeader( "Transform Hierarchy" ) )
+		{
+			auto& transforms = model.GetTransforms();
+			const auto& stats = transforms.GetStats();
+			ImGui::Text( "%zu nodes, %zu updated last frame in %.4f ms", stats.nodeCount, stats.updatedCount, stats.updateTime );
+			if( ImGui::Button( "Benchmark Full Update" ) )
+			{
+				transforms.Benchmark( 1000u );
+			}
+			ImGui::Text( "Recursive: %.4f ms, Flattened: %.4f ms", stats.recursiveTime, stats.flatTime );
+		}
 		ImGui::End();
 	}
+	/**
+	 * @brief Moves selection and outline highlight to the node, used by the tree and by viewport picking
+	*/
+	void SelectNode( Node& node )
+	{
+		// used to change the highlighted node on selection change
+		struct Probe : public TechniqueProbe
+		{
+			void OnSetTechnique() override
+			{
+				if( pTech->GetName() == L"Outline" )
+				{
+					pTech->SetActive( highlighted );
+				}
+			}
+			bool highlighted = false;
+		} probe;
+
+		// remove highlight on prev-selected node
+		if( pSelectedNode != nullptr )
+		{
+			pSelectedNode->Accept( probe );
+		}
+		// add highlight to newly-selected node
+		probe.highlighted = true;
+		node.Accept( probe );
+
+		pSelectedNode = &node;
+	}
 
 protected:
 	bool PushNode( Node& node ) override
@@ -145,29 +186,7 @@ protected:
 		// processing for selecting node
 		if( ImGui::IsItemClicked() )
 		{
-			// used to change the highlighted node on selection change
-			struct Probe : public TechniqueProbe
-			{
-				void OnSetTechnique() override
-				{
-					if( pTech->GetName() == L"Outline" )
-					{
-						pTech->SetActive( highlighted );
-					}
-				}
-				bool highlighted = false;
-			} probe;
-
-			// remove highlight on prev-selected node
-			if( pSelectedNode != nullptr )
-			{
-				pSelectedNode->Accept( probe );
-			}
-			// add highlight to newly-selected node
-			probe.highlighted = true;
-			node.Accept( probe );
-
-			pSelectedNode = &node;
+			SelectNode( node );
 		}
 		// signal if children should also be recursed
 		return expanded;
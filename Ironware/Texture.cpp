@@ -11,12 +11,15 @@
 #include "GraphicsExceptionMacros.h"
 
 Texture::Texture( Graphics& gfx, const std::wstring& path, UINT slot ) :
+	Texture( gfx, path, slot, SurfaceEx::FromFile( path ) )
+{}
+
+Texture::Texture( Graphics& gfx, const std::wstring& path, UINT slot, const SurfaceEx& sur ) :
 	path( path ),
 	slot( slot )
 {
 	INFOMAN( gfx );
 
-	const auto sur = SurfaceEx::FromFile( path );
 	hasAlpha = sur.IsAlphaLoaded();
 	auto width = sur.GetWidth();
 	auto height = sur.GetHeight();
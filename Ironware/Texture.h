@@ -13,6 +13,8 @@
 #include "Bindable.h"
 #include "BindableCollection.h"
 
+class SurfaceEx;
+
 /*!
  * \class Texture
  *
@@ -31,8 +33,22 @@ class Texture : public Bindable
 {
 public:
 	Texture( Graphics& gfx, const std::wstring& path, UINT slot = 0u );
-	void Bind( Graphics& gfx ) IFNOEXCEPT override { GetContext( gfx )->PSSetShaderResources( slot, 1u, pTextureView.GetAddressOf() ); }
+	/**
+	 * @brief Creates texture from the surface that was already decoded from the file at path
+	*/
+	Texture( Graphics& gfx, const std::wstring& path, UINT slot, const SurfaceEx& surface );
+	void Bind( Graphics& gfx ) IFNOEXCEPT override
+	{
+		if( GetStateCache( gfx ).Set( PipelineStateCache::Stage::PSShaderResource, slot, pTextureView.Get() ) )
+		{
+			GetContext( gfx )->PSSetShaderResources( slot, 1u, pTextureView.GetAddressOf() );
+		}
+	}
 	static std::shared_ptr<Texture> Resolve( Graphics& gfx, const std::wstring& path, UINT slot = 0u ) { return BindableCollection::Resolve<Texture>( gfx, path, slot ); }
+	static std::shared_ptr<Texture> Resolve( Graphics& gfx, const std::wstring& path, UINT slot, const SurfaceEx& surface ) { return BindableCollection::Resolve<Texture>( gfx, path, slot, surface ); }
+	static size_t GenerateKey( const std::wstring& path, UINT slot, const SurfaceEx& surface ) noexcept { return GenerateKey( path, slot ); }
+	static size_t GenerateKey( const std::wstring& path, UINT slot = 0u ) noexcept { return hash_values( path, slot ); }
+	static std::wstring GenerateUID( const std::wstring& path, UINT slot, const SurfaceEx& surface ) { return GenerateUID( path, slot ); }
 	static std::wstring GenerateUID( const std::wstring& path, UINT slot = 0u ) { return GET_CLASS_WNAME( Texture ) + L"#" + path + L"#" + std::to_wstring( slot ); }
 	std::wstring GetUID() const noexcept override { return GenerateUID( path, slot ); }
 	bool HasAlpha() const noexcept { return hasAlpha; }
@@ -40,6 +56,6 @@ public:
 protected:
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> pTextureView;
 	bool hasAlpha = false;
-	const std::wstring& path;
+	const std::wstring path;
 	const UINT slot;
 };
\ No newline at end of file
@@ -10,7 +10,8 @@
 
 std::unique_ptr<VertexConstantBuffer<TransformCBuffer::Transforms>> TransformCBuffer::pVertConstBuffer;
 
-TransformCBuffer::TransformCBuffer( Graphics & gfx, UINT slot )
+TransformCBuffer::TransformCBuffer( Graphics & gfx, UINT slot ) :
+	slot( slot )
 {
 	if( !pVertConstBuffer )
 	{
@@ -23,6 +24,34 @@ void TransformCBuffer::InitializeParentReference( const Drawable & parent ) noex
 	pParent = &parent;
 }
 
+void TransformCBuffer::Bind( Graphics& gfx ) IFNOEXCEPT
+{
+	auto& ring = gfx.GetConstantRing();
+	if( !ring.IsActive() )
+	{
+		UpdateBind( gfx, GetTransform( gfx ) );
+		return;
+	}
+	if( ring.IsFlushed( ticket ) )
+	{
+		ring.BindVS( gfx, slot, ring.GetRange( ticket ) );
+		return;
+	}
+	// bound outside of a queue pass
+	const auto transforms = GetTransform( gfx );
+	ring.BindVS( gfx, slot, ring.Write( gfx, &transforms, sizeof( transforms ) ) );
+}
+
+void TransformCBuffer::StageConstants( Graphics& gfx ) IFNOEXCEPT
+{
+	auto& ring = gfx.GetConstantRing();
+	if( ring.IsActive() )
+	{
+		const auto transforms = GetTransform( gfx );
+		ticket = ring.Stage( &transforms, sizeof( transforms ) );
+	}
+}
+
 void TransformCBuffer::UpdateBind( Graphics& gfx, const Transforms& transforms ) noexcept
 {
 	assert( pParent );
@@ -33,6 +62,10 @@ void TransformCBuffer::UpdateBind( Graphics& gfx, const Transforms& transforms )
 TransformCBuffer::Transforms TransformCBuffer::GetTransform( Graphics& gfx ) const noexcept
 {
 	assert( pParent );
+	if( const auto pTransforms = gfx.GetTransformStage().Find( *pParent ) )
+	{
+		return *pTransforms;
+	}
 	const auto model = pParent->GetTransformXM();
 	const auto modelView = model * gfx.GetCameraXM();
 	return {
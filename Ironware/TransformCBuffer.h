@@ -15,6 +15,8 @@
 #include "Bindable.h"
 #include "Drawable.h"
 #include "ConstantBuffers.h"
+#include "ConstantUploadRing.h"
+#include "TransformStage.h"
 
 #include <DirectXMath.h>
 
@@ -35,22 +37,25 @@
 class TransformCBuffer : public CloningBindable
 {
 protected:
-	struct Transforms
-	{
-		DirectX::XMMATRIX model;
-		DirectX::XMMATRIX modelView;
-		DirectX::XMMATRIX modelViewProj;
-	};
+	using Transforms = TransformStage::Transforms;
 
 public:
 	TransformCBuffer( Graphics& gfx, UINT slot = 0u );
 	void InitializeParentReference( const Drawable& parent ) noexcept override;
 	std::unique_ptr<CloningBindable> Clone() const noexcept override { return std::make_unique<TransformCBuffer>( *this ); }
-	void Bind( Graphics& gfx ) IFNOEXCEPT override { UpdateBind( gfx, GetTransform( gfx ) ); }
+	/**
+	 * @brief Binds the range of the frame ring that the transforms were staged to,
+	 * * or the shared buffer after updating it if the ring isn't active
+	*/
+	void Bind( Graphics& gfx ) IFNOEXCEPT override;
+	void StageConstants( Graphics& gfx ) IFNOEXCEPT override;
 
 protected:
 	void UpdateBind( Graphics& gfx, const Transforms &transforms ) noexcept;
-	Transforms GetTransform( Graphics & gfx ) const noexcept;
+	/**
+	 * @brief Copies the transforms that the stage computed for the current camera, or computes them
+	*/
+	virtual Transforms GetTransform( Graphics & gfx ) const noexcept;
 
 private:
 	std::wstring GetUID() const noexcept override;
@@ -58,4 +63,7 @@ private:
 protected:
 	static std::unique_ptr<VertexConstantBuffer<Transforms>> pVertConstBuffer;
 	const Drawable* pParent = nullptr;
+	UINT slot;
+	// transforms staged for the draws of the current pass
+	ConstantUploadRing::Ticket ticket;
 };
\ No newline at end of file
@@ -23,14 +23,14 @@ void TransformCBufferScaling::Accept( TechniqueProbe& probe )
 	probe.VisitBuffer( buf );
 }
 
-void TransformCBufferScaling::Bind( Graphics& gfx ) noexcept
+TransformCBuffer::Transforms TransformCBufferScaling::GetTransform( Graphics& gfx ) const noexcept
 {
 	const float scale = buf["scale"];
 	const auto scaleMatrix = dx::XMMatrixScaling( scale, scale, scale );
-	auto xf = GetTransform( gfx );
+	auto xf = TransformCBuffer::GetTransform( gfx );
 	xf.modelView = xf.modelView * scaleMatrix;
 	xf.modelViewProj = xf.modelViewProj * scaleMatrix;
-	UpdateBind( gfx, xf );
+	return xf;
 }
 
 std::unique_ptr<CloningBindable> TransformCBufferScaling::Clone() const noexcept
@@ -16,9 +16,11 @@ class TransformCBufferScaling : public TransformCBuffer
 public:
 	TransformCBufferScaling( Graphics& gfx, float scale );
 	void Accept( TechniqueProbe& probe ) override;
-	void Bind( Graphics& gfx ) noexcept override;
 	std::unique_ptr<CloningBindable> Clone() const noexcept override;
 
+protected:
+	Transforms GetTransform( Graphics& gfx ) const noexcept override;
+
 private:
 	static RawLayout MakeLayout();
 
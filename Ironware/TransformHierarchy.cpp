@@ -0,0 +1,151 @@
+/*!
+ * \file TransformHierarchy.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ *
+ */
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+namespace dx = DirectX;
+
+uint32_t TransformHierarchy::Add( uint32_t parent, dx::FXMMATRIX local ) noexcept
+{
+	const auto slot = (uint32_t)parents.size();
+	assert( ( parent == NO_PARENT ) == ( slot == 0u ) );
+	if( parent != NO_PARENT )
+	{
+		assert( parent < slot );
+		// breadth-first order keeps siblings next to each other
+		assert( childCounts[parent] == 0u || firstChildren[parent] + childCounts[parent] == slot );
+		if( childCounts[parent]++ == 0u )
+		{
+			firstChildren[parent] = slot;
+		}
+	}
+
+	parents.push_back( parent );
+	firstChildren.push_back( 0u );
+	childCounts.push_back( 0u );
+	locals.emplace_back();
+	dx::XMStoreFloat4x4( &locals.back(), local );
+	applied.emplace_back();
+	dx::XMStoreFloat4x4( &applied.back(), dx::XMMatrixIdentity() );
+	world.emplace_back();
+	dirty.push_back( 1u );
+	updated.push_back( 0u );
+	anyDirty = true;
+	stats.nodeCount = parents.size();
+
+	return slot;
+}
+
+void TransformHierarchy::SetApplied( uint32_t slot, dx::FXMMATRIX transform ) noexcept
+{
+	dx::XMStoreFloat4x4( &applied[slot], transform );
+	dirty[slot] = 1u;
+	anyDirty = true;
+}
+
+void TransformHierarchy::Update() noexcept
+{
+	using namespace std::chrono;
+	if( stats.updatedCount != 0u )
+	{
+		std::fill( updated.begin(), updated.end(), uint8_t( 0u ) );
+		stats.updatedCount = 0u;
+	}
+	if( !anyDirty )
+	{
+		stats.updateTime = 0.f;
+		return;
+	}
+
+	const auto start = steady_clock::now();
+
+	const size_t count = parents.size();
+	// parents precede children, so a single forward pass propagates dirtiness down the subtrees
+	for( size_t i = 1; i < count; i++ )
+	{
+		dirty[i] |= dirty[parents[i]];
+	}
+
+	for( size_t i = 0; i < count; i++ )
+	{
+		if( !dirty[i] )
+		{
+			continue;
+		}
+		const auto local = dx::XMLoadFloat4x4( &applied[i] ) * dx::XMLoadFloat4x4( &locals[i] );
+		const auto built = parents[i] == NO_PARENT ?
+			local :
+			local * dx::XMLoadFloat4x4( &world[parents[i]] );
+		dx::XMStoreFloat4x4( &world[i], built );
+		stats.updatedCount++;
+	}
+
+	// dirty flags of this update become the updated flags, the cleared ones are reused for the next frame
+	dirty.swap( updated );
+	anyDirty = false;
+
+	stats.updateTime = duration<float, std::milli>( steady_clock::now() - start ).count();
+}
+
+void TransformHierarchy::Benchmark( size_t iterations ) noexcept
+{
+	using namespace std::chrono;
+	if( parents.empty() || iterations == 0u )
+	{
+		return;
+	}
+
+	std::vector<dx::XMFLOAT4X4> scratch( parents.size() );
+
+	auto start = steady_clock::now();
+	for( size_t i = 0; i < iterations; i++ )
+	{
+		UpdateRecursive( 0u, dx::XMMatrixIdentity(), scratch );
+	}
+	stats.recursiveTime = duration<float, std::milli>( steady_clock::now() - start ).count() / iterations;
+
+	start = steady_clock::now();
+	for( size_t i = 0; i < iterations; i++ )
+	{
+		UpdateFlat( scratch );
+	}
+	stats.flatTime = duration<float, std::milli>( steady_clock::now() - start ).count() / iterations;
+}
+
+void TransformHierarchy::UpdateFlat( std::vector<dx::XMFLOAT4X4>& out ) const noexcept
+{
+	const size_t count = parents.size();
+	dx::XMStoreFloat4x4( &out[0], dx::XMLoadFloat4x4( &applied[0] ) * dx::XMLoadFloat4x4( &locals[0] ) );
+	for( size_t i = 1; i < count; i++ )
+	{
+		dx::XMStoreFloat4x4( &out[i],
+			dx::XMLoadFloat4x4( &applied[i] ) *
+			dx::XMLoadFloat4x4( &locals[i] ) *
+			dx::XMLoadFloat4x4( &out[parents[i]] )
+		);
+	}
+}
+
+void TransformHierarchy::UpdateRecursive( uint32_t slot, dx::FXMMATRIX accumulated, std::vector<dx::XMFLOAT4X4>& out ) const noexcept
+{
+	// same traversal as the former per node submission chain
+	const auto built =
+		dx::XMLoadFloat4x4( &applied[slot] ) *
+		dx::XMLoadFloat4x4( &locals[slot] ) *
+		accumulated;
+	dx::XMStoreFloat4x4( &out[slot], built );
+	const auto end = firstChildren[slot] + childCounts[slot];
+	for( uint32_t c = firstChildren[slot]; c < end; c++ )
+	{
+		UpdateRecursive( c, built, out );
+	}
+}
@@ -0,0 +1,88 @@
+/*!
+ * \file TransformHierarchy.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Flattened node transform hierarchy of a model
+ *
+ * \note Nodes are stored breadth-first in structure-of-arrays form, so every
+ * parent precedes its children and children of a node are contiguous.
+ * World matrices are only recomputed for the subtrees that were changed since the last update.
+ */
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+class TransformHierarchy
+{
+public:
+	/**
+	 * @brief Statistics of the last update and of the last benchmark run
+	*/
+	struct Stats
+	{
+		size_t nodeCount = 0u;
+		// world matrices recomputed by the last update
+		size_t updatedCount = 0u;
+		float updateTime = 0.f;
+		// average time of a full hierarchy update, measured by Benchmark
+		float recursiveTime = 0.f;
+		float flatTime = 0.f;
+	};
+
+	static constexpr uint32_t NO_PARENT = std::numeric_limits<uint32_t>::max();
+
+public:
+	/**
+	 * @brief Appends node to the hierarchy, nodes have to be added in breadth-first order
+	 * @param parent slot of the parent node or NO_PARENT for the root
+	 * @param local transform of the node relative to its parent
+	 * @return slot of the added node
+	*/
+	uint32_t Add( uint32_t parent, DirectX::FXMMATRIX local ) noexcept;
+	/**
+	 * @brief Sets user transform that is applied before the local one, marks the subtree dirty
+	*/
+	void SetApplied( uint32_t slot, DirectX::FXMMATRIX transform ) noexcept;
+	const DirectX::XMFLOAT4X4& GetApplied( uint32_t slot ) const noexcept { return applied[slot]; }
+	DirectX::XMMATRIX GetWorldXM( uint32_t slot ) const noexcept { return DirectX::XMLoadFloat4x4( &world[slot] ); }
+	uint32_t GetParent( uint32_t slot ) const noexcept { return parents[slot]; }
+	/**
+	 * @brief Whether world matrix of the slot was recomputed by the last update
+	*/
+	bool WasUpdated( uint32_t slot ) const noexcept { return updated[slot] != 0u; }
+	size_t GetSize() const noexcept { return parents.size(); }
+	/**
+	 * @brief Recomputes world matrices of dirty subtrees
+	 * @note Must not run concurrently with readers of the world matrices
+	*/
+	void Update() noexcept;
+	/**
+	 * @brief Times full recursive and flattened recomputation of the whole hierarchy
+	 * * Results are written to the stats, world matrices are left untouched
+	*/
+	void Benchmark( size_t iterations ) noexcept;
+	const Stats& GetStats() const noexcept { return stats; }
+
+private:
+	void UpdateFlat( std::vector<DirectX::XMFLOAT4X4>& out ) const noexcept;
+	void UpdateRecursive( uint32_t slot, DirectX::FXMMATRIX accumulated, std::vector<DirectX::XMFLOAT4X4>& out ) const noexcept;
+
+private:
+	std::vector<uint32_t> parents;
+	std::vector<uint32_t> firstChildren;
+	std::vector<uint32_t> childCounts;
+	std::vector<DirectX::XMFLOAT4X4> locals;
+	std::vector<DirectX::XMFLOAT4X4> applied;
+	std::vector<DirectX::XMFLOAT4X4> world;
+	std::vector<uint8_t> dirty;
+	std::vector<uint8_t> updated;
+	bool anyDirty = false;
+	Stats stats;
+};
@@ -0,0 +1,213 @@
+/*!
+ * \file TransformStage.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ *
+ */
+#include "TransformStage.h"
+#include "Drawable.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstring>
+
+namespace dx = DirectX;
+
+namespace
+{
+	bool matrices_equal( dx::FXMMATRIX a, dx::CXMMATRIX b ) noexcept
+	{
+		return std::memcmp( &a, &b, sizeof( dx::XMMATRIX ) ) == 0;
+	}
+}
+
+void TransformStage::NewFrame() noexcept
+{
+	current.drawables = drawables.size();
+	current.cameras = cameraCount;
+	lastFrame = current;
+	current = {};
+
+	frame++;
+	drawables.clear();
+	models.clear();
+	for( size_t i = 0; i < cameraCount; i++ )
+	{
+		cameras[i].computed.clear();
+		cameras[i].pending.clear();
+		cameras[i].requests.clear();
+	}
+	cameraCount = 0u;
+	currentCamera = NO_CAMERA;
+}
+
+uint32_t TransformStage::Acquire( const Drawable& drawable )
+{
+	if( drawable.transformFrame != frame )
+	{
+		drawable.transformFrame = frame;
+		drawable.transformSlot = uint32_t( drawables.size() );
+		drawables.push_back( &drawable );
+		models.push_back( drawable.GetTransformXM() );
+	}
+	assert( drawables[drawable.transformSlot] == &drawable );
+	return drawable.transformSlot;
+}
+
+void TransformStage::BindCamera( dx::FXMMATRIX view, dx::CXMMATRIX projection )
+{
+	for( size_t i = 0; i < cameraCount; i++ )
+	{
+		if( matrices_equal( cameras[i].view, view ) && matrices_equal( cameras[i].projection, projection ) )
+		{
+			currentCamera = i;
+			return;
+		}
+	}
+	if( cameraCount == cameras.size() )
+	{
+		cameras.emplace_back();
+	}
+	auto& c = cameras[cameraCount];
+	c.view = view;
+	c.projection = projection;
+	currentCamera = cameraCount++;
+}
+
+void TransformStage::Request( uint32_t slot )
+{
+	assert( currentCamera != NO_CAMERA && slot < models.size() );
+	auto& c = cameras[currentCamera];
+	if( c.computed.size() < models.size() )
+	{
+		c.computed.resize( models.size(), 0u );
+	}
+	c.requests.push_back( slot );
+	if( !c.computed[slot] )
+	{
+		c.computed[slot] = 1u;
+		c.pending.push_back( slot );
+	}
+}
+
+void TransformStage::Compute()
+{
+	using namespace std::chrono;
+	if( currentCamera == NO_CAMERA || cameras[currentCamera].pending.empty() )
+	{
+		return;
+	}
+	const auto start = steady_clock::now();
+
+	auto& c = cameras[currentCamera];
+	if( c.transforms.size() < models.size() )
+	{
+		c.transforms.resize( models.size() );
+	}
+	ComputeBatch( models.data(), c.pending.data(), c.pending.size(), c.view, c.projection, c.transforms.data() );
+	current.computed += c.pending.size();
+	c.pending.clear();
+
+	current.computeTime += duration<float, std::milli>( steady_clock::now() - start ).count();
+}
+
+const TransformStage::Transforms* TransformStage::Find( const Drawable& drawable ) noexcept
+{
+	if( !enabled || currentCamera == NO_CAMERA || drawable.transformFrame != frame )
+	{
+		return nullptr;
+	}
+	const auto& c = cameras[currentCamera];
+	const auto slot = drawable.transformSlot;
+	if( slot >= c.computed.size() || !c.computed[slot] )
+	{
+		return nullptr;
+	}
+	assert( c.pending.empty() );
+	current.requests++;
+	return &c.transforms[slot];
+}
+
+TransformStage::BenchmarkStats TransformStage::Benchmark( size_t iterations ) const
+{
+	using namespace std::chrono;
+	BenchmarkStats stats;
+	stats.drawables = drawables.size();
+	stats.cameras = cameraCount;
+	// slots of every camera without repeats, as they are batched
+	std::vector<std::vector<uint32_t>> uniqueSlots( cameraCount );
+	for( size_t i = 0; i < cameraCount; i++ )
+	{
+		const auto& c = cameras[i];
+		stats.requests += c.requests.size();
+		std::vector<uint8_t> seen( models.size(), 0u );
+		for( const auto slot : c.requests )
+		{
+			if( !seen[slot] )
+			{
+				seen[slot] = 1u;
+				uniqueSlots[i].push_back( slot );
+			}
+		}
+	}
+	if( stats.requests == 0u || iterations == 0u )
+	{
+		return stats;
+	}
+
+	std::vector<Transforms> out( models.size() );
+	auto start = steady_clock::now();
+	for( size_t it = 0; it < iterations; it++ )
+	{
+		for( size_t i = 0; i < cameraCount; i++ )
+		{
+			const auto& c = cameras[i];
+			for( const auto slot : c.requests )
+			{
+				const auto model = drawables[slot]->GetTransformXM();
+				const auto modelView = model * c.view;
+				out[slot] = {
+					dx::XMMatrixTranspose( model ),
+					dx::XMMatrixTranspose( modelView ),
+					dx::XMMatrixTranspose( modelView * c.projection )
+				};
+			}
+		}
+	}
+	stats.perRequestTime = duration<float, std::milli>( steady_clock::now() - start ).count() / float( iterations );
+
+	std::vector<dx::XMMATRIX> batchModels( models.size() );
+	start = steady_clock::now();
+	for( size_t it = 0; it < iterations; it++ )
+	{
+		for( size_t d = 0; d < drawables.size(); d++ )
+		{
+			batchModels[d] = drawables[d]->GetTransformXM();
+		}
+		for( size_t i = 0; i < cameraCount; i++ )
+		{
+			const auto& c = cameras[i];
+			ComputeBatch( batchModels.data(), uniqueSlots[i].data(), uniqueSlots[i].size(), c.view, c.projection, out.data() );
+		}
+	}
+	stats.batchedTime = duration<float, std::milli>( steady_clock::now() - start ).count() / float( iterations );
+	return stats;
+}
+
+void TransformStage::ComputeBatch( const dx::XMMATRIX* pModels, const uint32_t* pSlots, size_t count,
+	dx::FXMMATRIX view, dx::CXMMATRIX projection, Transforms* pOut ) noexcept
+{
+	// model * view * projection doesn't have to wait for model * view
+	const auto viewProj = dx::XMMatrixMultiply( view, projection );
+	for( size_t i = 0; i < count; i++ )
+	{
+		const auto slot = pSlots[i];
+		const auto model = pModels[slot];
+		auto& out = pOut[slot];
+		out.model = dx::XMMatrixTranspose( model );
+		out.modelView = dx::XMMatrixTranspose( dx::XMMatrixMultiply( model, view ) );
+		out.modelViewProj = dx::XMMatrixTranspose( dx::XMMatrixMultiply( model, viewProj ) );
+	}
+}
@@ -0,0 +1,130 @@
+/*!
+ * \file TransformStage.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Header file that contains TransformStage, per frame table of the transforms of the drawn drawables
+ *
+ * \note Model matrices are read once per frame into a contiguous array indexed by the slot of the drawable.
+ * * Cameras are told apart by their view and projection, and every camera computes the transforms of the slots
+ * * requested by its passes in one batch, so a drawable drawn by several passes of a camera pays for them once.
+ * * Doesn't depend on d3d, slots are kept by the drawables for the frame they were acquired in.
+*/
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Drawable;
+
+class TransformStage
+{
+public:
+	static constexpr uint32_t NO_SLOT = ~0u;
+
+	/**
+	 * @brief Transposed matrices as they're read by the vertex shaders
+	*/
+	struct Transforms
+	{
+		DirectX::XMMATRIX model;
+		DirectX::XMMATRIX modelView;
+		DirectX::XMMATRIX modelViewProj;
+	};
+
+	struct Stats
+	{
+		size_t drawables = 0u;
+		size_t cameras = 0u;
+		// transforms that were looked up by the binds, and the ones computed for them
+		size_t requests = 0u;
+		size_t computed = 0u;
+		float computeTime = 0.f;
+	};
+
+	struct BenchmarkStats
+	{
+		size_t drawables = 0u;
+		size_t cameras = 0u;
+		size_t requests = 0u;
+		// transforms computed for every request, as binds did without the stage
+		float perRequestTime = 0.f;
+		float batchedTime = 0.f;
+	};
+
+public:
+	/**
+	 * @brief Publishes the counters of the finished frame and forgets all slots
+	*/
+	void NewFrame() noexcept;
+	/**
+	 * @return slot of the drawable in this frame, its model matrix is read on the first call of the frame
+	*/
+	uint32_t Acquire( const Drawable& drawable );
+	DirectX::XMMATRIX GetModel( uint32_t slot ) const noexcept { return models[slot]; }
+	/**
+	 * @brief Makes the camera current, the transforms of a camera that was seen in this frame are kept
+	*/
+	void BindCamera( DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection );
+	/**
+	 * @brief Binds that aren't prepared by a pass compute their transforms on their own
+	*/
+	void UnbindCamera() noexcept { currentCamera = NO_CAMERA; }
+	/**
+	 * @brief Marks the transforms of the slot as needed by the current camera
+	*/
+	void Request( uint32_t slot );
+	/**
+	 * @brief Computes the requested transforms of the current camera that weren't computed yet
+	*/
+	void Compute();
+	/**
+	 * @return transforms of the drawable for the current camera, nullptr if they weren't computed
+	*/
+	const Transforms* Find( const Drawable& drawable ) noexcept;
+	void SetEnabled( bool enabled_in ) noexcept { enabled = enabled_in; }
+	bool IsEnabled() const noexcept { return enabled; }
+	/**
+	 * @return counters of the previous frame
+	*/
+	const Stats& GetStats() const noexcept { return lastFrame; }
+	/**
+	 * @brief Times the transforms of the requests of the current frame, computed per request and batched
+	*/
+	BenchmarkStats Benchmark( size_t iterations ) const;
+
+private:
+	struct Camera
+	{
+		DirectX::XMMATRIX view;
+		DirectX::XMMATRIX projection;
+		std::vector<Transforms> transforms;
+		std::vector<uint8_t> computed;
+		std::vector<uint32_t> pending;
+		// slot of every request, in the order of the requests
+		std::vector<uint32_t> requests;
+	};
+
+private:
+	static void ComputeBatch( const DirectX::XMMATRIX* pModels, const uint32_t* pSlots, size_t count,
+		DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection, Transforms* pOut ) noexcept;
+
+private:
+	static constexpr size_t NO_CAMERA = ~size_t( 0u );
+
+private:
+	bool enabled = true;
+	uint64_t frame = 1u;
+	std::vector<const Drawable*> drawables;
+	std::vector<DirectX::XMMATRIX> models;
+	// cameras of the frame, the storage of the previous frames is reused
+	std::vector<Camera> cameras;
+	size_t cameraCount = 0u;
+	size_t currentCamera = NO_CAMERA;
+	Stats current;
+	Stats lastFrame;
+};
@@ -0,0 +1,109 @@
+/*!
+ * \file UploadRing.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ *
+ */
+#include "UploadRing.h"
+
+#include <cassert>
+
+UploadRing::UploadRing( size_t capacity, size_t alignment ) :
+	capacity( capacity ),
+	alignment( alignment )
+{
+	assert( alignment > 0u && capacity % alignment == 0u );
+}
+
+size_t UploadRing::Allocate( size_t size ) noexcept
+{
+	const size_t aligned = ( size + alignment - 1u ) / alignment * alignment;
+	if( aligned == 0u || aligned > capacity )
+	{
+		return NO_SPACE;
+	}
+	if( used == 0u )
+	{
+		// frames in flight are all empty, so the ring can start over from the beginning
+		head = 0u;
+		tail = 0u;
+		for( auto& f : frames )
+		{
+			f.end = 0u;
+		}
+	}
+
+	size_t offset = NO_SPACE;
+	size_t taken = aligned;
+	if( head < tail )
+	{
+		if( tail - head >= aligned )
+		{
+			offset = head;
+		}
+	}
+	else if( used < capacity )
+	{
+		if( capacity - head >= aligned )
+		{
+			offset = head;
+		}
+		else if( tail >= aligned )
+		{
+			// the end of the ring is too short, it stays taken until the frame is given back
+			taken += capacity - head;
+			offset = 0u;
+			wraps++;
+		}
+	}
+	if( offset == NO_SPACE )
+	{
+		return NO_SPACE;
+	}
+
+	head = offset + aligned;
+	used += taken;
+	frameBytes += taken;
+	return offset;
+}
+
+void UploadRing::EndFrame( uint64_t fence )
+{
+	assert( frames.empty() || frames.back().fence < fence );
+	frames.push_back( { fence, head, frameBytes } );
+	frameBytes = 0u;
+}
+
+void UploadRing::Retire( uint64_t fence ) noexcept
+{
+	while( !frames.empty() && frames.front().fence <= fence )
+	{
+		tail = frames.front().end;
+		used -= frames.front().bytes;
+		frames.pop_front();
+	}
+}
+
+void UploadRing::Reset( size_t capacity_in ) noexcept
+{
+	assert( capacity_in % alignment == 0u );
+	capacity = capacity_in;
+	head = 0u;
+	tail = 0u;
+	used = 0u;
+	frameBytes = 0u;
+	frames.clear();
+}
+
+UploadRing::Stats UploadRing::GetStats() const noexcept
+{
+	Stats stats;
+	stats.capacity = capacity;
+	stats.used = used;
+	stats.pendingFrames = frames.size();
+	stats.wraps = wraps;
+	stats.stalls = stalls;
+	return stats;
+}
@@ -0,0 +1,112 @@
+/*!
+ * \file UploadRing.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Header file that contains UploadRing, linear suballocation of a ring buffer that is rewritten every frame
+ *
+ * \note Doesn't depend on d3d, it only keeps offsets. Allocations of a frame are closed under the id of its
+ * * fence and are given back all at once when the owner reports the fence as passed. Allocations are never
+ * * split over the end of the ring, the rest of the end is skipped and given back with the frame.
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+class UploadRing
+{
+public:
+	static constexpr size_t NO_SPACE = ~size_t( 0u );
+
+	struct Stats
+	{
+		size_t capacity = 0u;
+		// bytes of the frames that weren't given back, the skipped ends included
+		size_t used = 0u;
+		size_t pendingFrames = 0u;
+		size_t wraps = 0u;
+		// allocations that had to wait for the fence of an older frame
+		size_t stalls = 0u;
+	};
+
+public:
+	/**
+	 * @param alignment every offset and size is a multiple of it
+	*/
+	UploadRing( size_t capacity, size_t alignment );
+	/**
+	 * @return offset of the range, NO_SPACE if the frames in flight hold too much of the ring
+	*/
+	size_t Allocate( size_t size ) noexcept;
+	/**
+	 * @brief Allocates, waiting for the oldest frames in flight while the ring is full
+	 * @param wait called with the fence id of a frame, has to return once that frame is done on the gpu
+	 * @return NO_SPACE only if the size doesn't fit even in the empty ring
+	*/
+	template<typename W>
+	size_t AllocateWaiting( size_t size, W&& wait );
+	/**
+	 * @brief Closes the allocations made since the previous call under the fence id
+	*/
+	void EndFrame( uint64_t fence );
+	/**
+	 * @brief Gives back the allocations of the frames up to the fence id
+	*/
+	void Retire( uint64_t fence ) noexcept;
+	/**
+	 * @brief Drops all allocations, the fences of the frames in flight are not awaited
+	*/
+	void Reset( size_t capacity_in ) noexcept;
+	bool HasPendingFrames() const noexcept { return !frames.empty(); }
+	uint64_t GetOldestFence() const noexcept { return frames.front().fence; }
+	size_t GetCapacity() const noexcept { return capacity; }
+	size_t GetAlignment() const noexcept { return alignment; }
+	/**
+	 * @return bytes allocated since the last EndFrame, skipped ends included
+	*/
+	size_t GetFrameBytes() const noexcept { return frameBytes; }
+	Stats GetStats() const noexcept;
+
+private:
+	struct Frame
+	{
+		uint64_t fence;
+		// head when the frame was closed, the tail moves there when the frame is given back
+		size_t end;
+		size_t bytes;
+	};
+
+private:
+	size_t capacity;
+	size_t alignment;
+	size_t head = 0u;
+	size_t tail = 0u;
+	size_t used = 0u;
+	size_t frameBytes = 0u;
+	std::deque<Frame> frames;
+	size_t wraps = 0u;
+	size_t stalls = 0u;
+};
+
+template<typename W>
+size_t UploadRing::AllocateWaiting( size_t size, W&& wait )
+{
+	// no amount of waiting makes room for these, the frames in flight are left alone
+	if( size == 0u || size > capacity )
+	{
+		return NO_SPACE;
+	}
+	auto offset = Allocate( size );
+	while( offset == NO_SPACE && HasPendingFrames() )
+	{
+		const auto fence = GetOldestFence();
+		wait( fence );
+		Retire( fence );
+		stalls++;
+		offset = Allocate( size );
+	}
+	return offset;
+}
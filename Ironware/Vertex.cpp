@@ -8,6 +8,12 @@
  */
 #define DVTX_SOURCE_FILE
 #include "Vertex.h"
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 
 Vertex::Vertex( std::byte* data, const VertexLayout& layout ) :
 	pData( data ),
@@ -34,13 +40,169 @@ struct AttributeAiMeshFill
 	}
 };
 
+template<VertexLayout::ElementType type>
+struct AttributeAiMeshStream
+{
+	static void Exec( std::byte* pDst, size_t dstStride, const aiMesh& mesh, size_t begin, size_t end, float positionScale ) IFNOEXCEPT
+	{
+		using Map = VertexLayout::Map<type>;
+		const auto pSrc = Map::Source( mesh );
+		assert( pSrc && "Mesh doesn't have an attribute of the layout" );
+		if constexpr( Map::packed )
+		{
+			Map::Encode( mesh, begin, end, pDst + begin * dstStride, dstStride );
+			return;
+		}
+		if constexpr( type == VertexLayout::ElementType::Position3D )
+		{
+			if( positionScale != 1.f )
+			{
+				// strided SIMD stream, scaling matrix has no translation part to apply
+				DirectX::XMVector3TransformNormalStream(
+					reinterpret_cast<DirectX::XMFLOAT3*>( pDst + begin * dstStride ), dstStride,
+					reinterpret_cast<const DirectX::XMFLOAT3*>( pSrc + begin * Map::sourceStride ), Map::sourceStride,
+					end - begin, DirectX::XMMatrixScaling( positionScale, positionScale, positionScale )
+				);
+				return;
+			}
+		}
+		for( size_t i = begin; i < end; i++ )
+		{
+			std::memcpy( pDst + i * dstStride, pSrc + i * Map::sourceStride, sizeof( typename Map::SysType ) );
+		}
+	}
+};
+
 VertexByteBuffer::VertexByteBuffer( VertexLayout layout_in, const aiMesh & mesh ) :
+	VertexByteBuffer( std::move( layout_in ), mesh, 1.f )
+{}
+
+VertexByteBuffer::VertexByteBuffer( VertexLayout layout_in, const aiMesh& mesh, float positionScale, TaskScheduler* pScheduler ) :
 	layout( std::move( layout_in ) )
 {
-	Resize( mesh.mNumVertices );
-	for( size_t i = 0, end = layout.GetElementCount(); i < end; i++ )
+	const size_t count = mesh.mNumVertices;
+	Resize( count );
+	if( !pScheduler || pScheduler->GetThreadCount() < 2u || count < PARALLEL_FILL_MIN )
+	{
+		FillRange( mesh, 0u, count, positionScale );
+		return;
+	}
+	TaskScheduler::Group group;
+	for( size_t begin = 0; begin < count; begin += PARALLEL_FILL_CHUNK )
+	{
+		const size_t end = std::min( begin + PARALLEL_FILL_CHUNK, count );
+		pScheduler->Run( group, [this, &mesh, begin, end, positionScale]
+		{
+			FillRange( mesh, begin, end, positionScale );
+		} );
+	}
+	pScheduler->Wait( group );
+}
+
+void VertexByteBuffer::BenchmarkAiMeshFill( FillBenchmarkStats& stats, const VertexLayout& layout, const aiMesh& mesh, float scale, TaskScheduler& scheduler )
+{
+	using namespace std::chrono;
+	const auto elapsed = []( steady_clock::time_point start )
+	{
+		return duration<float, std::milli>( steady_clock::now() - start ).count();
+	};
+
+	// previous extraction path: vertex proxies per attribute, then a second pass for the scale
+	auto start = steady_clock::now();
+	{
+		VertexByteBuffer vtc( layout, mesh.mNumVertices );
+		for( size_t i = 0, end = layout.GetElementCount(); i < end; i++ )
+		{
+			VertexLayout::Bridge<AttributeAiMeshFill>( layout.ResolveByIndex( i ).GetType(), &vtc, mesh );
+		}
+		if( scale != 1.f )
+		{
+			for( size_t i = 0; i < vtc.Size(); i++ )
+			{
+				auto& pos = vtc[i].Attribute<VertexLayout::ElementType::Position3D>();
+				pos.x *= scale;
+				pos.y *= scale;
+				pos.z *= scale;
+			}
+		}
+	}
+	stats.perVertexTime += elapsed( start );
+
+	start = steady_clock::now();
+	{
+		VertexByteBuffer vtc( layout, mesh, scale );
+	}
+	stats.streamTime += elapsed( start );
+
+	start = steady_clock::now();
+	{
+		VertexByteBuffer vtc( layout, mesh, scale, &scheduler );
+	}
+	stats.parallelTime += elapsed( start );
+
 	{
-		VertexLayout::Bridge<AttributeAiMeshFill>( layout.ResolveByIndex( i ).GetType(), this, mesh );
+		const VertexByteBuffer vtc( layout, mesh, scale );
+		vtc.MeasurePackingError( stats, mesh );
+	}
+
+	stats.meshCount++;
+	stats.vertexCount += mesh.mNumVertices;
+}
+
+void VertexByteBuffer::FillRange( const aiMesh& mesh, size_t begin, size_t end, float positionScale ) IFNOEXCEPT
+{
+	const auto stride = layout.Size();
+	for( size_t i = 0, count = layout.GetElementCount(); i < count; i++ )
+	{
+		const auto& element = layout.ResolveByIndex( i );
+		VertexLayout::Bridge<AttributeAiMeshStream>( element.GetType(), buffer.data() + element.GetOffset(), stride, mesh, begin, end, positionScale );
+	}
+}
+
+void VertexByteBuffer::MeasurePackingError( FillBenchmarkStats& stats, const aiMesh& mesh ) const IFNOEXCEPT
+{
+	using namespace DirectX;
+	using namespace DirectX::PackedVector;
+	using Type = VertexLayout::ElementType;
+	const auto loadSource = []( const aiVector3D& v )
+	{
+		return XMVector3Normalize( XMLoadFloat3( reinterpret_cast<const XMFLOAT3*>( &v ) ) );
+	};
+	const auto angle = []( FXMVECTOR a, FXMVECTOR b )
+	{
+		return XMConvertToDegrees( XMVectorGetX( XMVector3AngleBetweenNormals( a, XMVector3Normalize( b ) ) ) );
+	};
+	if( layout.Has( Type::NormalPacked ) )
+	{
+		const auto normals = View<Type::NormalPacked>();
+		for( size_t i = 0; i < normals.size(); i++ )
+		{
+			stats.maxNormalError = std::max( stats.maxNormalError, angle( loadSource( mesh.mNormals[i] ), XMLoadShortN4( &normals[i] ) ) );
+		}
+	}
+	if( layout.Has( Type::TangentFrame ) )
+	{
+		const auto frames = View<Type::TangentFrame>();
+		for( size_t i = 0; i < frames.size(); i++ )
+		{
+			const XMVECTOR frame = XMLoadShortN4( &frames[i] );
+			const XMVECTOR bitangent = XMVectorScale( XMVector3Cross( loadSource( mesh.mNormals[i] ), frame ), XMVectorGetW( frame ) );
+			stats.maxTangentError = std::max( stats.maxTangentError, angle( loadSource( mesh.mTangents[i] ), frame ) );
+			stats.maxBitangentError = std::max( stats.maxBitangentError, angle( loadSource( mesh.mBitangents[i] ), bitangent ) );
+		}
+	}
+	if( layout.Has( Type::Texture2DHalf ) )
+	{
+		const auto coords = View<Type::Texture2DHalf>();
+		for( size_t i = 0; i < coords.size(); i++ )
+		{
+			const auto& src = mesh.mTextureCoords[0][i];
+			stats.maxTexCoordError = std::max( {
+				stats.maxTexCoordError,
+				std::abs( XMConvertHalfToFloat( coords[i].x ) - src.x ),
+				std::abs( XMConvertHalfToFloat( coords[i].y ) - src.y )
+			} );
+		}
 	}
 }
 
@@ -101,6 +263,16 @@ std::wstring VertexLayout::GetCode() const IFNOEXCEPT
 	return code;
 }
 
+size_t VertexLayout::GetHash() const noexcept
+{
+	size_t seed = elements.size();
+	for( const auto& e : elements )
+	{
+		hash_combine( seed, e.GetType() );
+	}
+	return seed;
+}
+
 bool VertexLayout::Has( ElementType Type ) const noexcept
 {
 	for( auto& e : elements )
@@ -113,6 +285,44 @@ bool VertexLayout::Has( ElementType Type ) const noexcept
 	return false;
 }
 
+void VertexLayout::Map<VertexLayout::ElementType::Texture2DHalf>::Encode( const aiMesh& mesh, size_t begin, size_t end, std::byte* pDst, size_t dstStride ) noexcept
+{
+	using namespace DirectX::PackedVector;
+	// u and v are converted as two strided streams, which use F16C when it is enabled
+	const auto pSrc = &mesh.mTextureCoords[0][begin];
+	XMConvertFloatToHalfStream( reinterpret_cast<HALF*>( pDst ), dstStride, &pSrc->x, sizeof( aiVector3D ), end - begin );
+	XMConvertFloatToHalfStream( reinterpret_cast<HALF*>( pDst + sizeof( HALF ) ), dstStride, &pSrc->y, sizeof( aiVector3D ), end - begin );
+}
+
+void VertexLayout::Map<VertexLayout::ElementType::NormalPacked>::Encode( const aiMesh& mesh, size_t begin, size_t end, std::byte* pDst, size_t dstStride ) noexcept
+{
+	using namespace DirectX;
+	using namespace DirectX::PackedVector;
+	for( size_t i = begin; i < end; i++, pDst += dstStride )
+	{
+		// snorm clamps to [-1, 1], so source normals are normalized first
+		const XMVECTOR n = XMVector3Normalize( XMLoadFloat3( reinterpret_cast<const XMFLOAT3*>( &mesh.mNormals[i] ) ) );
+		XMStoreShortN4( reinterpret_cast<XMSHORTN4*>( pDst ), n );
+	}
+}
+
+void VertexLayout::Map<VertexLayout::ElementType::TangentFrame>::Encode( const aiMesh& mesh, size_t begin, size_t end, std::byte* pDst, size_t dstStride ) noexcept
+{
+	using namespace DirectX;
+	using namespace DirectX::PackedVector;
+	assert( mesh.mNormals && mesh.mBitangents && "Tangent frame needs normals and bitangents" );
+	for( size_t i = begin; i < end; i++, pDst += dstStride )
+	{
+		const XMVECTOR n = XMLoadFloat3( reinterpret_cast<const XMFLOAT3*>( &mesh.mNormals[i] ) );
+		const XMVECTOR t = XMVector3Normalize( XMLoadFloat3( reinterpret_cast<const XMFLOAT3*>( &mesh.mTangents[i] ) ) );
+		const XMVECTOR b = XMLoadFloat3( reinterpret_cast<const XMFLOAT3*>( &mesh.mBitangents[i] ) );
+		// sign is -1 for mirrored uvs, where the bitangent points against cross( n, t )
+		const XMVECTOR mirrored = XMVectorLess( XMVector3Dot( XMVector3Cross( n, t ), b ), XMVectorZero() );
+		const XMVECTOR sign = XMVectorSelect( g_XMOne, g_XMNegativeOne, mirrored );
+		XMStoreShortN4( reinterpret_cast<XMSHORTN4*>( pDst ), XMVectorSelect( sign, t, g_XMSelect1110 ) );
+	}
+}
+
 template<VertexLayout::ElementType type>
 struct DescGenerate
 {
@@ -5,24 +5,38 @@
  * \author Yernar Aldabergenov
  * Contact: yernar.aa@gmail.com
  *
- * \brief Header file that contains VertexLayout, Vertex and VertexByteBuffer
+ * \brief Header file that contains VertexLayout, Vertex, VertexByteBuffer and StaticVertexByteBuffer
 */
 #pragma once
 
 #include "CommonMacros.h"
 #include "IronUtils.h"
 #include "IronWin.h"
+#include "StridedView.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <DirectXMath.h>
+#include <DirectXPackedVector.h>
 #include <dxgiformat.h>
 #include <type_traits>
+#include <utility>
 #include <d3d11.h>
 
 #include <assimp/scene.h>
 
-#define DVTX_ELEMENT_AI_EXTRACTOR(member) static SysType Extract( const aiMesh& mesh,size_t i ) noexcept {return *reinterpret_cast<const SysType*>(&mesh.member[i]);}
+#define DVTX_ELEMENT_AI_EXTRACTOR(member) static SysType Extract( const aiMesh& mesh,size_t i ) noexcept {return *reinterpret_cast<const SysType*>(&mesh.member[i]);} \
+	static const std::byte* Source( const aiMesh& mesh ) noexcept {return reinterpret_cast<const std::byte*>(mesh.member);} \
+	static constexpr size_t sourceStride = sizeof( *std::declval<aiMesh>().member ); \
+	static constexpr bool packed = false;
+
+// packed elements convert the source floats with Encode, which takes the destination of vertex begin
+#define DVTX_ELEMENT_AI_ENCODER(member) static SysType Extract( const aiMesh& mesh,size_t i ) noexcept {SysType v; Encode( mesh,i,i + 1u,reinterpret_cast<std::byte*>(&v),sizeof( SysType ) ); return v;} \
+	static void Encode( const aiMesh& mesh,size_t begin,size_t end,std::byte* pDst,size_t dstStride ) noexcept; \
+	static const std::byte* Source( const aiMesh& mesh ) noexcept {return reinterpret_cast<const std::byte*>(mesh.member);} \
+	static constexpr size_t sourceStride = sizeof( *std::declval<aiMesh>().member ); \
+	static constexpr bool packed = true;
 
 #define LAYOUT_ELEMENT_TYPES \
 	X( Position2D ) \
@@ -31,6 +45,9 @@
 	X( Normal ) \
 	X( Tangent ) \
 	X( Bitangent ) \
+	X( Texture2DHalf ) \
+	X( NormalPacked ) \
+	X( TangentFrame ) \
 	X( Float3Color ) \
 	X( Float4Color ) \
 	X( BGRAColor ) \
@@ -107,6 +124,33 @@ public:
 		static constexpr const wchar_t* code = L"B";
 		DVTX_ELEMENT_AI_EXTRACTOR( mBitangents )
 	};
+	// half floats keep 11 significant bits, coordinates in [0, 1] are precise to 1/2048
+	template<> struct Map<ElementType::Texture2DHalf>
+	{
+		using SysType = DirectX::PackedVector::XMHALF2;
+		static constexpr DXGI_FORMAT dxgiFormat = DXGI_FORMAT_R16G16_FLOAT;
+		static constexpr const char* semantic = "TexCoord";
+		static constexpr const wchar_t* code = L"Th";
+		DVTX_ELEMENT_AI_ENCODER( mTextureCoords[0] )
+	};
+	// normalized, w is zero, input assembler expands it to floats
+	template<> struct Map<ElementType::NormalPacked>
+	{
+		using SysType = DirectX::PackedVector::XMSHORTN4;
+		static constexpr DXGI_FORMAT dxgiFormat = DXGI_FORMAT_R16G16B16A16_SNORM;
+		static constexpr const char* semantic = "Normal";
+		static constexpr const wchar_t* code = L"Np";
+		DVTX_ELEMENT_AI_ENCODER( mNormals )
+	};
+	// normalized tangent, w is the bitangent sign: bitangent = cross( normal, tangent ) * w
+	template<> struct Map<ElementType::TangentFrame>
+	{
+		using SysType = DirectX::PackedVector::XMSHORTN4;
+		static constexpr DXGI_FORMAT dxgiFormat = DXGI_FORMAT_R16G16B16A16_SNORM;
+		static constexpr const char* semantic = "Tangent";
+		static constexpr const wchar_t* code = L"TF";
+		DVTX_ELEMENT_AI_ENCODER( mTangents )
+	};
 	template<> struct Map<ElementType::Float3Color>
 	{
 		using SysType = DirectX::XMFLOAT3;
@@ -210,6 +254,10 @@ public:
 
 	std::vector<D3D11_INPUT_ELEMENT_DESC> GetD3DLayout() const IFNOEXCEPT;
 	std::wstring GetCode() const IFNOEXCEPT;
+	/**
+	 * @return hash of the element types, equal for layouts with equal codes
+	*/
+	size_t GetHash() const noexcept;
 	bool Has( ElementType Type ) const noexcept;
 
 private:
@@ -301,15 +349,45 @@ private:
 	Vertex vertex;
 };
 
+class TaskScheduler;
+
 /**
  * @brief Lower level class that holds data buffer as bytes.
  * * Allows emplacing the vertices to the buffer.
 */
 class VertexByteBuffer
 {
+public:
+	struct FillBenchmarkStats
+	{
+		size_t meshCount = 0u;
+		size_t vertexCount = 0u;
+		// summed fill times in milliseconds
+		float perVertexTime = 0.f;
+		float streamTime = 0.f;
+		float parallelTime = 0.f;
+		// largest round-trip errors of the packed elements against the source floats,
+		// angles in degrees, the bitangent is rebuilt from the tangent frame
+		float maxNormalError = 0.f;
+		float maxTangentError = 0.f;
+		float maxBitangentError = 0.f;
+		float maxTexCoordError = 0.f;
+	};
+
 public:
 	VertexByteBuffer( VertexLayout layout, size_t size = 0u ) IFNOEXCEPT;
 	VertexByteBuffer( VertexLayout layout_in, const aiMesh& mesh );
+	/**
+	 * @brief Streams the mesh attributes into the interleaved buffer one attribute at a time,
+	 * * element offsets are resolved once and positions are scaled during the copy
+	 * @param pScheduler if given, meshes of at least PARALLEL_FILL_MIN vertices are filled in vertex ranges on it
+	*/
+	VertexByteBuffer( VertexLayout layout_in, const aiMesh& mesh, float positionScale, TaskScheduler* pScheduler = nullptr );
+	/**
+	 * @brief Times the per-vertex proxy fill followed by a scaling pass against the streamed fill, serial and parallel
+	 * @param stats times and counts of the mesh are added to it
+	*/
+	static void BenchmarkAiMeshFill( FillBenchmarkStats& stats, const VertexLayout& layout, const aiMesh& mesh, float scale, TaskScheduler& scheduler );
 
 	void Resize( size_t newSize ) IFNOEXCEPT;
 	VertexLayout& GetLayout() noexcept { return layout; }
@@ -351,6 +429,25 @@ public:
 	 * @return ConstVertex instance that will hold all the elements of a single vertex
 	*/
 	ConstVertex operator[]( size_t index ) const IFNOEXCEPT { return const_cast<VertexByteBuffer&>( *this )[index]; }
+	/**
+	 * @brief Typed view of one attribute of all of the vertices, the element is resolved only once
+	 * @tparam Type of the element, has to be part of the layout
+	*/
+	template<VertexLayout::ElementType Type>
+	StridedView<typename VertexLayout::Map<Type>::SysType> View() IFNOEXCEPT;
+	template<VertexLayout::ElementType Type>
+	StridedView<const typename VertexLayout::Map<Type>::SysType> View() const IFNOEXCEPT;
+
+private:
+	void FillRange( const aiMesh& mesh, size_t begin, size_t end, float positionScale ) IFNOEXCEPT;
+	/**
+	 * @brief Decodes the packed elements of the layout and compares them to the source mesh
+	*/
+	void MeasurePackingError( FillBenchmarkStats& stats, const aiMesh& mesh ) const IFNOEXCEPT;
+
+private:
+	static constexpr size_t PARALLEL_FILL_MIN = 16384u;
+	static constexpr size_t PARALLEL_FILL_CHUNK = 4096u;
 
 private:
 	// buffer has no alignment, so when you will be dealing
@@ -359,6 +456,50 @@ private:
 	VertexLayout layout;
 };
 
+/**
+ * @brief Vertex buffer whose layout is fixed at compile time, offsets of the elements are constants
+ * @tparam Types elements of the layout in order
+*/
+template<VertexLayout::ElementType... Types>
+class StaticVertexByteBuffer
+{
+public:
+	static constexpr size_t stride = ( sizeof( typename VertexLayout::Map<Types>::SysType ) + ... );
+
+public:
+	explicit StaticVertexByteBuffer( size_t size = 0u ) : buffer( size * stride ) {}
+
+	template<VertexLayout::ElementType Type>
+	static constexpr size_t OffsetOf() noexcept;
+	/**
+	 * @brief Runtime layout with the same offsets, e.g. for creating the input layout
+	*/
+	static VertexLayout GetLayout() IFNOEXCEPT;
+
+	void Resize( size_t newSize ) { buffer.resize( newSize * stride ); }
+	size_t Size() const noexcept { return buffer.size() / stride; }
+	size_t SizeBytes() const noexcept { return buffer.size(); }
+	std::byte* GetData() noexcept { return buffer.data(); }
+	const std::byte* GetData() const noexcept { return buffer.data(); }
+	/**
+	 * @param ...params values of the elements in the order of the layout
+	*/
+	template<TPACK Params>
+	void EmplaceBack( Params&&... params );
+
+	template<VertexLayout::ElementType Type>
+	StridedView<typename VertexLayout::Map<Type>::SysType> View() noexcept { return { buffer.data() + OffsetOf<Type>(), stride, Size() }; }
+	template<VertexLayout::ElementType Type>
+	StridedView<const typename VertexLayout::Map<Type>::SysType> View() const noexcept { return { buffer.data() + OffsetOf<Type>(), stride, Size() }; }
+	/**
+	 * @brief Copies the vertices to a buffer with the equivalent runtime layout
+	*/
+	VertexByteBuffer ToDynamic() const IFNOEXCEPT;
+
+private:
+	std::vector<std::byte> buffer;
+};
+
 #pragma region impl
 
 #pragma region layoutImpl
@@ -446,11 +587,70 @@ void VertexByteBuffer::EmplaceBack( Params&&... params ) IFNOEXCEPT
 	Back().SetAttributeByIndex( 0u, std::forward<Params>( params )... );
 }
 
+template<VertexLayout::ElementType Type>
+StridedView<typename VertexLayout::Map<Type>::SysType> VertexByteBuffer::View() IFNOEXCEPT
+{
+	return { buffer.data() + layout.Resolve<Type>().GetOffset(), layout.Size(), Size() };
+}
+
+template<VertexLayout::ElementType Type>
+StridedView<const typename VertexLayout::Map<Type>::SysType> VertexByteBuffer::View() const IFNOEXCEPT
+{
+	return { buffer.data() + layout.Resolve<Type>().GetOffset(), layout.Size(), Size() };
+}
+
 #pragma endregion bufferImpl
 
+#pragma region staticBufferImpl
+
+template<VertexLayout::ElementType... Types>
+template<VertexLayout::ElementType Type>
+constexpr size_t StaticVertexByteBuffer<Types...>::OffsetOf() noexcept
+{
+	static_assert( ( ( Type == Types ) || ... ), "Element is not part of the layout" );
+	constexpr VertexLayout::ElementType types[] = { Types... };
+	constexpr size_t sizes[] = { sizeof( typename VertexLayout::Map<Types>::SysType )... };
+	size_t offset = 0u;
+	for( size_t i = 0; types[i] != Type; i++ )
+	{
+		offset += sizes[i];
+	}
+	return offset;
+}
+
+template<VertexLayout::ElementType... Types>
+VertexLayout StaticVertexByteBuffer<Types...>::GetLayout() IFNOEXCEPT
+{
+	VertexLayout layout;
+	( layout.Append( Types ), ... );
+	return layout;
+}
+
+template<VertexLayout::ElementType... Types>
+template<TPACK Params>
+void StaticVertexByteBuffer<Types...>::EmplaceBack( Params&&... params )
+{
+	static_assert( sizeof...( Params ) == sizeof...( Types ), "Parameter and layout count is NOT equal!" );
+	buffer.resize( buffer.size() + stride );
+	const size_t i = Size() - 1u;
+	( ( View<Types>()[i] = std::forward<Params>( params ) ), ... );
+}
+
+template<VertexLayout::ElementType... Types>
+VertexByteBuffer StaticVertexByteBuffer<Types...>::ToDynamic() const IFNOEXCEPT
+{
+	VertexByteBuffer vbuf( GetLayout(), Size() );
+	assert( vbuf.SizeBytes() == buffer.size() && "Layout has duplicate elements" );
+	std::copy( buffer.begin(), buffer.end(), vbuf.GetData() );
+	return vbuf;
+}
+
+#pragma endregion staticBufferImpl
+
 #pragma endregion impl
 
 #undef DVTX_ELEMENT_AI_EXTRACTOR
+#undef DVTX_ELEMENT_AI_ENCODER
 #ifndef DVTX_SOURCE_FILE
 #undef LAYOUT_ELEMENT_TYPES
 #endif
\ No newline at end of file
@@ -14,10 +14,14 @@ VertexBuffer::VertexBuffer( Graphics & gfx, const VertexByteBuffer & vbuff, UINT
 {}
 
 VertexBuffer::VertexBuffer( Graphics& gfx, const std::wstring& tag, const VertexByteBuffer& vbuff, UINT offset ) :
+	VertexBuffer( gfx, tag, vbuff.GetLayout(), vbuff.GetData(), vbuff.SizeBytes(), offset )
+{}
+
+VertexBuffer::VertexBuffer( Graphics& gfx, const std::wstring& tag, const VertexLayout& layout_in, const std::byte* pData, size_t sizeBytes, UINT offset ) :
+	layout( layout_in ),
 	tag( tag ),
 	stride( (UINT)layout.Size() ),
-	offset( offset ),
-	layout( vbuff.GetLayout() )
+	offset( offset )
 {
 	INFOMAN( gfx );
 
@@ -26,10 +30,10 @@ VertexBuffer::VertexBuffer( Graphics& gfx, const std::wstring& tag, const Vertex
 	descVertexBuffer.Usage = D3D11_USAGE_DEFAULT;
 	descVertexBuffer.CPUAccessFlags = 0u;
 	descVertexBuffer.MiscFlags = 0u;
-	descVertexBuffer.ByteWidth = UINT( vbuff.SizeBytes() );
+	descVertexBuffer.ByteWidth = UINT( sizeBytes );
 	descVertexBuffer.StructureByteStride = stride;
 	D3D11_SUBRESOURCE_DATA subresVertexData = {};
-	subresVertexData.pSysMem = vbuff.GetData();
+	subresVertexData.pSysMem = pData;
 	GFX_CALL_THROW_INFO( GetDevice( gfx )->CreateBuffer( &descVertexBuffer, &subresVertexData, &pVertexBuffer ) );
 }
 
@@ -38,3 +42,9 @@ std::shared_ptr<VertexBuffer> VertexBuffer::Resolve( Graphics& gfx, const std::w
 	assert( tag != L"?" );
 	return BindableCollection::Resolve<VertexBuffer>( gfx, tag, vbuff, offset );
 }
+
+std::shared_ptr<VertexBuffer> VertexBuffer::Resolve( Graphics& gfx, const std::wstring& tag, const VertexLayout& layout, const std::byte* pData, size_t sizeBytes, UINT offset )
+{
+	assert( tag != L"?" );
+	return BindableCollection::Resolve<VertexBuffer>( gfx, tag, layout, pData, sizeBytes, offset );
+}
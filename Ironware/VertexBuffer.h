@@ -34,13 +34,26 @@ class VertexBuffer : public Bindable
 public:
 	VertexBuffer( Graphics& gfx, const VertexByteBuffer& vbuff, UINT offset = 0u );
 	VertexBuffer( Graphics& gfx, const std::wstring& tag, const VertexByteBuffer& vbuff, UINT offset = 0u );
+	/**
+	 * @brief Creates buffer straight from vertex bytes laid out for the layout, e.g. a mapped cooked file
+	*/
+	VertexBuffer( Graphics& gfx, const std::wstring& tag, const VertexLayout& layout, const std::byte* pData, size_t sizeBytes, UINT offset = 0u );
 
-	void Bind( Graphics& gfx ) IFNOEXCEPT override { GetContext( gfx )->IASetVertexBuffers( 0u, 1u, pVertexBuffer.GetAddressOf(), &stride, &offset ); }
+	void Bind( Graphics& gfx ) IFNOEXCEPT override
+	{
+		if( GetStateCache( gfx ).Set( PipelineStateCache::Stage::IAVertexBuffer, pVertexBuffer.Get(), offset ) )
+		{
+			GetContext( gfx )->IASetVertexBuffers( 0u, 1u, pVertexBuffer.GetAddressOf(), &stride, &offset );
+		}
+	}
 
 	static std::shared_ptr<VertexBuffer> Resolve( Graphics& gfx, const std::wstring& tag, const VertexByteBuffer& vbuff, UINT offset = 0u );
+	static std::shared_ptr<VertexBuffer> Resolve( Graphics& gfx, const std::wstring& tag, const VertexLayout& layout, const std::byte* pData, size_t sizeBytes, UINT offset = 0u );
 	std::wstring GetUID() const noexcept override { return GenerateUID( tag ); }
 	const VertexLayout& GetLayout() const noexcept { return layout; }
 
+	template<TPACK Ignore>
+	static size_t GenerateKey( const std::wstring& tag, Ignore&&... ignore ) noexcept { return hash_values( tag ); }
 	template<TPACK Ignore>
 	static std::wstring GenerateUID( const std::wstring& tag, Ignore&&... ignore ) { return GenerateUID_( tag ); }
 
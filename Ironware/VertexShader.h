@@ -39,9 +39,17 @@ class VertexShader : public Bindable
 public:
 	VertexShader( Graphics& gfx, const std::wstring& path );
 
-	void Bind( Graphics& gfx ) IFNOEXCEPT override { GetContext( gfx )->VSSetShader( pVertexShader.Get(), nullptr, 0u ); }
+	void Bind( Graphics& gfx ) IFNOEXCEPT override
+	{
+		if( GetStateCache( gfx ).Set( PipelineStateCache::Stage::VSShader, pVertexShader.Get() ) )
+		{
+			GetContext( gfx )->VSSetShader( pVertexShader.Get(), nullptr, 0u );
+		}
+	}
 	ID3DBlob* GetBytecode() const noexcept { return pBytecodeBlob.Get(); }
 	static std::shared_ptr<VertexShader> Resolve( Graphics& gfx, const std::wstring& path ) noexcept { return BindableCollection::Resolve<VertexShader>( gfx, path ); }
+	static size_t GenerateKey( const std::wstring& path ) noexcept { return hash_values( path ); }
+	size_t GetKey() const noexcept { return GenerateKey( path ); }
 	static std::wstring GenerateUID( const std::wstring path ) noexcept { return to_wide( typeid( VertexShader ).name() ) + L"#" + path; }
 	std::wstring GetUID() const noexcept override { return GenerateUID( path ); }
 
@@ -0,0 +1,167 @@
+/*!
+ * \file IndexByteBufferTests.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Index formats of synthetic meshes around the 16-bit limit
+ *
+ * \note Meshes are built as aiMesh and extracted like Material::ExtractIndices does
+*/
+#include "IronTest.h"
+#include "IndexByteBuffer.h"
+
+#include <assimp/mesh.h>
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace
+{
+	/**
+	 * @brief Strip of triangles over every vertex, the last one references the last vertex
+	*/
+	std::unique_ptr<aiMesh> make_mesh( unsigned vertexCount )
+	{
+		auto pMesh = std::make_unique<aiMesh>();
+		pMesh->mNumVertices = vertexCount;
+		pMesh->mNumFaces = vertexCount - 2u;
+		pMesh->mFaces = new aiFace[pMesh->mNumFaces];
+		for( unsigned i = 0; i < pMesh->mNumFaces; i++ )
+		{
+			auto& face = pMesh->mFaces[i];
+			face.mNumIndices = 3u;
+			face.mIndices = new unsigned[3]{ i, i + 1u, i + 2u };
+		}
+		return pMesh;
+	}
+
+	bool same_indices( const IndexByteBuffer& a, const IndexByteBuffer& b )
+	{
+		if( a.Count() != b.Count() )
+		{
+			return false;
+		}
+		for( size_t i = 0; i < a.Count(); i++ )
+		{
+			if( a[i] != b[i] )
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+IRON_TEST( SelectFormatAtSixteenBitLimit )
+{
+	using Format = IndexByteBuffer::Format;
+	static_assert( IndexByteBuffer::SelectFormat( 0u ) == Format::UInt16 );
+	IRON_CHECK( IndexByteBuffer::SelectFormat( 65535u ) == Format::UInt16 );
+	// indices of 65536 vertices end at 0xFFFF
+	IRON_CHECK( IndexByteBuffer::SelectFormat( 65536u ) == Format::UInt16 );
+	IRON_CHECK( IndexByteBuffer::SelectFormat( 65537u ) == Format::UInt32 );
+	IRON_CHECK( IndexByteBuffer::SizeOf( Format::UInt16 ) == 2u );
+	IRON_CHECK( IndexByteBuffer::SizeOf( Format::UInt32 ) == 4u );
+}
+
+IRON_TEST( ExtractedIndicesOfSyntheticMeshes )
+{
+	using Format = IndexByteBuffer::Format;
+	for( const unsigned vertexCount : { 65535u, 65536u, 65537u, 200000u } )
+	{
+		const auto pMesh = make_mesh( vertexCount );
+		const auto indices = IndexByteBuffer::FromTriangles( pMesh->mNumVertices, pMesh->mFaces, pMesh->mNumFaces );
+		const auto expected = vertexCount > 65536u ? Format::UInt32 : Format::UInt16;
+		IRON_CHECK( indices.GetFormat() == expected );
+		IRON_CHECK( indices.Count() == size_t( pMesh->mNumFaces ) * 3u );
+		IRON_CHECK( indices.SizeBytes() == indices.Count() * IndexByteBuffer::SizeOf( expected ) );
+		IRON_CHECK( indices.GetMaxIndex() == vertexCount - 1u );
+		bool allMatch = true;
+		for( unsigned f = 0; f < pMesh->mNumFaces; f++ )
+		{
+			for( unsigned k = 0; k < 3u; k++ )
+			{
+				allMatch = allMatch && indices[size_t( f ) * 3u + k] == pMesh->mFaces[f].mIndices[k];
+			}
+		}
+		IRON_CHECK( allMatch );
+	}
+}
+
+IRON_TEST( IndicesAboveSixteenBitsRoundTrip )
+{
+	IndexByteBuffer wide( IndexByteBuffer::Format::UInt32, 4u );
+	const uint32_t values[] = { 0xFFFFu, 0x10000u, 0x12345u, 0xFFFFFFFEu };
+	for( size_t i = 0; i < 4u; i++ )
+	{
+		wide.Set( i, values[i] );
+	}
+	for( size_t i = 0; i < 4u; i++ )
+	{
+		IRON_CHECK( wide[i] == values[i] );
+	}
+	IRON_CHECK( wide.GetMaxIndex() == 0xFFFFFFFEu );
+
+	// pushing an index that doesn't fit widens a 16-bit buffer and keeps the earlier indices
+	IndexByteBuffer narrow( std::vector<uint16_t>{ 0u, 1u, 0xFFFFu } );
+	narrow.PushBack( 0x10000u );
+	IRON_CHECK( narrow.GetFormat() == IndexByteBuffer::Format::UInt32 );
+	IRON_CHECK( narrow.Count() == 4u );
+	IRON_CHECK( narrow[2] == 0xFFFFu && narrow[3] == 0x10000u );
+}
+
+IRON_TEST( CompactNarrowsOnlyWhenIndicesFit )
+{
+	using Format = IndexByteBuffer::Format;
+	// 32-bit source of the vector constructor is compacted right away when it fits
+	IRON_CHECK( IndexByteBuffer( std::vector<uint32_t>{ 0u, 0xFFFFu, 7u } ).GetFormat() == Format::UInt16 );
+	IRON_CHECK( IndexByteBuffer( std::vector<uint32_t>{ 0u, 0x10000u, 7u } ).GetFormat() == Format::UInt32 );
+
+	IndexByteBuffer fits( Format::UInt32, 3u );
+	fits.Set( 0u, 0u );
+	fits.Set( 1u, 0xFFFFu );
+	fits.Set( 2u, 42u );
+	const auto before = fits;
+	IRON_CHECK( fits.Compact() );
+	IRON_CHECK( fits.GetFormat() == Format::UInt16 );
+	IRON_CHECK( fits.SizeBytes() == 6u );
+	IRON_CHECK( same_indices( fits, before ) );
+	// already narrow
+	IRON_CHECK( !fits.Compact() );
+
+	IndexByteBuffer tooWide( Format::UInt32, 3u );
+	tooWide.Set( 0u, 0u );
+	tooWide.Set( 1u, 0x10000u );
+	tooWide.Set( 2u, 42u );
+	IRON_CHECK( !tooWide.Compact() );
+	IRON_CHECK( tooWide.GetFormat() == Format::UInt32 );
+	IRON_CHECK( tooWide[1] == 0x10000u );
+}
+
+IRON_TEST( WidenRoundTrips )
+{
+	using Format = IndexByteBuffer::Format;
+	std::vector<uint16_t> source;
+	for( uint32_t i = 0; i < 1000u; i++ )
+	{
+		source.push_back( uint16_t( ( i * 977u ) & 0xFFFFu ) );
+	}
+	source.push_back( 0xFFFFu );
+	IndexByteBuffer indices( source );
+	const auto narrow = indices;
+
+	indices.Widen();
+	IRON_CHECK( indices.GetFormat() == Format::UInt32 );
+	IRON_CHECK( indices.SizeBytes() == source.size() * 4u );
+	IRON_CHECK( same_indices( indices, narrow ) );
+	// widening twice changes nothing
+	indices.Widen();
+	IRON_CHECK( same_indices( indices, narrow ) );
+
+	IRON_CHECK( indices.Compact() );
+	IRON_CHECK( indices.GetFormat() == Format::UInt16 );
+	IRON_CHECK( indices.SizeBytes() == narrow.SizeBytes() );
+	IRON_CHECK( std::memcmp( indices.GetData(), narrow.GetData(), narrow.SizeBytes() ) == 0 );
+}
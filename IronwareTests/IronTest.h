@@ -0,0 +1,46 @@
+/*!
+ * \file IronTest.h
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Minimal test registry for the engine parts that don't need a d3d device
+ *
+ * \note Every IRON_TEST registers itself before main, TestMain runs them all
+ * * and returns the number of failed checks, so the exit code can gate a build.
+*/
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+namespace IronTest
+{
+	struct Case
+	{
+		const char* name;
+		void( *run )();
+	};
+
+	std::vector<Case>& GetCases() noexcept;
+	void ReportFailure( const char* file, int line, const char* expression ) noexcept;
+
+	struct Registrar
+	{
+		Registrar( const char* name, void( *run )() ) noexcept
+		{
+			GetCases().push_back( { name, run } );
+		}
+	};
+}
+
+#define IRON_TEST( name ) \
+	static void name(); \
+	static const IronTest::Registrar name##Registrar{ #name, name }; \
+	static void name()
+
+#define IRON_CHECK( expression ) \
+	( ( expression ) ? (void)0 : IronTest::ReportFailure( __FILE__, __LINE__, #expression ) )
+
+#define IRON_CHECK_NEAR( a, b, tolerance ) \
+	IRON_CHECK( std::abs( double( a ) - double( b ) ) <= double( tolerance ) )
@@ -0,0 +1,169 @@
+/*!
+ * \file LayoutTableTests.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Paths and handles of LayoutTable against the layout tree it was compiled from
+ *
+ * \note The reference offsets come from keying and indexing a Buffer, which walks the tree
+ * * with the operators [] of its refs, the table and both kinds of handles have to agree with them.
+*/
+#include "IronTest.h"
+#include "DynamicLayout.h"
+
+#include <string>
+
+namespace
+{
+	namespace dx = DirectX;
+
+	constexpr size_t LIGHT_COUNT = 3u;
+	constexpr size_t WEIGHT_COUNT = 2u;
+	constexpr size_t ROW_COUNT = 2u;
+	constexpr size_t COLUMN_COUNT = 3u;
+
+	/**
+	 * @brief Layout with an array of structs that hold an array and an array of arrays, between leaves
+	*/
+	CookedLayout make_nested_layout()
+	{
+		RawLayout raw;
+		raw.Add<Float>( "time" );
+		raw.Add<Array>( "lights" );
+		raw["lights"].Set<Struct>( LIGHT_COUNT );
+		auto& light = raw["lights"].T();
+		light.Add<Float3>( "color" );
+		light.Add<Float>( "intensity" );
+		light.Add<Array>( "weights" );
+		light["weights"].Set<Float>( WEIGHT_COUNT );
+		light.Add<Bool>( "enabled" );
+		raw.Add<Array>( "grid" );
+		raw["grid"].Set<Array>( ROW_COUNT );
+		raw["grid"].T().Set<Float2>( COLUMN_COUNT );
+		raw.Add<Integer>( "count" );
+		return DynamicLayout::Resolve( std::move( raw ) );
+	}
+
+	template<typename T>
+	size_t tree_offset( const Buffer& buf, const ConstElementRef& ref )
+	{
+		return size_t( reinterpret_cast<const std::byte*>( static_cast<const T*>( &ref ) ) - buf.GetData() );
+	}
+
+	/**
+	 * @return number of ways in which the table and the handles resolve the leaf differently than the tree
+	*/
+	template<typename T>
+	size_t count_leaf_mismatches( const LayoutTable& table, const Buffer& buf, const ConstElementRef& ref, const std::string& path )
+	{
+		const auto& root = *buf.ShareLayoutRoot();
+		const auto expected = tree_offset<T>( buf, ref );
+		const auto [offset, pRecord] = table.ResolvePath( path );
+		const auto [indexOffset, pElement] = root.ResolvePath( path );
+		if( pRecord == nullptr || !pElement->Exists() )
+		{
+			return 1u;
+		}
+		return size_t( offset != expected ) +
+			size_t( indexOffset + pElement->GetOffsetBegin() != expected ) +
+			size_t( pRecord->type != ReverseMap<T>::type || pRecord->size != pElement->GetSizeInBytes() ) +
+			size_t( buf.MakeHandle<T>( path ).GetOffset() != expected ) +
+			size_t( root.MakeHandle<T>( path ).GetOffset() != expected );
+	}
+
+	/**
+	 * @return number of ways in which the array handles or the elements resolve differently than the tree
+	*/
+	template<typename T>
+	size_t count_array_mismatches( const LayoutTable& table, const Buffer& buf, const ConstElementRef& ref, const std::string& path, size_t count )
+	{
+		const auto& root = *buf.ShareLayoutRoot();
+		const auto tableHandle = buf.MakeArrayHandle<T>( path );
+		const auto treeHandle = root.MakeArrayHandle<T>( path );
+		size_t mismatches = size_t( tableHandle.GetSize() != count ) + size_t( treeHandle.GetSize() != count );
+		if( mismatches != 0u )
+		{
+			return mismatches;
+		}
+		for( size_t k = 0; k < count; k++ )
+		{
+			const auto expected = tree_offset<T>( buf, ref[k] );
+			mismatches += size_t( tableHandle[k].GetOffset() != expected ) + size_t( treeHandle[k].GetOffset() != expected );
+			mismatches += count_leaf_mismatches<T>( table, buf, ref[k], path + "[" + std::to_string( k ) + "]" );
+		}
+		return mismatches;
+	}
+}
+
+IRON_TEST( TableResolvesStructsInArrays )
+{
+	const auto cooked = make_nested_layout();
+	const Buffer buf( cooked );
+	const auto& root = *buf.ShareLayoutRoot();
+	const auto& table = cooked.GetTable();
+	IRON_CHECK( table.Matches( root ) );
+	IRON_CHECK( table.GetSizeInBytes() == root.GetSizeInBytes() );
+
+	size_t mismatches = count_leaf_mismatches<float>( table, buf, buf["time"], "time" );
+	mismatches += count_leaf_mismatches<int>( table, buf, buf["count"], "count" );
+	for( size_t i = 0; i < LIGHT_COUNT; i++ )
+	{
+		const auto path = "lights[" + std::to_string( i ) + "]";
+		const auto light = buf["lights"][i];
+		mismatches += count_leaf_mismatches<dx::XMFLOAT3>( table, buf, light["color"], path + ".color" );
+		mismatches += count_leaf_mismatches<float>( table, buf, light["intensity"], path + ".intensity" );
+		mismatches += count_leaf_mismatches<bool>( table, buf, light["enabled"], path + ".enabled" );
+		mismatches += count_array_mismatches<float>( table, buf, light["weights"], path + ".weights", WEIGHT_COUNT );
+
+		// the struct element itself, its size and where it starts
+		const auto [offset, pRecord] = table.ResolvePath( path );
+		const auto [indexOffset, pElement] = root.ResolvePath( path );
+		IRON_CHECK( pRecord != nullptr && pRecord->type == Struct && pRecord->size == pElement->GetSizeInBytes() );
+		IRON_CHECK( offset == indexOffset + pElement->GetOffsetBegin() );
+		IRON_CHECK( offset == tree_offset<dx::XMFLOAT3>( buf, light["color"] ) );
+	}
+	IRON_CHECK( mismatches == 0u );
+
+	const auto [lightsOffset, pLights] = table.ResolvePath( "lights" );
+	IRON_CHECK( pLights != nullptr && pLights->count == LIGHT_COUNT && pLights->stride == root["lights"].GetArrayStride() );
+	IRON_CHECK( lightsOffset == root["lights"].GetOffsetBegin() );
+
+	// paths past the end or through missing members resolve to nothing in both
+	for( const auto path : { "lights[3].color", "lights[0].radius", "lights[0].weights[2]", "time[0]", "lights.color" } )
+	{
+		IRON_CHECK( table.ResolvePath( path ).second == nullptr );
+		IRON_CHECK( !root.ResolvePath( path ).second->Exists() );
+	}
+}
+
+IRON_TEST( TableResolvesArraysOfArrays )
+{
+	const auto cooked = make_nested_layout();
+	const Buffer buf( cooked );
+	const auto& root = *buf.ShareLayoutRoot();
+	const auto& table = cooked.GetTable();
+	IRON_CHECK( table.Matches( root ) );
+
+	size_t mismatches = 0u;
+	for( size_t r = 0; r < ROW_COUNT; r++ )
+	{
+		const auto path = "grid[" + std::to_string( r ) + "]";
+		mismatches += count_array_mismatches<dx::XMFLOAT2>( table, buf, buf["grid"][r], path, COLUMN_COUNT );
+
+		const auto [offset, pRecord] = table.ResolvePath( path );
+		const auto [indexOffset, pElement] = root.ResolvePath( path );
+		IRON_CHECK( pRecord != nullptr && pRecord->type == Array && pRecord->count == COLUMN_COUNT );
+		IRON_CHECK( pRecord != nullptr && pRecord->stride == pElement->GetArrayStride() && pRecord->size == pElement->GetSizeInBytes() );
+		IRON_CHECK( offset == indexOffset + pElement->GetOffsetBegin() );
+	}
+	IRON_CHECK( mismatches == 0u );
+
+	// rows are whole registers apart, so the second row starts past the padding of the first
+	const auto [gridOffset, pGrid] = table.ResolvePath( "grid" );
+	IRON_CHECK( pGrid != nullptr && pGrid->count == ROW_COUNT && pGrid->stride == root["grid"].GetArrayStride() );
+	IRON_CHECK( pGrid != nullptr && pGrid->stride % 16u == 0u );
+	IRON_CHECK( tree_offset<dx::XMFLOAT2>( buf, buf["grid"][1][0] ) == gridOffset + root["grid"].GetArrayStride() );
+	IRON_CHECK( !table.ResolvePath( "grid[2][0]" ).second );
+	IRON_CHECK( !table.ResolvePath( "grid[0][3]" ).second );
+}
@@ -0,0 +1,233 @@
+/*!
+ * \file MeshOptimizerTests.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Orders of MeshOptimizer on a shuffled sphere
+ *
+ * \note The sphere is a latitude/longitude grid whose triangles and vertices are shuffled
+ * * with a fixed seed, so the input order has no locality that the stages could keep by accident.
+*/
+#include "IronTest.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	namespace dx = DirectX;
+	using Type = VertexLayout::ElementType;
+
+	// Tipsify reaches about 0.7 on regular grids with a 16 entry cache, shuffled input is close to 3
+	constexpr float MAX_TIPSIFY_ACMR = 0.8f;
+	constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+	struct Sphere
+	{
+		VertexByteBuffer vertices;
+		std::vector<uint32_t> indices;
+		// vertices that no triangle references
+		size_t unusedCount;
+	};
+
+	/**
+	 * @brief Sphere of stacks * slices quads, a few unreferenced vertices are mixed in
+	*/
+	Sphere make_sphere( uint32_t stacks, uint32_t slices, uint32_t seed )
+	{
+		VertexLayout layout;
+		layout.Append( Type::Position3D );
+		const size_t unusedCount = 5u;
+		const uint32_t ringSize = slices + 1u;
+		const size_t gridCount = size_t( stacks + 1u ) * ringSize;
+		std::mt19937 rng( seed );
+
+		// vertices are stored in a shuffled order, remap gives the slot of every grid vertex
+		std::vector<uint32_t> remap( gridCount + unusedCount );
+		std::iota( remap.begin(), remap.end(), 0u );
+		std::shuffle( remap.begin(), remap.end(), rng );
+
+		Sphere s = { VertexByteBuffer( layout, remap.size() ), {}, unusedCount };
+		auto positions = s.vertices.View<Type::Position3D>();
+		for( uint32_t i = 0; i <= stacks; i++ )
+		{
+			const float theta = 3.14159265f * float( i ) / float( stacks );
+			for( uint32_t j = 0; j <= slices; j++ )
+			{
+				const float phi = 6.28318531f * float( j ) / float( slices );
+				positions[remap[i * ringSize + j]] = { std::sin( theta ) * std::cos( phi ), std::cos( theta ), std::sin( theta ) * std::sin( phi ) };
+			}
+		}
+		for( size_t u = 0; u < unusedCount; u++ )
+		{
+			positions[remap[gridCount + u]] = { 10.f + float( u ), 0.f, 0.f };
+		}
+
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for( uint32_t i = 0; i < stacks; i++ )
+		{
+			for( uint32_t j = 0; j < slices; j++ )
+			{
+				const auto a = remap[i * ringSize + j];
+				const auto b = remap[i * ringSize + j + 1u];
+				const auto c = remap[( i + 1u ) * ringSize + j];
+				const auto d = remap[( i + 1u ) * ringSize + j + 1u];
+				triangles.push_back( { a, b, c } );
+				triangles.push_back( { b, d, c } );
+			}
+		}
+		std::shuffle( triangles.begin(), triangles.end(), rng );
+		for( const auto& t : triangles )
+		{
+			s.indices.insert( s.indices.end(), t.begin(), t.end() );
+		}
+		return s;
+	}
+
+	/**
+	 * @brief Triangles rotated to start at their smallest index, which keeps the winding, and sorted
+	*/
+	std::vector<std::array<uint32_t, 3>> triangle_multiset( const std::vector<uint32_t>& indices )
+	{
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for( size_t i = 0; i + 2u < indices.size(); i += 3u )
+		{
+			std::array<uint32_t, 3> t = { indices[i], indices[i + 1u], indices[i + 2u] };
+			std::rotate( t.begin(), std::min_element( t.begin(), t.end() ), t.end() );
+			triangles.push_back( t );
+		}
+		std::sort( triangles.begin(), triangles.end() );
+		return triangles;
+	}
+
+	using PositionTriangle = std::array<std::tuple<float, float, float>, 3>;
+
+	/**
+	 * @brief Same as triangle_multiset but with the positions of the corners, for buffers whose vertices moved
+	*/
+	std::vector<PositionTriangle> position_multiset( const VertexByteBuffer& vertices, const std::vector<uint32_t>& indices )
+	{
+		const auto positions = vertices.View<Type::Position3D>();
+		std::vector<PositionTriangle> triangles;
+		for( size_t i = 0; i + 2u < indices.size(); i += 3u )
+		{
+			PositionTriangle t;
+			for( size_t k = 0; k < 3u; k++ )
+			{
+				const auto& p = positions[indices[i + k]];
+				t[k] = { p.x, p.y, p.z };
+			}
+			std::rotate( t.begin(), std::min_element( t.begin(), t.end() ), t.end() );
+			triangles.push_back( t );
+		}
+		std::sort( triangles.begin(), triangles.end() );
+		return triangles;
+	}
+
+	float acmr( const std::vector<uint32_t>& indices, size_t vertexCount )
+	{
+		return float( MeshOptimizer::CountTransforms( indices, vertexCount ) ) / float( indices.size() / 3u );
+	}
+
+	std::vector<uint32_t> to_list( const IndexByteBuffer& indices )
+	{
+		std::vector<uint32_t> list( indices.Count() );
+		for( size_t i = 0; i < list.size(); i++ )
+		{
+			list[i] = indices[i];
+		}
+		return list;
+	}
+}
+
+IRON_TEST( TipsifyKeepsTrianglesAndLowersAcmr )
+{
+	const auto sphere = make_sphere( 48u, 96u, 1u );
+	const auto vertexCount = sphere.vertices.Size();
+	const auto optimized = MeshOptimizer::OptimizeVertexCache( sphere.indices, vertexCount );
+	IRON_CHECK( triangle_multiset( optimized ) == triangle_multiset( sphere.indices ) );
+
+	const float before = acmr( sphere.indices, vertexCount );
+	const float after = acmr( optimized, vertexCount );
+	IRON_CHECK( after < before );
+	IRON_CHECK( after <= MAX_TIPSIFY_ACMR );
+}
+
+IRON_TEST( OverdrawClustersKeepAcmrThreshold )
+{
+	const auto sphere = make_sphere( 48u, 96u, 2u );
+	const auto vertexCount = sphere.vertices.Size();
+	const auto cacheOrder = MeshOptimizer::OptimizeVertexCache( sphere.indices, vertexCount );
+	const auto positions = sphere.vertices.View<Type::Position3D>();
+	const auto clustered = MeshOptimizer::OptimizeOverdraw( cacheOrder, positions, OVERDRAW_THRESHOLD );
+	IRON_CHECK( triangle_multiset( clustered ) == triangle_multiset( sphere.indices ) );
+	// a sphere has clusters facing every way, so they have to be sorted
+	IRON_CHECK( clustered != cacheOrder );
+	// every cluster stays within the threshold of the order it was cut from, starting with an empty cache
+	IRON_CHECK( acmr( clustered, vertexCount ) <= OVERDRAW_THRESHOLD * acmr( cacheOrder, vertexCount ) );
+}
+
+IRON_TEST( VertexFetchOrdersVerticesByFirstUse )
+{
+	auto sphere = make_sphere( 16u, 32u, 3u );
+	const auto source = sphere.vertices;
+	const auto sourceIndices = sphere.indices;
+	const size_t used = MeshOptimizer::OptimizeVertexFetch( sphere.vertices, sphere.indices );
+	IRON_CHECK( used == source.Size() - sphere.unusedCount );
+	IRON_CHECK( sphere.vertices.Size() == used );
+
+	// the first use of every vertex is the one after the largest index so far
+	uint32_t next = 0u;
+	size_t outOfOrder = 0u;
+	for( const auto i : sphere.indices )
+	{
+		if( i == next )
+		{
+			next++;
+		}
+		else if( i > next )
+		{
+			outOfOrder++;
+		}
+	}
+	IRON_CHECK( outOfOrder == 0u );
+	IRON_CHECK( next == used );
+
+	// every corner still has the position it had before the remap
+	const auto before = source.View<Type::Position3D>();
+	const auto after = std::as_const( sphere.vertices ).View<Type::Position3D>();
+	size_t moved = 0u;
+	for( size_t i = 0; i < sphere.indices.size(); i++ )
+	{
+		const auto& a = before[sourceIndices[i]];
+		const auto& b = after[sphere.indices[i]];
+		moved += a.x != b.x || a.y != b.y || a.z != b.z;
+	}
+	IRON_CHECK( moved == 0u );
+}
+
+IRON_TEST( OptimizeReportsFewerTransforms )
+{
+	auto sphere = make_sphere( 48u, 96u, 4u );
+	const auto expected = position_multiset( sphere.vertices, sphere.indices );
+	IndexByteBuffer indices( sphere.indices );
+	std::vector<MeshletSet::Meshlet> meshlets;
+	const auto stats = MeshOptimizer::Optimize( sphere.vertices, indices, &meshlets );
+	const auto list = to_list( indices );
+
+	IRON_CHECK( stats.triangleCount == sphere.indices.size() / 3u );
+	IRON_CHECK( position_multiset( sphere.vertices, list ) == expected );
+	IRON_CHECK( stats.transformsAfter < stats.transformsBefore );
+	IRON_CHECK( stats.transformsAfter == MeshOptimizer::CountTransforms( list, sphere.vertices.Size() ) );
+	// ATVR, the reused vertices of a closed grid cost a few extra transforms
+	IRON_CHECK( float( stats.transformsAfter ) / float( sphere.vertices.Size() ) < 1.6f );
+	IRON_CHECK( !meshlets.empty() );
+}
@@ -0,0 +1,215 @@
+/*!
+ * \file MeshletSetTests.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Partition, limits and cone bounds of meshlets built from synthetic meshes
+ *
+ * \note Cones are tested on the lanes of the blocks with the inequality that Frustum::CullMeshlets
+ * * evaluates four at a time, from eyes inside, near and far away of the meshes.
+*/
+#include "IronTest.h"
+#include "MeshletSet.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+	namespace dx = DirectX;
+
+	struct TestMesh
+	{
+		std::vector<dx::XMFLOAT3> positions;
+		std::vector<uint32_t> indices;
+
+		StridedView<const dx::XMFLOAT3> View() const noexcept
+		{
+			return { positions.data(), sizeof( dx::XMFLOAT3 ), positions.size() };
+		}
+	};
+
+	/**
+	 * @brief Closed sphere with a wavy surface, so neighboring meshlets face different ways,
+	 * * followed by loose triangles that the meshlets have to pack without adjacency
+	*/
+	TestMesh make_mesh( uint32_t stacks, uint32_t slices, size_t looseCount )
+	{
+		TestMesh mesh;
+		for( uint32_t i = 0; i <= stacks; i++ )
+		{
+			const float theta = 3.14159265f * float( i ) / float( stacks );
+			for( uint32_t j = 0; j < slices; j++ )
+			{
+				const float phi = 6.28318531f * float( j ) / float( slices );
+				const float r = 1.f + 0.03f * std::sin( 5.f * theta ) * std::cos( 7.f * phi );
+				mesh.positions.push_back( { r * std::sin( theta ) * std::cos( phi ), r * std::cos( theta ), r * std::sin( theta ) * std::sin( phi ) } );
+			}
+		}
+		for( uint32_t i = 0; i < stacks; i++ )
+		{
+			for( uint32_t j = 0; j < slices; j++ )
+			{
+				const uint32_t a = i * slices + j;
+				const uint32_t b = i * slices + ( j + 1u ) % slices;
+				const uint32_t c = a + slices;
+				const uint32_t d = b + slices;
+				// the triangles at the poles are degenerate, they have no normal to bound
+				mesh.indices.insert( mesh.indices.end(), { a, c, b, b, c, d } );
+			}
+		}
+		std::mt19937 rng( 7u );
+		std::uniform_real_distribution<float> coordinate( -3.f, 3.f );
+		for( size_t t = 0; t < looseCount; t++ )
+		{
+			const auto first = uint32_t( mesh.positions.size() );
+			const dx::XMFLOAT3 p = { coordinate( rng ), coordinate( rng ), coordinate( rng ) };
+			mesh.positions.push_back( p );
+			mesh.positions.push_back( { p.x + 0.1f, p.y, p.z } );
+			mesh.positions.push_back( { p.x, p.y + 0.1f, p.z + 0.05f } );
+			mesh.indices.insert( mesh.indices.end(), { first, first + 1u, first + 2u } );
+		}
+		return mesh;
+	}
+
+	std::vector<std::array<uint32_t, 3>> triangle_multiset( const std::vector<uint32_t>& indices )
+	{
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for( size_t i = 0; i + 2u < indices.size(); i += 3u )
+		{
+			std::array<uint32_t, 3> t = { indices[i], indices[i + 1u], indices[i + 2u] };
+			std::rotate( t.begin(), std::min_element( t.begin(), t.end() ), t.end() );
+			triangles.push_back( t );
+		}
+		std::sort( triangles.begin(), triangles.end() );
+		return triangles;
+	}
+
+	/**
+	 * @brief Cone test of a lane as CullMeshlets does it, true if the meshlet is culled as back facing
+	*/
+	bool lane_faces_away( const MeshletSet::Block& block, size_t lane, const dx::XMFLOAT3& eye )
+	{
+		const float vx = block.centerX[lane] - eye.x;
+		const float vy = block.centerY[lane] - eye.y;
+		const float vz = block.centerZ[lane] - eye.z;
+		const float length = std::sqrt( vx * vx + vy * vy + vz * vz );
+		const float along = vx * block.axisX[lane] + vy * block.axisY[lane] + vz * block.axisZ[lane];
+		return along >= block.cutoff[lane] * length + block.radius[lane];
+	}
+
+	/**
+	 * @brief Triangle faces the eye if the eye is on the side its normal points to
+	*/
+	bool faces_eye( const TestMesh& mesh, const uint32_t* pTriangle, const dx::XMFLOAT3& eye )
+	{
+		const auto p0 = dx::XMLoadFloat3( &mesh.positions[pTriangle[0]] );
+		const auto p1 = dx::XMLoadFloat3( &mesh.positions[pTriangle[1]] );
+		const auto p2 = dx::XMLoadFloat3( &mesh.positions[pTriangle[2]] );
+		const auto n = dx::XMVector3Cross( dx::XMVectorSubtract( p1, p0 ), dx::XMVectorSubtract( p2, p0 ) );
+		const auto toEye = dx::XMVectorSubtract( dx::XMLoadFloat3( &eye ), p0 );
+		// triangles seen edge on within rounding can go either way
+		const float tolerance = 1e-5f * dx::XMVectorGetX( dx::XMVector3Length( n ) ) * dx::XMVectorGetX( dx::XMVector3Length( toEye ) );
+		return dx::XMVectorGetX( dx::XMVector3Dot( n, toEye ) ) > tolerance;
+	}
+}
+
+IRON_TEST( MeshletsPartitionTriangles )
+{
+	auto mesh = make_mesh( 40u, 80u, 300u );
+	const auto source = mesh.indices;
+	const auto meshlets = MeshletSet::Build( mesh.indices, mesh.View() );
+	IRON_CHECK( !meshlets.empty() );
+	IRON_CHECK( triangle_multiset( mesh.indices ) == triangle_multiset( source ) );
+
+	// ranges follow each other without gaps or overlaps, so every triangle is in exactly one meshlet
+	uint32_t next = 0u;
+	size_t misplaced = 0u;
+	for( const auto& m : meshlets )
+	{
+		misplaced += m.startIndex != next || m.indexCount % 3u != 0u || m.indexCount == 0u;
+		next = m.startIndex + m.indexCount;
+	}
+	IRON_CHECK( misplaced == 0u );
+	IRON_CHECK( next == mesh.indices.size() );
+}
+
+IRON_TEST( MeshletsRespectLimits )
+{
+	const size_t limits[][2] = {
+		{ MeshletSet::MAX_VERTICES, MeshletSet::MAX_TRIANGLES },
+		{ 32u, 40u },
+		// vertex bound meshlets, fewer vertices than a fan of the triangle limit needs
+		{ 16u, 124u },
+	};
+	for( const auto& limit : limits )
+	{
+		auto mesh = make_mesh( 30u, 60u, 100u );
+		const auto meshlets = MeshletSet::Build( mesh.indices, mesh.View(), limit[0], limit[1] );
+		size_t over = 0u;
+		size_t outsideBounds = 0u;
+		for( const auto& m : meshlets )
+		{
+			std::vector<uint32_t> vertices( mesh.indices.begin() + m.startIndex, mesh.indices.begin() + m.startIndex + m.indexCount );
+			std::sort( vertices.begin(), vertices.end() );
+			vertices.erase( std::unique( vertices.begin(), vertices.end() ), vertices.end() );
+			over += vertices.size() > limit[0] || m.indexCount / 3u > limit[1];
+			for( const auto v : vertices )
+			{
+				const auto& p = mesh.positions[v];
+				const float x = p.x - m.center.x;
+				const float y = p.y - m.center.y;
+				const float z = p.z - m.center.z;
+				outsideBounds += std::sqrt( x * x + y * y + z * z ) > m.radius * 1.0001f + 1e-6f;
+			}
+		}
+		IRON_CHECK( over == 0u );
+		IRON_CHECK( outsideBounds == 0u );
+	}
+}
+
+IRON_TEST( ConesNeverCullFrontFacingTriangles )
+{
+	auto mesh = make_mesh( 40u, 80u, 50u );
+	const MeshletSet set( MeshletSet::Build( mesh.indices, mesh.View() ) );
+	const auto& meshlets = set.GetMeshlets();
+
+	// eyes inside of the sphere, close to its surface and far away, in all directions
+	std::mt19937 rng( 11u );
+	std::normal_distribution<float> gaussian;
+	const float distances[] = { 0.3f, 1.2f, 2.f, 5.f, 50.f };
+	size_t wrongCulls = 0u;
+	size_t culled = 0u;
+	size_t tests = 0u;
+	for( const auto distance : distances )
+	{
+		for( size_t e = 0; e < 64u; e++ )
+		{
+			auto direction = dx::XMVector3Normalize( dx::XMVectorSet( gaussian( rng ), gaussian( rng ), gaussian( rng ), 0.f ) );
+			dx::XMFLOAT3 eye;
+			dx::XMStoreFloat3( &eye, dx::XMVectorScale( direction, distance ) );
+			for( size_t i = 0; i < meshlets.size(); i++ )
+			{
+				tests++;
+				if( !lane_faces_away( set.GetBlock( i / MeshletSet::BLOCK_SIZE ), i % MeshletSet::BLOCK_SIZE, eye ) )
+				{
+					continue;
+				}
+				culled++;
+				const auto& m = meshlets[i];
+				for( uint32_t t = m.startIndex; t < m.startIndex + m.indexCount; t += 3u )
+				{
+					wrongCulls += faces_eye( mesh, &mesh.indices[t], eye );
+				}
+			}
+		}
+	}
+	IRON_CHECK( wrongCulls == 0u );
+	// the test only means something if the cones do cull, eyes inside and close to the sphere cull
+	// next to nothing, the far ones a good part of the meshlets
+	IRON_CHECK( culled > tests / 25u );
+}
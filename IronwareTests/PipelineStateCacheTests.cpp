@@ -0,0 +1,335 @@
+/*!
+ * \file PipelineStateCacheTests.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Drives PipelineStateCache the way bindables do, against a recording stand-in for the context
+ *
+ * \note The stand-in keeps the slots it was told to bind and unbinds shader resources
+ * * that alias new output targets, like the d3d runtime does. Replaying a frame with the cache
+ * * has to leave the stand-in in the same state at every draw as replaying it without the cache.
+*/
+#include "IronTest.h"
+#include "PipelineStateCache.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	using Stage = PipelineStateCache::Stage;
+
+	struct Slot
+	{
+		const void* pObject = nullptr;
+		uint64_t extra = 0u;
+
+		bool operator==( const Slot& rhs ) const noexcept { return pObject == rhs.pObject && extra == rhs.extra; }
+	};
+
+	class RecordingContext
+	{
+	public:
+		void Set( Stage stage, unsigned slot, const void* pObject, uint64_t extra ) noexcept
+		{
+			slots[(size_t)stage][slot] = { pObject, extra };
+			calls++;
+		}
+		void SetOutputTargets( const void* pRenderTarget, const void* pDepthStencil ) noexcept
+		{
+			for( auto& s : slots[(size_t)Stage::PSShaderResource] )
+			{
+				if( s.pObject != nullptr && ( s.pObject == pRenderTarget || s.pObject == pDepthStencil ) )
+				{
+					s = {};
+				}
+			}
+			calls++;
+		}
+		bool SameState( const RecordingContext& rhs ) const noexcept
+		{
+			return slots == rhs.slots;
+		}
+		size_t GetCalls() const noexcept { return calls; }
+
+	private:
+		std::array<std::array<Slot, PipelineStateCache::MAX_SLOTS>, (size_t)Stage::Count> slots;
+		size_t calls = 0u;
+	};
+
+	// one command of a captured frame, either a bind, a change of output targets or a draw
+	struct Command
+	{
+		enum class Kind
+		{
+			Bind,
+			Targets,
+			Draw,
+		};
+
+		Kind kind;
+		Stage stage = Stage::Count;
+		unsigned slot = 0u;
+		const void* pObject = nullptr;
+		const void* pDepthStencil = nullptr;
+		uint64_t extra = 0u;
+	};
+
+	// distinct addresses stand in for d3d objects
+	const void* object( size_t id ) noexcept
+	{
+		static std::array<char, 4096u> pool;
+		return pool.data() + id;
+	}
+
+	/**
+	 * @brief Frame like the blur outline graph submits: a shadow pass, a lambertian pass that samples
+	 * * the shadow map and an outline pass that renders into the target sampled by the next pass
+	*/
+	std::vector<Command> capture_frame( size_t jobsPerPass )
+	{
+		enum : size_t
+		{
+			BackBuffer = 1u, MasterDepth, ShadowMap, Scratch, ShadowSampler, Sampler,
+			ShadowVS, LambertianVS, LambertianPS, OutlineVS, OutlinePS, BlurPS,
+			Topology, Rasterizer, Blend, DepthState, InputLayout, FullscreenVB,
+			FirstMesh = 100u, FirstMaterial = 1000u, FirstTransform = 2000u,
+		};
+		constexpr size_t meshes = 40u;
+		constexpr size_t materials = 6u;
+
+		std::vector<Command> frame;
+		const auto bind = [&]( Stage stage, unsigned slot, size_t id, uint64_t extra = 0u )
+		{
+			frame.push_back( { Command::Kind::Bind, stage, slot, object( id ), nullptr, extra } );
+		};
+		const auto targets = [&]( size_t rt, size_t ds )
+		{
+			frame.push_back( { Command::Kind::Targets, Stage::Count, 0u, rt ? object( rt ) : nullptr, ds ? object( ds ) : nullptr } );
+		};
+		const auto draw = [&]()
+		{
+			frame.push_back( { Command::Kind::Draw } );
+		};
+		// every job binds its whole technique step, jobs are sorted by material like the queues sort them
+		const auto jobs = [&]( size_t vs, size_t ps, bool textured )
+		{
+			for( size_t j = 0; j < jobsPerPass; j++ )
+			{
+				const auto material = j * materials / jobsPerPass;
+				const auto mesh = ( j * 7u ) % meshes;
+				bind( Stage::IATopology, 0u, Topology, 4u );
+				bind( Stage::IAInputLayout, 0u, InputLayout );
+				bind( Stage::IAVertexBuffer, 0u, FirstMesh + mesh );
+				bind( Stage::IAIndexBuffer, 0u, FirstMesh + meshes + mesh );
+				bind( Stage::VSShader, 0u, vs );
+				bind( Stage::VSConstantBuffer, 0u, FirstTransform + j );
+				bind( Stage::PSShader, 0u, ps );
+				bind( Stage::RSState, 0u, Rasterizer );
+				bind( Stage::OMBlendState, 0u, Blend );
+				bind( Stage::OMDepthStencilState, 0u, DepthState );
+				if( textured )
+				{
+					bind( Stage::PSConstantBuffer, 1u, FirstMaterial + material );
+					bind( Stage::PSShaderResource, 0u, FirstMaterial + materials + material );
+					bind( Stage::PSShaderResource, 3u, ShadowMap );
+					bind( Stage::PSSampler, 0u, Sampler );
+					bind( Stage::PSSampler, 1u, ShadowSampler );
+				}
+				draw();
+			}
+		};
+
+		targets( 0u, ShadowMap );
+		jobs( ShadowVS, 0u, false );
+		targets( BackBuffer, MasterDepth );
+		jobs( LambertianVS, LambertianPS, true );
+		targets( Scratch, 0u );
+		jobs( OutlineVS, OutlinePS, false );
+		// fullscreen blur samples the scratch target after rendering into the back buffer again
+		targets( BackBuffer, MasterDepth );
+		bind( Stage::IAVertexBuffer, 0u, FullscreenVB );
+		bind( Stage::PSShader, 0u, BlurPS );
+		bind( Stage::PSShaderResource, 0u, Scratch );
+		draw();
+		// the next frame starts with shadow map bound as output while the lambertian pass left it as input
+		targets( 0u, ShadowMap );
+		jobs( ShadowVS, 0u, false );
+		targets( BackBuffer, MasterDepth );
+		jobs( LambertianVS, LambertianPS, true );
+		return frame;
+	}
+
+	/**
+	 * @brief Issues the commands like bindables do, asking the cache before every bind
+	 * @return true if the context matched the uncached context at every draw
+	*/
+	bool replay( const std::vector<Command>& frame, PipelineStateCache& cache, RecordingContext& context, RecordingContext* pReference )
+	{
+		bool same = true;
+		for( const auto& c : frame )
+		{
+			switch( c.kind )
+			{
+			case Command::Kind::Bind:
+				if( cache.Set( c.stage, c.slot, c.pObject, c.extra ) )
+				{
+					context.Set( c.stage, c.slot, c.pObject, c.extra );
+				}
+				if( pReference )
+				{
+					pReference->Set( c.stage, c.slot, c.pObject, c.extra );
+				}
+				break;
+			case Command::Kind::Targets:
+				context.SetOutputTargets( c.pObject, c.pDepthStencil );
+				cache.OutputTargetsChanged();
+				if( pReference )
+				{
+					pReference->SetOutputTargets( c.pObject, c.pDepthStencil );
+				}
+				break;
+			case Command::Kind::Draw:
+				if( pReference )
+				{
+					same = same && context.SameState( *pReference );
+				}
+				break;
+			}
+		}
+		return same;
+	}
+}
+
+IRON_TEST( CacheSkipsRedundantBinds )
+{
+	PipelineStateCache cache;
+	int a = 0, b = 0;
+	IRON_CHECK( cache.Set( Stage::PSShader, &a ) );
+	IRON_CHECK( !cache.Set( Stage::PSShader, &a ) );
+	IRON_CHECK( cache.Set( Stage::PSShader, &b ) );
+	// extra parameters are part of the state
+	IRON_CHECK( cache.Set( Stage::IAVertexBuffer, &a, 0u ) );
+	IRON_CHECK( cache.Set( Stage::IAVertexBuffer, &a, 16u ) );
+	IRON_CHECK( !cache.Set( Stage::IAVertexBuffer, &a, 16u ) );
+	// slots are independent
+	IRON_CHECK( cache.Set( Stage::PSShaderResource, 0u, &a ) );
+	IRON_CHECK( cache.Set( Stage::PSShaderResource, 1u, &a ) );
+	IRON_CHECK( !cache.Set( Stage::PSShaderResource, 0u, &a ) );
+	// slots past the cached range are always issued
+	IRON_CHECK( cache.Set( Stage::PSShaderResource, PipelineStateCache::MAX_SLOTS, &a ) );
+	IRON_CHECK( cache.Set( Stage::PSShaderResource, PipelineStateCache::MAX_SLOTS, &a ) );
+}
+
+IRON_TEST( OutputTargetsInvalidateShaderResources )
+{
+	PipelineStateCache cache;
+	int view = 0, shader = 0, sampler = 0;
+	cache.Set( Stage::PSShaderResource, 3u, &view );
+	cache.Set( Stage::PSShader, &shader );
+	cache.Set( Stage::PSSampler, 1u, &sampler );
+	cache.OutputTargetsChanged();
+	// the runtime may have unbound the view, it has to be bound again
+	IRON_CHECK( cache.Set( Stage::PSShaderResource, 3u, &view ) );
+	IRON_CHECK( !cache.Set( Stage::PSShaderResource, 3u, &view ) );
+	// other stages aren't touched by output targets
+	IRON_CHECK( !cache.Set( Stage::PSShader, &shader ) );
+	IRON_CHECK( !cache.Set( Stage::PSSampler, 1u, &sampler ) );
+}
+
+IRON_TEST( InvalidateStageAndDisable )
+{
+	PipelineStateCache cache;
+	int a = 0;
+	cache.Set( Stage::VSConstantBuffer, 2u, &a );
+	cache.Set( Stage::PSConstantBuffer, 2u, &a );
+	cache.Invalidate( Stage::VSConstantBuffer );
+	IRON_CHECK( cache.Set( Stage::VSConstantBuffer, 2u, &a ) );
+	IRON_CHECK( !cache.Set( Stage::PSConstantBuffer, 2u, &a ) );
+	cache.Invalidate();
+	IRON_CHECK( cache.Set( Stage::PSConstantBuffer, 2u, &a ) );
+
+	cache.SetEnabled( false );
+	IRON_CHECK( cache.Set( Stage::PSConstantBuffer, 2u, &a ) );
+	IRON_CHECK( cache.Set( Stage::PSConstantBuffer, 2u, &a ) );
+	cache.SetEnabled( true );
+	IRON_CHECK( cache.Set( Stage::PSConstantBuffer, 2u, &a ) );
+	IRON_CHECK( !cache.Set( Stage::PSConstantBuffer, 2u, &a ) );
+}
+
+IRON_TEST( NewFrameResetsCacheAndPublishesStats )
+{
+	PipelineStateCache cache;
+	int a = 0, b = 0;
+	cache.Set( Stage::PSShader, &a );
+	cache.Set( Stage::PSShader, &a );
+	cache.Set( Stage::PSShader, &a );
+	cache.Set( Stage::VSShader, &b );
+	IRON_CHECK( cache.GetFrameStats().issued == 0u && cache.GetFrameStats().skipped == 0u );
+
+	cache.NewFrame();
+	IRON_CHECK( cache.GetFrameStats().issued == 2u );
+	IRON_CHECK( cache.GetFrameStats().skipped == 2u );
+	// state of the previous frame isn't trusted
+	IRON_CHECK( cache.Set( Stage::PSShader, &a ) );
+	IRON_CHECK( cache.Set( Stage::VSShader, &b ) );
+
+	cache.NewFrame();
+	IRON_CHECK( cache.GetFrameStats().issued == 2u );
+	IRON_CHECK( cache.GetFrameStats().skipped == 0u );
+}
+
+IRON_TEST( ReplayedFrameMatchesUncachedContext )
+{
+	const auto frame = capture_frame( 300u );
+	PipelineStateCache cache;
+	RecordingContext cached;
+	RecordingContext reference;
+	IRON_CHECK( replay( frame, cache, cached, &reference ) );
+	IRON_CHECK( cached.GetCalls() < reference.GetCalls() );
+	cache.NewFrame();
+	const auto& stats = cache.GetFrameStats();
+	const auto targetChanges = size_t( std::count_if( frame.begin(), frame.end(), []( const Command& c ) { return c.kind == Command::Kind::Targets; } ) );
+	IRON_CHECK( stats.issued + targetChanges == cached.GetCalls() );
+	IRON_CHECK( stats.issued + stats.skipped + targetChanges == reference.GetCalls() );
+
+	// a disabled cache issues every bind
+	PipelineStateCache disabled;
+	disabled.SetEnabled( false );
+	RecordingContext uncached;
+	RecordingContext uncachedReference;
+	IRON_CHECK( replay( frame, disabled, uncached, &uncachedReference ) );
+	IRON_CHECK( uncached.GetCalls() == uncachedReference.GetCalls() );
+}
+
+IRON_TEST( ReplayBenchmark )
+{
+	using namespace std::chrono;
+	const auto frame = capture_frame( 2000u );
+	constexpr size_t frames = 50u;
+
+	const auto run = [&]( bool enabled )
+	{
+		PipelineStateCache cache;
+		cache.SetEnabled( enabled );
+		RecordingContext context;
+		const auto start = steady_clock::now();
+		for( size_t f = 0; f < frames; f++ )
+		{
+			replay( frame, cache, context, nullptr );
+			cache.NewFrame();
+		}
+		const auto time = duration<float, std::micro>( steady_clock::now() - start ).count() / float( frames );
+		std::printf( "  cache %s: %zu of %zu binds issued, %.1f us per frame\n", enabled ? "on" : "off",
+			cache.GetFrameStats().issued, cache.GetFrameStats().issued + cache.GetFrameStats().skipped, time );
+		return cache.GetFrameStats();
+	};
+	const auto on = run( true );
+	const auto off = run( false );
+	IRON_CHECK( on.issued + on.skipped == off.issued );
+	IRON_CHECK( on.issued < off.issued );
+}
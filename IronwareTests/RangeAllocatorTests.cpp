@@ -0,0 +1,203 @@
+/*!
+ * \file RangeAllocatorTests.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Placement, merging and defragmentation of RangeAllocator on small capacities
+ *
+ * \note Free ranges are not exposed, so they are observed through the stats and through
+ * * the offsets that the next allocations get.
+*/
+#include "IronTest.h"
+#include "RangeAllocator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+IRON_TEST( AllocateTakesBestFit )
+{
+	RangeAllocator allocator( 100u );
+	const auto a = allocator.Allocate( 10u );
+	const auto b = allocator.Allocate( 30u );
+	const auto c = allocator.Allocate( 5u );
+	const auto d = allocator.Allocate( 20u );
+	const auto e = allocator.Allocate( 5u );
+	IRON_CHECK( allocator.GetOffset( a ) == 0u );
+	IRON_CHECK( allocator.GetOffset( c ) == 40u );
+	IRON_CHECK( allocator.GetOffset( e ) == 65u );
+
+	// free ranges of 30 at 10, 20 at 45 and the tail of 30 at 70
+	allocator.Free( b );
+	allocator.Free( d );
+	const auto fit = allocator.Allocate( 15u );
+	IRON_CHECK( allocator.GetOffset( fit ) == 45u );
+	IRON_CHECK( allocator.GetSize( fit ) == 15u );
+	// two ranges of 30, the lower one is taken
+	const auto lower = allocator.Allocate( 30u );
+	IRON_CHECK( allocator.GetOffset( lower ) == 10u );
+	IRON_CHECK( allocator.Allocate( 31u ) == RangeAllocator::INVALID_HANDLE );
+	IRON_CHECK( allocator.Allocate( 0u ) == RangeAllocator::INVALID_HANDLE );
+	const auto rest = allocator.Allocate( 5u );
+	IRON_CHECK( allocator.GetOffset( rest ) == 60u );
+}
+
+IRON_TEST( FreeCoalescesNeighbors )
+{
+	RangeAllocator allocator( 40u );
+	const auto a = allocator.Allocate( 10u );
+	const auto b = allocator.Allocate( 10u );
+	const auto c = allocator.Allocate( 10u );
+	const auto d = allocator.Allocate( 10u );
+
+	allocator.Free( b );
+	IRON_CHECK( allocator.GetStats().freeRangeCount == 1u );
+	// merges with the free range on its left
+	allocator.Free( c );
+	IRON_CHECK( allocator.GetStats().freeRangeCount == 1u );
+	IRON_CHECK( allocator.GetStats().largestFreeRange == 20u );
+	// merges with the free range on its right
+	allocator.Free( a );
+	IRON_CHECK( allocator.GetStats().freeRangeCount == 1u );
+	IRON_CHECK( allocator.GetStats().largestFreeRange == 30u );
+	const auto merged = allocator.Allocate( 30u );
+	IRON_CHECK( allocator.GetOffset( merged ) == 0u );
+
+	// merges with both neighbors at once
+	allocator.Free( merged );
+	allocator.Free( d );
+	const auto stats = allocator.GetStats();
+	IRON_CHECK( stats.freeRangeCount == 1u );
+	IRON_CHECK( stats.largestFreeRange == 40u );
+	IRON_CHECK( stats.used == 0u );
+	IRON_CHECK( stats.allocationCount == 0u );
+
+	RangeAllocator gap( 30u );
+	const auto left = gap.Allocate( 10u );
+	const auto middle = gap.Allocate( 10u );
+	const auto right = gap.Allocate( 10u );
+	gap.Free( left );
+	gap.Free( right );
+	IRON_CHECK( gap.GetStats().freeRangeCount == 2u );
+	gap.Free( middle );
+	IRON_CHECK( gap.GetStats().freeRangeCount == 1u );
+	IRON_CHECK( gap.GetStats().largestFreeRange == 30u );
+}
+
+IRON_TEST( GrowMergesFreeTail )
+{
+	RangeAllocator allocator( 30u );
+	const auto a = allocator.Allocate( 20u );
+	allocator.Grow( 50u );
+	IRON_CHECK( allocator.GetCapacity() == 50u );
+	IRON_CHECK( allocator.GetStats().freeRangeCount == 1u );
+	IRON_CHECK( allocator.GetStats().largestFreeRange == 30u );
+	const auto tail = allocator.Allocate( 30u );
+	IRON_CHECK( allocator.GetOffset( tail ) == 20u );
+
+	// smaller capacities are ignored
+	allocator.Grow( 10u );
+	IRON_CHECK( allocator.GetCapacity() == 50u );
+
+	// without a free tail the new space is a range of its own
+	allocator.Free( a );
+	allocator.Grow( 60u );
+	IRON_CHECK( allocator.GetStats().freeRangeCount == 2u );
+	IRON_CHECK( allocator.GetStats().largestFreeRange == 20u );
+
+	RangeAllocator empty;
+	IRON_CHECK( empty.Allocate( 1u ) == RangeAllocator::INVALID_HANDLE );
+	empty.Grow( 8u );
+	IRON_CHECK( empty.GetOffset( empty.Allocate( 8u ) ) == 0u );
+}
+
+IRON_TEST( DefragmentPacksAndMergesMoves )
+{
+	RangeAllocator allocator( 100u );
+	std::vector<RangeAllocator::Handle> handles;
+	for( size_t i = 0; i < 7u; i++ )
+	{
+		handles.push_back( allocator.Allocate( 10u ) );
+	}
+	// the buffer that the allocator manages, every range is filled with its handle
+	std::vector<int> memory( allocator.GetCapacity(), -1 );
+	for( const auto h : handles )
+	{
+		std::fill_n( memory.begin() + allocator.GetOffset( h ), allocator.GetSize( h ), int( h ) );
+	}
+	allocator.Free( handles[1] );
+	allocator.Free( handles[4] );
+
+	const auto moves = allocator.Defragment();
+	// neighbors that move by the same distance are merged into one move
+	IRON_CHECK( moves.size() == 2u );
+	if( moves.size() == 2u )
+	{
+		IRON_CHECK( moves[0].from == 20u && moves[0].to == 10u && moves[0].size == 20u );
+		IRON_CHECK( moves[1].from == 50u && moves[1].to == 30u && moves[1].size == 20u );
+	}
+	for( const auto& m : moves )
+	{
+		IRON_CHECK( m.to <= m.from );
+		std::memmove( memory.data() + m.to, memory.data() + m.from, m.size * sizeof( int ) );
+	}
+
+	size_t expected = 0u;
+	size_t corrupted = 0u;
+	for( const size_t i : { 0u, 2u, 3u, 5u, 6u } )
+	{
+		const auto h = handles[i];
+		IRON_CHECK( allocator.GetOffset( h ) == expected );
+		for( size_t k = 0; k < allocator.GetSize( h ); k++ )
+		{
+			corrupted += memory[allocator.GetOffset( h ) + k] != int( h );
+		}
+		expected += allocator.GetSize( h );
+	}
+	IRON_CHECK( corrupted == 0u );
+
+	const auto stats = allocator.GetStats();
+	IRON_CHECK( stats.freeRangeCount == 1u );
+	IRON_CHECK( stats.largestFreeRange == 50u );
+	IRON_CHECK( allocator.GetOffset( allocator.Allocate( 50u ) ) == 50u );
+
+	// nothing to move once packed
+	IRON_CHECK( allocator.Defragment().empty() );
+}
+
+IRON_TEST( StatsTrackFragmentation )
+{
+	RangeAllocator allocator( 100u );
+	std::vector<RangeAllocator::Handle> handles;
+	for( size_t i = 0; i < 10u; i++ )
+	{
+		handles.push_back( allocator.Allocate( 10u ) );
+	}
+	auto stats = allocator.GetStats();
+	IRON_CHECK( stats.capacity == 100u );
+	IRON_CHECK( stats.used == 100u );
+	IRON_CHECK( stats.allocationCount == 10u );
+	IRON_CHECK( stats.freeRangeCount == 0u );
+	IRON_CHECK( stats.largestFreeRange == 0u );
+
+	// every other range freed, half of the space is free but nothing larger than 10 fits
+	for( size_t i = 0; i < handles.size(); i += 2u )
+	{
+		allocator.Free( handles[i] );
+	}
+	stats = allocator.GetStats();
+	IRON_CHECK( stats.used == 50u );
+	IRON_CHECK( stats.allocationCount == 5u );
+	IRON_CHECK( stats.freeRangeCount == 5u );
+	IRON_CHECK( stats.largestFreeRange == 10u );
+	IRON_CHECK( allocator.Allocate( 11u ) == RangeAllocator::INVALID_HANDLE );
+
+	// the handle of the last free is reused for the lowest range
+	const auto reused = allocator.Allocate( 10u );
+	IRON_CHECK( reused == handles[8] );
+	IRON_CHECK( allocator.GetOffset( reused ) == 0u );
+	stats = allocator.GetStats();
+	IRON_CHECK( stats.allocationCount == 6u );
+	IRON_CHECK( stats.freeRangeCount == 4u );
+}
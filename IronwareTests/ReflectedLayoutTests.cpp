@@ -0,0 +1,109 @@
+/*!
+ * \file ReflectedLayoutTests.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Offsets of the reflected constant buffers against their cooked layouts and tables
+ *
+ * \note Every field is looked up in the tree of the cooked layout and in the table compiled from it,
+ * * both have to agree with the offset that the C++ compiler gave the member.
+*/
+#include "IronTest.h"
+#include "BlurConstants.h"
+#include "PointLightCBuf.h"
+#include "ReflectedLayout.h"
+
+#include <cstring>
+
+namespace
+{
+	// the second vector would straddle a register in hlsl, so it starts 4 bytes later than in C++
+	struct MisPackedCBuf
+	{
+		DirectX::XMFLOAT3 first;
+		DirectX::XMFLOAT3 second;
+		CBUFFER_FIELDS( MisPackedCBuf, CBUFFER_FIELD( first ), CBUFFER_FIELD( second ) )
+	};
+
+	/**
+	 * @return number of fields whose offset, type or stride differs in the tree or in the table of the layout
+	*/
+	template<typename S>
+	size_t count_mismatched_fields()
+	{
+		const auto cooked = ReflectedLayout<S>::Cook();
+		const auto& root = *cooked.ShareRoot();
+		const auto& table = cooked.GetTable();
+		const auto& records = table.GetRecords();
+		size_t mismatches = 0u;
+		for( const auto& f : ReflectedLayout<S>::fields )
+		{
+			const auto& el = root[f.name];
+			const auto [offset, pRecord] = table.ResolvePath( f.name );
+			if( pRecord == nullptr || el.GetOffsetBegin() != f.offset || offset != f.offset || pRecord->offset != f.offset )
+			{
+				mismatches++;
+				continue;
+			}
+			if( f.count == 0u )
+			{
+				mismatches += el.GetType() != f.type || pRecord->type != f.type || pRecord->size != LayoutElement::GetLeafSize( f.type );
+			}
+			else
+			{
+				mismatches += pRecord->type != Array || pRecord->count != f.count || pRecord->stride != f.size ||
+					records[pRecord->first].type != f.type || el.GetArrayStride() != f.size;
+			}
+		}
+		mismatches += table.GetSizeInBytes() != sizeof( S ) || root.GetSizeInBytes() != sizeof( S );
+		return mismatches;
+	}
+}
+
+IRON_TEST( PointLightBufferMatchesCookedLayout )
+{
+	IRON_CHECK( count_mismatched_fields<PointLightCBuf>() == 0u );
+	IRON_CHECK( ReflectedLayout<PointLightCBuf>::MatchesLayout( *ReflectedLayout<PointLightCBuf>::Cook().ShareRoot() ) );
+
+	// the buffer of the struct reads the members where the struct has them
+	const PointLightCBuf data = { { 1.f, 2.f, 3.f }, { 0.1f, 0.2f, 0.3f }, { 0.5f, 0.6f, 0.7f }, 1.5f, 1.f, 0.045f, 0.0075f };
+	const auto buf = ReflectedLayout<PointLightCBuf>::MakeBuffer( data );
+	IRON_CHECK( static_cast<const float&>( buf["diffuseIntensity"] ) == data.diffuseIntensity );
+	IRON_CHECK( static_cast<const float&>( buf["attQuad"] ) == data.attQuad );
+	IRON_CHECK( static_cast<const DirectX::XMFLOAT3&>( buf["ambient"] ).z == data.ambient.z );
+	PointLightCBuf loaded = {};
+	ReflectedLayout<PointLightCBuf>::Load( buf, loaded );
+	IRON_CHECK( std::memcmp( &loaded, &data, sizeof( data ) ) == 0 );
+}
+
+IRON_TEST( BlurBuffersMatchCookedLayouts )
+{
+	IRON_CHECK( count_mismatched_fields<BlurKernel>() == 0u );
+	IRON_CHECK( count_mismatched_fields<BlurControl>() == 0u );
+	IRON_CHECK( ReflectedLayout<BlurKernel>::MatchesLayout( *ReflectedLayout<BlurKernel>::Cook().ShareRoot() ) );
+	IRON_CHECK( ReflectedLayout<BlurControl>::MatchesLayout( *ReflectedLayout<BlurControl>::Cook().ShareRoot() ) );
+	// layouts of other structs are rejected
+	IRON_CHECK( !ReflectedLayout<BlurKernel>::MatchesLayout( *ReflectedLayout<BlurControl>::Cook().ShareRoot() ) );
+	IRON_CHECK( !ReflectedLayout<BlurControl>::MatchesLayout( *ReflectedLayout<PointLightCBuf>::Cook().ShareRoot() ) );
+
+	// every coefficient takes a register of its own
+	const auto cooked = ReflectedLayout<BlurKernel>::Cook();
+	const auto [offset, pRecord] = cooked.GetTable().ResolvePath( "coefficients[3]" );
+	IRON_CHECK( pRecord != nullptr && pRecord->type == Float4 );
+	IRON_CHECK( offset == offsetof( BlurKernel, coefficients ) + 3u * sizeof( DirectX::XMFLOAT4 ) );
+}
+
+IRON_TEST( MisPackedStructIsRejected )
+{
+	constexpr auto fields = MisPackedCBuf::GetReflectedFields();
+	// ReflectedLayout<MisPackedCBuf> wouldn't compile, the packing check fails
+	static_assert( pack_hlsl( fields ) == 0u );
+	auto cooked = DynamicLayout::Resolve( make_raw_layout( fields ) );
+	const auto& root = *cooked.ShareRoot();
+	IRON_CHECK( root["second"].GetOffsetBegin() == 16u );
+	IRON_CHECK( offsetof( MisPackedCBuf, second ) == 12u );
+	IRON_CHECK( !matches_layout( fields, sizeof( MisPackedCBuf ), root ) );
+	// rejected for the offset of the member even when the size is taken from the layout
+	IRON_CHECK( !matches_layout( fields, root.GetSizeInBytes(), root ) );
+}
@@ -0,0 +1,78 @@
+/*!
+ * \file TaskSchedulerTests.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Thread indices of a frame scheduler and a background scheduler running side by side, like App runs them
+*/
+#include "IronTest.h"
+#include "TaskScheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+
+IRON_TEST( ThreadIndicesArePerScheduler )
+{
+	TaskScheduler frame( 4u );
+	TaskScheduler loader( 2u, TaskScheduler::Role::Background );
+	IRON_CHECK( TaskScheduler::IsFrameThread() );
+	IRON_CHECK( TaskScheduler::GetFrameThreadIndex() == 0u );
+
+	std::mutex mtx;
+	std::set<size_t> frameIndices;
+	std::atomic<size_t> loaderTasks = 0u;
+	std::atomic<size_t> foreignFrameThreads = 0u;
+	std::atomic<size_t> badLoaderIndices = 0u;
+	TaskScheduler::Group loaderGroup;
+	for( size_t i = 0; i < 64u; i++ )
+	{
+		loader.Run( loaderGroup, [&]()
+		{
+			// a loader worker is neither a frame thread nor a worker of the frame scheduler
+			if( loader.GetThreadIndex() != 0u )
+			{
+				foreignFrameThreads += TaskScheduler::IsFrameThread() ? 1u : 0u;
+				foreignFrameThreads += frame.GetThreadIndex() != 0u ? 1u : 0u;
+			}
+			badLoaderIndices += loader.GetThreadIndex() >= loader.GetThreadCount() ? 1u : 0u;
+			loaderTasks++;
+			std::this_thread::sleep_for( std::chrono::microseconds( 50 ) );
+		} );
+	}
+
+	TaskScheduler::Group frameGroup;
+	TaskScheduler::Group nestedGroup;
+	std::atomic<size_t> nestedTasks = 0u;
+	for( size_t i = 0; i < 256u; i++ )
+	{
+		frame.Run( frameGroup, [&]()
+		{
+			IRON_CHECK( TaskScheduler::IsFrameThread() );
+			IRON_CHECK( frame.GetThreadIndex() == TaskScheduler::GetFrameThreadIndex() );
+			{
+				std::lock_guard<std::mutex> lock( mtx );
+				frameIndices.insert( TaskScheduler::GetFrameThreadIndex() );
+			}
+			// frame workers have indices past the queues of the smaller loader, runs there fall back to its shared queue
+			IRON_CHECK( loader.GetThreadIndex() == 0u );
+			loader.Run( nestedGroup, [&]() { nestedTasks++; } );
+			std::this_thread::sleep_for( std::chrono::microseconds( 20 ) );
+		} );
+	}
+	frame.Wait( frameGroup );
+	loader.Wait( loaderGroup );
+	loader.Wait( nestedGroup );
+
+	IRON_CHECK( loaderTasks == 64u );
+	IRON_CHECK( nestedTasks == 256u );
+	IRON_CHECK( foreignFrameThreads == 0u );
+	IRON_CHECK( badLoaderIndices == 0u );
+	for( const auto i : frameIndices )
+	{
+		IRON_CHECK( i < frame.GetThreadCount() );
+	}
+}
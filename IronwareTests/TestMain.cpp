@@ -0,0 +1,44 @@
+/*!
+ * \file TestMain.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ *
+ */
+#include "IronTest.h"
+
+#include <atomic>
+#include <cstdio>
+
+namespace
+{
+	// checks may fail on the workers of the scheduler tests
+	std::atomic<size_t> failures = 0u;
+}
+
+std::vector<IronTest::Case>& IronTest::GetCases() noexcept
+{
+	static std::vector<Case> cases;
+	return cases;
+}
+
+void IronTest::ReportFailure( const char* file, int line, const char* expression ) noexcept
+{
+	failures++;
+	std::printf( "  %s(%d): check failed: %s\n", file, line, expression );
+}
+
+int main()
+{
+	size_t failedCases = 0u;
+	for( const auto& c : IronTest::GetCases() )
+	{
+		const auto before = failures.load();
+		std::printf( "%s\n", c.name );
+		c.run();
+		failedCases += failures != before;
+	}
+	std::printf( "%zu of %zu tests failed, %zu failed checks\n", failedCases, IronTest::GetCases().size(), failures.load() );
+	return int( failures.load() );
+}
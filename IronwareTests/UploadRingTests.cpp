@@ -0,0 +1,139 @@
+/*!
+ * \file UploadRingTests.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Wrapping, retiring and waiting of UploadRing with a stand-in fence
+ *
+ * \note The fence only records the ids it was waited on and the last completed one,
+ * * the way ConstantUploadRing waits on the frame queries of Graphics.
+*/
+#include "IronTest.h"
+#include "UploadRing.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+	struct TestFence
+	{
+		uint64_t completed = 0u;
+		std::vector<uint64_t> waited;
+
+		void Wait( uint64_t fence )
+		{
+			waited.push_back( fence );
+			completed = std::max( completed, fence );
+		}
+	};
+
+	/**
+	 * @brief Ring of 128 bytes with three frames of 32 in flight, the last 32 are free
+	*/
+	UploadRing make_busy_ring()
+	{
+		UploadRing ring( 128u, 16u );
+		for( uint64_t fence = 1u; fence <= 3u; fence++ )
+		{
+			ring.Allocate( 32u );
+			ring.EndFrame( fence );
+		}
+		return ring;
+	}
+}
+
+IRON_TEST( WrapSkipsUnusableTail )
+{
+	UploadRing ring( 256u, 16u );
+	IRON_CHECK( ring.Allocate( 90u ) == 0u );
+	ring.EndFrame( 1u );
+	IRON_CHECK( ring.Allocate( 128u ) == 96u );
+	ring.EndFrame( 2u );
+	ring.Retire( 1u );
+
+	// 32 bytes are left at the end, the allocation starts over and the end is taken with it
+	IRON_CHECK( ring.Allocate( 64u ) == 0u );
+	IRON_CHECK( ring.GetFrameBytes() == 96u );
+	auto stats = ring.GetStats();
+	IRON_CHECK( stats.wraps == 1u );
+	IRON_CHECK( stats.used == 224u );
+
+	// up to the start of the frame in flight and no further
+	IRON_CHECK( ring.Allocate( 32u ) == 64u );
+	IRON_CHECK( ring.Allocate( 16u ) == UploadRing::NO_SPACE );
+	ring.EndFrame( 3u );
+
+	// the skipped end is given back with the frame that skipped it
+	ring.Retire( 2u );
+	IRON_CHECK( ring.GetStats().used == 128u );
+	ring.Retire( 3u );
+	stats = ring.GetStats();
+	IRON_CHECK( stats.used == 0u );
+	IRON_CHECK( stats.pendingFrames == 0u );
+}
+
+IRON_TEST( RetireFreesOnlyUpToFence )
+{
+	auto ring = make_busy_ring();
+	IRON_CHECK( ring.GetStats().used == 96u );
+	IRON_CHECK( ring.Allocate( 64u ) == UploadRing::NO_SPACE );
+
+	ring.Retire( 1u );
+	IRON_CHECK( ring.GetOldestFence() == 2u );
+	IRON_CHECK( ring.GetStats().used == 64u );
+	// 32 at the end and 32 at the start are free, but not in one piece
+	IRON_CHECK( ring.Allocate( 64u ) == UploadRing::NO_SPACE );
+
+	// fences that are already given back change nothing
+	ring.Retire( 1u );
+	ring.Retire( 0u );
+	IRON_CHECK( ring.GetStats().pendingFrames == 2u );
+
+	ring.Retire( 2u );
+	IRON_CHECK( ring.GetStats().pendingFrames == 1u );
+	IRON_CHECK( ring.Allocate( 64u ) == 0u );
+	IRON_CHECK( ring.GetStats().wraps == 1u );
+}
+
+IRON_TEST( AllocateWaitingWaitsForOldestFrames )
+{
+	auto ring = make_busy_ring();
+	TestFence fence;
+	// with room left at the end nothing is waited on
+	IRON_CHECK( ring.AllocateWaiting( 32u, [&]( uint64_t f ) { fence.Wait( f ); } ) == 96u );
+	IRON_CHECK( fence.waited.empty() );
+
+	const auto offset = ring.AllocateWaiting( 64u, [&]( uint64_t f )
+	{
+		// the ring asks only for frames it still holds, oldest first
+		IRON_CHECK( ring.HasPendingFrames() && ring.GetOldestFence() == f );
+		fence.Wait( f );
+	} );
+	IRON_CHECK( offset == 0u );
+	IRON_CHECK( ( fence.waited == std::vector<uint64_t>{ 1u, 2u } ) );
+	const auto stats = ring.GetStats();
+	IRON_CHECK( stats.stalls == 2u );
+	IRON_CHECK( stats.pendingFrames == 1u );
+	// the head was at the very end, so it starts over without skipping anything
+	IRON_CHECK( stats.wraps == 1u );
+	// frame 3 and both allocations of the open frame
+	IRON_CHECK( stats.used == 32u + 32u + 64u );
+}
+
+IRON_TEST( OversizedAllocationFailsWithoutWaiting )
+{
+	auto ring = make_busy_ring();
+	TestFence fence;
+	const auto wait = [&]( uint64_t f ) { fence.Wait( f ); };
+	IRON_CHECK( ring.AllocateWaiting( 129u, wait ) == UploadRing::NO_SPACE );
+	IRON_CHECK( ring.AllocateWaiting( 0u, wait ) == UploadRing::NO_SPACE );
+	IRON_CHECK( fence.waited.empty() );
+	IRON_CHECK( ring.GetStats().pendingFrames == 3u );
+
+	// the whole ring still fits once every frame is done
+	IRON_CHECK( ring.AllocateWaiting( 128u, wait ) == 0u );
+	IRON_CHECK( ( fence.waited == std::vector<uint64_t>{ 1u, 2u, 3u } ) );
+	IRON_CHECK( ring.GetStats().used == 128u );
+}
@@ -0,0 +1,206 @@
+/*!
+ * \file VertexPackingTests.cpp
+ *
+ * \author Yernar Aldabergenov
+ * \date June 2021
+ *
+ * \brief Round trips of the packed vertex elements on synthetic meshes
+ *
+ * \note Normals cover the whole sphere, every other tangent frame is mirrored and
+ * * texture coordinates tile past [0, 1]. Packed elements are decoded on the CPU
+ * * the way the input assembler expands them and compared to the source floats.
+*/
+#include "IronTest.h"
+#include "Vertex.h"
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+
+namespace
+{
+	namespace dx = DirectX;
+	using Type = VertexLayout::ElementType;
+
+	// snorm16 steps are 1/32767, a unit vector is turned by less than 0.005 degrees
+	constexpr float MAX_DIRECTION_ERROR = 0.01f;
+	// rebuilt from two packed directions, so both of their errors add up
+	constexpr float MAX_BITANGENT_ERROR = 0.02f;
+	// half floats keep 11 significant bits and round to the nearest
+	constexpr float HALF_UNIT_ERROR = 1.f / 4096.f;
+	constexpr float HALF_RELATIVE_ERROR = 1.f / 2048.f;
+
+	/**
+	 * @brief Vertices over a fibonacci sphere, odd vertices have mirrored uvs
+	 * * Source directions aren't unit length, the encoders have to normalize them
+	*/
+	std::unique_ptr<aiMesh> make_mesh( unsigned count )
+	{
+		auto pMesh = std::make_unique<aiMesh>();
+		pMesh->mNumVertices = count;
+		pMesh->mVertices = new aiVector3D[count];
+		pMesh->mNormals = new aiVector3D[count];
+		pMesh->mTangents = new aiVector3D[count];
+		pMesh->mBitangents = new aiVector3D[count];
+		pMesh->mTextureCoords[0] = new aiVector3D[count];
+		pMesh->mNumUVComponents[0] = 2u;
+		const float goldenAngle = 2.39996323f;
+		for( unsigned i = 0; i < count; i++ )
+		{
+			const float y = 1.f - 2.f * ( float( i ) + 0.5f ) / float( count );
+			const float r = std::sqrt( 1.f - y * y );
+			const float phi = goldenAngle * float( i );
+			const aiVector3D n( std::cos( phi ) * r, y, std::sin( phi ) * r );
+			// any direction that isn't parallel to the normal gives a tangent
+			const aiVector3D axis = std::abs( n.y ) < 0.99f ? aiVector3D( 0.f, 1.f, 0.f ) : aiVector3D( 1.f, 0.f, 0.f );
+			const aiVector3D t = ( axis ^ n ).Normalize();
+			const float mirror = i % 2u ? -1.f : 1.f;
+			const float length = 0.5f + float( i % 3u );
+			pMesh->mVertices[i] = n * 10.f;
+			pMesh->mNormals[i] = n * length;
+			pMesh->mTangents[i] = t * length;
+			pMesh->mBitangents[i] = ( n ^ t ) * mirror * length;
+			// tiled from -4 to 8, exact values at the borders of the unit range included
+			const float u = i % 7u == 0u ? float( i % 2u ) : -4.f + 12.f * std::fmod( float( i ) * 0.6180339f, 1.f );
+			const float v = i % 5u == 0u ? 1.f : -2.f + 5.f * std::fmod( float( i ) * 0.4142135f, 1.f );
+			pMesh->mTextureCoords[0][i] = aiVector3D( u, v, 0.f );
+		}
+		return pMesh;
+	}
+
+	VertexLayout make_packed_layout()
+	{
+		VertexLayout layout;
+		layout.Append( Type::Position3D );
+		layout.Append( Type::Texture2DHalf );
+		layout.Append( Type::NormalPacked );
+		layout.Append( Type::TangentFrame );
+		return layout;
+	}
+
+	dx::XMVECTOR load_direction( const aiVector3D& v )
+	{
+		return dx::XMVector3Normalize( dx::XMVectorSet( v.x, v.y, v.z, 0.f ) );
+	}
+
+	// acos of the dot product loses the small angles to rounding, atan2 keeps them
+	float angle_degrees( dx::FXMVECTOR a, dx::FXMVECTOR b )
+	{
+		const auto na = dx::XMVector3Normalize( a );
+		const auto nb = dx::XMVector3Normalize( b );
+		const float sine = dx::XMVectorGetX( dx::XMVector3Length( dx::XMVector3Cross( na, nb ) ) );
+		const float cosine = dx::XMVectorGetX( dx::XMVector3Dot( na, nb ) );
+		return dx::XMConvertToDegrees( std::atan2( sine, cosine ) );
+	}
+
+	float allowed_half_error( float value )
+	{
+		return std::abs( value ) <= 1.f ? HALF_UNIT_ERROR : std::abs( value ) * HALF_RELATIVE_ERROR;
+	}
+}
+
+IRON_TEST( TexCoordsHalfRoundTrip )
+{
+	const auto pMesh = make_mesh( 5000u );
+	const VertexByteBuffer vertices( make_packed_layout(), *pMesh, 1.f );
+	const auto coords = vertices.View<Type::Texture2DHalf>();
+	IRON_CHECK( coords.size() == pMesh->mNumVertices );
+	size_t outside = 0u;
+	size_t failures = 0u;
+	for( size_t i = 0; i < coords.size(); i++ )
+	{
+		const auto& src = pMesh->mTextureCoords[0][i];
+		const float u = dx::PackedVector::XMConvertHalfToFloat( coords[i].x );
+		const float v = dx::PackedVector::XMConvertHalfToFloat( coords[i].y );
+		failures += std::abs( u - src.x ) > allowed_half_error( src.x );
+		failures += std::abs( v - src.y ) > allowed_half_error( src.y );
+		outside += src.x < 0.f || src.x > 1.f;
+		// borders of the unit range are exact in half
+		if( src.x == 0.f || src.x == 1.f )
+		{
+			failures += u != src.x;
+		}
+	}
+	IRON_CHECK( failures == 0u );
+	// the mesh really exercises coordinates outside of the unit range
+	IRON_CHECK( outside > coords.size() / 2u );
+}
+
+IRON_TEST( NormalPackedRoundTrip )
+{
+	const auto pMesh = make_mesh( 5000u );
+	const VertexByteBuffer vertices( make_packed_layout(), *pMesh, 1.f );
+	const auto normals = vertices.View<Type::NormalPacked>();
+	float maxError = 0.f;
+	float maxLengthError = 0.f;
+	for( size_t i = 0; i < normals.size(); i++ )
+	{
+		const auto decoded = dx::PackedVector::XMLoadShortN4( &normals[i] );
+		maxError = std::max( maxError, angle_degrees( load_direction( pMesh->mNormals[i] ), decoded ) );
+		maxLengthError = std::max( maxLengthError, std::abs( dx::XMVectorGetX( dx::XMVector3Length( decoded ) ) - 1.f ) );
+		IRON_CHECK( dx::XMVectorGetW( decoded ) == 0.f );
+	}
+	IRON_CHECK( maxError <= MAX_DIRECTION_ERROR );
+	// normalized before packing, the shader may skip normalizing
+	IRON_CHECK( maxLengthError <= 1e-4f );
+}
+
+IRON_TEST( TangentFrameRoundTripAndMirroring )
+{
+	const auto pMesh = make_mesh( 5000u );
+	const VertexByteBuffer vertices( make_packed_layout(), *pMesh, 1.f );
+	const auto normals = vertices.View<Type::NormalPacked>();
+	const auto frames = vertices.View<Type::TangentFrame>();
+	float maxTangentError = 0.f;
+	float maxBitangentError = 0.f;
+	size_t wrongSigns = 0u;
+	size_t mirrored = 0u;
+	for( size_t i = 0; i < frames.size(); i++ )
+	{
+		const auto frame = dx::PackedVector::XMLoadShortN4( &frames[i] );
+		const auto normal = dx::PackedVector::XMLoadShortN4( &normals[i] );
+		const float sign = dx::XMVectorGetW( frame );
+		const bool isMirrored = i % 2u != 0u;
+		// the sign has to survive packing exactly, the shader multiplies by it
+		wrongSigns += sign != ( isMirrored ? -1.f : 1.f );
+		mirrored += sign < 0.f;
+		maxTangentError = std::max( maxTangentError, angle_degrees( load_direction( pMesh->mTangents[i] ), frame ) );
+		// rebuilt like the vertex shader does, from the packed normal and tangent
+		const auto bitangent = dx::XMVectorScale( dx::XMVector3Cross( normal, frame ), sign );
+		maxBitangentError = std::max( maxBitangentError, angle_degrees( load_direction( pMesh->mBitangents[i] ), bitangent ) );
+	}
+	IRON_CHECK( wrongSigns == 0u );
+	IRON_CHECK( mirrored == frames.size() / 2u );
+	IRON_CHECK( maxTangentError <= MAX_DIRECTION_ERROR );
+	IRON_CHECK( maxBitangentError <= MAX_BITANGENT_ERROR );
+}
+
+IRON_TEST( PackedFillsAgree )
+{
+	// large enough to be filled in parallel ranges
+	const auto pMesh = make_mesh( 20000u );
+	const auto layout = make_packed_layout();
+	const VertexByteBuffer streamed( layout, *pMesh, 1.f );
+	TaskScheduler scheduler( 3u, TaskScheduler::Role::Background );
+	const VertexByteBuffer parallel( layout, *pMesh, 1.f, &scheduler );
+	IRON_CHECK( streamed.SizeBytes() == parallel.SizeBytes() );
+	IRON_CHECK( std::memcmp( streamed.GetData(), parallel.GetData(), streamed.SizeBytes() ) == 0 );
+
+	// per vertex extraction converts one vertex at a time and has to give the same bits
+	const auto coords = streamed.View<Type::Texture2DHalf>();
+	const auto normals = streamed.View<Type::NormalPacked>();
+	const auto frames = streamed.View<Type::TangentFrame>();
+	size_t differences = 0u;
+	for( unsigned i = 0; i < pMesh->mNumVertices; i += 97u )
+	{
+		const auto coord = VertexLayout::Map<Type::Texture2DHalf>::Extract( *pMesh, i );
+		const auto normal = VertexLayout::Map<Type::NormalPacked>::Extract( *pMesh, i );
+		const auto frame = VertexLayout::Map<Type::TangentFrame>::Extract( *pMesh, i );
+		differences += std::memcmp( &coord, &coords[i], sizeof( coord ) ) != 0;
+		differences += std::memcmp( &normal, &normals[i], sizeof( normal ) ) != 0;
+		differences += std::memcmp( &frame, &frames[i], sizeof( frame ) ) != 0;
+	}
+	IRON_CHECK( differences == 0u );
+}